@@ -113,6 +113,11 @@ struct TransactionsInBlockInfo {
   std::vector<WalletTransactionWithTransfers> transactions;
 };
 
+struct TransactionsFilter {
+  std::vector<std::string> addresses; // transactions with a transfer for any of them, all transactions if empty
+  boost::optional<Crypto::Hash> paymentId;
+};
+
 class IWallet {
 public:
   virtual ~IWallet() {}
@@ -124,6 +129,9 @@ public:
 
   virtual void changePassword(const std::string& oldPassword, const std::string& newPassword) = 0;
   virtual void save(std::ostream& destination, bool saveDetails = true, bool saveCache = true) = 0;
+  // Appends what changed since destination was last saved or loaded to it. Returns false without writing if that
+  // can't be done, destination has to be written with save() then.
+  virtual bool saveChanges(std::iostream& destination) = 0;
 
   virtual size_t getAddressCount() const = 0;
   virtual std::string getAddress(size_t index) const = 0;
@@ -150,6 +158,9 @@ public:
   virtual WalletTransactionWithTransfers getTransaction(const Crypto::Hash& transactionHash) const = 0;
   virtual std::vector<TransactionsInBlockInfo> getTransactions(const Crypto::Hash& blockHash, size_t count) const = 0;
   virtual std::vector<TransactionsInBlockInfo> getTransactions(uint32_t blockIndex, size_t count) const = 0;
+  // Only the blocks holding transactions that match the filter are returned
+  virtual std::vector<TransactionsInBlockInfo> getTransactions(const Crypto::Hash& blockHash, size_t count, const TransactionsFilter& filter) const = 0;
+  virtual std::vector<TransactionsInBlockInfo> getTransactions(uint32_t blockIndex, size_t count, const TransactionsFilter& filter) const = 0;
   virtual std::vector<Crypto::Hash> getBlockHashes(uint32_t blockIndex, size_t count) const = 0;
   virtual uint32_t getBlockCount() const  = 0;
   virtual std::vector<WalletTransactionWithTransfers> getUnconfirmedTransactions() const = 0;
@@ -0,0 +1,96 @@
+// Copyright (c) 2018-2022 The Cash2 developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "RecursiveSharedMutex.h"
+
+#include <cassert>
+
+namespace Tools {
+
+RecursiveSharedMutex::RecursiveSharedMutex() :
+  m_writerDepth(0),
+  m_waitingWriters(0) {
+}
+
+void RecursiveSharedMutex::lock() {
+  std::unique_lock<std::mutex> lk(m_mutex);
+  std::thread::id self = std::this_thread::get_id();
+  if (m_writerDepth != 0 && m_writer == self) {
+    ++m_writerDepth;
+    return;
+  }
+
+  assert(m_readers.count(self) == 0);
+
+  ++m_waitingWriters;
+  m_writersCondition.wait(lk, [this] { return m_writerDepth == 0 && m_readers.empty(); });
+  --m_waitingWriters;
+
+  m_writer = self;
+  m_writerDepth = 1;
+}
+
+void RecursiveSharedMutex::unlock() {
+  std::unique_lock<std::mutex> lk(m_mutex);
+  releaseExclusive();
+}
+
+void RecursiveSharedMutex::lock_shared() {
+  std::unique_lock<std::mutex> lk(m_mutex);
+  std::thread::id self = std::this_thread::get_id();
+  if (m_writerDepth != 0 && m_writer == self) {
+    ++m_writerDepth;
+    return;
+  }
+
+  auto it = m_readers.find(self);
+  if (it != m_readers.end()) {
+    ++it->second;
+    return;
+  }
+
+  m_readersCondition.wait(lk, [this] { return m_writerDepth == 0 && m_waitingWriters == 0; });
+  m_readers.emplace(self, 1);
+}
+
+void RecursiveSharedMutex::unlock_shared() {
+  std::unique_lock<std::mutex> lk(m_mutex);
+  std::thread::id self = std::this_thread::get_id();
+  if (m_writerDepth != 0 && m_writer == self) {
+    releaseExclusive();
+    return;
+  }
+
+  auto it = m_readers.find(self);
+  assert(it != m_readers.end());
+  if (--it->second == 0) {
+    m_readers.erase(it);
+    if (m_readers.empty() && m_waitingWriters != 0) {
+      m_writersCondition.notify_one();
+    }
+  }
+}
+
+bool RecursiveSharedMutex::ownedByCurrentThread() const {
+  std::unique_lock<std::mutex> lk(m_mutex);
+  std::thread::id self = std::this_thread::get_id();
+  return (m_writerDepth != 0 && m_writer == self) || m_readers.count(self) != 0;
+}
+
+// Precondition: m_mutex is locked and the calling thread owns the exclusive lock.
+void RecursiveSharedMutex::releaseExclusive() {
+  assert(m_writerDepth != 0 && m_writer == std::this_thread::get_id());
+  if (--m_writerDepth != 0) {
+    return;
+  }
+
+  m_writer = std::thread::id();
+  if (m_waitingWriters != 0) {
+    m_writersCondition.notify_one();
+  } else {
+    m_readersCondition.notify_all();
+  }
+}
+
+}
@@ -0,0 +1,64 @@
+// Copyright (c) 2018-2022 The Cash2 developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace Tools {
+
+// Reader/writer mutex which may be re-entered by the thread that holds it.
+// The exclusive owner may lock again and may take shared locks, a shared owner may take further shared locks
+// even while a writer is waiting. Upgrading a shared lock to an exclusive one is not supported.
+// Waiting writers have priority over new readers.
+class RecursiveSharedMutex {
+public:
+  RecursiveSharedMutex();
+
+  RecursiveSharedMutex(const RecursiveSharedMutex&) = delete;
+  RecursiveSharedMutex& operator=(const RecursiveSharedMutex&) = delete;
+
+  void lock();
+  void unlock();
+
+  void lock_shared();
+  void unlock_shared();
+
+  // true if the calling thread holds the mutex in any mode
+  bool ownedByCurrentThread() const;
+
+private:
+  mutable std::mutex m_mutex;
+  std::condition_variable m_readersCondition;
+  std::condition_variable m_writersCondition;
+  std::thread::id m_writer;
+  size_t m_writerDepth;
+  size_t m_waitingWriters;
+  std::unordered_map<std::thread::id, size_t> m_readers;
+
+  void releaseExclusive();
+};
+
+template<class Mutex> class SharedLockGuard {
+public:
+  explicit SharedLockGuard(Mutex& mutex) : m_mutex(mutex) {
+    m_mutex.lock_shared();
+  }
+
+  ~SharedLockGuard() {
+    m_mutex.unlock_shared();
+  }
+
+  SharedLockGuard(const SharedLockGuard&) = delete;
+  SharedLockGuard& operator=(const SharedLockGuard&) = delete;
+
+private:
+  Mutex& m_mutex;
+};
+
+}
@@ -0,0 +1,71 @@
+// Copyright (c) 2018-2022 The Cash2 developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "WorkerPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+namespace Tools {
+
+WorkerPool::WorkerPool(size_t threadCount) :
+  m_jobs(std::max<size_t>(threadCount, 1) * 16) {
+  for (size_t i = 0; i < threadCount; ++i) {
+    m_threads.emplace_back(&WorkerPool::workerThread, this);
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  m_jobs.close();
+  for (auto& thread : m_threads) {
+    thread.join();
+  }
+}
+
+size_t WorkerPool::threadCount() const {
+  return m_threads.size();
+}
+
+// The calling thread takes part in the loop, so the loop ends even if the pool threads are busy with other loops.
+// A helper that starts late finds nothing left to do, it is only waited for because it references the loop state.
+void WorkerPool::parallelFor(size_t count, size_t helperCount, const std::function<void(size_t)>& job) {
+  helperCount = std::min(helperCount, m_threads.size());
+
+  std::atomic<size_t> next(0);
+  auto loop = [&] {
+    for (size_t i = next++; i < count; i = next++) {
+      job(i);
+    }
+  };
+
+  std::mutex mutex;
+  std::condition_variable helpersDone;
+  size_t runningHelpers = helperCount;
+  for (size_t i = 0; i < helperCount; ++i) {
+    m_jobs.push([&] {
+      loop();
+
+      std::lock_guard<std::mutex> lock(mutex);
+      if (--runningHelpers == 0) {
+        helpersDone.notify_one();
+      }
+    });
+  }
+
+  loop();
+
+  std::unique_lock<std::mutex> lock(mutex);
+  helpersDone.wait(lock, [&] { return runningHelpers == 0; });
+}
+
+void WorkerPool::workerThread() {
+  std::function<void()> job;
+  while (m_jobs.pop(job)) {
+    job();
+  }
+}
+
+}
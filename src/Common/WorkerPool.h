@@ -0,0 +1,39 @@
+// Copyright (c) 2018-2022 The Cash2 developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "BlockingQueue.h"
+
+namespace Tools {
+
+// Threads started once and kept for parallel loops, so that a short loop doesn't pay for starting threads.
+// Several threads may run loops on the same pool at the same time.
+class WorkerPool {
+public:
+  explicit WorkerPool(size_t threadCount);
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  size_t threadCount() const;
+
+  // Calls job(i) for every i below count, on the calling thread and on at most helperCount threads of the pool,
+  // and returns when all the calls have returned. The job must not throw.
+  void parallelFor(size_t count, size_t helperCount, const std::function<void(size_t)>& job);
+
+private:
+  void workerThread();
+
+  BlockingQueue<std::function<void()>> m_jobs;
+  std::vector<std::thread> m_threads;
+};
+
+}
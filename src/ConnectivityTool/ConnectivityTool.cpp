@@ -148,6 +148,8 @@ bool print_COMMAND_REQUEST_STAT_INFO(const COMMAND_REQUEST_STAT_INFO::response &
   std::cout << "Mining speed:          " << si.payload_info.mining_speed << ENDL;
   std::cout << "Alternative blocks:  " << si.payload_info.alternative_blocks << ENDL;
   std::cout << "Top block id:        " << si.payload_info.top_block_id_str << ENDL;
+  std::cout << "Spent keys filter:   " << si.payload_info.spent_keys_filter_size << " bytes, " <<
+    si.payload_info.spent_keys_filter_false_positive_rate * 100 << "% false positives" << ENDL;
   return true;
 }
 //---------------------------------------------------------------------------------------------------------------
@@ -65,6 +65,9 @@ const size_t   FUSION_TX_MIN_IN_OUT_COUNT_RATIO              = 4;
 const char     CRYPTONOTE_BLOCKS_FILENAME[]                  = "blocks.dat";
 const char     CRYPTONOTE_BLOCKINDEXES_FILENAME[]            = "blockindexes.dat";
 const char     CRYPTONOTE_BLOCKSCACHE_FILENAME[]             = "blockscache.dat";
+const char     CRYPTONOTE_BLOCKSCACHE_JOURNAL_FILENAME[]     = "blockscachejournal.dat";
+const char     CRYPTONOTE_BLOCKSTORE_FILENAME[]              = "blockstore.dat";
+const char     CRYPTONOTE_BLOCKSTOREINDEXES_FILENAME[]       = "blockstoreindexes.dat";
 const char     CRYPTONOTE_POOLDATA_FILENAME[]                = "poolstate.bin";
 const char     P2P_NET_DATA_FILENAME[]                       = "p2pstate.bin";
 const char     CRYPTONOTE_BLOCKCHAIN_INDEXES_FILENAME[]      = "blockchainindexes.dat";
@@ -92,10 +95,20 @@ const char     GENESIS_COINBASE_TX_HEX[]                     = "013c01ff0001a7d7
 const uint8_t  CURRENT_TRANSACTION_VERSION                   = 1;
 const size_t   BLOCKS_IDS_SYNCHRONIZING_DEFAULT_COUNT        = 10000;  //by default, blocks ids count in synchronizing
 const size_t   BLOCKS_SYNCHRONIZING_DEFAULT_COUNT            = 20;    //by default, blocks count in blocks downloading
+const size_t   BLOCKS_SYNCHRONIZING_MAX_COUNT                = 200;   //upper limit of the per peer adapted blocks count in blocks downloading
+const size_t   BLOCKS_SYNCHRONIZING_MAX_SIZE                 = 8 * 1024 * 1024; //bytes, adapted blocks requests are kept below this response size
+const uint64_t BLOCKS_SYNCHRONIZING_TARGET_TIME              = 2000;  //milliseconds, adapted blocks requests aim at responses taking this long
+const size_t   BLOCKS_CACHE_DEFAULT_SIZE                     = 1024;  //by default, deserialized blocks kept in memory
+const size_t   VERIFIED_TRANSACTIONS_CACHE_SIZE              = 50000; //transactions remembered as having valid ring signatures
+const size_t   SPENT_KEYS_FILTER_MIN_CAPACITY                = 65536; //key images the spent key image filter is sized for at least
 const size_t   COMMAND_RPC_GET_BLOCKS_FAST_MAX_COUNT         = 1000;
 const int      P2P_DEFAULT_PORT                              = 12275;
 const int      RPC_DEFAULT_PORT                              = 12276;
 const int      WALLETD_DEFAULT_PORT                          = 12277;
+const size_t   RPC_DEFAULT_WORKER_THREADS                    = 2;     //threads running the rpc handlers that don't need the dispatcher
+const size_t   RPC_DEFAULT_MAX_REQUEST_SIZE                  = 16 * 1024 * 1024; // 16 MB
+const size_t   RPC_DEFAULT_MAX_CONNECTION_REQUESTS           = 16;    //pipelined requests of a connection read ahead of their responses
+const size_t   RPC_DEFAULT_MAX_QUEUED_REQUESTS               = 1024;  //requests waiting for a worker thread, more are answered with 503
 const size_t   P2P_LOCAL_WHITE_PEERLIST_LIMIT                = 1000;
 const size_t   P2P_LOCAL_GRAY_PEERLIST_LIMIT                 = 5000;
 const size_t   P2P_CONNECTION_MAX_WRITE_BUFFER_SIZE          = 16 * 1024 * 1024; // 16 MB
@@ -8,21 +8,32 @@
 #include "Blockchain.h"
 
 #include <algorithm>
+#include <condition_variable>
 #include <cstdio>
+#include <exception>
+#include <thread>
+#include <boost/filesystem.hpp>
 #include <boost/foreach.hpp>
 #include "Common/Math.h"
+#include "Common/MemoryInputStream.h"
+#include "Common/ScopeExit.h"
 #include "Common/ShuffleGenerator.h"
 #include "Common/StdInputStream.h"
 #include "Common/StdOutputStream.h"
 #include "Rpc/CoreRpcServerCommandsDefinitions.h"
 #include "Serialization/BinarySerializationTools.h"
 #include "CryptoNoteTools.h"
+#include "SwappedVector.h"
 
 using namespace Logging;
 using namespace Common;
 
 namespace {
 
+const uint32_t REBUILD_CACHE_BATCH_SIZE = 1000;
+// blocks journaled before the indexes are saved in full again
+const uint32_t BLOCKS_CACHE_SNAPSHOT_INTERVAL = 10000;
+
 std::string appendPath(const std::string& path, const std::string& fileName) {
   std::string result = path;
   if (!result.empty()) {
@@ -33,6 +44,120 @@ std::string appendPath(const std::string& path, const std::string& fileName) {
   return result;
 }
 
+// Walks the binary serialization of a stored item without deserializing it
+class BlobReader {
+public:
+  explicit BlobReader(Common::StringView blob) : m_blob(blob), m_position(0) {
+  }
+
+  size_t position() const {
+    return m_position;
+  }
+
+  uint8_t readByte() {
+    require(1);
+    return static_cast<uint8_t>(m_blob.getData()[m_position++]);
+  }
+
+  uint64_t readVarint() {
+    uint64_t value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+      uint8_t byte = readByte();
+      value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0) {
+        return value;
+      }
+    }
+
+    throw std::runtime_error("BlobReader: varint is too long");
+  }
+
+  void read(void* data, size_t size) {
+    require(size);
+    memcpy(data, m_blob.getData() + m_position, size);
+    m_position += size;
+  }
+
+  void skip(uint64_t count, uint64_t itemSize = 1) {
+    if (count > (m_blob.getSize() - m_position) / itemSize) {
+      throw std::runtime_error("BlobReader: unexpected end of data");
+    }
+
+    m_position += static_cast<size_t>(count * itemSize);
+  }
+
+  void skipVarints(uint64_t count) {
+    for (uint64_t i = 0; i < count; ++i) {
+      readVarint();
+    }
+  }
+
+  Common::StringView slice(size_t start) const {
+    return Common::StringView(m_blob.getData() + start, m_position - start);
+  }
+
+private:
+  void require(uint64_t size) const {
+    if (size > m_blob.getSize() - m_position) {
+      throw std::runtime_error("BlobReader: unexpected end of data");
+    }
+  }
+
+  Common::StringView m_blob;
+  size_t m_position;
+};
+
+// Mirrors serialize(Transaction&) for a BinaryOutputStreamSerializer
+void skipTransaction(BlobReader& reader) {
+  reader.readVarint(); // version
+  reader.readVarint(); // unlock time
+
+  uint64_t signatureCount = 0;
+  uint64_t inputCount = reader.readVarint();
+  for (uint64_t i = 0; i < inputCount; ++i) {
+    switch (reader.readByte()) {
+    case 0xff: // BaseInput
+      reader.readVarint();
+      break;
+    case 0x2: { // KeyInput
+      reader.readVarint();
+      uint64_t outputCount = reader.readVarint();
+      reader.skipVarints(outputCount);
+      reader.skip(sizeof(Crypto::KeyImage));
+      signatureCount += outputCount;
+      break;
+    }
+    case 0x3: // MultisignatureInput
+      reader.readVarint();
+      signatureCount += reader.readVarint();
+      reader.readVarint();
+      break;
+    default:
+      throw std::runtime_error("Unknown transaction input type");
+    }
+  }
+
+  uint64_t outputCount = reader.readVarint();
+  for (uint64_t i = 0; i < outputCount; ++i) {
+    reader.readVarint(); // amount
+    switch (reader.readByte()) {
+    case 0x2: // KeyOutput
+      reader.skip(sizeof(Crypto::PublicKey));
+      break;
+    case 0x3: // MultisignatureOutput
+      reader.skip(reader.readVarint(), sizeof(Crypto::PublicKey));
+      reader.readVarint();
+      break;
+    default:
+      throw std::runtime_error("Unknown transaction output type");
+    }
+  }
+
+  reader.skip(reader.readVarint()); // extra
+  reader.skip(signatureCount, sizeof(Crypto::Signature));
+}
+
+
 }
 
 namespace std {
@@ -45,7 +170,8 @@ bool operator<(const Crypto::KeyImage& keyImage1, const Crypto::KeyImage& keyIma
 }
 }
 
-#define CURRENT_BLOCKCACHE_STORAGE_ARCHIVE_VER 1
+#define CURRENT_BLOCKCACHE_STORAGE_ARCHIVE_VER 3
+#define CURRENT_BLOCKCACHE_JOURNAL_VER 2
 #define CURRENT_BLOCKCHAININDEXES_STORAGE_ARCHIVE_VER 1
 
 namespace CryptoNote {
@@ -84,9 +210,10 @@ bool serialize(google::sparse_hash_set<K, Hash>& value, Common::StringView name,
   return true;
 }
 
-// custom serialization to speedup cache loading
-bool serialize(std::vector<std::pair<Blockchain::TransactionIndex, uint16_t>>& value, Common::StringView name, CryptoNote::ISerializer& s) {
-  const size_t elementSize = sizeof(std::pair<Blockchain::TransactionIndex, uint16_t>);
+// custom serialization to speedup cache loading, the elements are written as they are in memory
+template<typename T>
+bool serializeVectorAsArray(std::vector<T>& value, Common::StringView name, CryptoNote::ISerializer& s) {
+  const size_t elementSize = sizeof(T);
   size_t size = value.size() * elementSize;
 
   if (!s.beginArray(size, name)) {
@@ -108,11 +235,43 @@ bool serialize(std::vector<std::pair<Blockchain::TransactionIndex, uint16_t>>& v
   return true;
 }
 
+bool serialize(std::vector<Blockchain::OutputReference>& value, Common::StringView name, CryptoNote::ISerializer& s) {
+  return serializeVectorAsArray(value, name, s);
+}
+
+bool serialize(std::vector<Blockchain::KeyOutputEntry>& value, Common::StringView name, CryptoNote::ISerializer& s) {
+  return serializeVectorAsArray(value, name, s);
+}
+
 void serialize(Blockchain::TransactionIndex& value, ISerializer& s) {
   s(value.block, "block");
   s(value.transaction, "tx");
 }
 
+// the keys and the values are written as two arrays, the slots are rebuilt when loading
+template<typename K, typename V>
+bool serialize(FlatHashMap<K, V>& value, Common::StringView name, CryptoNote::ISerializer& s) {
+  if (!s.beginObject(name)) {
+    return false;
+  }
+
+  std::vector<K> keys;
+  std::vector<V> values;
+  if (s.type() == CryptoNote::ISerializer::OUTPUT) {
+    keys = value.keys();
+    values = value.values();
+  }
+
+  serializeVectorAsArray(keys, "keys", s);
+  serializeVectorAsArray(values, "values", s);
+  if (s.type() == CryptoNote::ISerializer::INPUT) {
+    value.assign(std::move(keys), std::move(values));
+  }
+
+  s.endObject();
+  return true;
+}
+
 class BlockCacheSerializer {
 
 public:
@@ -162,20 +321,9 @@ public:
     if (version < CURRENT_BLOCKCACHE_STORAGE_ARCHIVE_VER)
       return;
 
-    std::string operation;
-    if (s.type() == ISerializer::INPUT) {
-      operation = "- loading ";
-      Crypto::Hash blockHash;
-      s(blockHash, "last_block");
-
-      if (blockHash != m_lastBlockHash) {
-        return;
-      }
-
-    } else {
-      operation = "- saving ";
-      s(m_lastBlockHash, "last_block");
-    }
+    // any snapshot is loaded, the cache journal and the stored blocks bring it up to date
+    std::string operation = s.type() == ISerializer::INPUT ? "- loading " : "- saving ";
+    s(m_lastBlockHash, "last_block");
 
     logger(INFO) << operation << "block index...";
     s(m_bs.m_blockIndex, "block_index");
@@ -189,6 +337,9 @@ public:
     logger(INFO) << operation << "outputs...";
     s(m_bs.m_outputs, "outputs");
 
+    logger(INFO) << operation << "key outputs...";
+    s(m_bs.m_keyOutputs, "key_outputs");
+
     logger(INFO) << operation << "multi-signature outputs...";
     s(m_bs.m_multisignatureOutputs, "multisig_outputs");
 
@@ -203,6 +354,10 @@ public:
     return m_loaded;
   }
 
+  const Crypto::Hash& lastBlockHash() const {
+    return m_lastBlockHash;
+  }
+
 private:
 
   LoggerRef logger;
@@ -307,13 +462,50 @@ Blockchain::Blockchain(const Currency& currency, tx_memory_pool& tx_pool, ILogge
 logger(logger, "Blockchain"),
 m_currency(currency),
 m_tx_pool(tx_pool),
+m_ringSignatureVerifier(std::max(1u, std::thread::hardware_concurrency()) - 1),
+m_verifiedTransactions(VERIFIED_TRANSACTIONS_CACHE_SIZE),
+m_spentKeysFilter(nullptr),
+m_staleSpentKeys(0),
 m_current_block_cumul_sz_limit(0),
 m_is_in_checkpoint_zone(false),
-m_checkpoints(logger) {
+m_checkpoints(logger),
+m_blocksCacheSize(BLOCKS_CACHE_DEFAULT_SIZE),
+m_cacheJournalLength(0),
+m_transactionMap(Crypto::rand<uint64_t>()) {
 
   m_outputs.set_deleted_key(0);
+  m_keyOutputs.set_deleted_key(0);
   Crypto::KeyImage nullImage = boost::value_initialized<decltype(nullImage)>();
   m_spent_keys.set_deleted_key(nullImage);
+  rebuildSpentKeysFilter();
+  m_checkedProofOfWork = { NULL_HASH, 0, NULL_HASH, false };
+  m_checkedRingSignatures = { NULL_HASH, false };
+}
+
+Blockchain::ReadLock::ReadLock(Blockchain& blockchain) : m_blockchain(blockchain) {
+  // Readers leave blocks evicted from the cache alive, see MappedVector::releaseRetired().
+  // Once enough of them pile up, let the readers drain so a writer can free them.
+  if (m_blockchain.m_blocks.retiredCount() >= m_blockchain.m_blocksCacheSize && !m_blockchain.m_blockchain_lock.ownedByCurrentThread()) {
+    WriteLock lock(m_blockchain);
+  }
+
+  m_blockchain.m_blockchain_lock.lock_shared();
+}
+
+Blockchain::ReadLock::~ReadLock() {
+  m_blockchain.m_blockchain_lock.unlock_shared();
+}
+
+Blockchain::WriteLock::WriteLock(Blockchain& blockchain) : m_blockchain(blockchain) {
+  bool outermost = !m_blockchain.m_blockchain_lock.ownedByCurrentThread();
+  m_blockchain.m_blockchain_lock.lock();
+  if (outermost) {
+    m_blockchain.m_blocks.releaseRetired();
+  }
+}
+
+Blockchain::WriteLock::~WriteLock() {
+  m_blockchain.m_blockchain_lock.unlock();
 }
 
 bool Blockchain::addObserver(IBlockchainStorageObserver* observer) {
@@ -324,11 +516,11 @@ bool Blockchain::removeObserver(IBlockchainStorageObserver* observer) {
   return m_observerManager.remove(observer);
 }
 
-bool Blockchain::checkTransactionInputs(const CryptoNote::Transaction& tx, BlockInfo& maxUsedBlock) {
+bool Blockchain::checkTransactionInputs(const CryptoNote::CachedTransaction& tx, BlockInfo& maxUsedBlock) {
   return checkTransactionInputs(tx, maxUsedBlock.height, maxUsedBlock.id);
 }
 
-bool Blockchain::checkTransactionInputs(const CryptoNote::Transaction& tx, BlockInfo& maxUsedBlock, BlockInfo& lastFailed) {
+bool Blockchain::checkTransactionInputs(const CryptoNote::CachedTransaction& tx, BlockInfo& maxUsedBlock, BlockInfo& lastFailed) {
 
   BlockInfo tail;
 
@@ -401,22 +593,71 @@ bool Blockchain::checkTransactionExtraSize(size_t txExtraSize)
 }
 
 bool Blockchain::haveTransaction(const Crypto::Hash &id) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
-  return m_transactionMap.find(id) != m_transactionMap.end();
+  ReadLock lk(*this);
+  return m_transactionMap.contains(id);
 }
 
 bool Blockchain::have_tx_keyimg_as_spent(const Crypto::KeyImage &key_im) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  // most key images looked up aren't spent, the filter tells so without the lock
+  if (!m_spentKeysFilter.load(std::memory_order_acquire)->mayContain(key_im)) {
+    return false;
+  }
+
+  ReadLock lk(*this);
   return  m_spent_keys.find(key_im) != m_spent_keys.end();
 }
 
+/**
+* \pre m_blockchain_lock is locked exclusively
+*/
+bool Blockchain::insertSpentKey(const Crypto::KeyImage& keyImage) {
+  if (!m_spent_keys.insert(keyImage).second) {
+    return false;
+  }
+
+  if (m_spent_keys.size() + m_staleSpentKeys > m_spentKeysFilters.back()->capacity()) {
+    rebuildSpentKeysFilter();
+  } else {
+    m_spentKeysFilters.back()->add(keyImage);
+  }
+
+  return true;
+}
+
+/**
+* \pre m_blockchain_lock is locked exclusively
+*/
+bool Blockchain::eraseSpentKey(const Crypto::KeyImage& keyImage) {
+  if (m_spent_keys.erase(keyImage) == 0) {
+    return false;
+  }
+
+  ++m_staleSpentKeys;
+  return true;
+}
+
+/**
+* \pre m_blockchain_lock is locked exclusively
+*/
+void Blockchain::rebuildSpentKeysFilter() {
+  // room to grow to twice the key images before the next rebuild
+  std::unique_ptr<KeyImageFilter> filter(new KeyImageFilter(std::max(SPENT_KEYS_FILTER_MIN_CAPACITY, 2 * m_spent_keys.size()), Crypto::rand<uint64_t>()));
+  for (const Crypto::KeyImage& keyImage : m_spent_keys) {
+    filter->add(keyImage);
+  }
+
+  m_spentKeysFilter.store(filter.get(), std::memory_order_release);
+  m_spentKeysFilters.push_back(std::move(filter));
+  m_staleSpentKeys = 0;
+}
+
 uint32_t Blockchain::getCurrentBlockchainHeight() {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  ReadLock lk(*this);
   return static_cast<uint32_t>(m_blocks.size());
 }
 
 bool Blockchain::init(const std::string& config_folder, bool load_existing) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  WriteLock lk(*this);
   if (!config_folder.empty() && !Tools::create_directories_if_necessary(config_folder)) {
     logger(ERROR, BRIGHT_RED) << "Failed to create data directory: " << m_config_folder;
     return false;
@@ -424,18 +665,23 @@ bool Blockchain::init(const std::string& config_folder, bool load_existing) {
 
   m_config_folder = config_folder;
 
-  if (!m_blocks.open(appendPath(config_folder, m_currency.blocksFileName()), appendPath(config_folder, m_currency.blockIndexesFileName()), 1024)) {
+  if (!m_blocks.open(appendPath(config_folder, m_currency.blockStoreFileName()), appendPath(config_folder, m_currency.blockStoreIndexesFileName()), m_blocksCacheSize)) {
+    logger(ERROR, BRIGHT_RED) << "Failed to open block store in " << config_folder;
+    return false;
+  }
+
+  if (load_existing && m_blocks.empty() && !importBlocks(appendPath(config_folder, m_currency.blocksFileName()), appendPath(config_folder, m_currency.blockIndexesFileName()))) {
     return false;
   }
 
   if (load_existing && !m_blocks.empty()) {
     logger(INFO, BRIGHT_WHITE) << "Loading blockchain...";
-    BlockCacheSerializer loader(*this, get_block_hash(m_blocks.back().bl), logger.getLogger());
-    loader.load(appendPath(config_folder, m_currency.blocksCacheFileName()));
-
-    if (!loader.loaded()) {
+    if (!loadCache()) {
       logger(WARNING, BRIGHT_YELLOW) << "No actual blockchain cache found, rebuilding internal structures...";
-      rebuildCache();
+      if (!rebuildCache()) {
+        logger(ERROR, BRIGHT_RED) << "Failed to rebuild internal structures, the data directory " << config_folder << " has to be synchronized again";
+        return false;
+      }
     }
 
     loadBlockchainIndexes();
@@ -465,6 +711,10 @@ bool Blockchain::init(const std::string& config_folder, bool load_existing) {
 
   // removed hard fork 1 if clause here
 
+  if (!m_cacheJournal.is_open() && !storeCache()) {
+    return false;
+  }
+
   uint64_t timestamp_diff = time(NULL) - m_blocks.back().bl.timestamp;
   if (!m_blocks.back().bl.timestamp) {
     timestamp_diff = time(NULL) - 1341378000;
@@ -477,82 +727,492 @@ bool Blockchain::init(const std::string& config_folder, bool load_existing) {
   return true;
 }
 
-void Blockchain::rebuildCache() {
+bool Blockchain::rebuildCache() {
   std::chrono::steady_clock::time_point timePoint = std::chrono::steady_clock::now();
   m_blockIndex.clear();
   m_transactionMap.clear();
   m_spent_keys.clear();
   m_outputs.clear();
+  m_keyOutputs.clear();
   m_multisignatureOutputs.clear();
-  for (uint32_t b = 0; b < m_blocks.size(); ++b) {
-    if (b % 1000 == 0) {
-      logger(INFO, BRIGHT_WHITE) << "Height " << b << " of " << m_blocks.size();
-    }
-    const BlockEntry& block = m_blocks[b];
-    Crypto::Hash blockHash = get_block_hash(block.bl);
-    m_blockIndex.push(blockHash);
-    for (uint16_t t = 0; t < block.transactions.size(); ++t) {
-      const TransactionEntry& transaction = block.transactions[t];
-      Crypto::Hash transactionHash = getObjectHash(transaction.tx);
-      TransactionIndex transactionIndex = { b, t };
-      m_transactionMap.insert(std::make_pair(transactionHash, transactionIndex));
-
-      // process inputs
-      for (auto& i : transaction.tx.inputs) {
-        if (i.type() == typeid(KeyInput)) {
-          m_spent_keys.insert(::boost::get<KeyInput>(i).keyImage);
-        } else if (i.type() == typeid(MultisignatureInput)) {
-          auto out = ::boost::get<MultisignatureInput>(i);
-          m_multisignatureOutputs[out.amount][out.outputIndex].isUsed = true;
+
+  struct PreparedBlock {
+    BlockEntry block;
+    Crypto::Hash hash;
+    std::vector<Crypto::Hash> transactionHashes;
+  };
+
+  // Workers deserialize and hash batches of blocks, the indexes are filled here in height order.
+  // At most two batches per worker are waiting to be merged at any time.
+  const uint32_t blockCount = static_cast<uint32_t>(m_blocks.size());
+  const uint32_t batchCount = (blockCount + REBUILD_CACHE_BATCH_SIZE - 1) / REBUILD_CACHE_BATCH_SIZE;
+  const uint32_t threadCount = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<std::vector<PreparedBlock>> batches(batchCount);
+  std::vector<bool> batchPrepared(batchCount, false);
+  uint32_t nextBatch = 0;
+  uint32_t mergedBatches = 0;
+  bool stop = false;
+  std::exception_ptr error;
+  std::mutex mutex;
+  std::condition_variable preparedCondition;
+  std::condition_variable mergedCondition;
+
+  auto worker = [&] {
+    for (;;) {
+      uint32_t batch;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        mergedCondition.wait(lock, [&] { return stop || nextBatch == batchCount || nextBatch < mergedBatches + 2 * threadCount; });
+        if (stop || nextBatch == batchCount) {
+          return;
+        }
+
+        batch = nextBatch++;
+      }
+
+      std::vector<PreparedBlock> prepared;
+      try {
+        uint32_t height = batch * REBUILD_CACHE_BATCH_SIZE;
+        prepared.resize(std::min(REBUILD_CACHE_BATCH_SIZE, blockCount - height));
+        for (PreparedBlock& preparedBlock : prepared) {
+          m_blocks.load(height++, preparedBlock.block);
+          CachedBlock cachedBlock(preparedBlock.block.bl);
+          preparedBlock.hash = cachedBlock.getBlockHash();
+          preparedBlock.transactionHashes.push_back(cachedBlock.getBaseTransaction().getTransactionHash());
+          // the rest were checked against the merkle root when the block was pushed
+          preparedBlock.transactionHashes.insert(preparedBlock.transactionHashes.end(),
+            preparedBlock.block.bl.transactionHashes.begin(), preparedBlock.block.bl.transactionHashes.end());
         }
+      } catch (...) {
+        std::unique_lock<std::mutex> lock(mutex);
+        error = std::current_exception();
+        preparedCondition.notify_all();
+        return;
+      }
+
+      std::unique_lock<std::mutex> lock(mutex);
+      batches[batch].swap(prepared);
+      batchPrepared[batch] = true;
+      preparedCondition.notify_all();
+    }
+  };
+
+  std::vector<std::thread> workers;
+  Tools::ScopeExit joinWorkers([&] {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      stop = true;
+      mergedCondition.notify_all();
+    }
+
+    for (auto& thread : workers) {
+      thread.join();
+    }
+  });
+
+  for (uint32_t i = 0; i < threadCount; ++i) {
+    workers.emplace_back(worker);
+  }
+
+  uint32_t b = 0;
+  for (uint32_t batch = 0; batch < batchCount; ++batch) {
+    std::vector<PreparedBlock> prepared;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      preparedCondition.wait(lock, [&] { return batchPrepared[batch] || error; });
+      if (error) {
+        std::rethrow_exception(error);
       }
 
-      // process outputs
-      for (uint16_t o = 0; o < transaction.tx.outputs.size(); ++o) {
-        const auto& out = transaction.tx.outputs[o];
-        if (out.target.type() == typeid(KeyOutput)) {
-          m_outputs[out.amount].push_back(std::make_pair<>(transactionIndex, o));
-        } else if (out.target.type() == typeid(MultisignatureOutput)) {
-          MultisignatureOutputUsage usage = { transactionIndex, o, false };
-          m_multisignatureOutputs[out.amount].push_back(usage);
+      prepared.swap(batches[batch]);
+      ++mergedBatches;
+      mergedCondition.notify_all();
+    }
+
+    for (const PreparedBlock& preparedBlock : prepared) {
+      if (!m_checkpoints.check_block(b, preparedBlock.hash)) {
+        logger(ERROR, BRIGHT_RED) << "Stored block " << b << " doesn't match the checkpoint";
+        return false;
+      }
+
+      const BlockEntry& block = preparedBlock.block;
+      m_blockIndex.push(preparedBlock.hash);
+      for (uint16_t t = 0; t < block.transactions.size(); ++t) {
+        const TransactionEntry& transaction = block.transactions[t];
+        TransactionIndex transactionIndex = { b, t };
+        m_transactionMap.insert(preparedBlock.transactionHashes[t], transactionIndex);
+
+        // process inputs
+        for (auto& i : transaction.tx.inputs) {
+          if (i.type() == typeid(KeyInput)) {
+            m_spent_keys.insert(::boost::get<KeyInput>(i).keyImage);
+          } else if (i.type() == typeid(MultisignatureInput)) {
+            auto out = ::boost::get<MultisignatureInput>(i);
+            m_multisignatureOutputs[out.amount][out.outputIndex].isUsed = true;
+          }
+        }
+
+        // process outputs
+        for (uint16_t o = 0; o < transaction.tx.outputs.size(); ++o) {
+          const auto& out = transaction.tx.outputs[o];
+          if (out.target.type() == typeid(KeyOutput)) {
+            OutputReference reference = { b, t, o };
+            m_outputs[out.amount].push_back(reference);
+            KeyOutputEntry entry = { ::boost::get<KeyOutput>(out.target).key, transaction.tx.unlockTime };
+            m_keyOutputs[out.amount].push_back(entry);
+          } else if (out.target.type() == typeid(MultisignatureOutput)) {
+            MultisignatureOutputUsage usage = { transactionIndex, o, false };
+            m_multisignatureOutputs[out.amount].push_back(usage);
+          }
         }
       }
+
+      ++b;
+    }
+
+    if (batch % 10 == 9) {
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - timePoint;
+      logger(INFO, BRIGHT_WHITE) << "Height " << b << " of " << blockCount << ", " << static_cast<uint64_t>(b / elapsed.count()) << " blocks/s";
     }
   }
 
   std::chrono::duration<double> duration = std::chrono::steady_clock::now() - timePoint;
-  logger(INFO, BRIGHT_WHITE) << "Rebuilding internal structures took: " << duration.count();
+  logger(INFO, BRIGHT_WHITE) << "Rebuilding internal structures took: " << duration.count() << " sec, " <<
+    static_cast<uint64_t>(blockCount / duration.count()) << " blocks/s using " << threadCount << " threads";
+  rebuildSpentKeysFilter();
+  return true;
+}
+
+// Copies the blocks of a data directory written before the block store was introduced.
+// The old files are left in place.
+bool Blockchain::importBlocks(const std::string& blocksFileName, const std::string& indexesFileName) {
+  if (!std::ifstream(blocksFileName) || !std::ifstream(indexesFileName)) {
+    return true;
+  }
+
+  SwappedVector<BlockEntry> blocks;
+  if (!blocks.open(blocksFileName, indexesFileName, 1)) {
+    logger(ERROR, BRIGHT_RED) << "Failed to open " << blocksFileName;
+    return false;
+  }
+
+  logger(INFO, BRIGHT_WHITE) << "Importing " << blocks.size() << " blocks from " << blocksFileName << "...";
+  for (uint64_t i = 0; i < blocks.size(); ++i) {
+    if (i % 10000 == 0) {
+      logger(INFO, BRIGHT_WHITE) << "Height " << i << " of " << blocks.size();
+    }
+
+    m_blocks.push_back(blocks[i]);
+    blocks.releaseRetired();
+    m_blocks.releaseRetired();
+  }
+
+  return true;
 }
 
+// Writes a snapshot of the indexes and starts a new cache journal on top of it. The snapshot replaces the old one only
+// once it is complete, so a crash leaves either the old snapshot with its journal or the new one.
 bool Blockchain::storeCache() {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  WriteLock lk(*this);
 
   logger(INFO, BRIGHT_WHITE) << "Saving blockchain...";
+  std::string fileName = appendPath(m_config_folder, m_currency.blocksCacheFileName());
   BlockCacheSerializer ser(*this, getTailId(), logger.getLogger());
-  if (!ser.save(appendPath(m_config_folder, m_currency.blocksCacheFileName()))) {
+  if (!ser.save(fileName + ".tmp")) {
     logger(ERROR, BRIGHT_RED) << "Failed to save blockchain cache";
     return false;
   }
 
+  boost::system::error_code ec;
+  boost::filesystem::rename(fileName + ".tmp", fileName, ec);
+  if (ec) {
+    logger(ERROR, BRIGHT_RED) << "Failed to save blockchain cache: " << ec.message();
+    return false;
+  }
+
+  return resetCacheJournal(getTailId());
+}
+
+// Loads the last snapshot, replays the cache journal written since and adds the stored blocks the journal misses.
+// Takes time proportional to the journal length, unless the snapshot doesn't match the stored chain at all.
+bool Blockchain::loadCache() {
+  BlockCacheSerializer loader(*this, NULL_HASH, logger.getLogger());
+  loader.load(appendPath(m_config_folder, m_currency.blocksCacheFileName()));
+  if (!loader.loaded()) {
+    return false;
+  }
+
+  rebuildSpentKeysFilter();
+  std::string journalFileName = appendPath(m_config_folder, m_currency.blocksCacheJournalFileName());
+  uint32_t replayedBlocks = 0;
+  uint64_t journalSize = replayCacheJournal(journalFileName, loader.lastBlockHash(), replayedBlocks);
+
+  uint32_t height = m_blockIndex.size();
+  if (height > m_blocks.size() || (height != 0 && m_blockIndex.getTailId() != get_block_hash(m_blocks[height - 1].bl))) {
+    logger(WARNING, BRIGHT_YELLOW) << "Blockchain cache doesn't match the stored blocks";
+    return false;
+  }
+
+  if (journalSize == 0) {
+    if (!resetCacheJournal(loader.lastBlockHash())) {
+      return false;
+    }
+  } else {
+    boost::system::error_code ec;
+    boost::filesystem::resize_file(journalFileName, journalSize, ec);
+    m_cacheJournal.open(journalFileName, std::ios::out | std::ios::binary | std::ios::app);
+    if (ec || !m_cacheJournal) {
+      logger(ERROR, BRIGHT_RED) << "Failed to open blockchain cache journal " << journalFileName;
+      m_cacheJournal.close();
+      return false;
+    }
+
+    m_cacheJournalLength = replayedBlocks;
+  }
+
+  uint32_t missingBlocks = static_cast<uint32_t>(m_blocks.size()) - height;
+  for (; height < m_blocks.size(); ++height) {
+    const BlockEntry& block = m_blocks[height];
+    CachedBlock cachedBlock(block.bl);
+    BlockCacheDelta delta = makeCacheDelta(true, height, block, cachedBlock.getBlockHash(), cachedBlock.getBaseTransaction().getTransactionHash());
+    applyCacheDelta(delta);
+    journalBlock(delta);
+  }
+
+  logger(INFO, BRIGHT_WHITE) << "Replayed " << replayedBlocks << " blocks from the cache journal, " << missingBlocks << " blocks from the block store";
+  return true;
+}
+
+// Applies the records of the journal written on top of the snapshot ending at snapshotTailId, as long as they are
+// complete and fit the indexes. Returns the size of the part applied, 0 if the journal belongs to another snapshot.
+uint64_t Blockchain::replayCacheJournal(const std::string& fileName, const Crypto::Hash& snapshotTailId, uint32_t& replayedBlocks) {
+  std::ifstream file(fileName, std::ios::binary);
+  if (!file) {
+    return 0;
+  }
+
+  uint8_t version;
+  Crypto::Hash tailId;
+  file.read(reinterpret_cast<char*>(&version), sizeof version);
+  file.read(reinterpret_cast<char*>(&tailId), sizeof tailId);
+  if (!file || version != CURRENT_BLOCKCACHE_JOURNAL_VER || tailId != snapshotTailId) {
+    return 0;
+  }
+
+  uint64_t journalSize = file.tellg();
+  file.seekg(0, std::ios::end);
+  uint64_t fileSize = file.tellg();
+  file.seekg(journalSize);
+
+  for (;;) {
+    uint32_t recordSize;
+    Crypto::Hash checksum;
+    file.read(reinterpret_cast<char*>(&recordSize), sizeof recordSize);
+    file.read(reinterpret_cast<char*>(&checksum), sizeof checksum);
+    if (!file || recordSize > fileSize - journalSize) {
+      break;
+    }
+
+    std::vector<uint8_t> record(recordSize);
+    file.read(reinterpret_cast<char*>(record.data()), record.size());
+    if (!file || Crypto::cn_fast_hash(record.data(), record.size()) != checksum) {
+      break;
+    }
+
+    BlockCacheDelta delta;
+    try {
+      MemoryInputStream stream(record.data(), record.size());
+      BinaryInputStreamSerializer s(stream);
+      CryptoNote::serialize(delta, s);
+    } catch (std::exception&) {
+      break;
+    }
+
+    if (delta.pushed && delta.height == m_blockIndex.size()) {
+      applyCacheDelta(delta);
+    } else if (!delta.pushed && delta.height + 1 == m_blockIndex.size() && delta.hash == m_blockIndex.getTailId()) {
+      revertCacheDelta(delta);
+    } else {
+      logger(WARNING, BRIGHT_YELLOW) << "Blockchain cache journal record for height " << delta.height << " doesn't fit, ignoring the rest of the journal";
+      break;
+    }
+
+    journalSize = file.tellg();
+    ++replayedBlocks;
+  }
+
+  return journalSize;
+}
+
+bool Blockchain::resetCacheJournal(const Crypto::Hash& snapshotTailId) {
+  std::string fileName = appendPath(m_config_folder, m_currency.blocksCacheJournalFileName());
+  m_cacheJournal.close();
+  m_cacheJournal.clear();
+  m_cacheJournal.open(fileName, std::ios::out | std::ios::binary | std::ios::trunc);
+
+  uint8_t version = CURRENT_BLOCKCACHE_JOURNAL_VER;
+  m_cacheJournal.write(reinterpret_cast<const char*>(&version), sizeof version);
+  m_cacheJournal.write(reinterpret_cast<const char*>(&snapshotTailId), sizeof snapshotTailId);
+  m_cacheJournal.flush();
+  if (!m_cacheJournal) {
+    logger(ERROR, BRIGHT_RED) << "Failed to create blockchain cache journal " << fileName;
+    m_cacheJournal.close();
+    return false;
+  }
+
+  m_cacheJournalLength = 0;
   return true;
 }
 
+void Blockchain::journalBlock(const BlockCacheDelta& delta) {
+  if (!m_cacheJournal.is_open()) {
+    return;
+  }
+
+  BinaryArray record = toBinaryArray(delta);
+  uint32_t recordSize = static_cast<uint32_t>(record.size());
+  Crypto::Hash checksum = Crypto::cn_fast_hash(record.data(), record.size());
+  m_cacheJournal.write(reinterpret_cast<const char*>(&recordSize), sizeof recordSize);
+  m_cacheJournal.write(reinterpret_cast<const char*>(&checksum), sizeof checksum);
+  m_cacheJournal.write(reinterpret_cast<const char*>(record.data()), record.size());
+  m_cacheJournal.flush();
+  if (!m_cacheJournal) {
+    // deinit() saves a full snapshot instead
+    logger(ERROR, BRIGHT_RED) << "Failed to write blockchain cache journal";
+    m_cacheJournal.close();
+    return;
+  }
+
+  ++m_cacheJournalLength;
+}
+
+Blockchain::BlockCacheDelta Blockchain::makeCacheDelta(bool pushed, uint32_t height, const BlockEntry& block, const Crypto::Hash& blockHash, const Crypto::Hash& baseTransactionHash) {
+  BlockCacheDelta delta;
+  delta.pushed = pushed;
+  delta.height = height;
+  delta.hash = blockHash;
+  delta.transactions.resize(block.transactions.size());
+  for (size_t t = 0; t < block.transactions.size(); ++t) {
+    const Transaction& transaction = block.transactions[t].tx;
+    TransactionCacheDelta& transactionDelta = delta.transactions[t];
+    transactionDelta.hash = t == 0 ? baseTransactionHash : block.bl.transactionHashes[t - 1];
+
+    for (const auto& input : transaction.inputs) {
+      if (input.type() == typeid(KeyInput)) {
+        transactionDelta.keyImages.push_back(::boost::get<KeyInput>(input).keyImage);
+      } else if (input.type() == typeid(MultisignatureInput)) {
+        transactionDelta.multisignatureInputs.push_back(::boost::get<MultisignatureInput>(input));
+      }
+    }
+
+    for (const auto& output : transaction.outputs) {
+      OutputCacheDelta outputDelta = { output.amount, output.target.type() == typeid(MultisignatureOutput), NULL_PUBLIC_KEY, transaction.unlockTime };
+      if (output.target.type() == typeid(KeyOutput)) {
+        outputDelta.key = ::boost::get<KeyOutput>(output.target).key;
+      }
+
+      transactionDelta.outputs.push_back(outputDelta);
+    }
+  }
+
+  return delta;
+}
+
+// Same changes rebuildCache() makes for a block
+void Blockchain::applyCacheDelta(const BlockCacheDelta& delta) {
+  m_blockIndex.push(delta.hash);
+  for (uint16_t t = 0; t < delta.transactions.size(); ++t) {
+    const TransactionCacheDelta& transaction = delta.transactions[t];
+    TransactionIndex transactionIndex = { delta.height, t };
+    m_transactionMap.insert(transaction.hash, transactionIndex);
+
+    for (const auto& keyImage : transaction.keyImages) {
+      insertSpentKey(keyImage);
+    }
+
+    for (const auto& input : transaction.multisignatureInputs) {
+      m_multisignatureOutputs[input.amount][input.outputIndex].isUsed = true;
+    }
+
+    for (uint16_t o = 0; o < transaction.outputs.size(); ++o) {
+      const OutputCacheDelta& output = transaction.outputs[o];
+      if (output.multisignature) {
+        MultisignatureOutputUsage usage = { transactionIndex, o, false };
+        m_multisignatureOutputs[output.amount].push_back(usage);
+      } else {
+        OutputReference reference = { delta.height, t, o };
+        m_outputs[output.amount].push_back(reference);
+        KeyOutputEntry entry = { output.key, output.unlockTime };
+        m_keyOutputs[output.amount].push_back(entry);
+      }
+    }
+  }
+}
+
+void Blockchain::revertCacheDelta(const BlockCacheDelta& delta) {
+  for (size_t t = delta.transactions.size(); t-- > 0;) {
+    const TransactionCacheDelta& transaction = delta.transactions[t];
+    for (size_t o = transaction.outputs.size(); o-- > 0;) {
+      const OutputCacheDelta& output = transaction.outputs[o];
+      if (output.multisignature) {
+        auto amountOutputs = m_multisignatureOutputs.find(output.amount);
+        amountOutputs->second.pop_back();
+        if (amountOutputs->second.empty()) {
+          m_multisignatureOutputs.erase(amountOutputs);
+        }
+      } else {
+        auto amountOutputs = m_outputs.find(output.amount);
+        amountOutputs->second.pop_back();
+        if (amountOutputs->second.empty()) {
+          m_outputs.erase(amountOutputs);
+        }
+
+        auto amountKeyOutputs = m_keyOutputs.find(output.amount);
+        amountKeyOutputs->second.pop_back();
+        if (amountKeyOutputs->second.empty()) {
+          m_keyOutputs.erase(amountKeyOutputs);
+        }
+      }
+    }
+
+    for (const auto& input : transaction.multisignatureInputs) {
+      m_multisignatureOutputs[input.amount][input.outputIndex].isUsed = false;
+    }
+
+    for (const auto& keyImage : transaction.keyImages) {
+      eraseSpentKey(keyImage);
+    }
+
+    m_transactionMap.erase(transaction.hash);
+  }
+
+  m_blockIndex.pop();
+}
+
 bool Blockchain::deinit() {
-  storeCache();
+  if (m_cacheJournal.is_open()) {
+    m_cacheJournal.close();
+  } else {
+    storeCache();
+  }
+
   storeBlockchainIndexes();
+  logger(INFO) << "Block cache hits: " << m_blocks.cacheHits() << ", misses: " << m_blocks.cacheMisses();
   assert(m_messageQueueList.empty());
   return true;
 }
 
 bool Blockchain::resetAndSetGenesisBlock(const Block& b) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  WriteLock lk(*this);
   m_blocks.clear();
   m_blockIndex.clear();
   m_transactionMap.clear();
 
   m_spent_keys.clear();
+  rebuildSpentKeysFilter();
   m_alternative_chains.clear();
   m_outputs.clear();
+  m_keyOutputs.clear();
 
   m_paymentIdIndex.clear();
   m_timestampIndex.clear();
@@ -561,29 +1221,33 @@ bool Blockchain::resetAndSetGenesisBlock(const Block& b) {
 
   block_verification_context bvc = boost::value_initialized<block_verification_context>();
   addNewBlock(b, bvc);
+  if (m_cacheJournal.is_open()) {
+    storeCache();
+  }
+
   return bvc.m_added_to_main_chain && !bvc.m_verification_failed;
 }
 
 Crypto::Hash Blockchain::getTailId(uint32_t& height) {
   assert(!m_blocks.empty());
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  ReadLock lk(*this);
   height = getCurrentBlockchainHeight() - 1;
   return getTailId();
 }
 
 Crypto::Hash Blockchain::getTailId() {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  ReadLock lk(*this);
   return m_blocks.empty() ? NULL_HASH : m_blockIndex.getTailId();
 }
 
 std::vector<Crypto::Hash> Blockchain::buildSparseChain() {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  ReadLock lk(*this);
   assert(m_blockIndex.size() != 0);
   return doBuildSparseChain(m_blockIndex.getTailId());
 }
 
 std::vector<Crypto::Hash> Blockchain::buildSparseChain(const Crypto::Hash& startBlockId) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  ReadLock lk(*this);
   assert(haveBlock(startBlockId));
   return doBuildSparseChain(startBlockId);
 }
@@ -620,13 +1284,13 @@ std::vector<Crypto::Hash> Blockchain::doBuildSparseChain(const Crypto::Hash& sta
 }
 
 Crypto::Hash Blockchain::getBlockIdByHeight(uint32_t height) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  ReadLock lk(*this);
   assert(height < m_blockIndex.size());
   return m_blockIndex.getBlockId(height);
 }
 
 bool Blockchain::getBlockByHash(const Crypto::Hash& blockHash, Block& b) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  ReadLock lk(*this);
 
   uint32_t height = 0;
 
@@ -647,12 +1311,12 @@ bool Blockchain::getBlockByHash(const Crypto::Hash& blockHash, Block& b) {
 }
 
 bool Blockchain::getBlockHeight(const Crypto::Hash& blockId, uint32_t& blockHeight) {
-  std::lock_guard<decltype(m_blockchain_lock)> lock(m_blockchain_lock);
+  ReadLock lock(*this);
   return m_blockIndex.getBlockHeight(blockId, blockHeight);
 }
 
 difficulty_type Blockchain::getDifficultyForNextBlock() {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  ReadLock lk(*this);
   std::vector<uint64_t> timestamps;
   std::vector<difficulty_type> cummulative_difficulties;
   size_t offset = m_blocks.size() - std::min(m_blocks.size(), static_cast<uint64_t>(m_currency.difficultyBlocksCount()));
@@ -687,7 +1351,7 @@ uint64_t Blockchain::getMinimalFee(uint32_t height)
 }
 
 uint64_t Blockchain::getCoinsInCirculation() {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  ReadLock lk(*this);
   if (m_blocks.empty()) {
     return 0;
   } else {
@@ -696,10 +1360,10 @@ uint64_t Blockchain::getCoinsInCirculation() {
 }
 
 bool Blockchain::rollback_blockchain_switching(std::list<Block> &original_chain, size_t rollback_height) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  WriteLock lk(*this);
   // remove failed subchain
   for (size_t i = m_blocks.size() - 1; i >= rollback_height; i--) {
-    popBlock(get_block_hash(m_blocks.back().bl));
+    popBlock(m_blockIndex.getTailId());
   }
 
   // return back original chain
@@ -719,7 +1383,7 @@ bool Blockchain::rollback_blockchain_switching(std::list<Block> &original_chain,
 }
 
 bool Blockchain::switch_to_alternative_blockchain(std::list<blocks_ext_by_hash::iterator>& alt_chain, bool discard_disconnected_chain) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  WriteLock lk(*this);
 
   if (!(alt_chain.size())) {
     logger(ERROR, BRIGHT_RED) << "switch_to_alternative_blockchain: empty chain passed";
@@ -737,7 +1401,7 @@ bool Blockchain::switch_to_alternative_blockchain(std::list<blocks_ext_by_hash::
   std::list<Block> disconnected_chain;
   for (size_t i = m_blocks.size() - 1; i >= split_height; i--) {
     Block b = m_blocks[i].bl;
-    popBlock(get_block_hash(b));
+    popBlock(m_blockIndex.getTailId());
     //if (!(r)) { logger(ERROR, BRIGHT_RED) << "failed to remove block on chain switching"; return false; }
     disconnected_chain.push_front(b);
   }
@@ -800,7 +1464,7 @@ difficulty_type Blockchain::get_next_difficulty_for_alternative_chain(const std:
   std::vector<uint64_t> timestamps;
   std::vector<difficulty_type> cummulative_difficulties;
   if (alt_chain.size() < m_currency.difficultyBlocksCount()) {
-    std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+    ReadLock lk(*this);
     size_t main_chain_stop_offset = alt_chain.size() ? alt_chain.front()->second.height : bei.height;
     size_t main_chain_count = m_currency.difficultyBlocksCount() - std::min(m_currency.difficultyBlocksCount(), alt_chain.size());
     main_chain_count = std::min(main_chain_count, main_chain_stop_offset);
@@ -937,7 +1601,7 @@ bool Blockchain::validate_miner_transaction(const Block& b, uint32_t height, siz
 }
 
 bool Blockchain::getBackwardBlocksSize(size_t from_height, std::vector<size_t>& sz, size_t count) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  ReadLock lk(*this);
   if (!(from_height < m_blocks.size())) {
     logger(ERROR, BRIGHT_RED)
       << "Internal error: get_backward_blocks_sizes called with from_height="
@@ -953,7 +1617,7 @@ bool Blockchain::getBackwardBlocksSize(size_t from_height, std::vector<size_t>&
 }
 
 bool Blockchain::get_last_n_blocks_sizes(std::vector<size_t>& sz, size_t count) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  ReadLock lk(*this);
   if (!m_blocks.size()) {
     return true;
   }
@@ -969,7 +1633,7 @@ bool Blockchain::complete_timestamps_vector(uint64_t start_top_height, std::vect
   if (timestamps.size() >= m_currency.timestampCheckWindow())
     return true;
 
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  ReadLock lk(*this);
   size_t need_elements = m_currency.timestampCheckWindow() - timestamps.size();
   if (!(start_top_height < m_blocks.size())) { logger(ERROR, BRIGHT_RED) << "internal error: passed start_height = " << start_top_height << " not less then m_blocks.size()=" << m_blocks.size(); return false; }
   size_t stop_offset = start_top_height > need_elements ? start_top_height - need_elements : 0;
@@ -983,7 +1647,7 @@ bool Blockchain::complete_timestamps_vector(uint64_t start_top_height, std::vect
 }
 
 bool Blockchain::handle_alternative_block(const Block& b, const Crypto::Hash& id, block_verification_context& bvc, bool sendNewAlternativeBlockMessage) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  WriteLock lk(*this);
 
   auto block_height = get_block_height(b);
   if (block_height == 0) {
@@ -1189,7 +1853,7 @@ bool Blockchain::handle_alternative_block(const Block& b, const Crypto::Hash& id
 }
 
 bool Blockchain::getBlocks(uint32_t start_offset, uint32_t count, std::list<Block>& blocks, std::list<Transaction>& txs) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  ReadLock lk(*this);
   if (start_offset >= m_blocks.size())
     return false;
   for (size_t i = start_offset; i < start_offset + count && i < m_blocks.size(); i++) {
@@ -1203,7 +1867,7 @@ bool Blockchain::getBlocks(uint32_t start_offset, uint32_t count, std::list<Bloc
 }
 
 bool Blockchain::getBlocks(uint32_t start_offset, uint32_t count, std::list<Block>& blocks) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  ReadLock lk(*this);
   if (start_offset >= m_blocks.size()) {
     return false;
   }
@@ -1215,8 +1879,47 @@ bool Blockchain::getBlocks(uint32_t start_offset, uint32_t count, std::list<Bloc
   return true;
 }
 
+// Splits the stored BlockEntry into the blobs of the block and of its transactions, the coinbase transaction is the
+// first entry and is a part of the block
+bool Blockchain::getRawBlock(uint32_t height, RawBlock& block) {
+  ReadLock lk(*this);
+  if (height >= m_blocks.size()) {
+    return false;
+  }
+
+  block.id = m_blockIndex.getBlockId(height);
+  block.transactions.clear();
+
+  try {
+    BlobReader reader(m_blocks.serialized(height));
+    reader.skip(sizeof(Crypto::Hash) + sizeof(uint64_t)); // prev_id, nonce
+    reader.read(&block.timestamp, sizeof(block.timestamp));
+    reader.skip(sizeof(Crypto::Hash)); // merkle_root
+    skipTransaction(reader);
+    reader.skip(reader.readVarint(), sizeof(Crypto::Hash));
+    block.block = reader.slice(0);
+
+    reader.skipVarints(4); // height, block_cumulative_size, cumulative_difficulty, already_generated_coins
+    uint64_t transactionCount = reader.readVarint();
+    for (uint64_t i = 0; i < transactionCount; ++i) {
+      size_t start = reader.position();
+      skipTransaction(reader);
+      if (i != 0) {
+        block.transactions.push_back(reader.slice(start));
+      }
+
+      reader.skipVarints(reader.readVarint()); // global output indexes
+    }
+  } catch (std::exception& e) {
+    logger(ERROR, BRIGHT_RED) << "Failed to read stored block " << height << ": " << e.what();
+    return false;
+  }
+
+  return true;
+}
+
 bool Blockchain::handleGetObjects(NOTIFY_REQUEST_GET_OBJECTS::request& arg, NOTIFY_RESPONSE_GET_OBJECTS::request& rsp) { //Deprecated. Should be removed with CryptoNoteProtocolHandler.
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  ReadLock lk(*this);
   rsp.current_blockchain_height = getCurrentBlockchainHeight();
   std::list<Block> blocks;
   getBlocks(arg.blocks, blocks, rsp.missed_ids);
@@ -1248,7 +1951,7 @@ bool Blockchain::handleGetObjects(NOTIFY_REQUEST_GET_OBJECTS::request& arg, NOTI
 }
 
 bool Blockchain::getAlternativeBlocks(std::list<Block>& blocks) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  ReadLock lk(*this);
   for (auto& alt_bl : m_alternative_chains) {
     blocks.push_back(alt_bl.second.bl);
   }
@@ -1257,72 +1960,62 @@ bool Blockchain::getAlternativeBlocks(std::list<Block>& blocks) {
 }
 
 uint32_t Blockchain::getAlternativeBlocksCount() {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  ReadLock lk(*this);
   return static_cast<uint32_t>(m_alternative_chains.size());
 }
 
-bool Blockchain::add_out_to_get_random_outs(std::vector<std::pair<TransactionIndex, uint16_t>>& amount_outs, COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount& result_outs, uint64_t amount, size_t i) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
-  const Transaction& tx = transactionByIndex(amount_outs[i].first).tx;
-  if (!(tx.outputs.size() > amount_outs[i].second)) {
-    logger(ERROR, BRIGHT_RED) << "internal error: in global outs index, transaction out index="
-      << amount_outs[i].second << " more than transaction outputs = " << tx.outputs.size() << ", for tx id = " << getObjectHash(tx); return false;
-  }
-  if (!(tx.outputs[amount_outs[i].second].target.type() == typeid(KeyOutput))) { logger(ERROR, BRIGHT_RED) << "unknown tx out type"; return false; }
+void Blockchain::getSpentKeysFilterInfo(size_t& memoryUsage, double& falsePositiveRate) {
+  const KeyImageFilter* filter = m_spentKeysFilter.load(std::memory_order_acquire);
+  memoryUsage = filter->memoryUsage();
+  falsePositiveRate = filter->falsePositiveRate();
+}
 
+bool Blockchain::add_out_to_get_random_outs(const std::vector<KeyOutputEntry>& amount_outs, COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount& result_outs, size_t i) {
   //check if transaction is unlocked
-  if (!is_tx_spendtime_unlocked(tx.unlockTime))
+  if (!is_tx_spendtime_unlocked(amount_outs[i].unlockTime))
     return false;
 
   COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::out_entry& oen = *result_outs.outs.insert(result_outs.outs.end(), COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::out_entry());
   oen.global_amount_index = static_cast<uint32_t>(i);
-  oen.out_key = boost::get<KeyOutput>(tx.outputs[amount_outs[i].second].target).key;
+  oen.out_key = amount_outs[i].key;
   return true;
 }
 
-size_t Blockchain::find_end_of_allowed_index(const std::vector<std::pair<TransactionIndex, uint16_t>>& amount_outs) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
-  if (amount_outs.empty()) {
-    return 0;
-  }
-
+// The outputs of an amount are in block order, so the ones old enough are a prefix
+size_t Blockchain::find_end_of_allowed_index(const std::vector<OutputReference>& amount_outs) {
   uint32_t blockchainHeight = getCurrentBlockchainHeight();
   size_t minedMoneyUnlockWindow = m_currency.getMinedMoneyUnlockWindow(blockchainHeight);
 
-  size_t i = amount_outs.size();
-  do {
-    --i;
-    if (amount_outs[i].first.block + minedMoneyUnlockWindow <= blockchainHeight) {
-      return i + 1;
-    }
-  } while (i != 0);
+  auto end = std::partition_point(amount_outs.begin(), amount_outs.end(), [&](const OutputReference& output) {
+    return output.block + minedMoneyUnlockWindow <= blockchainHeight;
+  });
 
-  return 0;
+  return end - amount_outs.begin();
 }
 
 bool Blockchain::getRandomOutsByAmount(const COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::request& req, COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::response& res) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  ReadLock lk(*this);
 
   for (uint64_t amount : req.amounts) {
     COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount& result_outs = *res.outs.insert(res.outs.end(), COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount());
     result_outs.amount = amount;
-    auto it = m_outputs.find(amount);
-    if (it == m_outputs.end()) {
+    auto it = m_keyOutputs.find(amount);
+    if (it == m_keyOutputs.end()) {
       logger(ERROR, BRIGHT_RED) <<
         "COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS: no outs for amount " << amount;
       continue;//actually this is strange situation, wallet should use some real outs when it lookup for some mix, so, at least one out for this amount should exist
     }
 
-    std::vector<std::pair<TransactionIndex, uint16_t>>& amount_outs = it->second;
+    const std::vector<KeyOutputEntry>& amount_outs = it->second;
     //it is not good idea to use top fresh outs, because it increases possibility of transaction canceling on split
     //lets find upper bound of not fresh outs
-    size_t up_index_limit = find_end_of_allowed_index(amount_outs);
+    size_t up_index_limit = find_end_of_allowed_index(m_outputs.find(amount)->second);
     if (!(up_index_limit <= amount_outs.size())) { logger(ERROR, BRIGHT_RED) << "internal error: find_end_of_allowed_index returned wrong index=" << up_index_limit << ", with amount_outs.size = " << amount_outs.size(); return false; }
 
     if (up_index_limit > 0) {
       ShuffleGenerator<size_t, Crypto::random_engine<size_t>> generator(up_index_limit);
       for (uint64_t j = 0; j < up_index_limit && result_outs.outs.size() < req.outs_count; ++j) {
-        add_out_to_get_random_outs(amount_outs, result_outs, amount, generator());
+        add_out_to_get_random_outs(amount_outs, result_outs, generator());
       }
     }
   }
@@ -1333,7 +2026,7 @@ uint32_t Blockchain::findBlockchainSupplement(const std::vector<Crypto::Hash>& q
   assert(!qblock_ids.empty());
   assert(qblock_ids.back() == m_blockIndex.getBlockId(0));
 
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  ReadLock lk(*this);
   uint32_t blockIndex;
   // assert above guarantees that method returns true
   m_blockIndex.findSupplement(qblock_ids, blockIndex);
@@ -1341,7 +2034,7 @@ uint32_t Blockchain::findBlockchainSupplement(const std::vector<Crypto::Hash>& q
 }
 
 uint64_t Blockchain::blockDifficulty(size_t i) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  ReadLock lk(*this);
   if (!(i < m_blocks.size())) { logger(ERROR, BRIGHT_RED) << "wrong block index i = " << i << " at Blockchain::block_difficulty()"; return false; }
   if (i == 0)
     return m_blocks[i].cumulative_difficulty;
@@ -1351,7 +2044,7 @@ uint64_t Blockchain::blockDifficulty(size_t i) {
 
 void Blockchain::print_blockchain(uint64_t start_index, uint64_t end_index) {
   std::stringstream ss;
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  ReadLock lk(*this);
   if (start_index >= m_blocks.size()) {
     logger(INFO, BRIGHT_WHITE) <<
       "Wrong starter index set: " << start_index << ", expected max index " << m_blocks.size() - 1;
@@ -1371,7 +2064,7 @@ void Blockchain::print_blockchain(uint64_t start_index, uint64_t end_index) {
 
 void Blockchain::print_blockchain_index() {
   std::stringstream ss;
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  ReadLock lk(*this);
 
   std::vector<Crypto::Hash> blockIds = m_blockIndex.getBlockIds(0, std::numeric_limits<uint32_t>::max());
   logger(INFO, BRIGHT_WHITE) << "Current blockchain index:";
@@ -1385,13 +2078,13 @@ void Blockchain::print_blockchain_index() {
 
 void Blockchain::print_blockchain_outs(const std::string& file) {
   std::stringstream ss;
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  ReadLock lk(*this);
   for (const outputs_container::value_type& v : m_outputs) {
-    const std::vector<std::pair<TransactionIndex, uint16_t>>& vals = v.second;
+    const std::vector<OutputReference>& vals = v.second;
     if (!vals.empty()) {
       ss << "amount: " << v.first << ENDL;
       for (size_t i = 0; i != vals.size(); i++) {
-        ss << "\t" << getObjectHash(transactionByIndex(vals[i].first).tx) << ": " << vals[i].second << ENDL;
+        ss << "\t" << getObjectHash(transactionByIndex(vals[i].transactionIndex()).tx) << ": " << vals[i].output << ENDL;
       }
     }
   }
@@ -1411,7 +2104,7 @@ std::vector<Crypto::Hash> Blockchain::findBlockchainSupplement(const std::vector
   assert(!remoteBlockIds.empty());
   assert(remoteBlockIds.back() == m_blockIndex.getBlockId(0));
 
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  ReadLock lk(*this);
   totalBlockCount = getCurrentBlockchainHeight();
   startBlockIndex = findBlockchainSupplement(remoteBlockIds);
 
@@ -1419,7 +2112,7 @@ std::vector<Crypto::Hash> Blockchain::findBlockchainSupplement(const std::vector
 }
 
 bool Blockchain::haveBlock(const Crypto::Hash& id) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  ReadLock lk(*this);
   if (m_blockIndex.hasBlock(id))
     return true;
 
@@ -1430,19 +2123,19 @@ bool Blockchain::haveBlock(const Crypto::Hash& id) {
 }
 
 size_t Blockchain::getTotalTransactions() {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  ReadLock lk(*this);
   return m_transactionMap.size();
 }
 
 bool Blockchain::getTransactionOutputGlobalIndexes(const Crypto::Hash& tx_id, std::vector<uint32_t>& indexes) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
-  auto it = m_transactionMap.find(tx_id);
-  if (it == m_transactionMap.end()) {
+  ReadLock lk(*this);
+  const TransactionIndex* transactionIndex = m_transactionMap.find(tx_id);
+  if (transactionIndex == nullptr) {
     logger(WARNING, YELLOW) << "warning: get_tx_outputs_gindexes failed to find transaction with id = " << tx_id;
     return false;
   }
 
-  const TransactionEntry& tx = transactionByIndex(it->second);
+  const TransactionEntry& tx = transactionByIndex(*transactionIndex);
   if (!(tx.m_global_output_indexes.size())) { logger(ERROR, BRIGHT_RED) << "internal error: global indexes for transaction " << tx_id << " is empty"; return false; }
   indexes.resize(tx.m_global_output_indexes.size());
   for (size_t i = 0; i < tx.m_global_output_indexes.size(); ++i) {
@@ -1453,7 +2146,7 @@ bool Blockchain::getTransactionOutputGlobalIndexes(const Crypto::Hash& tx_id, st
 }
 
 bool Blockchain::get_out_by_msig_gindex(uint64_t amount, uint64_t gindex, MultisignatureOutput& out) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  ReadLock lk(*this);
   auto it = m_multisignatureOutputs.find(amount);
   if (it == m_multisignatureOutputs.end()) {
     return false;
@@ -1475,19 +2168,92 @@ bool Blockchain::get_out_by_msig_gindex(uint64_t amount, uint64_t gindex, Multis
 
 
 
-bool Blockchain::checkTransactionInputs(const Transaction& tx, uint32_t& max_used_block_height, Crypto::Hash& max_used_block_id, BlockInfo* tail) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+bool Blockchain::checkTransactionInputs(const CachedTransaction& tx, uint32_t& max_used_block_height, Crypto::Hash& max_used_block_id, BlockInfo* tail) {
+  const Crypto::Hash& transactionHash = tx.getTransactionHash();
+  std::vector<RingSignatureCheck> ringSignatureChecks;
+
+  {
+    ReadLock lk(*this);
+
+    if (tail)
+      tail->id = getTailId(tail->height);
 
-  if (tail)
-    tail->id = getTailId(tail->height);
+    bool res = checkTransactionInputs(tx, &max_used_block_height, &ringSignatureChecks);
+    if (!res) return false;
+    if (!(max_used_block_height < m_blocks.size())) { logger(ERROR, BRIGHT_RED) << "internal error: max used block index=" << max_used_block_height << " is not less then blockchain size = " << m_blocks.size(); return false; }
+    max_used_block_id = m_blockIndex.getBlockId(max_used_block_height);
 
-  bool res = checkTransactionInputs(tx, &max_used_block_height);
-  if (!res) return false;
-  if (!(max_used_block_height < m_blocks.size())) { logger(ERROR, BRIGHT_RED) << "internal error: max used block index=" << max_used_block_height << " is not less then blockchain size = " << m_blocks.size(); return false; }
-  get_block_hash(m_blocks[max_used_block_height].bl, max_used_block_id);
+    if (isTransactionVerified(transactionHash, max_used_block_height)) {
+      return true;
+    }
+  }
+
+  // the output keys are resolved, the signatures themselves don't need the blockchain lock
+  if (m_ringSignatureVerifier.verify(ringSignatureChecks) != ringSignatureChecks.size()) {
+    logger(INFO, BRIGHT_WHITE) <<
+      "Failed to check ring signature for tx " << transactionHash;
+    return false;
+  }
+
+  BlockInfo maxUsedBlock;
+  maxUsedBlock.height = max_used_block_height;
+  maxUsedBlock.id = max_used_block_id;
+  m_verifiedTransactions.add(transactionHash, maxUsedBlock);
   return true;
 }
 
+void Blockchain::preverifyRingSignatures(const std::vector<const CachedTransaction*>& transactions, std::vector<bool>& invalidSignatures) {
+  struct BatchTransaction {
+    size_t index;
+    Crypto::Hash hash;
+    BlockInfo maxUsedBlock;
+    size_t checksEnd;
+  };
+
+  invalidSignatures.assign(transactions.size(), false);
+  std::vector<BatchTransaction> batch;
+  std::vector<RingSignatureCheck> ringSignatureChecks;
+
+  {
+    ReadLock lk(*this);
+
+    for (size_t i = 0; i < transactions.size(); ++i) {
+      size_t checkCount = ringSignatureChecks.size();
+      BatchTransaction transaction;
+      transaction.index = i;
+      transaction.hash = transactions[i]->getTransactionHash();
+      if (!checkTransactionInputs(*transactions[i], &transaction.maxUsedBlock.height, &ringSignatureChecks) ||
+          isTransactionVerified(transaction.hash, transaction.maxUsedBlock.height)) {
+        ringSignatureChecks.resize(checkCount);
+        continue;
+      }
+
+      transaction.maxUsedBlock.id = m_blockIndex.getBlockId(transaction.maxUsedBlock.height);
+      transaction.checksEnd = ringSignatureChecks.size();
+      batch.push_back(transaction);
+    }
+  }
+
+  // the verifier stops at the first bad signature, the transactions after it are verified again without the bad one
+  size_t verifiedChecks = 0;
+  auto transaction = batch.begin();
+  while (transaction != batch.end()) {
+    size_t failedCheck = verifiedChecks + m_ringSignatureVerifier.verify(ringSignatureChecks);
+    for (; transaction != batch.end() && transaction->checksEnd <= failedCheck; ++transaction) {
+      m_verifiedTransactions.add(transaction->hash, transaction->maxUsedBlock);
+    }
+
+    if (transaction == batch.end()) {
+      break;
+    }
+
+    invalidSignatures[transaction->index] = true;
+    ringSignatureChecks.erase(ringSignatureChecks.begin(), ringSignatureChecks.begin() + (transaction->checksEnd - verifiedChecks));
+    verifiedChecks = transaction->checksEnd;
+    ++transaction;
+  }
+}
+
 bool Blockchain::haveTransactionKeyImagesAsSpent(const Transaction &tx) {
   for (const auto& in : tx.inputs) {
     if (in.type() == typeid(KeyInput)) {
@@ -1500,23 +2266,21 @@ bool Blockchain::haveTransactionKeyImagesAsSpent(const Transaction &tx) {
   return false;
 }
 
-bool Blockchain::checkTransactionInputs(const Transaction& tx, uint32_t* pmax_used_block_height) {
-  Crypto::Hash tx_prefix_hash = getObjectHash(*static_cast<const TransactionPrefix*>(&tx));
-  return checkTransactionInputs(tx, tx_prefix_hash, pmax_used_block_height);
-}
-
-bool Blockchain::checkTransactionInputs(const Transaction& tx, const Crypto::Hash& tx_prefix_hash, uint32_t* pmax_used_block_height) {
+// If ringSignatureChecks is given, ring signatures are appended to it instead of being verified here.
+bool Blockchain::checkTransactionInputs(const CachedTransaction& cachedTransaction, uint32_t* pmax_used_block_height, std::vector<RingSignatureCheck>* ringSignatureChecks) {
   size_t inputIndex = 0;
   if (pmax_used_block_height) {
     *pmax_used_block_height = 0;
   }
 
-  Crypto::Hash transactionHash = getObjectHash(tx);
+  const Transaction& tx = cachedTransaction.getTransaction();
+  const Crypto::Hash& transactionHash = cachedTransaction.getTransactionHash();
+  const Crypto::Hash& tx_prefix_hash = cachedTransaction.getTransactionPrefixHash();
   for (const auto& txin : tx.inputs) {
     assert(inputIndex < tx.signatures.size());
     if (txin.type() == typeid(KeyInput)) {
       const KeyInput& in_to_key = boost::get<KeyInput>(txin);
-      if (!(!in_to_key.outputIndexes.empty())) { logger(ERROR, BRIGHT_RED) << "empty in_to_key.outputIndexes in transaction with id " << getObjectHash(tx); return false; }
+      if (!(!in_to_key.outputIndexes.empty())) { logger(ERROR, BRIGHT_RED) << "empty in_to_key.outputIndexes in transaction with id " << transactionHash; return false; }
 
       if (have_tx_keyimg_as_spent(in_to_key.keyImage)) {
         logger(DEBUGGING) <<
@@ -1524,7 +2288,7 @@ bool Blockchain::checkTransactionInputs(const Transaction& tx, const Crypto::Has
         return false;
       }
 
-      if (!check_tx_input(in_to_key, tx_prefix_hash, tx.signatures[inputIndex], pmax_used_block_height)) {
+      if (!check_tx_input(in_to_key, tx_prefix_hash, tx.signatures[inputIndex], pmax_used_block_height, ringSignatureChecks)) {
         logger(INFO, BRIGHT_WHITE) <<
           "Failed to check ring signature for tx " << transactionHash;
         return false;
@@ -1566,8 +2330,8 @@ bool Blockchain::is_tx_spendtime_unlocked(uint64_t unlock_time) {
   return false;
 }
 
-bool Blockchain::check_tx_input(const KeyInput& txin, const Crypto::Hash& tx_prefix_hash, const std::vector<Crypto::Signature>& sig, uint32_t* pmax_related_block_height) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+bool Blockchain::check_tx_input(const KeyInput& txin, const Crypto::Hash& tx_prefix_hash, const std::vector<Crypto::Signature>& sig, uint32_t* pmax_related_block_height, std::vector<RingSignatureCheck>* ringSignatureChecks) {
+  ReadLock lk(*this);
 
   struct outputs_visitor {
     std::vector<const Crypto::PublicKey *>& m_results_collector;
@@ -1616,6 +2380,20 @@ bool Blockchain::check_tx_input(const KeyInput& txin, const Crypto::Hash& tx_pre
     return true;
   }
 
+  if (ringSignatureChecks) {
+    RingSignatureCheck check;
+    check.prefixHash = tx_prefix_hash;
+    check.keyImage = txin.keyImage;
+    check.outputKeys.reserve(output_keys.size());
+    for (const Crypto::PublicKey* key : output_keys) {
+      check.outputKeys.push_back(*key);
+    }
+
+    check.signatures = sig;
+    ringSignatureChecks->push_back(std::move(check));
+    return true;
+  }
+
   return Crypto::check_ring_signature(tx_prefix_hash, txin.keyImage, output_keys, sig.data());
 }
 
@@ -1698,21 +2476,38 @@ bool Blockchain::update_next_comulative_size_limit() {
 }
 
 bool Blockchain::addNewBlock(const Block& bl_, block_verification_context& bvc) {
-  //copy block here to let modify block.target
-  Block bl = bl_;
-  Crypto::Hash id;
-  if (!get_block_hash(bl, id)) {
+  return addNewBlock(CachedBlock(bl_), bvc);
+}
+
+// The hashes of the block and of its transactions are computed once here and passed down to pushBlock()
+bool Blockchain::addNewBlock(const CachedBlock& cachedBlock, block_verification_context& bvc) {
+  const Block& bl = cachedBlock.getBlock();
+  if (cachedBlock.getBlockHashingBinaryArray().empty()) {
     logger(ERROR, BRIGHT_RED) <<
       "Failed to get block hash, possible block has invalid format";
     bvc.m_verification_failed = true;
     return false;
   }
 
+  const Crypto::Hash& id = cachedBlock.getBlockHash();
   bool add_result;
 
+  CheckedProofOfWork checkedProofOfWork;
+  bool proofOfWorkChecked = precheckProofOfWork(cachedBlock, checkedProofOfWork);
+  CheckedRingSignatures checkedRingSignatures;
+  bool ringSignaturesChecked = precheckRingSignatures(cachedBlock, checkedRingSignatures);
+
   { //to avoid deadlock lets lock tx_pool for whole add/reorganize process
     std::lock_guard<decltype(m_tx_pool)> poolLock(m_tx_pool);
-    std::lock_guard<decltype(m_blockchain_lock)> bcLock(m_blockchain_lock);
+    WriteLock bcLock(*this);
+
+    if (proofOfWorkChecked) {
+      m_checkedProofOfWork = checkedProofOfWork;
+    }
+
+    if (ringSignaturesChecked) {
+      m_checkedRingSignatures = checkedRingSignatures;
+    }
 
     if (haveBlock(id)) {
       logger(TRACE) << "block with id = " << id << " already exists";
@@ -1726,7 +2521,7 @@ bool Blockchain::addNewBlock(const Block& bl_, block_verification_context& bvc)
       bvc.m_added_to_main_chain = false;
       add_result = handle_alternative_block(bl, id, bvc);
     } else {
-      add_result = pushBlock(bl, bvc);
+      add_result = pushBlock(cachedBlock, bvc);
       if (add_result) {
         sendMessage(BlockchainMessage(NewBlockMessage(id)));
       }
@@ -1740,18 +2535,126 @@ bool Blockchain::addNewBlock(const Block& bl_, block_verification_context& bvc)
   return add_result;
 }
 
+// The long hash is the most expensive part of block verification. For a block extending the current tail it is
+// computed here with the lock held only shared, so queries are not stalled by it; pushBlock() reuses the result
+// if the tail did not move in between.
+bool Blockchain::precheckProofOfWork(const CachedBlock& block, CheckedProofOfWork& result) {
+  uint32_t blockchainHeight;
+  difficulty_type currentDifficulty;
+
+  {
+    ReadLock lk(*this);
+    if (m_blocks.empty() || block.getBlock().previousBlockHash != getTailId()) {
+      return false;
+    }
+
+    blockchainHeight = static_cast<uint32_t>(m_blocks.size());
+    if (m_checkpoints.is_in_checkpoint_zone(blockchainHeight)) {
+      return false;
+    }
+
+    currentDifficulty = getDifficultyForNextBlock();
+  }
+
+  if (!currentDifficulty) {
+    return false;
+  }
+
+  result.blockHash = block.getBlockHash();
+  result.difficulty = currentDifficulty;
+  result.proofOfWork = NULL_HASH;
+  if (blockchainHeight < parameters::HARD_FORK_HEIGHT_2) {
+    result.valid = m_currency.checkProofOfWork1(block, currentDifficulty, result.proofOfWork);
+  } else {
+    result.valid = m_currency.checkProofOfWork2(block, currentDifficulty, result.proofOfWork);
+  }
+
+  return true;
+}
+
+// Resolves the output keys of all ring signatures in the block under the shared lock and verifies them after releasing it.
+// pushBlock() reuses the result as long as the block still extends the same tail.
+bool Blockchain::precheckRingSignatures(const CachedBlock& cachedBlock, CheckedRingSignatures& result) {
+  const Block& block = cachedBlock.getBlock();
+
+  // the pool is locked before the blockchain everywhere else, so take the transactions before the shared lock
+  std::vector<tx_memory_pool::TransactionDetails> transactions;
+  std::vector<Crypto::Hash> missedTransactions;
+  m_tx_pool.getTransactionDetails(block.transactionHashes, transactions, missedTransactions);
+  if (!missedTransactions.empty()) {
+    return false;
+  }
+
+  std::vector<RingSignatureCheck> ringSignatureChecks;
+
+  {
+    ReadLock lk(*this);
+    if (m_blocks.empty() || block.previousBlockHash != getTailId()) {
+      return false;
+    }
+
+    for (size_t i = 0; i < transactions.size(); ++i) {
+      size_t checkCount = ringSignatureChecks.size();
+      uint32_t maxUsedBlockHeight;
+      CachedTransaction transaction(transactions[i].tx, transactions[i].id, transactions[i].prefixHash, transactions[i].blobSize);
+      if (!checkTransactionInputs(transaction, &maxUsedBlockHeight, &ringSignatureChecks)) {
+        // pushBlock() will reject the block and report why
+        return false;
+      }
+
+      if (isTransactionVerified(block.transactionHashes[i], maxUsedBlockHeight)) {
+        ringSignatureChecks.resize(checkCount);
+      }
+    }
+  }
+
+  result.blockHash = cachedBlock.getBlockHash();
+  result.valid = m_ringSignatureVerifier.verify(ringSignatureChecks) == ringSignatureChecks.size();
+  return true;
+}
+
+// Ring signatures only depend on the outputs a transaction spends, so a verification done when the transaction entered
+// the pool holds as long as the newest block with one of those outputs is still in the main chain.
+// Must be called with the blockchain lock held.
+bool Blockchain::isTransactionVerified(const Crypto::Hash& transactionHash, uint32_t maxUsedBlockHeight) {
+  BlockInfo maxUsedBlock;
+  if (!m_verifiedTransactions.find(transactionHash, maxUsedBlock)) {
+    return false;
+  }
+
+  if (maxUsedBlock.height == maxUsedBlockHeight && maxUsedBlock.height < m_blockIndex.size() &&
+      m_blockIndex.getBlockId(maxUsedBlock.height) == maxUsedBlock.id) {
+    return true;
+  }
+
+  // the block was switched out by a reorganization since
+  m_verifiedTransactions.remove(transactionHash);
+  return false;
+}
+
 const Blockchain::TransactionEntry& Blockchain::transactionByIndex(TransactionIndex index) {
   return m_blocks[index.block].transactions[index.transaction];
 }
 
 bool Blockchain::pushBlock(const Block& blockData, block_verification_context& bvc) {
-  std::vector<Transaction> transactions;
-  if (!loadTransactions(blockData, transactions)) {
+  return pushBlock(CachedBlock(blockData), bvc);
+}
+
+bool Blockchain::pushBlock(const CachedBlock& cachedBlock, block_verification_context& bvc) {
+  std::vector<tx_memory_pool::TransactionDetails> transactionDetails;
+  if (!loadTransactions(cachedBlock.getBlock(), transactionDetails)) {
     bvc.m_verification_failed = true;
     return false;
   }
 
-  if (!pushBlock(blockData, transactions, bvc)) {
+  // the pool hands the hashes and sizes over with the transactions
+  std::vector<CachedTransaction> transactions;
+  transactions.reserve(transactionDetails.size());
+  for (const tx_memory_pool::TransactionDetails& details : transactionDetails) {
+    transactions.emplace_back(details.tx, details.id, details.prefixHash, details.blobSize);
+  }
+
+  if (!pushBlock(cachedBlock, transactions, bvc)) {
     saveTransactions(transactions);
     return false;
   }
@@ -1759,12 +2662,13 @@ bool Blockchain::pushBlock(const Block& blockData, block_verification_context& b
   return true;
 }
 
-bool Blockchain::pushBlock(const Block& blockData, const std::vector<Transaction>& transactions, block_verification_context& bvc) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+bool Blockchain::pushBlock(const CachedBlock& cachedBlock, const std::vector<CachedTransaction>& transactions, block_verification_context& bvc) {
+  WriteLock lk(*this);
 
   auto blockProcessingStart = std::chrono::steady_clock::now();
 
-  Crypto::Hash blockHash = get_block_hash(blockData);
+  const Block& blockData = cachedBlock.getBlock();
+  const Crypto::Hash& blockHash = cachedBlock.getBlockHash();
 
   // check block hash
   if (m_blockIndex.hasBlock(blockHash)) {
@@ -1791,7 +2695,7 @@ bool Blockchain::pushBlock(const Block& blockData, const std::vector<Transaction
   }
 
   // check merkle root
-  Crypto::Hash merkleRoot = get_tx_tree_hash(blockData);
+  const Crypto::Hash& merkleRoot = cachedBlock.getTransactionTreeHash();
   if (merkleRoot != blockData.merkleRoot) {
     logger(INFO, BRIGHT_WHITE) <<
       "Block " << blockHash << " merkle root supplied " << blockData.merkleRoot << " does not match merkle root calculated " << merkleRoot;
@@ -1817,17 +2721,26 @@ bool Blockchain::pushBlock(const Block& blockData, const std::vector<Transaction
       bvc.m_verification_failed = true;
       return false;
     }
+  } else if (m_checkedProofOfWork.blockHash == blockHash && m_checkedProofOfWork.difficulty == currentDifficulty) {
+    // already computed by addNewBlock() before the exclusive lock was taken
+    proof_of_work = m_checkedProofOfWork.proofOfWork;
+    if (!m_checkedProofOfWork.valid) {
+      logger(INFO, BRIGHT_WHITE) <<
+        "Block " << blockHash << ", has too weak proof of work: " << proof_of_work << ", expected difficulty: " << currentDifficulty;
+      bvc.m_verification_failed = true;
+      return false;
+    }
   } else {
     bool proofOfWorkSuccess = false;
     uint32_t blockchainHeight = static_cast<uint32_t>(m_blocks.size());
 
     if (blockchainHeight < parameters::HARD_FORK_HEIGHT_2)
     {
-      proofOfWorkSuccess = m_currency.checkProofOfWork1(m_cn_context, blockData, currentDifficulty, proof_of_work);
+      proofOfWorkSuccess = m_currency.checkProofOfWork1(cachedBlock, currentDifficulty, proof_of_work);
     }
     else
     {
-      proofOfWorkSuccess = m_currency.checkProofOfWork2(m_cn_context, blockData, currentDifficulty, proof_of_work);
+      proofOfWorkSuccess = m_currency.checkProofOfWork2(cachedBlock, currentDifficulty, proof_of_work);
     }
 
     if (!proofOfWorkSuccess) {
@@ -1847,7 +2760,7 @@ bool Blockchain::pushBlock(const Block& blockData, const std::vector<Transaction
     return false;
   }
 
-  Crypto::Hash coinbaseTransactionHash = getObjectHash(blockData.baseTransaction);
+  const Crypto::Hash& coinbaseTransactionHash = cachedBlock.getBaseTransaction().getTransactionHash();
 
   BlockEntry block;
   block.bl = blockData;
@@ -1856,19 +2769,23 @@ bool Blockchain::pushBlock(const Block& blockData, const std::vector<Transaction
   TransactionIndex transactionIndex = { static_cast<uint32_t>(m_blocks.size()), static_cast<uint16_t>(0) };
   pushTransaction(block, coinbaseTransactionHash, transactionIndex);
 
-  size_t coinbase_blob_size = getObjectBinarySize(blockData.baseTransaction);
+  size_t coinbase_blob_size = cachedBlock.getBaseTransaction().getTransactionBinarySize();
   size_t cumulative_block_size = coinbase_blob_size;
   uint64_t fee_summary = 0;
+  std::vector<RingSignatureCheck> ringSignatureChecks;
+  std::vector<size_t> ringSignatureCheckTransactions;
   for (size_t i = 0; i < transactions.size(); ++i) {
     const Crypto::Hash& tx_id = blockData.transactionHashes[i];
     block.transactions.resize(block.transactions.size() + 1);
     size_t blob_size = 0;
     uint64_t fee = 0;
-    block.transactions.back().tx = transactions[i];
+    block.transactions.back().tx = transactions[i].getTransaction();
 
-    blob_size = toBinaryArray(block.transactions.back().tx).size();
+    blob_size = transactions[i].getTransactionBinarySize();
     fee = getInputAmount(block.transactions.back().tx) - getOutputAmount(block.transactions.back().tx);
-    if (!checkTransactionInputs(block.transactions.back().tx)) {
+    size_t checkCount = ringSignatureChecks.size();
+    uint32_t maxUsedBlockHeight;
+    if (!checkTransactionInputs(transactions[i], &maxUsedBlockHeight, &ringSignatureChecks)) {
       logger(INFO, BRIGHT_WHITE) <<
         "Block " << blockHash << " has at least one transaction with wrong inputs: " << tx_id;
       bvc.m_verification_failed = true;
@@ -1878,6 +2795,12 @@ bool Blockchain::pushBlock(const Block& blockData, const std::vector<Transaction
       return false;
     }
 
+    if (isTransactionVerified(tx_id, maxUsedBlockHeight)) {
+      // only the checks against the current chain above are needed, the signatures were verified at pool admission
+      ringSignatureChecks.resize(checkCount);
+    }
+
+    ringSignatureCheckTransactions.resize(ringSignatureChecks.size(), i);
     ++transactionIndex.transaction;
     pushTransaction(block, tx_id, transactionIndex);
 
@@ -1885,6 +2808,18 @@ bool Blockchain::pushBlock(const Block& blockData, const std::vector<Transaction
     fee_summary += fee;
   }
 
+  // the keys resolved above are the ones addNewBlock() has already verified the signatures against if the block hash matches
+  if (m_checkedRingSignatures.blockHash != blockHash || !m_checkedRingSignatures.valid) {
+    size_t failedCheck = m_ringSignatureVerifier.verify(ringSignatureChecks);
+    if (failedCheck != ringSignatureChecks.size()) {
+      logger(INFO, BRIGHT_WHITE) <<
+        "Block " << blockHash << " has at least one transaction with wrong inputs: " << blockData.transactionHashes[ringSignatureCheckTransactions[failedCheck]];
+      bvc.m_verification_failed = true;
+      popTransactions(block, coinbaseTransactionHash);
+      return false;
+    }
+  }
+
   if (!checkCumulativeBlockSize(blockHash, cumulative_block_size, m_blocks.size())) {
     bvc.m_verification_failed = true;
     return false;
@@ -1919,7 +2854,11 @@ bool Blockchain::pushBlock(const Block& blockData, const std::vector<Transaction
     }
   }
 
-  pushBlock(block);
+  pushBlock(block, blockHash, coinbaseTransactionHash);
+
+  for (const Crypto::Hash& transactionHash : blockData.transactionHashes) {
+    m_verifiedTransactions.remove(transactionHash);
+  }
 
   auto block_processing_time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - blockProcessingStart).count();
 
@@ -1938,9 +2877,7 @@ bool Blockchain::pushBlock(const Block& blockData, const std::vector<Transaction
   return true;
 }
 
-bool Blockchain::pushBlock(BlockEntry& block) {
-  Crypto::Hash blockHash = get_block_hash(block.bl);
-
+bool Blockchain::pushBlock(BlockEntry& block, const Crypto::Hash& blockHash, const Crypto::Hash& baseTransactionHash) {
   m_blocks.push_back(block);
   m_blockIndex.push(blockHash);
 
@@ -1949,6 +2886,13 @@ bool Blockchain::pushBlock(BlockEntry& block) {
 
   assert(m_blockIndex.size() == m_blocks.size());
 
+  journalBlock(makeCacheDelta(true, static_cast<uint32_t>(m_blocks.size() - 1), block, blockHash, baseTransactionHash));
+  if (m_cacheJournalLength >= BLOCKS_CACHE_SNAPSHOT_INTERVAL) {
+    storeCache();
+  }
+
+  m_tx_pool.on_blockchain_inc(m_blocks.size(), blockHash);
+
   return true;
 }
 
@@ -1959,14 +2903,17 @@ void Blockchain::popBlock(const Crypto::Hash& blockHash) {
     return;
   }
 
-  std::vector<Transaction> transactions(m_blocks.back().transactions.size() - 1);
+  std::vector<CachedTransaction> transactions;
+  transactions.reserve(m_blocks.back().transactions.size() - 1);
   for (size_t i = 0; i < m_blocks.back().transactions.size() - 1; ++i) {
-    transactions[i] = m_blocks.back().transactions[1 + i].tx;
+    transactions.emplace_back(m_blocks.back().transactions[1 + i].tx);
   }
 
   saveTransactions(transactions);
 
-  popTransactions(m_blocks.back(), getObjectHash(m_blocks.back().bl.baseTransaction));
+  Crypto::Hash baseTransactionHash = getObjectHash(m_blocks.back().bl.baseTransaction);
+  journalBlock(makeCacheDelta(false, static_cast<uint32_t>(m_blocks.size() - 1), m_blocks.back(), blockHash, baseTransactionHash));
+  popTransactions(m_blocks.back(), baseTransactionHash);
 
   m_timestampIndex.remove(m_blocks.back().bl.timestamp, blockHash);
   m_generatedTransactionsIndex.remove(m_blocks.back().bl);
@@ -1975,11 +2922,12 @@ void Blockchain::popBlock(const Crypto::Hash& blockHash) {
   m_blockIndex.pop();
 
   assert(m_blockIndex.size() == m_blocks.size());
+
+  m_tx_pool.on_blockchain_dec(m_blocks.size(), m_blocks.empty() ? NULL_HASH : m_blockIndex.getTailId());
 }
 
 bool Blockchain::pushTransaction(BlockEntry& block, const Crypto::Hash& transactionHash, TransactionIndex transactionIndex) {
-  auto result = m_transactionMap.insert(std::make_pair(transactionHash, transactionIndex));
-  if (!result.second) {
+  if (!m_transactionMap.insert(transactionHash, transactionIndex)) {
     logger(ERROR, BRIGHT_RED) <<
       "Duplicate transaction was pushed to blockchain.";
     return false;
@@ -1996,12 +2944,11 @@ bool Blockchain::pushTransaction(BlockEntry& block, const Crypto::Hash& transact
 
   for (size_t i = 0; i < transaction.tx.inputs.size(); ++i) {
     if (transaction.tx.inputs[i].type() == typeid(KeyInput)) {
-      auto result = m_spent_keys.insert(::boost::get<KeyInput>(transaction.tx.inputs[i]).keyImage);
-      if (!result.second) {
+      if (!insertSpentKey(::boost::get<KeyInput>(transaction.tx.inputs[i]).keyImage)) {
         logger(ERROR, BRIGHT_RED) <<
           "Double spending transaction was pushed to blockchain.";
         for (size_t j = 0; j < i; ++j) {
-          m_spent_keys.erase(::boost::get<KeyInput>(transaction.tx.inputs[i - 1 - j]).keyImage);
+          eraseSpentKey(::boost::get<KeyInput>(transaction.tx.inputs[i - 1 - j]).keyImage);
         }
 
         m_transactionMap.erase(transactionHash);
@@ -2023,7 +2970,10 @@ bool Blockchain::pushTransaction(BlockEntry& block, const Crypto::Hash& transact
     if (transaction.tx.outputs[output].target.type() == typeid(KeyOutput)) {
       auto& amountOutputs = m_outputs[transaction.tx.outputs[output].amount];
       transaction.m_global_output_indexes[output] = static_cast<uint32_t>(amountOutputs.size());
-      amountOutputs.push_back(std::make_pair<>(transactionIndex, output));
+      OutputReference reference = { transactionIndex.block, transactionIndex.transaction, output };
+      amountOutputs.push_back(reference);
+      KeyOutputEntry entry = { ::boost::get<KeyOutput>(transaction.tx.outputs[output].target).key, transaction.tx.unlockTime };
+      m_keyOutputs[transaction.tx.outputs[output].amount].push_back(entry);
     } else if (transaction.tx.outputs[output].target.type() == typeid(MultisignatureOutput)) {
       auto& amountOutputs = m_multisignatureOutputs[transaction.tx.outputs[output].amount];
       transaction.m_global_output_indexes[output] = static_cast<uint32_t>(amountOutputs.size());
@@ -2038,7 +2988,12 @@ bool Blockchain::pushTransaction(BlockEntry& block, const Crypto::Hash& transact
 }
 
 void Blockchain::popTransaction(const Transaction& transaction, const Crypto::Hash& transactionHash) {
-  TransactionIndex transactionIndex = m_transactionMap.at(transactionHash);
+  const TransactionIndex* foundIndex = m_transactionMap.find(transactionHash);
+  if (foundIndex == nullptr) {
+    throw std::out_of_range("Transaction to pop isn't in the transaction map");
+  }
+
+  TransactionIndex transactionIndex = *foundIndex;
   for (size_t outputIndex = 0; outputIndex < transaction.outputs.size(); ++outputIndex) {
     const TransactionOutput& output = transaction.outputs[transaction.outputs.size() - 1 - outputIndex];
     if (output.target.type() == typeid(KeyOutput)) {
@@ -2055,13 +3010,13 @@ void Blockchain::popTransaction(const Transaction& transaction, const Crypto::Ha
         continue;
       }
 
-      if (amountOutputs->second.back().first.block != transactionIndex.block || amountOutputs->second.back().first.transaction != transactionIndex.transaction) {
+      if (amountOutputs->second.back().block != transactionIndex.block || amountOutputs->second.back().transaction != transactionIndex.transaction) {
         logger(ERROR, BRIGHT_RED) <<
           "Blockchain consistency broken - invalid transaction index.";
         continue;
       }
 
-      if (amountOutputs->second.back().second != transaction.outputs.size() - 1 - outputIndex) {
+      if (amountOutputs->second.back().output != transaction.outputs.size() - 1 - outputIndex) {
         logger(ERROR, BRIGHT_RED) <<
           "Blockchain consistency broken - invalid output index.";
         continue;
@@ -2071,6 +3026,12 @@ void Blockchain::popTransaction(const Transaction& transaction, const Crypto::Ha
       if (amountOutputs->second.empty()) {
         m_outputs.erase(amountOutputs);
       }
+
+      auto amountKeyOutputs = m_keyOutputs.find(output.amount);
+      amountKeyOutputs->second.pop_back();
+      if (amountKeyOutputs->second.empty()) {
+        m_keyOutputs.erase(amountKeyOutputs);
+      }
     } else if (output.target.type() == typeid(MultisignatureOutput)) {
       auto amountOutputs = m_multisignatureOutputs.find(output.amount);
       if (amountOutputs == m_multisignatureOutputs.end()) {
@@ -2112,8 +3073,7 @@ void Blockchain::popTransaction(const Transaction& transaction, const Crypto::Ha
 
   for (auto& input : transaction.inputs) {
     if (input.type() == typeid(KeyInput)) {
-      size_t count = m_spent_keys.erase(::boost::get<KeyInput>(input).keyImage);
-      if (count != 1) {
+      if (!eraseSpentKey(::boost::get<KeyInput>(input).keyImage)) {
         logger(ERROR, BRIGHT_RED) <<
           "Blockchain consistency broken - cannot find spent key.";
       }
@@ -2204,7 +3164,7 @@ bool Blockchain::validateInput(const MultisignatureInput& input, const Crypto::H
 }
 
 bool Blockchain::getLowerBound(uint64_t timestamp, uint64_t startOffset, uint32_t& height) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  ReadLock lk(*this);
 
   assert(startOffset < m_blocks.size());
 
@@ -2220,24 +3180,24 @@ bool Blockchain::getLowerBound(uint64_t timestamp, uint64_t startOffset, uint32_
 }
 
 std::vector<Crypto::Hash> Blockchain::getBlockIds(uint32_t startHeight, uint32_t maxCount) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  ReadLock lk(*this);
   return m_blockIndex.getBlockIds(startHeight, maxCount);
 }
 
 bool Blockchain::getBlockContainingTransaction(const Crypto::Hash& txId, Crypto::Hash& blockId, uint32_t& blockHeight) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
-  auto it = m_transactionMap.find(txId);
-  if (it == m_transactionMap.end()) {
+  ReadLock lk(*this);
+  const TransactionIndex* transactionIndex = m_transactionMap.find(txId);
+  if (transactionIndex == nullptr) {
     return false;
   } else {
-    blockHeight = m_blocks[it->second.block].height;
+    blockHeight = m_blocks[transactionIndex->block].height;
     blockId = getBlockIdByHeight(blockHeight);
     return true;
   }
 }
 
 bool Blockchain::getAlreadyGeneratedCoins(const Crypto::Hash& hash, uint64_t& generatedCoins) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  ReadLock lk(*this);
 
   // try to find block in main chain
   uint32_t height = 0;
@@ -2258,7 +3218,7 @@ bool Blockchain::getAlreadyGeneratedCoins(const Crypto::Hash& hash, uint64_t& ge
 }
 
 bool Blockchain::getBlockSize(const Crypto::Hash& hash, size_t& size) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  ReadLock lk(*this);
 
   // try to find block in main chain
   uint32_t height = 0;
@@ -2279,7 +3239,7 @@ bool Blockchain::getBlockSize(const Crypto::Hash& hash, size_t& size) {
 }
 
 bool Blockchain::getMultisigOutputReference(const MultisignatureInput& txInMultisig, std::pair<Crypto::Hash, size_t>& outputReference) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  ReadLock lk(*this);
   MultisignatureOutputsContainer::const_iterator amountIter = m_multisignatureOutputs.find(txInMultisig.amount);
   if (amountIter == m_multisignatureOutputs.end()) {
     logger(DEBUGGING) << "Transaction contains multisignature input with invalid amount.";
@@ -2297,7 +3257,7 @@ bool Blockchain::getMultisigOutputReference(const MultisignatureInput& txInMulti
 }
 
 bool Blockchain::storeBlockchainIndexes() {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  WriteLock lk(*this);
 
   logger(INFO, BRIGHT_WHITE) << "Saving blockchain indexes...";
   BlockchainIndexesSerializer ser(*this, getTailId(), logger.getLogger());
@@ -2311,7 +3271,7 @@ bool Blockchain::storeBlockchainIndexes() {
 }
 
 bool Blockchain::loadBlockchainIndexes() {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  WriteLock lk(*this);
 
   logger(INFO, BRIGHT_WHITE) << "Loading blockchain indexes for BlockchainExplorer...";
   BlockchainIndexesSerializer loader(*this, get_block_hash(m_blocks.back().bl), logger.getLogger());
@@ -2346,35 +3306,34 @@ bool Blockchain::loadBlockchainIndexes() {
 }
 
 bool Blockchain::getGeneratedTransactionsNumber(uint32_t height, uint64_t& generatedTransactions) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  ReadLock lk(*this);
   return m_generatedTransactionsIndex.find(height, generatedTransactions);
 }
 
 bool Blockchain::getOrphanBlockIdsByHeight(uint32_t height, std::vector<Crypto::Hash>& blockHashes) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  ReadLock lk(*this);
   return m_orthanBlocksIndex.find(height, blockHashes);
 }
 
 bool Blockchain::getBlockIdsByTimestamp(uint64_t timestampBegin, uint64_t timestampEnd, uint32_t blocksNumberLimit, std::vector<Crypto::Hash>& hashes, uint32_t& blocksNumberWithinTimestamps) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  ReadLock lk(*this);
   return m_timestampIndex.find(timestampBegin, timestampEnd, blocksNumberLimit, hashes, blocksNumberWithinTimestamps);
 }
 
 bool Blockchain::getTransactionIdsByPaymentId(const Crypto::Hash& paymentId, std::vector<Crypto::Hash>& transactionHashes) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  ReadLock lk(*this);
   return m_paymentIdIndex.find(paymentId, transactionHashes);
 }
 
-bool Blockchain::loadTransactions(const Block& block, std::vector<Transaction>& transactions) {
+bool Blockchain::loadTransactions(const Block& block, std::vector<tx_memory_pool::TransactionDetails>& transactions) {
   transactions.resize(block.transactionHashes.size());
-  size_t transactionSize;
-  uint64_t fee;
   uint32_t blockchainHeight = getCurrentBlockchainHeight();
   for (size_t i = 0; i < block.transactionHashes.size(); ++i) {
-    if (!m_tx_pool.take_tx(block.transactionHashes[i], transactions[i], transactionSize, fee)) {
+    if (!m_tx_pool.take_tx(block.transactionHashes[i], transactions[i])) {
       tx_verification_context context;
       for (size_t j = 0; j < i; ++j) {
-        if (!m_tx_pool.add_tx(transactions[i - 1 - j], context, true, blockchainHeight)) {
+        const tx_memory_pool::TransactionDetails& details = transactions[i - 1 - j];
+        if (!m_tx_pool.add_tx(CachedTransaction(details.tx, details.id, details.prefixHash, details.blobSize), context, true, blockchainHeight)) {
           throw std::runtime_error("Blockchain::loadTransactions, failed to add transaction to pool");
         }
       }
@@ -2386,7 +3345,7 @@ bool Blockchain::loadTransactions(const Block& block, std::vector<Transaction>&
   return true;
 }
 
-void Blockchain::saveTransactions(const std::vector<Transaction>& transactions) {
+void Blockchain::saveTransactions(const std::vector<CachedTransaction>& transactions) {
   tx_verification_context context;
   uint32_t blockchainHeight = getCurrentBlockchainHeight();
   for (size_t i = 0; i < transactions.size(); ++i) {
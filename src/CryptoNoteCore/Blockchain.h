@@ -7,20 +7,27 @@
 #pragma once
 
 #include <atomic>
+#include <fstream>
 
 #include "google/sparse_hash_set"
 #include "google/sparse_hash_map"
 
 #include "Common/ObserverManager.h"
+#include "Common/RecursiveSharedMutex.h"
 #include "Common/Util.h"
 #include "CryptoNoteCore/BlockIndex.h"
+#include "CryptoNoteCore/CachedBlock.h"
 #include "CryptoNoteCore/Checkpoints.h"
 #include "CryptoNoteCore/Currency.h"
+#include "CryptoNoteCore/FlatHashMap.h"
 #include "CryptoNoteCore/IBlockchainStorageObserver.h"
+#include "CryptoNoteCore/KeyImageFilter.h"
 #include "CryptoNoteCore/ITransactionValidator.h"
-#include "CryptoNoteCore/SwappedVector.h"
+#include "CryptoNoteCore/MappedVector.h"
+#include "CryptoNoteCore/RingSignatureVerifier.h"
 #include "CryptoNoteCore/CryptoNoteFormatUtils.h"
 #include "CryptoNoteCore/TransactionPool.h"
+#include "CryptoNoteCore/VerifiedTransactionCache.h"
 #include "CryptoNoteCore/BlockchainIndexes.h"
 
 #include "CryptoNoteCore/MessageQueue.h"
@@ -47,8 +54,8 @@ namespace CryptoNote {
     bool removeObserver(IBlockchainStorageObserver* observer);
 
     // ITransactionValidator
-    virtual bool checkTransactionInputs(const CryptoNote::Transaction& tx, BlockInfo& maxUsedBlock) override;
-    virtual bool checkTransactionInputs(const CryptoNote::Transaction& tx, BlockInfo& maxUsedBlock, BlockInfo& lastFailed) override;
+    virtual bool checkTransactionInputs(const CryptoNote::CachedTransaction& tx, BlockInfo& maxUsedBlock) override;
+    virtual bool checkTransactionInputs(const CryptoNote::CachedTransaction& tx, BlockInfo& maxUsedBlock, BlockInfo& lastFailed) override;
     virtual bool haveSpentKeyImages(const CryptoNote::Transaction& tx) override;
     virtual bool checkTransactionSize(size_t blobSize) override;
     virtual bool checkTransactionExtraSize(size_t txExtraSize) override;
@@ -61,10 +68,23 @@ namespace CryptoNote {
     std::vector<Crypto::Hash> getBlockIds(uint32_t startHeight, uint32_t maxCount);
 
     void setCheckpoints(Checkpoints&& chk_pts) { m_checkpoints = chk_pts; }
+    void setBlocksCacheSize(size_t size) { m_blocksCacheSize = size; }
     bool getBlocks(uint32_t start_offset, uint32_t count, std::list<Block>& blocks, std::list<Transaction>& txs);
     bool getBlocks(uint32_t start_offset, uint32_t count, std::list<Block>& blocks);
+
+    // Serialized block of the main chain and its transactions, in the order of the block's transaction hashes, as they
+    // are kept in the block storage. The blobs stay valid while the caller holds the blockchain lock.
+    struct RawBlock {
+      Crypto::Hash id;
+      uint64_t timestamp;
+      Common::StringView block;
+      std::vector<Common::StringView> transactions;
+    };
+
+    bool getRawBlock(uint32_t height, RawBlock& block);
     bool getAlternativeBlocks(std::list<Block>& blocks);
     uint32_t getAlternativeBlocksCount();
+    void getSpentKeysFilterInfo(size_t& memoryUsage, double& falsePositiveRate);
     Crypto::Hash getBlockIdByHeight(uint32_t height);
     bool getBlockByHash(const Crypto::Hash &h, Block &blk);
     bool getBlockHeight(const Crypto::Hash& blockId, uint32_t& blockHeight);
@@ -81,6 +101,7 @@ namespace CryptoNote {
     uint64_t getMinimalFee(uint32_t height);
     uint64_t getCoinsInCirculation();
     bool addNewBlock(const Block& bl_, block_verification_context& bvc);
+    bool addNewBlock(const CachedBlock& cachedBlock, block_verification_context& bvc);
     bool resetAndSetGenesisBlock(const Block& b);
     bool haveBlock(const Crypto::Hash& id);
     size_t getTotalTransactions();
@@ -94,7 +115,11 @@ namespace CryptoNote {
     bool getBackwardBlocksSize(size_t from_height, std::vector<size_t>& sz, size_t count);
     bool getTransactionOutputGlobalIndexes(const Crypto::Hash& tx_id, std::vector<uint32_t>& indexes);
     bool get_out_by_msig_gindex(uint64_t amount, uint64_t gindex, MultisignatureOutput& out);
-    bool checkTransactionInputs(const Transaction& tx, uint32_t& pmax_used_block_height, Crypto::Hash& max_used_block_id, BlockInfo* tail = 0);
+    bool checkTransactionInputs(const CachedTransaction& tx, uint32_t& pmax_used_block_height, Crypto::Hash& max_used_block_id, BlockInfo* tail = 0);
+    // Verifies the ring signatures of several transactions as one batch and remembers the valid ones, so that
+    // checkTransactionInputs() doesn't verify them again. invalidSignatures gets a flag per transaction; transactions
+    // whose inputs can't be resolved are left to checkTransactionInputs().
+    void preverifyRingSignatures(const std::vector<const CachedTransaction*>& transactions, std::vector<bool>& invalidSignatures);
     uint64_t getCurrentCumulativeBlocksizeLimit();
     uint64_t blockDifficulty(size_t i);
     bool getBlockContainingTransaction(const Crypto::Hash& txId, Crypto::Hash& blockId, uint32_t& blockHeight);
@@ -114,7 +139,7 @@ namespace CryptoNote {
 
     template<class t_ids_container, class t_blocks_container, class t_missed_container>
     bool getBlocks(const t_ids_container& block_ids, t_blocks_container& blocks, t_missed_container& missed_bs) {
-      std::lock_guard<std::recursive_mutex> lk(m_blockchain_lock);
+      ReadLock lk(*this);
 
       for (const auto& bl_id : block_ids) {
         uint32_t height = 0;
@@ -132,14 +157,14 @@ namespace CryptoNote {
 
     template<class t_ids_container, class t_tx_container, class t_missed_container>
     void getBlockchainTransactions(const t_ids_container& txs_ids, t_tx_container& txs, t_missed_container& missed_txs) {
-      std::lock_guard<decltype(m_blockchain_lock)> bcLock(m_blockchain_lock);
+      ReadLock bcLock(*this);
 
       for (const auto& tx_id : txs_ids) {
-        auto it = m_transactionMap.find(tx_id);
-        if (it == m_transactionMap.end()) {
+        const TransactionIndex* transactionIndex = m_transactionMap.find(tx_id);
+        if (transactionIndex == nullptr) {
           missed_txs.push_back(tx_id);
         } else {
-          txs.push_back(transactionByIndex(it->second).tx);
+          txs.push_back(transactionByIndex(*transactionIndex).tx);
         }
       }
     }
@@ -175,8 +200,63 @@ namespace CryptoNote {
       }
     };
 
+    // Key output of m_outputs, packed into 8 bytes
+    struct OutputReference {
+      uint32_t block;
+      uint16_t transaction;
+      uint16_t output;
+
+      TransactionIndex transactionIndex() const {
+        TransactionIndex index = { block, transaction };
+        return index;
+      }
+    };
+
+    // Key output with what picking it as a mixin needs besides its block, so that getRandomOutsByAmount() doesn't load it
+    struct KeyOutputEntry {
+      Crypto::PublicKey key;
+      uint64_t unlockTime;
+    };
+
   private:
 
+    // Queries hold m_blockchain_lock shared, everything that changes the chain holds it exclusively.
+    class ReadLock {
+    public:
+      explicit ReadLock(Blockchain& blockchain);
+      ~ReadLock();
+
+      ReadLock(const ReadLock&) = delete;
+      ReadLock& operator=(const ReadLock&) = delete;
+
+    private:
+      Blockchain& m_blockchain;
+    };
+
+    class WriteLock {
+    public:
+      explicit WriteLock(Blockchain& blockchain);
+      ~WriteLock();
+
+      WriteLock(const WriteLock&) = delete;
+      WriteLock& operator=(const WriteLock&) = delete;
+
+    private:
+      Blockchain& m_blockchain;
+    };
+
+    struct CheckedProofOfWork {
+      Crypto::Hash blockHash;
+      difficulty_type difficulty;
+      Crypto::Hash proofOfWork;
+      bool valid;
+    };
+
+    struct CheckedRingSignatures {
+      Crypto::Hash blockHash;
+      bool valid;
+    };
+
     struct MultisignatureOutputUsage {
       TransactionIndex transactionIndex;
       uint16_t outputIndex;
@@ -217,34 +297,92 @@ namespace CryptoNote {
       }
     };
 
+    struct OutputCacheDelta {
+      uint64_t amount;
+      bool multisignature;
+      Crypto::PublicKey key;
+      uint64_t unlockTime;
+
+      void serialize(ISerializer& s) {
+        s(amount, "amount");
+        s(multisignature, "multisignature");
+        s(key, "key");
+        s(unlockTime, "unlock_time");
+      }
+    };
+
+    struct TransactionCacheDelta {
+      Crypto::Hash hash;
+      std::vector<Crypto::KeyImage> keyImages;
+      std::vector<MultisignatureInput> multisignatureInputs;
+      std::vector<OutputCacheDelta> outputs;
+
+      void serialize(ISerializer& s) {
+        s(hash, "hash");
+        s(keyImages, "key_images");
+        s(multisignatureInputs, "multisig_inputs");
+        s(outputs, "outputs");
+      }
+    };
+
+    // What pushing or popping a block changes in the indexes saved by storeCache(), one record of the cache journal
+    struct BlockCacheDelta {
+      bool pushed;
+      uint32_t height;
+      Crypto::Hash hash;
+      std::vector<TransactionCacheDelta> transactions;
+
+      void serialize(ISerializer& s) {
+        s(pushed, "pushed");
+        s(height, "height");
+        s(hash, "hash");
+        s(transactions, "transactions");
+      }
+    };
+
     typedef google::sparse_hash_set<Crypto::KeyImage> key_images_container;
     typedef std::unordered_map<Crypto::Hash, BlockEntry> blocks_ext_by_hash;
-    typedef google::sparse_hash_map<uint64_t, std::vector<std::pair<TransactionIndex, uint16_t>>> outputs_container; //Crypto::Hash - tx hash, size_t - index of out in transaction
+    typedef google::sparse_hash_map<uint64_t, std::vector<OutputReference>> outputs_container;
+    typedef google::sparse_hash_map<uint64_t, std::vector<KeyOutputEntry>> key_outputs_container; // same order as outputs_container
     typedef google::sparse_hash_map<uint64_t, std::vector<MultisignatureOutputUsage>> MultisignatureOutputsContainer;
 
     const Currency& m_currency;
     tx_memory_pool& m_tx_pool;
-    std::recursive_mutex m_blockchain_lock; // TODO: add here reader/writer lock
+    Tools::RecursiveSharedMutex m_blockchain_lock;
     Crypto::cn_context m_cn_context;
+    CheckedProofOfWork m_checkedProofOfWork;
+    CheckedRingSignatures m_checkedRingSignatures;
+    RingSignatureVerifier m_ringSignatureVerifier;
+    VerifiedTransactionCache m_verifiedTransactions;
     Tools::ObserverManager<IBlockchainStorageObserver> m_observerManager;
 
     key_images_container m_spent_keys;
+    // Answers most lookups of unspent key images without m_blockchain_lock. It is replaced by one twice the size,
+    // under the exclusive lock, when it is full. Replaced filters are kept for readers that may still use them,
+    // together they take about as much memory as the current one.
+    std::atomic<KeyImageFilter*> m_spentKeysFilter;
+    std::vector<std::unique_ptr<KeyImageFilter>> m_spentKeysFilters;
+    size_t m_staleSpentKeys; // erased from m_spent_keys but still in the filter
     size_t m_current_block_cumul_sz_limit;
     blocks_ext_by_hash m_alternative_chains; // Crypto::Hash -> block_extended_info
     outputs_container m_outputs;
+    key_outputs_container m_keyOutputs;
 
     std::string m_config_folder;
     Checkpoints m_checkpoints;
     std::atomic<bool> m_is_in_checkpoint_zone;
 
-    typedef SwappedVector<BlockEntry> Blocks;
+    typedef MappedVector<BlockEntry> Blocks;
     typedef std::unordered_map<Crypto::Hash, uint32_t> BlockMap;
-    typedef std::unordered_map<Crypto::Hash, TransactionIndex> TransactionMap;
+    typedef FlatHashMap<Crypto::Hash, TransactionIndex> TransactionMap;
 
     friend class BlockCacheSerializer;
     friend class BlockchainIndexesSerializer;
 
     Blocks m_blocks;
+    size_t m_blocksCacheSize;
+    std::ofstream m_cacheJournal;
+    uint32_t m_cacheJournalLength;
     CryptoNote::BlockIndex m_blockIndex;
     TransactionMap m_transactionMap;
     MultisignatureOutputsContainer m_multisignatureOutputs;
@@ -258,8 +396,16 @@ namespace CryptoNote {
 
     Logging::LoggerRef logger;
 
-    void rebuildCache();
+    bool rebuildCache();
+    bool importBlocks(const std::string& blocksFileName, const std::string& indexesFileName);
     bool storeCache();
+    bool loadCache();
+    uint64_t replayCacheJournal(const std::string& fileName, const Crypto::Hash& snapshotTailId, uint32_t& replayedBlocks);
+    bool resetCacheJournal(const Crypto::Hash& snapshotTailId);
+    void journalBlock(const BlockCacheDelta& delta);
+    BlockCacheDelta makeCacheDelta(bool pushed, uint32_t height, const BlockEntry& block, const Crypto::Hash& blockHash, const Crypto::Hash& baseTransactionHash);
+    void applyCacheDelta(const BlockCacheDelta& delta);
+    void revertCacheDelta(const BlockCacheDelta& delta);
     bool switch_to_alternative_blockchain(std::list<blocks_ext_by_hash::iterator>& alt_chain, bool discard_disconnected_chain);
     bool handle_alternative_block(const Block& b, const Crypto::Hash& id, block_verification_context& bvc, bool sendNewAlternativeBlockMessage = true);
     difficulty_type get_next_difficulty_for_alternative_chain(const std::list<blocks_ext_by_hash::iterator>& alt_chain, BlockEntry& bei);
@@ -267,25 +413,31 @@ namespace CryptoNote {
     bool validate_miner_transaction(const Block& b, uint32_t height, size_t cumulativeBlockSize, uint64_t alreadyGeneratedCoins, uint64_t fee, uint64_t& reward, int64_t& emissionChange);
     bool rollback_blockchain_switching(std::list<Block>& original_chain, size_t rollback_height);
     bool get_last_n_blocks_sizes(std::vector<size_t>& sz, size_t count);
-    bool add_out_to_get_random_outs(std::vector<std::pair<TransactionIndex, uint16_t>>& amount_outs, COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS_outs_for_amount& result_outs, uint64_t amount, size_t i);
+    bool add_out_to_get_random_outs(const std::vector<KeyOutputEntry>& amount_outs, COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS_outs_for_amount& result_outs, size_t i);
     bool is_tx_spendtime_unlocked(uint64_t unlock_time);
-    size_t find_end_of_allowed_index(const std::vector<std::pair<TransactionIndex, uint16_t>>& amount_outs);
+    size_t find_end_of_allowed_index(const std::vector<OutputReference>& amount_outs);
     bool check_block_timestamp_main(const Block& b);
     bool check_block_timestamp(std::vector<uint64_t> timestamps, const Block& b);
     uint64_t get_adjusted_time();
     bool complete_timestamps_vector(uint64_t start_height, std::vector<uint64_t>& timestamps);
     bool checkCumulativeBlockSize(const Crypto::Hash& blockId, size_t cumulativeBlockSize, uint64_t height);
+    bool precheckProofOfWork(const CachedBlock& block, CheckedProofOfWork& result);
+    bool precheckRingSignatures(const CachedBlock& block, CheckedRingSignatures& result);
+    bool isTransactionVerified(const Crypto::Hash& transactionHash, uint32_t maxUsedBlockHeight);
     std::vector<Crypto::Hash> doBuildSparseChain(const Crypto::Hash& startBlockId) const;
     bool getBlockCumulativeSize(const Block& block, size_t& cumulativeSize);
     bool update_next_comulative_size_limit();
-    bool check_tx_input(const KeyInput& txin, const Crypto::Hash& tx_prefix_hash, const std::vector<Crypto::Signature>& sig, uint32_t* pmax_related_block_height = NULL);
-    bool checkTransactionInputs(const Transaction& tx, const Crypto::Hash& tx_prefix_hash, uint32_t* pmax_used_block_height = NULL);
-    bool checkTransactionInputs(const Transaction& tx, uint32_t* pmax_used_block_height = NULL);
+    bool check_tx_input(const KeyInput& txin, const Crypto::Hash& tx_prefix_hash, const std::vector<Crypto::Signature>& sig, uint32_t* pmax_related_block_height = NULL, std::vector<RingSignatureCheck>* ringSignatureChecks = NULL);
+    bool checkTransactionInputs(const CachedTransaction& tx, uint32_t* pmax_used_block_height = NULL, std::vector<RingSignatureCheck>* ringSignatureChecks = NULL);
     bool have_tx_keyimg_as_spent(const Crypto::KeyImage &key_im);
+    bool insertSpentKey(const Crypto::KeyImage& keyImage);
+    bool eraseSpentKey(const Crypto::KeyImage& keyImage);
+    void rebuildSpentKeysFilter();
     const TransactionEntry& transactionByIndex(TransactionIndex index);
     bool pushBlock(const Block& blockData, block_verification_context& bvc);
-    bool pushBlock(const Block& blockData, const std::vector<Transaction>& transactions, block_verification_context& bvc);
-    bool pushBlock(BlockEntry& block);
+    bool pushBlock(const CachedBlock& cachedBlock, block_verification_context& bvc);
+    bool pushBlock(const CachedBlock& cachedBlock, const std::vector<CachedTransaction>& transactions, block_verification_context& bvc);
+    bool pushBlock(BlockEntry& block, const Crypto::Hash& blockHash, const Crypto::Hash& baseTransactionHash);
     void popBlock(const Crypto::Hash& blockHash);
     bool pushTransaction(BlockEntry& block, const Crypto::Hash& transactionHash, TransactionIndex transactionIndex);
     void popTransaction(const Transaction& transaction, const Crypto::Hash& transactionHash);
@@ -295,19 +447,37 @@ namespace CryptoNote {
     bool storeBlockchainIndexes();
     bool loadBlockchainIndexes();
 
-    bool loadTransactions(const Block& block, std::vector<Transaction>& transactions);
-    void saveTransactions(const std::vector<Transaction>& transactions);
+    bool loadTransactions(const Block& block, std::vector<tx_memory_pool::TransactionDetails>& transactions);
+    void saveTransactions(const std::vector<CachedTransaction>& transactions);
 
     void sendMessage(const BlockchainMessage& message);
 
     friend class LockedBlockchainStorage;
+    friend class SharedLockedBlockchainStorage;
   };
 
   class LockedBlockchainStorage: boost::noncopyable {
   public:
 
     LockedBlockchainStorage(Blockchain& bc)
-      : m_bc(bc), m_lock(bc.m_blockchain_lock) {}
+      : m_bc(bc), m_lock(bc) {}
+
+    Blockchain* operator -> () {
+      return &m_bc;
+    }
+
+  private:
+
+    Blockchain& m_bc;
+    Blockchain::WriteLock m_lock;
+  };
+
+  // Same as LockedBlockchainStorage for read-only use, several of these can be held at once
+  class SharedLockedBlockchainStorage: boost::noncopyable {
+  public:
+
+    SharedLockedBlockchainStorage(Blockchain& bc)
+      : m_bc(bc), m_lock(bc) {}
 
     Blockchain* operator -> () {
       return &m_bc;
@@ -316,17 +486,17 @@ namespace CryptoNote {
   private:
 
     Blockchain& m_bc;
-    std::lock_guard<std::recursive_mutex> m_lock;
+    Blockchain::ReadLock m_lock;
   };
 
   template<class visitor_t> bool Blockchain::scanOutputKeysForIndexes(const KeyInput& tx_in_to_key, visitor_t& vis, uint32_t* pmax_related_block_height) {
-    std::lock_guard<std::recursive_mutex> lk(m_blockchain_lock);
+    ReadLock lk(*this);
     auto it = m_outputs.find(tx_in_to_key.amount);
     if (it == m_outputs.end() || !tx_in_to_key.outputIndexes.size())
       return false;
 
     std::vector<uint32_t> absolute_offsets = relative_output_offsets_to_absolute(tx_in_to_key.outputIndexes);
-    std::vector<std::pair<TransactionIndex, uint16_t>>& amount_outs_vec = it->second;
+    std::vector<OutputReference>& amount_outs_vec = it->second;
     size_t count = 0;
     for (uint64_t i : absolute_offsets) {
       if(i >= amount_outs_vec.size() ) {
@@ -337,24 +507,24 @@ namespace CryptoNote {
       //auto tx_it = m_transactionMap.find(amount_outs_vec[i].first);
       //if (!(tx_it != m_transactionMap.end())) { logger(ERROR, BRIGHT_RED) << "Wrong transaction id in output indexes: " << Common::podToHex(amount_outs_vec[i].first); return false; }
 
-      const TransactionEntry& tx = transactionByIndex(amount_outs_vec[i].first);
+      const TransactionEntry& tx = transactionByIndex(amount_outs_vec[i].transactionIndex());
 
-      if (!(amount_outs_vec[i].second < tx.tx.outputs.size())) {
+      if (!(amount_outs_vec[i].output < tx.tx.outputs.size())) {
         logger(Logging::ERROR, Logging::BRIGHT_RED)
             << "Wrong index in transaction outputs: "
-            << amount_outs_vec[i].second << ", expected less then "
+            << amount_outs_vec[i].output << ", expected less then "
             << tx.tx.outputs.size();
         return false;
       }
 
-      if (!vis.handle_output(tx.tx, tx.tx.outputs[amount_outs_vec[i].second], amount_outs_vec[i].second)) {
+      if (!vis.handle_output(tx.tx, tx.tx.outputs[amount_outs_vec[i].output], amount_outs_vec[i].output)) {
         logger(Logging::INFO) << "Failed to handle_output for output no = " << count << ", with absolute offset " << i;
         return false;
       }
 
       if(count++ == absolute_offsets.size()-1 && pmax_related_block_height) {
-        if (*pmax_related_block_height < amount_outs_vec[i].first.block) {
-          *pmax_related_block_height = amount_outs_vec[i].first.block;
+        if (*pmax_related_block_height < amount_outs_vec[i].block) {
+          *pmax_related_block_height = amount_outs_vec[i].block;
         }
       }
     }
@@ -0,0 +1,65 @@
+// Copyright (c) 2018-2022 The Cash2 developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "CachedBlock.h"
+
+#include "CryptoNoteFormatUtils.h"
+#include "CryptoNoteTools.h"
+
+using namespace Crypto;
+
+namespace CryptoNote {
+
+CachedBlock::CachedBlock(const Block& block) : m_block(block), m_baseTransaction(block.baseTransaction) {
+}
+
+const Block& CachedBlock::getBlock() const {
+  return m_block;
+}
+
+const CachedTransaction& CachedBlock::getBaseTransaction() const {
+  return m_baseTransaction;
+}
+
+const Hash& CachedBlock::getTransactionTreeHash() const {
+  if (!m_transactionTreeHash.is_initialized()) {
+    m_transactionTreeHash = get_tx_tree_hash(m_baseTransaction.getTransactionBinaryArray(), m_block.transactionHashes);
+  }
+
+  return m_transactionTreeHash.get();
+}
+
+// A block that fails to serialize gets an empty hashing blob and a NULL_HASH hash, as get_block_hash() gives it
+const BinaryArray& CachedBlock::getBlockHashingBinaryArray() const {
+  if (!m_blockHashingBinaryArray.is_initialized()) {
+    m_blockHashingBinaryArray = BinaryArray();
+    if (!get_block_hashing_blob(m_block, getTransactionTreeHash(), m_blockHashingBinaryArray.get())) {
+      m_blockHashingBinaryArray->clear();
+    }
+  }
+
+  return m_blockHashingBinaryArray.get();
+}
+
+const Hash& CachedBlock::getBlockHash() const {
+  if (!m_blockHash.is_initialized()) {
+    const BinaryArray& blockHashingBinaryArray = getBlockHashingBinaryArray();
+    m_blockHash = blockHashingBinaryArray.empty() ? NULL_HASH : getObjectHash(blockHashingBinaryArray);
+  }
+
+  return m_blockHash.get();
+}
+
+// Only meaningful if the hashing blob isn't empty, callers checking the proof of work have to check that first
+const Hash& CachedBlock::getBlockLongHash() const {
+  if (!m_blockLongHash.is_initialized()) {
+    Hash longHash = NULL_HASH;
+    get_block_longhash(getBlockHashingBinaryArray(), longHash);
+    m_blockLongHash = longHash;
+  }
+
+  return m_blockLongHash.get();
+}
+
+}
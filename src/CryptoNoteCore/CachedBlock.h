@@ -0,0 +1,36 @@
+// Copyright (c) 2018-2022 The Cash2 developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <boost/optional.hpp>
+
+#include "CryptoNoteCore/CachedTransaction.h"
+
+namespace CryptoNote {
+
+// Block with its hashing blob, hash and long hash, each computed the first time it is asked for and kept. The
+// transaction tree hash is built from the blob of the base transaction, which is kept as well. The block isn't copied,
+// it has to outlive this. Not thread safe.
+class CachedBlock {
+public:
+  explicit CachedBlock(const Block& block);
+
+  const Block& getBlock() const;
+  const CachedTransaction& getBaseTransaction() const;
+  const Crypto::Hash& getTransactionTreeHash() const;
+  const BinaryArray& getBlockHashingBinaryArray() const;
+  const Crypto::Hash& getBlockHash() const;
+  const Crypto::Hash& getBlockLongHash() const;
+
+private:
+  const Block& m_block;
+  CachedTransaction m_baseTransaction;
+  mutable boost::optional<Crypto::Hash> m_transactionTreeHash;
+  mutable boost::optional<BinaryArray> m_blockHashingBinaryArray;
+  mutable boost::optional<Crypto::Hash> m_blockHash;
+  mutable boost::optional<Crypto::Hash> m_blockLongHash;
+};
+
+}
@@ -0,0 +1,70 @@
+// Copyright (c) 2018-2022 The Cash2 developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "CachedTransaction.h"
+
+#include <limits>
+
+#include "CryptoNoteFormatUtils.h"
+#include "CryptoNoteTools.h"
+
+using namespace Crypto;
+
+namespace CryptoNote {
+
+CachedTransaction::CachedTransaction(const Transaction& transaction) : m_transaction(transaction) {
+}
+
+CachedTransaction::CachedTransaction(const Transaction& transaction, const Hash& transactionHash, const Hash& transactionPrefixHash, size_t transactionBinarySize) :
+  m_transaction(transaction),
+  m_transactionHash(transactionHash),
+  m_transactionPrefixHash(transactionPrefixHash),
+  m_transactionBinarySize(transactionBinarySize) {
+}
+
+const Transaction& CachedTransaction::getTransaction() const {
+  return m_transaction;
+}
+
+// A transaction that fails to serialize gets an empty blob, NULL_HASH hashes and the largest size, as getObjectHash() gives it
+const BinaryArray& CachedTransaction::getTransactionBinaryArray() const {
+  if (!m_transactionBinaryArray.is_initialized()) {
+    m_transactionBinaryArray = BinaryArray();
+    if (!toBinaryArray(m_transaction, m_transactionBinaryArray.get())) {
+      m_transactionBinaryArray->clear();
+    }
+  }
+
+  return m_transactionBinaryArray.get();
+}
+
+const Hash& CachedTransaction::getTransactionHash() const {
+  if (!m_transactionHash.is_initialized()) {
+    const BinaryArray& binaryArray = getTransactionBinaryArray();
+    m_transactionHash = binaryArray.empty() ? NULL_HASH : getBinaryArrayHash(binaryArray);
+  }
+
+  return m_transactionHash.get();
+}
+
+const Hash& CachedTransaction::getTransactionPrefixHash() const {
+  if (!m_transactionPrefixHash.is_initialized()) {
+    const BinaryArray& binaryArray = getTransactionBinaryArray();
+    m_transactionPrefixHash = binaryArray.empty() ? NULL_HASH :
+      cn_fast_hash(binaryArray.data(), get_tx_prefix_size(m_transaction, binaryArray.size()));
+  }
+
+  return m_transactionPrefixHash.get();
+}
+
+size_t CachedTransaction::getTransactionBinarySize() const {
+  if (!m_transactionBinarySize.is_initialized()) {
+    const BinaryArray& binaryArray = getTransactionBinaryArray();
+    m_transactionBinarySize = binaryArray.empty() ? (std::numeric_limits<size_t>::max)() : binaryArray.size();
+  }
+
+  return m_transactionBinarySize.get();
+}
+
+}
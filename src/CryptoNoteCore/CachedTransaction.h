@@ -0,0 +1,34 @@
+// Copyright (c) 2018-2022 The Cash2 developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <boost/optional.hpp>
+
+#include "CryptoNoteCore/CryptoNoteBasic.h"
+
+namespace CryptoNote {
+
+// Transaction with its blob, hash, prefix hash and size, each computed the first time it is asked for and kept, or
+// taken from whoever parsed the transaction. The transaction isn't copied, it has to outlive this. Not thread safe.
+class CachedTransaction {
+public:
+  explicit CachedTransaction(const Transaction& transaction);
+  CachedTransaction(const Transaction& transaction, const Crypto::Hash& transactionHash, const Crypto::Hash& transactionPrefixHash, size_t transactionBinarySize);
+
+  const Transaction& getTransaction() const;
+  const Crypto::Hash& getTransactionHash() const;
+  const Crypto::Hash& getTransactionPrefixHash() const;
+  const BinaryArray& getTransactionBinaryArray() const;
+  size_t getTransactionBinarySize() const;
+
+private:
+  const Transaction& m_transaction;
+  mutable boost::optional<BinaryArray> m_transactionBinaryArray;
+  mutable boost::optional<Crypto::Hash> m_transactionHash;
+  mutable boost::optional<Crypto::Hash> m_transactionPrefixHash;
+  mutable boost::optional<size_t> m_transactionBinarySize;
+};
+
+}
@@ -8,6 +8,7 @@
 #include "Core.h"
 
 #include <sstream>
+#include <thread>
 #include <unordered_set>
 #include "../CryptoNoteConfig.h"
 #include "../Common/CommandLine.h"
@@ -61,7 +62,8 @@ logger(logger, "core"),
 m_mempool(currency, m_blockchain, m_timeProvider, logger),
 m_blockchain(currency, m_mempool, logger),
 m_miner(new miner(currency, *this, logger)),
-m_starter_message_showed(false) {
+m_starter_message_showed(false),
+m_transactionWorkers(std::max(1u, std::thread::hardware_concurrency()) - 1) {
   set_cryptonote_protocol(pprotocol);
   m_blockchain.addObserver(this);
     m_mempool.addObserver(this);
@@ -123,6 +125,7 @@ size_t core::get_alternative_blocks_count() {
     bool r = m_mempool.init(m_config_folder);
   if (!(r)) { logger(ERROR, BRIGHT_RED) << "Failed to initialize memory pool"; return false; }
 
+  m_blockchain.setBlocksCacheSize(config.blocksCacheSize);
   r = m_blockchain.init(m_config_folder, load_existing);
   if (!(r)) { logger(ERROR, BRIGHT_RED) << "Failed to initialize blockchain storage"; return false; }
 
@@ -154,15 +157,11 @@ size_t core::addChain(const std::vector<const IBlock*>& chain) {
   for (const IBlock* block : chain) {
     bool allTransactionsAdded = true;
     for (size_t txNumber = 0; txNumber < block->getTransactionCount(); ++txNumber) {
-      const Transaction& tx = block->getTransaction(txNumber);
-
-      Crypto::Hash txHash = NULL_HASH;
-      size_t blobSize = 0;
-      getObjectHash(tx, txHash, blobSize);
+      CachedTransaction transaction(block->getTransaction(txNumber));
       tx_verification_context tvc = boost::value_initialized<tx_verification_context>();
 
-      if (!handleIncomingTransaction(tx, txHash, blobSize, tvc, true, get_block_height(block->getBlock()))) {
-        logger(ERROR, BRIGHT_RED) << "core::addChain() failed to handle transaction " << txHash << " from block " << blocksCounter << "/" << chain.size();
+      if (!handleIncomingTransaction(transaction, tvc, true, get_block_height(block->getBlock()))) {
+        logger(ERROR, BRIGHT_RED) << "core::addChain() failed to handle transaction " << transaction.getTransactionHash() << " from block " << blocksCounter << "/" << chain.size();
         allTransactionsAdded = false;
         break;
       }
@@ -173,9 +172,10 @@ size_t core::addChain(const std::vector<const IBlock*>& chain) {
     }
 
     block_verification_context bvc = boost::value_initialized<block_verification_context>();
-    m_blockchain.addNewBlock(block->getBlock(), bvc);
+    CachedBlock cachedBlock(block->getBlock());
+    m_blockchain.addNewBlock(cachedBlock, bvc);
     if (bvc.m_marked_as_orphaned || bvc.m_verification_failed) {
-      logger(ERROR, BRIGHT_RED) << "core::addChain() failed to handle incoming block " << get_block_hash(block->getBlock()) <<
+      logger(ERROR, BRIGHT_RED) << "core::addChain() failed to handle incoming block " << cachedBlock.getBlockHash() <<
         ", " << blocksCounter << "/" << chain.size();
       break;
     }
@@ -220,7 +220,77 @@ bool core::handle_incoming_tx(const BinaryArray& tx_blob, tx_verification_contex
     blockHeight = m_blockchain.getCurrentBlockchainHeight();
   }
 
-  return handleIncomingTransaction(tx, tx_hash, tx_blob.size(), tvc, kept_by_block, blockHeight);
+  return handleIncomingTransaction(CachedTransaction(tx, tx_hash, tx_prefixt_hash, tx_blob.size()), tvc, kept_by_block, blockHeight);
+}
+
+void core::handleIncomingTransactions(const std::vector<BinaryArray>& txBlobs, std::vector<tx_verification_context>& tvcs, bool keptByBlock) {
+  struct IncomingTransaction {
+    Transaction tx;
+    Crypto::Hash hash;
+    Crypto::Hash prefixHash;
+    bool valid;
+  };
+
+  tvcs.assign(txBlobs.size(), boost::value_initialized<tx_verification_context>());
+  std::vector<IncomingTransaction> transactions(txBlobs.size());
+
+  m_transactionWorkers.parallelFor(txBlobs.size(), m_transactionWorkers.threadCount(), [&](size_t i) {
+    IncomingTransaction& transaction = transactions[i];
+    transaction.valid = false;
+
+    if (txBlobs[i].size() > m_currency.maxTxSize()) {
+      logger(INFO) << "WRONG TRANSACTION BLOB, too big size " << txBlobs[i].size() << ", rejected";
+      tvcs[i].m_verification_failed = true;
+      return;
+    }
+
+    if (!parse_tx_from_blob(transaction.tx, transaction.hash, transaction.prefixHash, txBlobs[i])) {
+      logger(INFO) << "WRONG TRANSACTION BLOB, Failed to parse, rejected";
+      tvcs[i].m_verification_failed = true;
+      return;
+    }
+
+    Crypto::Hash blockIdIgnore;
+    uint32_t blockHeight;
+    if (!getBlockContainingTx(transaction.hash, blockIdIgnore, blockHeight)) {
+      blockHeight = m_blockchain.getCurrentBlockchainHeight();
+    }
+
+    transaction.valid = prevalidateTransaction(CachedTransaction(transaction.tx, transaction.hash, transaction.prefixHash, txBlobs[i].size()),
+      tvcs[i], keptByBlock, blockHeight);
+  });
+
+  // the hashes found when parsing are passed on, so no transaction is serialized again
+  std::vector<CachedTransaction> cachedTransactions;
+  std::vector<const CachedTransaction*> prevalidated;
+  cachedTransactions.reserve(transactions.size());
+  for (size_t i = 0; i < transactions.size(); ++i) {
+    if (transactions[i].valid) {
+      cachedTransactions.emplace_back(transactions[i].tx, transactions[i].hash, transactions[i].prefixHash, txBlobs[i].size());
+      prevalidated.push_back(&cachedTransactions.back());
+    }
+  }
+
+  std::vector<bool> invalidSignatures;
+  m_blockchain.preverifyRingSignatures(prevalidated, invalidSignatures);
+
+  // the key image conflicts are only known once the transactions before are in the pool
+  auto invalidSignature = invalidSignatures.begin();
+  auto cachedTransaction = cachedTransactions.begin();
+  for (size_t i = 0; i < transactions.size(); ++i) {
+    if (!transactions[i].valid) {
+      continue;
+    }
+
+    const CachedTransaction& transaction = *cachedTransaction++;
+    if (*invalidSignature++ && !keptByBlock) {
+      logger(INFO) << "Failed to check ring signature for tx " << transactions[i].hash << ", rejected";
+      tvcs[i].m_verification_failed = true;
+      continue;
+    }
+
+    handlePrevalidatedTransaction(transaction, tvcs[i], keptByBlock);
+  }
 }
 
 bool core::get_stat_info(core_stat_info& st_inf) {
@@ -229,6 +299,9 @@ bool core::get_stat_info(core_stat_info& st_inf) {
   st_inf.blockchain_height = m_blockchain.getCurrentBlockchainHeight();
   st_inf.tx_pool_size = m_mempool.get_transactions_count();
   st_inf.top_block_id_str = Common::podToHex(m_blockchain.getTailId());
+  size_t filterSize;
+  m_blockchain.getSpentKeysFilterInfo(filterSize, st_inf.spent_keys_filter_false_positive_rate);
+  st_inf.spent_keys_filter_size = filterSize;
   return true;
 }
 
@@ -403,11 +476,13 @@ size_t core::get_blockchain_total_transactions() {
 //  return m_blockchain.get_outs(amount, pkeys);
 //}
 
-bool core::add_new_tx(const Transaction& tx, const Crypto::Hash& tx_hash, size_t blob_size, tx_verification_context& tvc, bool kept_by_block) {
+bool core::add_new_tx(const CachedTransaction& transaction, tx_verification_context& tvc, bool kept_by_block) {
   //Locking on m_mempool and m_blockchain closes possibility to add tx to memory pool which is already in blockchain 
   std::lock_guard<decltype(m_mempool)> lk(m_mempool);
   LockedBlockchainStorage lbs(m_blockchain);
 
+  const Crypto::Hash& tx_hash = transaction.getTransactionHash();
+
   if (m_blockchain.haveTransaction(tx_hash)) {
     logger(TRACE) << "tx " << tx_hash << " is already in blockchain";
     return true;
@@ -420,7 +495,7 @@ bool core::add_new_tx(const Transaction& tx, const Crypto::Hash& tx_hash, size_t
 
   uint32_t blockchainHeight = m_blockchain.getCurrentBlockchainHeight();
 
-  return m_mempool.add_tx(tx, tx_hash, blob_size, tvc, kept_by_block, blockchainHeight);
+  return m_mempool.add_tx(transaction, tvc, kept_by_block, blockchainHeight);
 }
 
 bool core::get_block_template(Block& b, const AccountPublicAddress& adr, difficulty_type& diffic, uint32_t& blockchainHeight, const BinaryArray& ex_nonce) {
@@ -606,7 +681,8 @@ bool core::handle_incoming_block(const Block& b, block_verification_context& bvc
     pause_mining();
   }
 
-  m_blockchain.addNewBlock(b, bvc);
+  CachedBlock cachedBlock(b);
+  m_blockchain.addNewBlock(cachedBlock, bvc);
 
   if (control_miner) {
     update_block_template_and_resume_mining();
@@ -616,12 +692,12 @@ bool core::handle_incoming_block(const Block& b, block_verification_context& bvc
     std::list<Crypto::Hash> missed_txs;
     std::list<Transaction> txs;
     m_blockchain.getTransactions(b.transactionHashes, txs, missed_txs);
-    if (!missed_txs.empty() && getBlockIdByHeight(get_block_height(b)) != get_block_hash(b)) {
+    if (!missed_txs.empty() && getBlockIdByHeight(get_block_height(b)) != cachedBlock.getBlockHash()) {
       logger(INFO) << "Block added, but it seems that reorganize just happened after that, do not relay this block";
     } else {
       if (!(txs.size() == b.transactionHashes.size() && missed_txs.empty())) {
         logger(ERROR, BRIGHT_RED) << "can't find some transactions in found block:" <<
-          get_block_hash(b) << " txs.size()=" << txs.size() << ", b.transactionHashes.size()=" << b.transactionHashes.size() << ", missed_txs.size()" << missed_txs.size(); return false;
+          cachedBlock.getBlockHash() << " txs.size()=" << txs.size() << ", b.transactionHashes.size()=" << b.transactionHashes.size() << ", missed_txs.size()" << missed_txs.size(); return false;
       }
 
       NOTIFY_NEW_BLOCK::request arg;
@@ -683,7 +759,7 @@ std::vector<Crypto::Hash> core::buildSparseChain() {
 }
 
 std::vector<Crypto::Hash> core::buildSparseChain(const Crypto::Hash& startBlockId) {
-  LockedBlockchainStorage lbs(m_blockchain);
+  SharedLockedBlockchainStorage lbs(m_blockchain);
   assert(m_blockchain.haveBlock(startBlockId));
   return m_blockchain.buildSparseChain(startBlockId);
 }
@@ -693,7 +769,7 @@ bool core::handle_get_objects(NOTIFY_REQUEST_GET_OBJECTS::request& arg, NOTIFY_R
 }
 
 Crypto::Hash core::getBlockIdByHeight(uint32_t height) {
-  LockedBlockchainStorage lbs(m_blockchain);
+  SharedLockedBlockchainStorage lbs(m_blockchain);
   if (height < m_blockchain.getCurrentBlockchainHeight()) {
     return m_blockchain.getBlockIdByHeight(height);
   } else {
@@ -764,7 +840,7 @@ void core::poolUpdated() {
 bool core::queryBlocks(const std::vector<Crypto::Hash>& knownBlockIds, uint64_t timestamp,
   uint32_t& resStartHeight, uint32_t& resCurrentHeight, uint32_t& resFullOffset, std::vector<BlockFullInfo>& entries) {
 
-  LockedBlockchainStorage lbs(m_blockchain);
+  SharedLockedBlockchainStorage lbs(m_blockchain);
 
   uint32_t currentHeight = lbs->getCurrentBlockchainHeight();
   uint32_t startOffset = 0;
@@ -820,8 +896,68 @@ bool core::queryBlocks(const std::vector<Crypto::Hash>& knownBlockIds, uint64_t
   return true;
 }
 
+bool core::getRawBlockchainSupplement(const std::vector<Crypto::Hash>& remoteBlockIds, size_t maxCount, uint32_t& totalBlockCount, uint32_t& startBlockIndex,
+  const std::function<void(const std::vector<Blockchain::RawBlock>& blocks)>& handler) {
+
+  SharedLockedBlockchainStorage lbs(m_blockchain);
+
+  std::vector<Crypto::Hash> blockIds = findBlockchainSupplement(remoteBlockIds, maxCount, totalBlockCount, startBlockIndex);
+  std::vector<Blockchain::RawBlock> blocks;
+  blocks.reserve(blockIds.size());
+  for (uint32_t i = 0; i < blockIds.size(); ++i) {
+    Blockchain::RawBlock block;
+    if (!lbs->getRawBlock(startBlockIndex + i, block)) {
+      return false;
+    }
+
+    blocks.push_back(std::move(block));
+  }
+
+  handler(blocks);
+  return true;
+}
+
+bool core::queryRawBlocks(const std::vector<Crypto::Hash>& knownBlockIds, uint64_t timestamp, uint32_t& resStartHeight, uint32_t& resCurrentHeight, uint32_t& resFullOffset,
+  const std::function<void(const std::vector<Crypto::Hash>& shortBlockIds, const std::vector<Blockchain::RawBlock>& blocks)>& handler) {
+
+  SharedLockedBlockchainStorage lbs(m_blockchain);
+
+  uint32_t currentHeight = lbs->getCurrentBlockchainHeight();
+  uint32_t startOffset = 0;
+  uint32_t startFullOffset = 0;
+
+  if (!findStartAndFullOffsets(knownBlockIds, timestamp, startOffset, startFullOffset)) {
+    return false;
+  }
+
+  resFullOffset = startFullOffset;
+  resCurrentHeight = currentHeight;
+  resStartHeight = startOffset;
+
+  std::vector<Crypto::Hash> shortBlockIds = findIdsForShortBlocks(startOffset, startFullOffset);
+  uint32_t blocksLeft = static_cast<uint32_t>(std::min(BLOCKS_IDS_SYNCHRONIZING_DEFAULT_COUNT - shortBlockIds.size(), size_t(BLOCKS_SYNCHRONIZING_DEFAULT_COUNT)));
+
+  std::vector<Blockchain::RawBlock> blocks;
+  for (uint32_t height = startFullOffset; height < currentHeight && blocks.size() < blocksLeft; ++height) {
+    Blockchain::RawBlock block;
+    if (!lbs->getRawBlock(height, block)) {
+      return false;
+    }
+
+    if (block.timestamp < timestamp) {
+      block.block = Common::StringView::EMPTY;
+      block.transactions.clear();
+    }
+
+    blocks.push_back(std::move(block));
+  }
+
+  handler(shortBlockIds, blocks);
+  return true;
+}
+
 bool core::findStartAndFullOffsets(const std::vector<Crypto::Hash>& knownBlockIds, uint64_t timestamp, uint32_t& startOffset, uint32_t& startFullOffset) {
-  LockedBlockchainStorage lbs(m_blockchain);
+  SharedLockedBlockchainStorage lbs(m_blockchain);
 
   if (knownBlockIds.empty()) {
     logger(ERROR, BRIGHT_RED) << "knownBlockIds is empty";
@@ -844,7 +980,7 @@ bool core::findStartAndFullOffsets(const std::vector<Crypto::Hash>& knownBlockId
 std::vector<Crypto::Hash> core::findIdsForShortBlocks(uint32_t startOffset, uint32_t startFullOffset) {
   assert(startOffset <= startFullOffset);
 
-  LockedBlockchainStorage lbs(m_blockchain);
+  SharedLockedBlockchainStorage lbs(m_blockchain);
 
   std::vector<Crypto::Hash> result;
   if (startOffset < startFullOffset) {
@@ -856,7 +992,7 @@ std::vector<Crypto::Hash> core::findIdsForShortBlocks(uint32_t startOffset, uint
 
 bool core::queryBlocksLite(const std::vector<Crypto::Hash>& knownBlockIds, uint64_t timestamp, uint32_t& resStartHeight,
   uint32_t& resCurrentHeight, uint32_t& resFullOffset, std::vector<BlockShortInfo>& entries) {
-  LockedBlockchainStorage lbs(m_blockchain);
+  SharedLockedBlockchainStorage lbs(m_blockchain);
 
   resCurrentHeight = lbs->getCurrentBlockchainHeight();
   resStartHeight = 0;
@@ -1058,8 +1194,19 @@ uint64_t core::getTotalGeneratedAmount() {
   return m_blockchain.getCoinsInCirculation();
 }
 
-bool core::handleIncomingTransaction(const Transaction& tx, const Crypto::Hash& txHash, size_t blobSize, tx_verification_context& tvc, bool keptByBlock, uint32_t blockHeight) {
-  
+bool core::handleIncomingTransaction(const CachedTransaction& transaction, tx_verification_context& tvc, bool keptByBlock, uint32_t blockHeight) {
+  if (!prevalidateTransaction(transaction, tvc, keptByBlock, blockHeight)) {
+    return false;
+  }
+
+  return handlePrevalidatedTransaction(transaction, tvc, keptByBlock);
+}
+
+bool core::prevalidateTransaction(const CachedTransaction& transaction, tx_verification_context& tvc, bool keptByBlock, uint32_t blockHeight) {
+  const Transaction& tx = transaction.getTransaction();
+  const Crypto::Hash& txHash = transaction.getTransactionHash();
+
+  // only checks that don't depend on the blockchain or the pool, so this can run on any thread
   if (!check_tx_syntax(tx)) {
     logger(INFO) << "WRONG TRANSACTION BLOB, Failed to check tx " << txHash << " syntax, rejected";
     tvc.m_verification_failed = true;
@@ -1078,12 +1225,17 @@ bool core::handleIncomingTransaction(const Transaction& tx, const Crypto::Hash&
     return false;
   }
 
-  if (!check_tx_fee(tx, blobSize, tvc, keptByBlock, blockHeight)) {
+  if (!check_tx_fee(tx, transaction.getTransactionBinarySize(), tvc, keptByBlock, blockHeight)) {
     tvc.m_verification_failed = true;
     return false;
   }
 
-  bool r = add_new_tx(tx, txHash, blobSize, tvc, keptByBlock);
+  return true;
+}
+
+bool core::handlePrevalidatedTransaction(const CachedTransaction& transaction, tx_verification_context& tvc, bool keptByBlock) {
+  const Crypto::Hash& txHash = transaction.getTransactionHash();
+  bool r = add_new_tx(transaction, tvc, keptByBlock);
   if (tvc.m_verification_failed) {
     if (!tvc.m_tx_fee_too_small) {
       logger(ERROR) << "Transaction verification failed: " << txHash;
@@ -1104,7 +1256,7 @@ bool core::handleIncomingTransaction(const Transaction& tx, const Crypto::Hash&
 
 std::unique_ptr<IBlock> core::getBlock(const Crypto::Hash& blockId) {
   std::lock_guard<decltype(m_mempool)> lk(m_mempool);
-  LockedBlockchainStorage lbs(m_blockchain);
+  SharedLockedBlockchainStorage lbs(m_blockchain);
 
   std::unique_ptr<BlockWithTransactions> blockPtr(new BlockWithTransactions());
   if (!lbs->getBlockByHash(blockId, blockPtr->block)) {
@@ -19,6 +19,7 @@
 #include "ICore.h"
 #include "ICoreObserver.h"
 #include "Common/ObserverManager.h"
+#include "Common/WorkerPool.h"
 
 #include "System/Dispatcher.h"
 #include "CryptoNoteCore/MessageQueue.h"
@@ -77,7 +78,10 @@ namespace CryptoNote {
     virtual bool getTransactionsByPaymentId(const Crypto::Hash& paymentId, std::vector<Transaction>& transactions) override;
     virtual bool getOutByMSigGIndex(uint64_t amount, uint64_t gindex, MultisignatureOutput& out) override;
     virtual std::unique_ptr<IBlock> getBlock(const Crypto::Hash& blocksId) override;
-    virtual bool handleIncomingTransaction(const Transaction& tx, const Crypto::Hash& txHash, size_t blobSize, tx_verification_context& tvc, bool keptByBlock, uint32_t blockHeight) override;
+    virtual bool handleIncomingTransaction(const CachedTransaction& transaction, tx_verification_context& tvc, bool keptByBlock, uint32_t blockHeight) override;
+    virtual bool prevalidateTransaction(const CachedTransaction& transaction, tx_verification_context& tvc, bool keptByBlock, uint32_t blockHeight) override;
+    virtual bool handlePrevalidatedTransaction(const CachedTransaction& transaction, tx_verification_context& tvc, bool keptByBlock) override;
+    virtual void handleIncomingTransactions(const std::vector<BinaryArray>& txBlobs, std::vector<tx_verification_context>& tvcs, bool keptByBlock) override;
     virtual std::error_code executeLocked(const std::function<std::error_code()>& func) override;
     virtual uint64_t getMinimalFeeForHeight(uint32_t height) override;
     virtual uint64_t getMinimalFee() override;
@@ -101,6 +105,12 @@ namespace CryptoNote {
     }
     virtual bool queryBlocks(const std::vector<Crypto::Hash>& block_ids, uint64_t timestamp, uint32_t& start_height, uint32_t& current_height, uint32_t& full_offset, std::vector<BlockFullInfo>& entries) override;
     virtual bool queryBlocksLite(const std::vector<Crypto::Hash>& knownBlockIds, uint64_t timestamp, uint32_t& resStartHeight, uint32_t& resCurrentHeight, uint32_t& resFullOffset, std::vector<BlockShortInfo>& entries) override;
+    // Same as findBlockchainSupplement() and queryBlocks(), but the blocks are handed to the handler as they are stored,
+    // while the blockchain is locked. Blocks older than timestamp get an empty block blob and no transactions.
+    bool getRawBlockchainSupplement(const std::vector<Crypto::Hash>& remoteBlockIds, size_t maxCount, uint32_t& totalBlockCount, uint32_t& startBlockIndex,
+      const std::function<void(const std::vector<Blockchain::RawBlock>& blocks)>& handler);
+    bool queryRawBlocks(const std::vector<Crypto::Hash>& knownBlockIds, uint64_t timestamp, uint32_t& resStartHeight, uint32_t& resCurrentHeight, uint32_t& resFullOffset,
+      const std::function<void(const std::vector<Crypto::Hash>& shortBlockIds, const std::vector<Blockchain::RawBlock>& blocks)>& handler);
     virtual Crypto::Hash getBlockIdByHeight(uint32_t height) override;
     void getTransactions(const std::vector<Crypto::Hash>& txs_ids, std::list<Transaction>& txs, std::list<Crypto::Hash>& missed_txs, bool checkTxPool = false) override;
     virtual bool getBlockByHash(const Crypto::Hash &h, Block &blk) override;
@@ -143,7 +153,7 @@ namespace CryptoNote {
     uint64_t getTotalGeneratedAmount();
 
   private:
-    bool add_new_tx(const Transaction& tx, const Crypto::Hash& tx_hash, size_t blob_size, tx_verification_context& tvc, bool kept_by_block);
+    bool add_new_tx(const CachedTransaction& transaction, tx_verification_context& tvc, bool kept_by_block);
     bool load_state_data();
     bool parse_tx_from_blob(Transaction& tx, Crypto::Hash& tx_hash, Crypto::Hash& tx_prefix_hash, const BinaryArray& blob);
     bool handle_incoming_block(const Block& b, block_verification_context& bvc, bool control_miner, bool relay_block);
@@ -182,5 +192,6 @@ namespace CryptoNote {
     friend class tx_validate_inputs;
     std::atomic<bool> m_starter_message_showed;
     Tools::ObserverManager<ICoreObserver> m_observerManager;
+    Tools::WorkerPool m_transactionWorkers;
   };
 }
@@ -7,11 +7,17 @@
 
 #include "Common/Util.h"
 #include "Common/CommandLine.h"
+#include "CryptoNoteConfig.h"
 
 namespace CryptoNote {
 
+namespace {
+const command_line::arg_descriptor<size_t> arg_block_cache_size = {"block-cache-size", "Number of deserialized blocks kept in memory", BLOCKS_CACHE_DEFAULT_SIZE};
+}
+
 CoreConfig::CoreConfig() {
   configFolder = Tools::getDefaultDataDirectory();
+  blocksCacheSize = BLOCKS_CACHE_DEFAULT_SIZE;
 }
 
 void CoreConfig::init(const boost::program_options::variables_map& options) {
@@ -19,8 +25,13 @@ void CoreConfig::init(const boost::program_options::variables_map& options) {
     configFolder = command_line::get_arg(options, command_line::arg_data_dir);
     configFolderDefaulted = options[command_line::arg_data_dir.name].defaulted();
   }
+
+  if (command_line::has_arg(options, arg_block_cache_size)) {
+    blocksCacheSize = command_line::get_arg(options, arg_block_cache_size);
+  }
 }
 
 void CoreConfig::initOptions(boost::program_options::options_description& desc) {
+  command_line::add_arg(desc, arg_block_cache_size);
 }
 } //namespace CryptoNote
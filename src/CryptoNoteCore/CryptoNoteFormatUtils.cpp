@@ -37,7 +37,7 @@ bool parseAndValidateTransactionFromBinaryArray(const BinaryArray& tx_blob, Tran
 
   //TODO: validate tx
   cn_fast_hash(tx_blob.data(), tx_blob.size(), tx_hash);
-  getObjectHash(*static_cast<TransactionPrefix*>(&tx), tx_prefix_hash);
+  cn_fast_hash(tx_blob.data(), get_tx_prefix_size(tx, tx_blob.size()), tx_prefix_hash);
   return true;
 }
 
@@ -457,12 +457,16 @@ bool lookup_acc_outs(const AccountKeys& acc, const Transaction& tx, const Public
 }
 
 bool get_block_hashing_blob(const Block& b, BinaryArray& ba) {
+  return get_block_hashing_blob(b, get_tx_tree_hash(b), ba);
+}
+
+bool get_block_hashing_blob(const Block& b, const Hash& merkleRoot, BinaryArray& ba) {
   BlockHeader blockHeader;
 
   blockHeader.previousBlockHash = b.previousBlockHash;
   blockHeader.nonce = b.nonce;
   blockHeader.timestamp = b.timestamp;
-  blockHeader.merkleRoot = get_tx_tree_hash(b);
+  blockHeader.merkleRoot = merkleRoot;
 
   if (!toBinaryArray(blockHeader, ba)) {
     return false;
@@ -501,8 +505,12 @@ bool get_block_longhash(cn_context &context, const Block& b, Hash& res) {
     return false;
   }
 
+  return get_block_longhash(bd, res);
+}
+
+bool get_block_longhash(const BinaryArray& hashingBlob, Hash& res) {
   size_t hashLength = 32;
-  int result = blake2b(&res, hashLength, bd.data(), bd.size(), nullptr, 0);
+  int result = blake2b(&res, hashLength, hashingBlob.data(), hashingBlob.size(), nullptr, 0);
 
   if (result == -1)
   {
@@ -512,6 +520,15 @@ bool get_block_longhash(cn_context &context, const Block& b, Hash& res) {
   return true;
 }
 
+size_t get_tx_prefix_size(const Transaction& tx, size_t blobSize) {
+  size_t signaturesSize = 0;
+  for (const auto& signatures : tx.signatures) {
+    signaturesSize += signatures.size() * sizeof(Signature);
+  }
+
+  return blobSize - signaturesSize;
+}
+
 std::vector<uint32_t> relative_output_offsets_to_absolute(const std::vector<uint32_t>& off) {
   std::vector<uint32_t> res = off;
   for (size_t i = 1; i < res.size(); i++)
@@ -545,6 +562,10 @@ Hash get_tx_tree_hash(const Block& b) {
  
   toBinaryArray(b.baseTransaction, baseTransactionBA);
 
+  return get_tx_tree_hash(baseTransactionBA, b.transactionHashes);
+}
+
+Hash get_tx_tree_hash(const BinaryArray& baseTransactionBA, const std::vector<Hash>& transactionHashes) {
   std::vector<Hash> txs_ids;
 
   if (baseTransactionBA.size() > 120)
@@ -587,14 +608,15 @@ Hash get_tx_tree_hash(const Block& b) {
 
     // Prepend null byte to the base transaction binary array to comply with
     // Siacoin stratum protocol
-    baseTransactionBA.insert(baseTransactionBA.begin(), 0);
+    BinaryArray prefixedBaseTransactionBA(1, 0);
+    prefixedBaseTransactionBA.insert(prefixedBaseTransactionBA.end(), baseTransactionBA.begin(), baseTransactionBA.end());
 
-    Hash baseTransactionHash = getBinaryArrayHash(baseTransactionBA);
+    Hash baseTransactionHash = getBinaryArrayHash(prefixedBaseTransactionBA);
 
     txs_ids.push_back(baseTransactionHash);
   }
 
-  for (auto& th : b.transactionHashes) {
+  for (auto& th : transactionHashes) {
     txs_ids.push_back(th);
   }
 
@@ -58,10 +58,14 @@ bool generate_key_image_helper(const AccountKeys& ack, const Crypto::PublicKey&
 std::string short_hash_str(const Crypto::Hash& h);
 
 bool get_block_hashing_blob(const Block& b, BinaryArray& blob);
+bool get_block_hashing_blob(const Block& b, const Crypto::Hash& merkleRoot, BinaryArray& blob);
 bool get_aux_block_header_hash(const Block& b, Crypto::Hash& res);
 bool get_block_hash(const Block& b, Crypto::Hash& res);
 Crypto::Hash get_block_hash(const Block& b);
 bool get_block_longhash(Crypto::cn_context &context, const Block& b, Crypto::Hash& res);
+bool get_block_longhash(const BinaryArray& hashingBlob, Crypto::Hash& res);
+// Size of the prefix in the blob of the transaction, the signatures follow it without a size
+size_t get_tx_prefix_size(const Transaction& tx, size_t blobSize);
 bool get_inputs_money_amount(const Transaction& tx, uint64_t& money);
 uint64_t get_outs_money_amount(const Transaction& tx);
 bool check_inputs_types_supported(const TransactionPrefix& tx);
@@ -112,5 +116,6 @@ void decompose_amount_into_digits(uint64_t amount, uint64_t dust_threshold, cons
 void get_tx_tree_hash(const std::vector<Crypto::Hash>& tx_hashes, Crypto::Hash& h);
 Crypto::Hash get_tx_tree_hash(const std::vector<Crypto::Hash>& tx_hashes);
 Crypto::Hash get_tx_tree_hash(const Block& b);
+Crypto::Hash get_tx_tree_hash(const BinaryArray& baseTransactionBlob, const std::vector<Crypto::Hash>& transactionHashes);
 
 }
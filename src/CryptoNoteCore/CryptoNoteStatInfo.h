@@ -16,6 +16,8 @@ namespace CryptoNote
     uint64_t mining_speed;
     uint64_t alternative_blocks;
     std::string top_block_id_str;
+    uint64_t spent_keys_filter_size;
+    double spent_keys_filter_false_positive_rate;
     
     void serialize(ISerializer& s) {
       KV_MEMBER(tx_pool_size)
@@ -23,6 +25,8 @@ namespace CryptoNote
       KV_MEMBER(mining_speed)
       KV_MEMBER(alternative_blocks)
       KV_MEMBER(top_block_id_str)
+      KV_MEMBER(spent_keys_filter_size)
+      KV_MEMBER(spent_keys_filter_false_positive_rate)
     }
   };
 }
@@ -14,6 +14,7 @@
 #include "../Common/StringTools.h"
 
 #include "Account.h"
+#include "CachedBlock.h"
 #include "CryptoNoteBasicImpl.h"
 #include "CryptoNoteFormatUtils.h"
 #include "CryptoNoteTools.h"
@@ -63,7 +64,10 @@ bool Currency::init() {
   if (isTestnet()) {
     m_blocksFileName = "testnet_" + m_blocksFileName;
     m_blocksCacheFileName = "testnet_" + m_blocksCacheFileName;
+    m_blocksCacheJournalFileName = "testnet_" + m_blocksCacheJournalFileName;
     m_blockIndexesFileName = "testnet_" + m_blockIndexesFileName;
+    m_blockStoreFileName = "testnet_" + m_blockStoreFileName;
+    m_blockStoreIndexesFileName = "testnet_" + m_blockStoreIndexesFileName;
     m_txPoolFileName = "testnet_" + m_txPoolFileName;
     m_blockchainIndexesFileName = "testnet_" + m_blockchainIndexesFileName;
   }
@@ -595,20 +599,30 @@ difficulty_type Currency::nextDifficulty2(std::vector<uint64_t> timestamps, std:
 bool Currency::checkProofOfWork1(Crypto::cn_context& context, const Block& block, difficulty_type currentDiffic,
   Crypto::Hash& proofOfWork) const {
 
-  if (!get_block_longhash(context, block, proofOfWork)) {
+  return checkProofOfWork1(CachedBlock(block), currentDiffic, proofOfWork);
+}
+
+bool Currency::checkProofOfWork2(Crypto::cn_context& context, const Block& block, difficulty_type currentDiffic,
+  Crypto::Hash& proofOfWork) const {
+
+  return checkProofOfWork2(CachedBlock(block), currentDiffic, proofOfWork);
+}
+
+bool Currency::checkProofOfWork1(const CachedBlock& block, difficulty_type currentDiffic, Crypto::Hash& proofOfWork) const {
+  if (block.getBlockHashingBinaryArray().empty()) {
     return false;
   }
 
+  proofOfWork = block.getBlockLongHash();
   return check_hash1(proofOfWork, currentDiffic);
 }
 
-bool Currency::checkProofOfWork2(Crypto::cn_context& context, const Block& block, difficulty_type currentDiffic,
-  Crypto::Hash& proofOfWork) const {
-
-  if (!get_block_longhash(context, block, proofOfWork)) {
+bool Currency::checkProofOfWork2(const CachedBlock& block, difficulty_type currentDiffic, Crypto::Hash& proofOfWork) const {
+  if (block.getBlockHashingBinaryArray().empty()) {
     return false;
   }
 
+  proofOfWork = block.getBlockLongHash();
   return check_hash2(proofOfWork, currentDiffic);
 }
 
@@ -715,7 +729,10 @@ CurrencyBuilder::CurrencyBuilder(Logging::ILogger& log) : m_currency(log) {
 
   blocksFileName(parameters::CRYPTONOTE_BLOCKS_FILENAME);
   blocksCacheFileName(parameters::CRYPTONOTE_BLOCKSCACHE_FILENAME);
+  blocksCacheJournalFileName(parameters::CRYPTONOTE_BLOCKSCACHE_JOURNAL_FILENAME);
   blockIndexesFileName(parameters::CRYPTONOTE_BLOCKINDEXES_FILENAME);
+  blockStoreFileName(parameters::CRYPTONOTE_BLOCKSTORE_FILENAME);
+  blockStoreIndexesFileName(parameters::CRYPTONOTE_BLOCKSTOREINDEXES_FILENAME);
   txPoolFileName(parameters::CRYPTONOTE_POOLDATA_FILENAME);
   blockchainIndexesFileName(parameters::CRYPTONOTE_BLOCKCHAIN_INDEXES_FILENAME);
 
@@ -19,6 +19,7 @@
 namespace CryptoNote {
 
 class AccountBase;
+class CachedBlock;
 
 class Currency {
 public:
@@ -71,7 +72,10 @@ public:
 
   const std::string& blocksFileName() const { return m_blocksFileName; }
   const std::string& blocksCacheFileName() const { return m_blocksCacheFileName; }
+  const std::string& blocksCacheJournalFileName() const { return m_blocksCacheJournalFileName; }
   const std::string& blockIndexesFileName() const { return m_blockIndexesFileName; }
+  const std::string& blockStoreFileName() const { return m_blockStoreFileName; }
+  const std::string& blockStoreIndexesFileName() const { return m_blockStoreIndexesFileName; }
   const std::string& txPoolFileName() const { return m_txPoolFileName; }
   const std::string& blockchainIndexesFileName() const { return m_blockchainIndexesFileName; }
 
@@ -108,6 +112,8 @@ public:
   difficulty_type nextDifficulty2(std::vector<uint64_t> timestamps, std::vector<difficulty_type> cumulativeDifficulties) const;
   bool checkProofOfWork1(Crypto::cn_context& context, const Block& block, difficulty_type currentDiffic, Crypto::Hash& proofOfWork) const;
   bool checkProofOfWork2(Crypto::cn_context& context, const Block& block, difficulty_type currentDiffic, Crypto::Hash& proofOfWork) const;
+  bool checkProofOfWork1(const CachedBlock& block, difficulty_type currentDiffic, Crypto::Hash& proofOfWork) const;
+  bool checkProofOfWork2(const CachedBlock& block, difficulty_type currentDiffic, Crypto::Hash& proofOfWork) const;
 
   size_t getApproximateMaximumInputCount(size_t transactionSize, size_t outputCount, size_t mixinCount) const;
 
@@ -165,7 +171,10 @@ private:
 
   std::string m_blocksFileName;
   std::string m_blocksCacheFileName;
+  std::string m_blocksCacheJournalFileName;
   std::string m_blockIndexesFileName;
+  std::string m_blockStoreFileName;
+  std::string m_blockStoreIndexesFileName;
   std::string m_txPoolFileName;
   std::string m_blockchainIndexesFileName;
 
@@ -238,7 +247,10 @@ public:
 
   CurrencyBuilder& blocksFileName(const std::string& val) { m_currency.m_blocksFileName = val; return *this; }
   CurrencyBuilder& blocksCacheFileName(const std::string& val) { m_currency.m_blocksCacheFileName = val; return *this; }
+  CurrencyBuilder& blocksCacheJournalFileName(const std::string& val) { m_currency.m_blocksCacheJournalFileName = val; return *this; }
   CurrencyBuilder& blockIndexesFileName(const std::string& val) { m_currency.m_blockIndexesFileName = val; return *this; }
+  CurrencyBuilder& blockStoreFileName(const std::string& val) { m_currency.m_blockStoreFileName = val; return *this; }
+  CurrencyBuilder& blockStoreIndexesFileName(const std::string& val) { m_currency.m_blockStoreIndexesFileName = val; return *this; }
   CurrencyBuilder& txPoolFileName(const std::string& val) { m_currency.m_txPoolFileName = val; return *this; }
   CurrencyBuilder& blockchainIndexesFileName(const std::string& val) { m_currency.m_blockchainIndexesFileName = val; return *this; }
   
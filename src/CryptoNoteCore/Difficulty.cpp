@@ -7,6 +7,7 @@
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include <limits>
 #include <vector>
 
 #include "Common/int-util.h"
@@ -106,4 +107,14 @@ namespace CryptoNote {
     carry = cadc(high, top, carry);
     return !carry;
   }
+
+  uint64_t check_hash1_prefix_limit(difficulty_type difficulty) {
+    // the highest word times the difficulty has to fit in 64 bits
+    return difficulty == 0 ? std::numeric_limits<uint64_t>::max() : std::numeric_limits<uint64_t>::max() / difficulty;
+  }
+
+  uint64_t check_hash2_prefix_limit(difficulty_type difficulty) {
+    // 5 zero bytes followed by the first 3 bytes of the truncated hash's highest word
+    return check_hash1_prefix_limit(difficulty) >> 40;
+  }
 }
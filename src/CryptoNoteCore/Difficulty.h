@@ -16,4 +16,9 @@ namespace CryptoNote
 
     bool check_hash1(const Crypto::Hash &hash, difficulty_type difficulty);
     bool check_hash2(const Crypto::Hash &hash, difficulty_type difficulty);
+
+    // Largest first 64 bits of a hash, read as a big endian number, that can still pass check_hash1/check_hash2.
+    // Lets miners discard most hashes without the full check.
+    uint64_t check_hash1_prefix_limit(difficulty_type difficulty);
+    uint64_t check_hash2_prefix_limit(difficulty_type difficulty);
 }
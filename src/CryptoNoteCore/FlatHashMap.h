@@ -0,0 +1,300 @@
+// Copyright (c) 2018-2022 The Cash2 developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace CryptoNote {
+
+// Set of keys that are uniformly distributed already, like transaction hashes and key images, laid out for memory
+// and lookups: the keys are stored back to back in insertion order, and an open addressing table of 8 byte slots,
+// found from the first 8 bytes of a key mixed with a seed, points into them. The seed keeps keys from being chosen to
+// collide. Erasing a key moves the last one into its position.
+template<typename Key>
+class FlatHashSet {
+public:
+  static const size_t npos = static_cast<size_t>(-1);
+
+  explicit FlatHashSet(uint64_t seed) : m_seed(seed), m_shift(64) {
+  }
+
+  size_t size() const {
+    return m_keys.size();
+  }
+
+  bool empty() const {
+    return m_keys.empty();
+  }
+
+  const std::vector<Key>& keys() const {
+    return m_keys;
+  }
+
+  // Position of the key in keys(), npos if there is none
+  size_t find(const Key& key) const {
+    size_t i = findSlot(key);
+    return i == npos ? npos : m_slots[i].position;
+  }
+
+  bool contains(const Key& key) const {
+    return find(key) != npos;
+  }
+
+  std::pair<size_t, bool> insert(const Key& key) {
+    if ((m_keys.size() + 1) * 4 > m_slots.size() * 3) {
+      rehash(m_slots.empty() ? MIN_SLOTS : m_slots.size() * 2);
+    }
+
+    uint64_t hash = hashOf(key);
+    uint32_t tag = static_cast<uint32_t>(hash);
+    for (size_t i = hash >> m_shift;; i = (i + 1) & (m_slots.size() - 1)) {
+      Slot& slot = m_slots[i];
+      if (slot.position == EMPTY_SLOT) {
+        slot.position = static_cast<uint32_t>(m_keys.size());
+        slot.tag = tag;
+        m_keys.push_back(key);
+        return std::make_pair(slot.position, true);
+      }
+
+      if (slot.tag == tag && m_keys[slot.position] == key) {
+        return std::make_pair(slot.position, false);
+      }
+    }
+  }
+
+  size_t erase(const Key& key) {
+    size_t i = findSlot(key);
+    if (i == npos) {
+      return 0;
+    }
+
+    size_t position = m_slots[i].position;
+    removeSlot(i);
+
+    // the last key fills the gap, its slot follows it
+    size_t last = m_keys.size() - 1;
+    if (position != last) {
+      m_slots[findSlot(m_keys[last])].position = static_cast<uint32_t>(position);
+      m_keys[position] = m_keys[last];
+    }
+
+    m_keys.pop_back();
+    return 1;
+  }
+
+  void clear() {
+    m_keys.clear();
+    m_slots.clear();
+    m_shift = 64;
+  }
+
+  void reserve(size_t count) {
+    m_keys.reserve(count);
+    size_t slotCount = m_slots.empty() ? MIN_SLOTS : m_slots.size();
+    while (count * 4 > slotCount * 3) {
+      slotCount *= 2;
+    }
+
+    if (slotCount != m_slots.size()) {
+      rehash(slotCount);
+    }
+  }
+
+  // Takes the keys as they were returned by keys(), throws if one is there twice
+  void assign(std::vector<Key>&& keys) {
+    clear();
+    m_keys.swap(keys);
+    m_keys.shrink_to_fit();
+    size_t slotCount = MIN_SLOTS;
+    while (m_keys.size() * 4 > slotCount * 3) {
+      slotCount *= 2;
+    }
+
+    if (!rehash(slotCount)) {
+      clear();
+      throw std::runtime_error("Duplicate key in the set");
+    }
+  }
+
+private:
+  struct Slot {
+    uint32_t position;
+    uint32_t tag;
+  };
+
+  static const uint32_t EMPTY_SLOT = static_cast<uint32_t>(-1);
+  static const size_t MIN_SLOTS = 16;
+
+  uint64_t hashOf(const Key& key) const {
+    static_assert(sizeof(Key) >= sizeof(uint64_t), "Keys must be at least 8 bytes long");
+    uint64_t prefix;
+    std::memcpy(&prefix, &key, sizeof(prefix));
+
+    uint64_t hash = prefix ^ m_seed;
+    hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9;
+    hash = (hash ^ (hash >> 27)) * 0x94d049bb133111eb;
+    return hash ^ (hash >> 31);
+  }
+
+  size_t findSlot(const Key& key) const {
+    if (m_slots.empty()) {
+      return npos;
+    }
+
+    uint64_t hash = hashOf(key);
+    uint32_t tag = static_cast<uint32_t>(hash);
+    for (size_t i = hash >> m_shift;; i = (i + 1) & (m_slots.size() - 1)) {
+      const Slot& slot = m_slots[i];
+      if (slot.position == EMPTY_SLOT) {
+        return npos;
+      }
+
+      if (slot.tag == tag && m_keys[slot.position] == key) {
+        return i;
+      }
+    }
+  }
+
+  // Backward shift deletion, slots after the removed one move up to where their probe would reach them
+  void removeSlot(size_t hole) {
+    size_t mask = m_slots.size() - 1;
+    for (size_t i = (hole + 1) & mask; m_slots[i].position != EMPTY_SLOT; i = (i + 1) & mask) {
+      size_t home = hashOf(m_keys[m_slots[i].position]) >> m_shift;
+      if (((i - home) & mask) >= ((i - hole) & mask)) {
+        m_slots[hole] = m_slots[i];
+        hole = i;
+      }
+    }
+
+    m_slots[hole].position = EMPTY_SLOT;
+  }
+
+  // Returns false if a key is there twice, which only keys given to assign() can be
+  bool rehash(size_t slotCount) {
+    Slot empty = { EMPTY_SLOT, 0 };
+    m_slots.assign(slotCount, empty);
+    m_shift = 64;
+    while (slotCount > 1) {
+      slotCount /= 2;
+      --m_shift;
+    }
+
+    for (size_t position = 0; position < m_keys.size(); ++position) {
+      uint64_t hash = hashOf(m_keys[position]);
+      uint32_t tag = static_cast<uint32_t>(hash);
+      size_t i = hash >> m_shift;
+      for (; m_slots[i].position != EMPTY_SLOT; i = (i + 1) & (m_slots.size() - 1)) {
+        if (m_slots[i].tag == tag && m_keys[m_slots[i].position] == m_keys[position]) {
+          return false;
+        }
+      }
+
+      m_slots[i].position = static_cast<uint32_t>(position);
+      m_slots[i].tag = tag;
+    }
+
+    return true;
+  }
+
+  std::vector<Key> m_keys;
+  std::vector<Slot> m_slots;
+  uint64_t m_seed;
+  unsigned m_shift;
+};
+
+template<typename Key> const size_t FlatHashSet<Key>::npos;
+template<typename Key> const uint32_t FlatHashSet<Key>::EMPTY_SLOT;
+template<typename Key> const size_t FlatHashSet<Key>::MIN_SLOTS;
+
+// FlatHashSet with a value stored next to every key, in a second array in the same order
+template<typename Key, typename Value>
+class FlatHashMap {
+public:
+  explicit FlatHashMap(uint64_t seed) : m_keys(seed) {
+  }
+
+  size_t size() const {
+    return m_keys.size();
+  }
+
+  bool empty() const {
+    return m_keys.empty();
+  }
+
+  const std::vector<Key>& keys() const {
+    return m_keys.keys();
+  }
+
+  const std::vector<Value>& values() const {
+    return m_values;
+  }
+
+  Value* find(const Key& key) {
+    size_t position = m_keys.find(key);
+    return position == FlatHashSet<Key>::npos ? nullptr : &m_values[position];
+  }
+
+  const Value* find(const Key& key) const {
+    size_t position = m_keys.find(key);
+    return position == FlatHashSet<Key>::npos ? nullptr : &m_values[position];
+  }
+
+  bool contains(const Key& key) const {
+    return m_keys.contains(key);
+  }
+
+  // Returns false and leaves the value there if the key is there already
+  bool insert(const Key& key, const Value& value) {
+    if (!m_keys.insert(key).second) {
+      return false;
+    }
+
+    m_values.push_back(value);
+    return true;
+  }
+
+  size_t erase(const Key& key) {
+    size_t position = m_keys.find(key);
+    if (position == FlatHashSet<Key>::npos) {
+      return 0;
+    }
+
+    m_keys.erase(key);
+    m_values[position] = m_values.back();
+    m_values.pop_back();
+    return 1;
+  }
+
+  void clear() {
+    m_keys.clear();
+    m_values.clear();
+  }
+
+  void reserve(size_t count) {
+    m_keys.reserve(count);
+    m_values.reserve(count);
+  }
+
+  void assign(std::vector<Key>&& keys, std::vector<Value>&& values) {
+    if (keys.size() != values.size()) {
+      throw std::runtime_error("Keys and values of the map don't match");
+    }
+
+    m_values.clear();
+    m_keys.assign(std::move(keys));
+    m_values.swap(values);
+    m_values.shrink_to_fit();
+  }
+
+private:
+  FlatHashSet<Key> m_keys;
+  std::vector<Value> m_values;
+};
+
+}
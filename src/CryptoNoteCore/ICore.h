@@ -26,6 +26,7 @@ struct COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS_response;
 struct NOTIFY_RESPONSE_GET_OBJECTS_request;
 struct NOTIFY_REQUEST_GET_OBJECTS_request;
 
+class CachedTransaction;
 class Currency;
 class IBlock;
 class ICoreObserver;
@@ -106,7 +107,14 @@ public:
   virtual uint32_t get_current_blockchain_height() = 0;
 
   virtual std::unique_ptr<IBlock> getBlock(const Crypto::Hash& blocksId) = 0;
-  virtual bool handleIncomingTransaction(const Transaction& tx, const Crypto::Hash& txHash, size_t blobSize, tx_verification_context& tvc, bool keptByBlock, uint32_t blockHeight) = 0;
+  virtual bool handleIncomingTransaction(const CachedTransaction& transaction, tx_verification_context& tvc, bool keptByBlock, uint32_t blockHeight) = 0;
+  // handleIncomingTransaction split in two: the checks that don't need the blockchain (safe to call from any thread)
+  // and adding the transaction, which has to follow a successful prevalidateTransaction
+  virtual bool prevalidateTransaction(const CachedTransaction& transaction, tx_verification_context& tvc, bool keptByBlock, uint32_t blockHeight) = 0;
+  virtual bool handlePrevalidatedTransaction(const CachedTransaction& transaction, tx_verification_context& tvc, bool keptByBlock) = 0;
+  // Transactions relayed together are parsed, prevalidated and have their ring signatures verified in parallel, only
+  // adding them to the pool is serialized. tvcs gets a context per blob.
+  virtual void handleIncomingTransactions(const std::vector<BinaryArray>& txBlobs, std::vector<tx_verification_context>& tvcs, bool keptByBlock) = 0;
   virtual std::error_code executeLocked(const std::function<std::error_code()>& func) = 0;
 
   virtual bool addMessageQueue(MessageQueue<BlockchainMessage>& messageQueue) = 0;
@@ -0,0 +1,89 @@
+// Copyright (c) 2018-2022 The Cash2 developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "KeyImageFilter.h"
+
+#include <cstring>
+
+namespace CryptoNote {
+
+namespace {
+
+const size_t CACHE_LINE_SIZE = 64;
+
+uint64_t mix(uint64_t value) {
+  value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9;
+  value = (value ^ (value >> 27)) * 0x94d049bb133111eb;
+  return value ^ (value >> 31);
+}
+
+unsigned popCount(uint64_t value) {
+  unsigned count = 0;
+  for (; value != 0; value &= value - 1) {
+    ++count;
+  }
+
+  return count;
+}
+
+}
+
+KeyImageFilter::KeyImageFilter(size_t capacity, uint64_t seed) : m_capacity(capacity), m_seed(seed) {
+  m_blockCount = (capacity * BITS_PER_KEY + WORDS_PER_BLOCK * 64 - 1) / (WORDS_PER_BLOCK * 64);
+  if (m_blockCount == 0) {
+    m_blockCount = 1;
+  }
+
+  // the blocks start at a cache line, so that a lookup reads one
+  size_t padding = CACHE_LINE_SIZE / sizeof(uint64_t);
+  m_storage.reset(new std::atomic<uint64_t>[m_blockCount * WORDS_PER_BLOCK + padding]());
+  uintptr_t address = reinterpret_cast<uintptr_t>(m_storage.get());
+  m_words = m_storage.get() + (CACHE_LINE_SIZE - address % CACHE_LINE_SIZE) % CACHE_LINE_SIZE / sizeof(uint64_t);
+}
+
+size_t KeyImageFilter::locate(const Crypto::KeyImage& keyImage, uint64_t& bits) const {
+  uint64_t prefix[2];
+  std::memcpy(prefix, &keyImage, sizeof(prefix));
+
+  uint64_t blockHash = mix(prefix[0] ^ m_seed);
+  bits = mix(prefix[1] ^ m_seed);
+  size_t block = static_cast<size_t>((blockHash >> 32) * m_blockCount >> 32);
+  return block * WORDS_PER_BLOCK;
+}
+
+void KeyImageFilter::add(const Crypto::KeyImage& keyImage) {
+  uint64_t bits;
+  std::atomic<uint64_t>* words = m_words + locate(keyImage, bits);
+  for (size_t i = 0; i < WORDS_PER_BLOCK; ++i, bits >>= 6) {
+    words[i].fetch_or(uint64_t(1) << (bits & 63), std::memory_order_relaxed);
+  }
+}
+
+bool KeyImageFilter::mayContain(const Crypto::KeyImage& keyImage) const {
+  uint64_t bits;
+  const std::atomic<uint64_t>* words = m_words + locate(keyImage, bits);
+  for (size_t i = 0; i < WORDS_PER_BLOCK; ++i, bits >>= 6) {
+    if ((words[i].load(std::memory_order_relaxed) & (uint64_t(1) << (bits & 63))) == 0) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+double KeyImageFilter::falsePositiveRate() const {
+  double rate = 0;
+  for (size_t block = 0; block < m_blockCount; ++block) {
+    double blockRate = 1;
+    for (size_t i = 0; i < WORDS_PER_BLOCK; ++i) {
+      blockRate *= popCount(m_words[block * WORDS_PER_BLOCK + i].load(std::memory_order_relaxed)) / 64.0;
+    }
+
+    rate += blockRate;
+  }
+
+  return rate / m_blockCount;
+}
+
+}
@@ -0,0 +1,52 @@
+// Copyright (c) 2018-2022 The Cash2 developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "crypto/crypto.h"
+
+namespace CryptoNote {
+
+// Bloom filter over key images, answering "certainly not there" without a lock. It is split in blocks of a cache
+// line, a key image sets one bit in each of the 8 words of one block. Bits are only ever set, so a key image that
+// is removed from the set the filter follows stays a false positive until the filter is rebuilt. At capacity it
+// has 16 bits per key image and about 0.1% false positives.
+class KeyImageFilter {
+public:
+  KeyImageFilter(size_t capacity, uint64_t seed);
+
+  size_t capacity() const {
+    return m_capacity;
+  }
+
+  size_t memoryUsage() const {
+    return m_blockCount * WORDS_PER_BLOCK * sizeof(uint64_t);
+  }
+
+  // Safe to call while other threads call mayContain()
+  void add(const Crypto::KeyImage& keyImage);
+  bool mayContain(const Crypto::KeyImage& keyImage) const;
+
+  // Chance that a key image that wasn't added is reported as maybe there, going by the bits set
+  double falsePositiveRate() const;
+
+private:
+  static const size_t WORDS_PER_BLOCK = 8;
+  static const size_t BITS_PER_KEY = 16;
+
+  // Index of the first word of the block of the key image, bits gets the bit to test in each word, 6 bits a word
+  size_t locate(const Crypto::KeyImage& keyImage, uint64_t& bits) const;
+
+  size_t m_capacity;
+  size_t m_blockCount;
+  uint64_t m_seed;
+  std::unique_ptr<std::atomic<uint64_t>[]> m_storage;
+  std::atomic<uint64_t>* m_words;
+};
+
+}
@@ -0,0 +1,106 @@
+// Copyright (c) 2018-2022 The Cash2 developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "MappedVector.h"
+
+#include <algorithm>
+
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+SegmentedFile::SegmentedFile() : m_segmentSize(0), m_size(0) {
+}
+
+SegmentedFile::~SegmentedFile() {
+  close();
+}
+
+bool SegmentedFile::open(const std::string& fileName, uint64_t segmentSize) {
+  close();
+
+  boost::system::error_code ec;
+  if (!boost::filesystem::exists(fileName, ec)) {
+    std::ofstream file(fileName, std::ios::out | std::ios::binary);
+    if (!file) {
+      return false;
+    }
+  }
+
+  uint64_t size = boost::filesystem::file_size(fileName, ec);
+  if (ec || size % segmentSize != 0) {
+    return false;
+  }
+
+  try {
+    m_mapping.reset(new boost::interprocess::file_mapping(fileName.c_str(), boost::interprocess::read_write));
+  } catch (boost::interprocess::interprocess_exception&) {
+    return false;
+  }
+
+  m_fileName = fileName;
+  m_segmentSize = segmentSize;
+  m_size = size;
+  m_regions.resize(size / segmentSize);
+  return true;
+}
+
+void SegmentedFile::close() {
+  for (auto& region : m_regions) {
+    if (region) {
+      region->flush();
+    }
+  }
+
+  m_regions.clear();
+  m_mapping.reset();
+  m_size = 0;
+}
+
+uint64_t SegmentedFile::segmentSize() const {
+  return m_segmentSize;
+}
+
+uint64_t SegmentedFile::size() const {
+  return m_size;
+}
+
+void SegmentedFile::reserve(uint64_t size) {
+  if (!m_mapping) {
+    throw std::runtime_error("SegmentedFile::reserve");
+  }
+
+  if (size <= m_size) {
+    return;
+  }
+
+  uint64_t newSize = (size + m_segmentSize - 1) / m_segmentSize * m_segmentSize;
+  boost::system::error_code ec;
+  boost::filesystem::resize_file(m_fileName, newSize, ec);
+  if (ec) {
+    throw std::runtime_error("SegmentedFile::reserve, " + ec.message());
+  }
+
+  m_size = newSize;
+  m_regions.resize(newSize / m_segmentSize);
+}
+
+char* SegmentedFile::map(uint64_t offset, uint64_t size) {
+  uint64_t segment = offset / m_segmentSize;
+  uint64_t length = std::max(m_segmentSize, (offset % m_segmentSize + size + m_segmentSize - 1) / m_segmentSize * m_segmentSize);
+  if (!m_mapping || segment * m_segmentSize + length > m_size) {
+    throw std::runtime_error("SegmentedFile::map");
+  }
+
+  std::unique_ptr<boost::interprocess::mapped_region>& region = m_regions[segment];
+  if (!region || region->get_size() < length) {
+    try {
+      region.reset(new boost::interprocess::mapped_region(*m_mapping, boost::interprocess::read_write, segment * m_segmentSize, length));
+    } catch (boost::interprocess::interprocess_exception& e) {
+      throw std::runtime_error(std::string("SegmentedFile::map, ") + e.what());
+    }
+  }
+
+  return static_cast<char*>(region->get_address()) + offset % m_segmentSize;
+}
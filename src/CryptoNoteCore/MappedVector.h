@@ -0,0 +1,559 @@
+// Copyright (c) 2018-2022 The Cash2 developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Common/MemoryInputStream.h"
+#include "Common/StringView.h"
+#include "Common/VectorOutputStream.h"
+#include "Serialization/BinaryInputStreamSerializer.h"
+#include "Serialization/BinaryOutputStreamSerializer.h"
+
+namespace boost {
+namespace interprocess {
+class file_mapping;
+class mapped_region;
+}
+}
+
+// File made of fixed-size segments which are memory-mapped on first use. The file only ever grows by whole segments.
+class SegmentedFile {
+public:
+  SegmentedFile();
+  SegmentedFile(const SegmentedFile&) = delete;
+  ~SegmentedFile();
+  SegmentedFile& operator=(const SegmentedFile&) = delete;
+
+  bool open(const std::string& fileName, uint64_t segmentSize);
+  void close();
+
+  uint64_t segmentSize() const;
+  uint64_t size() const;
+
+  // Grows the file to at least size bytes
+  void reserve(uint64_t size);
+
+  // Returns the address of [offset, offset + size). The range must fit into the segment containing offset, unless
+  // offset is the start of a segment, in which case the range is mapped together with as many following segments
+  // as it needs.
+  char* map(uint64_t offset, uint64_t size);
+
+private:
+  std::string m_fileName;
+  uint64_t m_segmentSize;
+  uint64_t m_size;
+  std::unique_ptr<boost::interprocess::file_mapping> m_mapping;
+  std::vector<std::unique_ptr<boost::interprocess::mapped_region>> m_regions;
+};
+
+// Drop-in replacement for SwappedVector which keeps the items in a SegmentedFile instead of reading them through a stream.
+// Items are appended to the items file and never cross a segment boundary, unless an item is larger than a segment and gets
+// a run of segments of its own. The indexes file holds a fixed-width entry with the offset and size of every item, so
+// an item is located and deserialized without touching any other. Deserialized items are kept in an LRU cache.
+template<class T> class MappedVector {
+public:
+  typedef T value_type;
+
+  static const uint64_t DEFAULT_SEGMENT_SIZE = 64 * 1024 * 1024;
+
+  class const_iterator {
+  public:
+    typedef ptrdiff_t difference_type;
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef const T* pointer;
+    typedef const T& reference;
+    typedef T value_type;
+
+    const_iterator() {
+    }
+
+    const_iterator(MappedVector* mappedVector, size_t index) : m_mappedVector(mappedVector), m_index(index) {
+    }
+
+    bool operator!=(const const_iterator& other) const {
+      return m_index != other.m_index;
+    }
+
+    bool operator<(const const_iterator& other) const {
+      return m_index < other.m_index;
+    }
+
+    bool operator<=(const const_iterator& other) const {
+      return m_index <= other.m_index;
+    }
+
+    bool operator==(const const_iterator& other) const {
+      return m_index == other.m_index;
+    }
+
+    bool operator>(const const_iterator& other) const {
+      return m_index > other.m_index;
+    }
+
+    bool operator>=(const const_iterator& other) const {
+      return m_index >= other.m_index;
+    }
+
+    const_iterator& operator++() {
+      ++m_index;
+      return *this;
+    }
+
+    const_iterator operator++(int) {
+      const_iterator i = *this;
+      ++m_index;
+      return i;
+    }
+
+    const_iterator& operator--() {
+      --m_index;
+      return *this;
+    }
+
+    const_iterator operator--(int) {
+      const_iterator i = *this;
+      --m_index;
+      return i;
+    }
+
+    const_iterator& operator+=(difference_type n) {
+      m_index += n;
+      return *this;
+    }
+
+    const_iterator& operator-=(difference_type n) {
+      m_index -= n;
+      return *this;
+    }
+
+    const_iterator operator+(difference_type n) const {
+      return const_iterator(m_mappedVector, m_index + n);
+    }
+
+    friend const_iterator operator+(difference_type n, const const_iterator& i) {
+      return const_iterator(i.m_mappedVector, n + i.m_index);
+    }
+
+    difference_type operator-(const const_iterator& other) const {
+      return m_index - other.m_index;
+    }
+
+    const_iterator operator-(difference_type n) const {
+      return const_iterator(m_mappedVector, m_index - n);
+    }
+
+    const T& operator*() const {
+      return (*m_mappedVector)[m_index];
+    }
+
+    const T* operator->() const {
+      return &(*m_mappedVector)[m_index];
+    }
+
+    const T& operator[](difference_type offset) const {
+      return (*m_mappedVector)[m_index + offset];
+    }
+
+    size_t index() const {
+      return m_index;
+    }
+
+  private:
+    MappedVector* m_mappedVector;
+    size_t m_index;
+  };
+
+  MappedVector();
+  MappedVector(const MappedVector&) = delete;
+  ~MappedVector();
+  MappedVector& operator=(const MappedVector&) = delete;
+
+  // segmentSize is only used when the files are created, existing files keep the segment size they were created with
+  bool open(const std::string& itemFileName, const std::string& indexFileName, size_t poolSize, uint64_t segmentSize = DEFAULT_SEGMENT_SIZE);
+  void close();
+
+  bool empty() const;
+  uint64_t size() const;
+  const_iterator begin();
+  const_iterator end();
+  const T& operator[](uint64_t index);
+  const T& front();
+  const T& back();
+  // Deserializes an item without putting it into the cache
+  void load(uint64_t index, T& item);
+  // Returns the serialized item. The memory stays valid until the next clear, pop_back or push_back.
+  Common::StringView serialized(uint64_t index);
+  void clear();
+  void pop_back();
+  void push_back(const T& item);
+
+  // Same as in SwappedVector, evicted items are kept alive until released. operator[] may be called from several
+  // threads at once, but not concurrently with clear, pop_back or push_back.
+  size_t retiredCount();
+  void releaseRetired();
+
+  uint64_t cacheHits();
+  uint64_t cacheMisses();
+
+private:
+  struct ItemEntry;
+  struct CacheEntry;
+
+  struct ItemEntry {
+  public:
+    std::unique_ptr<T> item;
+    typename std::list<CacheEntry>::iterator cacheIter;
+  };
+
+  struct CacheEntry {
+  public:
+    typename std::map<uint64_t, ItemEntry>::iterator itemIter;
+  };
+
+  struct IndexHeader {
+    uint64_t count;
+    uint64_t segmentSize;
+  };
+
+  struct IndexEntry {
+    uint64_t offset;
+    uint32_t size;
+    uint32_t reserved;
+  };
+
+  SegmentedFile m_itemsFile;
+  std::fstream m_indexesFile;
+  size_t m_poolSize;
+  std::vector<IndexEntry> m_index;
+  uint64_t m_itemsEnd;
+  std::map<uint64_t, ItemEntry> m_items;
+  std::list<CacheEntry> m_cache;
+  std::vector<std::unique_ptr<T>> m_retired;
+  uint64_t m_cacheHits;
+  uint64_t m_cacheMisses;
+  std::mutex m_mutex;
+
+  void writeCount(uint64_t count);
+  T* prepare(uint64_t index);
+  void retire(typename std::map<uint64_t, ItemEntry>::iterator itemIter);
+};
+
+template<class T> MappedVector<T>::MappedVector() : m_poolSize(0), m_itemsEnd(0), m_cacheHits(0), m_cacheMisses(0) {
+}
+
+template<class T> MappedVector<T>::~MappedVector() {
+  close();
+}
+
+template<class T> bool MappedVector<T>::open(const std::string& itemFileName, const std::string& indexFileName, size_t poolSize, uint64_t segmentSize) {
+  if (poolSize == 0 || segmentSize == 0) {
+    return false;
+  }
+
+  close();
+
+  IndexHeader header;
+  std::vector<IndexEntry> index;
+  m_indexesFile.open(indexFileName, std::ios::in | std::ios::out | std::ios::binary);
+  if (m_indexesFile) {
+    m_indexesFile.read(reinterpret_cast<char*>(&header), sizeof header);
+    if (!m_indexesFile || header.segmentSize == 0) {
+      return false;
+    }
+
+    index.resize(header.count);
+    if (!index.empty()) {
+      m_indexesFile.read(reinterpret_cast<char*>(index.data()), index.size() * sizeof(IndexEntry));
+      if (!m_indexesFile) {
+        return false;
+      }
+    }
+  } else {
+    m_indexesFile.open(indexFileName, std::ios::out | std::ios::binary);
+    header.count = 0;
+    header.segmentSize = segmentSize;
+    m_indexesFile.write(reinterpret_cast<char*>(&header), sizeof header);
+    if (!m_indexesFile) {
+      return false;
+    }
+
+    m_indexesFile.close();
+    m_indexesFile.open(indexFileName, std::ios::in | std::ios::out | std::ios::binary);
+  }
+
+  if (!m_itemsFile.open(itemFileName, header.segmentSize)) {
+    return false;
+  }
+
+  uint64_t itemsEnd = index.empty() ? 0 : index.back().offset + index.back().size;
+  if (itemsEnd > m_itemsFile.size()) {
+    return false;
+  }
+
+  m_index.swap(index);
+  m_itemsEnd = itemsEnd;
+  m_poolSize = poolSize;
+  m_items.clear();
+  m_cache.clear();
+  m_retired.clear();
+  m_cacheHits = 0;
+  m_cacheMisses = 0;
+  return true;
+}
+
+template<class T> void MappedVector<T>::close() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_items.clear();
+  m_cache.clear();
+  m_retired.clear();
+  m_index.clear();
+  m_itemsEnd = 0;
+  m_itemsFile.close();
+  if (m_indexesFile.is_open()) {
+    m_indexesFile.close();
+  }
+}
+
+template<class T> bool MappedVector<T>::empty() const {
+  return m_index.empty();
+}
+
+template<class T> uint64_t MappedVector<T>::size() const {
+  return m_index.size();
+}
+
+template<class T> typename MappedVector<T>::const_iterator MappedVector<T>::begin() {
+  return const_iterator(this, 0);
+}
+
+template<class T> typename MappedVector<T>::const_iterator MappedVector<T>::end() {
+  return const_iterator(this, m_index.size());
+}
+
+template<class T> const T& MappedVector<T>::operator[](uint64_t index) {
+  const char* data;
+  uint32_t dataSize;
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto itemIter = m_items.find(index);
+    if (itemIter != m_items.end()) {
+      if (itemIter->second.cacheIter != --m_cache.end()) {
+        m_cache.splice(m_cache.end(), m_cache, itemIter->second.cacheIter);
+      }
+
+      ++m_cacheHits;
+      return *itemIter->second.item;
+    }
+
+    if (index >= m_index.size()) {
+      throw std::runtime_error("MappedVector::operator[]");
+    }
+
+    data = m_itemsFile.map(m_index[index].offset, m_index[index].size);
+    dataSize = m_index[index].size;
+    ++m_cacheMisses;
+  }
+
+  // The mapping stays valid until the next push_back, so other threads don't wait for the item to be deserialized
+  T tempItem;
+
+  Common::MemoryInputStream stream(data, dataSize);
+  CryptoNote::BinaryInputStreamSerializer archive(stream);
+  serialize(tempItem, archive);
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto itemIter = m_items.find(index);
+  if (itemIter != m_items.end()) {
+    return *itemIter->second.item;
+  }
+
+  T* item = prepare(index);
+  std::swap(tempItem, *item);
+  return *item;
+}
+
+template<class T> const T& MappedVector<T>::front() {
+  return operator[](0);
+}
+
+template<class T> const T& MappedVector<T>::back() {
+  return operator[](m_index.size() - 1);
+}
+
+template<class T> void MappedVector<T>::load(uint64_t index, T& item) {
+  const char* data;
+  uint32_t dataSize;
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (index >= m_index.size()) {
+      throw std::runtime_error("MappedVector::load");
+    }
+
+    data = m_itemsFile.map(m_index[index].offset, m_index[index].size);
+    dataSize = m_index[index].size;
+  }
+
+  Common::MemoryInputStream stream(data, dataSize);
+  CryptoNote::BinaryInputStreamSerializer archive(stream);
+  serialize(item, archive);
+}
+
+template<class T> Common::StringView MappedVector<T>::serialized(uint64_t index) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (index >= m_index.size()) {
+    throw std::runtime_error("MappedVector::serialized");
+  }
+
+  return Common::StringView(m_itemsFile.map(m_index[index].offset, m_index[index].size), m_index[index].size);
+}
+
+template<class T> void MappedVector<T>::clear() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  writeCount(0);
+
+  m_index.clear();
+  m_itemsEnd = 0;
+  for (auto& item : m_items) {
+    m_retired.emplace_back(std::move(item.second.item));
+  }
+
+  m_items.clear();
+  m_cache.clear();
+}
+
+template<class T> void MappedVector<T>::pop_back() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_index.empty()) {
+    throw std::runtime_error("MappedVector::pop_back");
+  }
+
+  writeCount(m_index.size() - 1);
+
+  m_index.pop_back();
+  m_itemsEnd = m_index.empty() ? 0 : m_index.back().offset + m_index.back().size;
+  auto itemIter = m_items.find(m_index.size());
+  if (itemIter != m_items.end()) {
+    retire(itemIter);
+  }
+}
+
+template<class T> void MappedVector<T>::push_back(const T& item) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::vector<uint8_t> blob;
+
+  {
+    Common::VectorOutputStream stream(blob);
+    CryptoNote::BinaryOutputStreamSerializer archive(stream);
+    serialize(const_cast<T&>(item), archive);
+  }
+
+  if (blob.size() > std::numeric_limits<uint32_t>::max()) {
+    throw std::runtime_error("MappedVector::push_back");
+  }
+
+  uint64_t segmentSize = m_itemsFile.segmentSize();
+  uint64_t offset = m_itemsEnd;
+  if (offset % segmentSize != 0 && offset % segmentSize + blob.size() > segmentSize) {
+    offset += segmentSize - offset % segmentSize;
+  }
+
+  m_itemsFile.reserve(offset + blob.size());
+  if (!blob.empty()) {
+    memcpy(m_itemsFile.map(offset, blob.size()), blob.data(), blob.size());
+  }
+
+  {
+    if (!m_indexesFile) {
+      throw std::runtime_error("MappedVector::push_back");
+    }
+
+    IndexEntry entry = { offset, static_cast<uint32_t>(blob.size()), 0 };
+    m_indexesFile.seekp(sizeof(IndexHeader) + sizeof(IndexEntry) * m_index.size());
+    m_indexesFile.write(reinterpret_cast<char*>(&entry), sizeof entry);
+    if (!m_indexesFile) {
+      throw std::runtime_error("MappedVector::push_back");
+    }
+
+    writeCount(m_index.size() + 1);
+    m_index.push_back(entry);
+  }
+
+  m_itemsEnd = offset + blob.size();
+
+  T* newItem = prepare(m_index.size() - 1);
+  *newItem = item;
+}
+
+template<class T> size_t MappedVector<T>::retiredCount() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_retired.size();
+}
+
+template<class T> void MappedVector<T>::releaseRetired() {
+  std::vector<std::unique_ptr<T>> retired;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    retired.swap(m_retired);
+  }
+}
+
+template<class T> uint64_t MappedVector<T>::cacheHits() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_cacheHits;
+}
+
+template<class T> uint64_t MappedVector<T>::cacheMisses() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_cacheMisses;
+}
+
+// Precondition: m_mutex is locked.
+template<class T> void MappedVector<T>::writeCount(uint64_t count) {
+  if (!m_indexesFile) {
+    throw std::runtime_error("MappedVector::writeCount");
+  }
+
+  m_indexesFile.seekp(0);
+  m_indexesFile.write(reinterpret_cast<char*>(&count), sizeof count);
+  if (!m_indexesFile) {
+    throw std::runtime_error("MappedVector::writeCount");
+  }
+}
+
+// Precondition: m_mutex is locked.
+template<class T> T* MappedVector<T>::prepare(uint64_t index) {
+  if (m_items.size() == m_poolSize) {
+    retire(m_cache.begin()->itemIter);
+  }
+
+  auto itemIter = m_items.insert(std::make_pair(index, ItemEntry()));
+  itemIter.first->second.item.reset(new T());
+  CacheEntry cacheEntry = { itemIter.first };
+  auto cacheIter = m_cache.insert(m_cache.end(), cacheEntry);
+  itemIter.first->second.cacheIter = cacheIter;
+  return itemIter.first->second.item.get();
+}
+
+// Precondition: m_mutex is locked.
+template<class T> void MappedVector<T>::retire(typename std::map<uint64_t, ItemEntry>::iterator itemIter) {
+  m_retired.emplace_back(std::move(itemIter->second.item));
+  m_cache.erase(itemIter->second.cacheIter);
+  m_items.erase(itemIter);
+}
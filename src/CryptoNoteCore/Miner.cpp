@@ -5,7 +5,9 @@
 
 #include "Miner.h"
 
+#include <algorithm>
 #include <future>
+#include <memory>
 #include <numeric>
 #include <sstream>
 #include <thread>
@@ -23,6 +25,7 @@
 #include "Serialization/SerializationTools.h"
 
 #include "CryptoNoteFormatUtils.h"
+#include "NonceSearcher.h"
 #include "TransactionExtra.h"
 #include "CryptoNoteConfig.h"
 
@@ -132,7 +135,7 @@ namespace CryptoNote
       if(m_do_print_hashrate) {
         uint64_t total_hr = std::accumulate(m_last_hash_rates.begin(), m_last_hash_rates.end(), static_cast<uint64_t>(0));
         float hr = static_cast<float>(total_hr)/static_cast<float>(m_last_hash_rates.size());
-        std::cout << "hashrate: " << std::setprecision(4) << std::fixed << hr << ENDL;
+        std::cout << "hashrate: " << std::setprecision(4) << std::fixed << hr << " (" << hr / std::max<uint32_t>(m_threads_total, 1) << " per thread)" << ENDL;
       }
     }
     
@@ -217,7 +220,9 @@ namespace CryptoNote
       m_threads.push_back(std::thread(std::bind(&miner::worker_thread, this, i)));
     }
 
+    Crypto::NonceHashingMode mode = Crypto::Blake2bNonceHasher::bestMode();
     logger(INFO) << "Mining has started with " << threads_count << " threads, good luck!";
+    logger(INFO) << "Using " << Crypto::Blake2bNonceHasher::modeName(mode) << " hashing, " << Crypto::Blake2bNonceHasher::lanes(mode) << " nonces per call";
     return true;
   }
   
@@ -252,66 +257,18 @@ namespace CryptoNote
   }
   //-----------------------------------------------------------------------------------------------------
   bool miner::find_nonce_for_given_block1(Crypto::cn_context &context, Block& bl, const difficulty_type& diffic) {
-
-    unsigned nthreads = std::thread::hardware_concurrency();
-
-    if (nthreads > 0 && diffic > 5) {
-      std::vector<std::future<void>> threads(nthreads);
-      std::atomic<uint64_t> foundNonce;
-      std::atomic<bool> found(false);
-      uint64_t startNonce = Crypto::rand<uint64_t>();
-
-      for (unsigned i = 0; i < nthreads; ++i) {
-        threads[i] = std::async(std::launch::async, [&, i]() {
-          Crypto::cn_context localctx;
-          Crypto::Hash h;
-
-          Block lb(bl); // copy to local block
-
-          for (uint64_t nonce = startNonce + i; !found; nonce += nthreads) {
-            lb.nonce = nonce;
-
-            if (!get_block_longhash(localctx, lb, h)) {
-              return;
-            }
-
-            if (check_hash1(h, diffic)) {
-              foundNonce = nonce;
-              found = true;
-              return;
-            }
-          }
-        });
-      }
-
-      for (auto& t : threads) {
-        t.wait();
-      }
-
-      if (found) {
-        bl.nonce = foundNonce.load();
-      }
-
-      return found;
-    } else {
-      for (; bl.nonce != std::numeric_limits<uint64_t>::max(); bl.nonce++) {
-        Crypto::Hash h;
-        if (!get_block_longhash(context, bl, h)) {
-          return false;
-        }
-
-        if (check_hash1(h, diffic)) {
-          return true;
-        }
-      }
-    }
-
-    return false;
+    return find_nonce_for_given_block(bl, diffic, false);
   }
   //-----------------------------------------------------------------------------------------------------
   bool miner::find_nonce_for_given_block2(Crypto::cn_context &context, Block& bl, const difficulty_type& diffic) {
+    return find_nonce_for_given_block(bl, diffic, true);
+  }
+  //-----------------------------------------------------------------------------------------------------
+  bool miner::find_nonce_for_given_block(Block& bl, const difficulty_type& diffic, bool checkHash2) {
 
     unsigned nthreads = std::thread::hardware_concurrency();
+    NonceSearcher searcher(bl, diffic, checkHash2);
+    uint64_t noncesPerCall = searcher.noncesPerCall();
 
     if (nthreads > 0 && diffic > 5) {
       std::vector<std::future<void>> threads(nthreads);
@@ -321,19 +278,9 @@ namespace CryptoNote
 
       for (unsigned i = 0; i < nthreads; ++i) {
         threads[i] = std::async(std::launch::async, [&, i]() {
-          Crypto::cn_context localctx;
-          Crypto::Hash h;
-
-          Block lb(bl); // copy to local block
-
-          for (uint64_t nonce = startNonce + i; !found; nonce += nthreads) {
-            lb.nonce = nonce;
-
-            if (!get_block_longhash(localctx, lb, h)) {
-              return;
-            }
-
-            if (check_hash2(h, diffic)) {
+          uint64_t nonce;
+          for (uint64_t firstNonce = startNonce + i; !found; firstNonce += noncesPerCall * nthreads) {
+            if (searcher.search(firstNonce, nthreads, nonce)) {
               foundNonce = nonce;
               found = true;
               return;
@@ -352,13 +299,10 @@ namespace CryptoNote
 
       return found;
     } else {
-      for (; bl.nonce != std::numeric_limits<uint64_t>::max(); bl.nonce++) {
-        Crypto::Hash h;
-        if (!get_block_longhash(context, bl, h)) {
-          return false;
-        }
-
-        if (check_hash2(h, diffic)) {
+      uint64_t nonce;
+      for (uint64_t firstNonce = bl.nonce; firstNonce <= std::numeric_limits<uint64_t>::max() - noncesPerCall; firstNonce += noncesPerCall) {
+        if (searcher.search(firstNonce, 1, nonce)) {
+          bl.nonce = nonce;
           return true;
         }
       }
@@ -401,7 +345,7 @@ namespace CryptoNote
     uint64_t nonce = m_starter_nonce + th_local_index;
     difficulty_type local_diff = 0;
     uint32_t local_template_ver = 0;
-    Crypto::cn_context context;
+    std::unique_ptr<NonceSearcher> searcher;
     Block b;
 
     while(!m_stop)
@@ -420,6 +364,15 @@ namespace CryptoNote
 
         local_template_ver = m_template_no;
         nonce = m_starter_nonce + th_local_index;
+
+        uint32_t blockHeight = boost::get<BaseInput>(b.baseTransaction.inputs[0]).blockIndex;
+        try {
+          searcher.reset(new NonceSearcher(b, local_diff, blockHeight >= parameters::HARD_FORK_HEIGHT_2));
+        } catch (std::exception& e) {
+          logger(ERROR) << "Failed to prepare block template for mining: " << e.what();
+          m_stop = true;
+          break;
+        }
       }
 
       if(!local_template_ver)//no any set_block_template call
@@ -429,29 +382,12 @@ namespace CryptoNote
         continue;
       }
 
-      b.nonce = nonce;
-      Crypto::Hash h;
-      if (!m_stop && !get_block_longhash(context, b, h)) {
-        logger(ERROR) << "Failed to get block long hash";
-        m_stop = true;
-      }
-
-      uint32_t blockHeight = boost::get<BaseInput>(b.baseTransaction.inputs[0]).blockIndex;
-
-      bool checkHashSuccess = false;
-
-      if (blockHeight < parameters::HARD_FORK_HEIGHT_2)
-      {
-        checkHashSuccess = check_hash1(h, local_diff);
-      }
-      else
-      {
-        checkHashSuccess = check_hash2(h, local_diff);
-      }
-
-      if (!m_stop && checkHashSuccess)
+      uint32_t threads_total = m_threads_total;
+      uint64_t found_nonce;
+      if (!m_stop && searcher->search(nonce, threads_total, found_nonce))
       {
         //we lucky!
+        b.nonce = found_nonce;
         ++m_config.current_extra_message_index;
 
         logger(INFO, GREEN) << "Found block for difficulty: " << local_diff;
@@ -464,8 +400,8 @@ namespace CryptoNote
         }
       }
 
-      nonce += m_threads_total;
-      ++m_hashes;
+      nonce += searcher->noncesPerCall() * threads_total;
+      m_hashes += searcher->noncesPerCall();
     }
     logger(INFO) << "Miner thread stopped ["<< th_local_index << "]";
     return true;
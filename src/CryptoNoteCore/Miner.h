@@ -45,6 +45,7 @@ namespace CryptoNote {
     void do_print_hashrate(bool do_hr);
 
   private:
+    static bool find_nonce_for_given_block(Block& bl, const difficulty_type& diffic, bool checkHash2);
     bool worker_thread(uint32_t th_local_index);
     bool request_block_template();
     void  merge_hr();
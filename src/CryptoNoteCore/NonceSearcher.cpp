@@ -0,0 +1,59 @@
+// Copyright (c) 2018-2022 The Cash2 developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "NonceSearcher.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#include "CryptoNoteFormatUtils.h"
+
+namespace CryptoNote {
+
+namespace {
+
+// the hashing blob starts with the previous block hash, followed by the little endian nonce
+const size_t NONCE_OFFSET = sizeof(Crypto::Hash);
+
+Crypto::Blake2bNonceHasher createHasher(const Block& block, Crypto::NonceHashingMode mode) {
+  Block probe = block;
+  probe.nonce = 0x0807060504030201;
+
+  BinaryArray blob;
+  if (!get_block_hashing_blob(probe, blob)) {
+    throw std::runtime_error("Failed to get block hashing blob");
+  }
+
+  const uint8_t expectedNonce[] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+  if (blob.size() < NONCE_OFFSET + sizeof(expectedNonce) || memcmp(blob.data() + NONCE_OFFSET, expectedNonce, sizeof(expectedNonce)) != 0) {
+    throw std::runtime_error("Unexpected nonce position in block hashing blob");
+  }
+
+  return Crypto::Blake2bNonceHasher(blob.data(), blob.size(), NONCE_OFFSET, mode);
+}
+
+}
+
+NonceSearcher::NonceSearcher(const Block& block, difficulty_type difficulty, bool checkHash2, Crypto::NonceHashingMode mode) :
+  m_hasher(createHasher(block, mode)),
+  m_difficulty(difficulty),
+  m_checkHash2(checkHash2),
+  m_prefixLimit(checkHash2 ? check_hash2_prefix_limit(difficulty) : check_hash1_prefix_limit(difficulty)) {
+}
+
+bool NonceSearcher::search(uint64_t firstNonce, uint64_t nonceStep, uint64_t& nonce) const {
+  Crypto::Hash hashes[Crypto::Blake2bNonceHasher::MAX_LANES];
+  uint32_t candidates = m_hasher.hash(firstNonce, nonceStep, m_prefixLimit, hashes);
+
+  for (size_t i = 0; candidates != 0; ++i, candidates >>= 1) {
+    if ((candidates & 1) != 0 && (m_checkHash2 ? check_hash2(hashes[i], m_difficulty) : check_hash1(hashes[i], m_difficulty))) {
+      nonce = firstNonce + i * nonceStep;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+}
@@ -0,0 +1,33 @@
+// Copyright (c) 2018-2022 The Cash2 developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include "crypto/blake2b-nonce.h"
+#include "CryptoNoteCore/CryptoNoteBasic.h"
+#include "CryptoNoteCore/Difficulty.h"
+
+namespace CryptoNote {
+
+// Proof of work search over the nonces of one block template. The hashing blob is built once, every call
+// hashes noncesPerCall() nonces and only hashes passing the cheap target prefilter get the full difficulty check.
+class NonceSearcher {
+public:
+  // checkHash2 selects check_hash2 (blocks from HARD_FORK_HEIGHT_2 on) instead of check_hash1
+  NonceSearcher(const Block& block, difficulty_type difficulty, bool checkHash2, Crypto::NonceHashingMode mode = Crypto::Blake2bNonceHasher::bestMode());
+
+  Crypto::NonceHashingMode mode() const { return m_hasher.mode(); }
+  size_t noncesPerCall() const { return m_hasher.lanes(); }
+
+  // Tries firstNonce + i * nonceStep for i < noncesPerCall(), returns the first of them meeting the difficulty in nonce
+  bool search(uint64_t firstNonce, uint64_t nonceStep, uint64_t& nonce) const;
+
+private:
+  Crypto::Blake2bNonceHasher m_hasher;
+  difficulty_type m_difficulty;
+  bool m_checkHash2;
+  uint64_t m_prefixLimit;
+};
+
+}
@@ -0,0 +1,118 @@
+// Copyright (c) 2018-2022 The Cash2 developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "RingSignatureVerifier.h"
+
+namespace CryptoNote {
+
+bool RingSignatureCheck::check() const {
+  if (outputKeys.size() != signatures.size()) {
+    return false;
+  }
+
+  std::vector<const Crypto::PublicKey*> outputKeyPointers;
+  outputKeyPointers.reserve(outputKeys.size());
+  for (const Crypto::PublicKey& key : outputKeys) {
+    outputKeyPointers.push_back(&key);
+  }
+
+  return Crypto::check_ring_signature(prefixHash, keyImage, outputKeyPointers, signatures.data());
+}
+
+RingSignatureVerifier::RingSignatureVerifier(size_t workerCount) :
+  m_checks(nullptr),
+  m_nextCheck(0),
+  m_firstFailure(0),
+  m_batchId(0),
+  m_busyWorkers(0),
+  m_stopped(false) {
+  for (size_t i = 0; i < workerCount; ++i) {
+    m_workers.emplace_back(&RingSignatureVerifier::workerThread, this);
+  }
+}
+
+RingSignatureVerifier::~RingSignatureVerifier() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopped = true;
+  }
+
+  m_haveBatch.notify_all();
+  for (auto& worker : m_workers) {
+    worker.join();
+  }
+}
+
+size_t RingSignatureVerifier::verify(const std::vector<RingSignatureCheck>& checks) {
+  if (checks.size() < 2 || m_workers.empty()) {
+    for (size_t i = 0; i < checks.size(); ++i) {
+      if (!checks[i].check()) {
+        return i;
+      }
+    }
+
+    return checks.size();
+  }
+
+  // one batch at a time, concurrent callers queue up here
+  std::lock_guard<std::mutex> verifyLock(m_verifyMutex);
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_checks = &checks;
+    m_nextCheck = 0;
+    m_firstFailure = checks.size();
+    m_busyWorkers = m_workers.size();
+    ++m_batchId;
+  }
+
+  m_haveBatch.notify_all();
+  processChecks();
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_batchDone.wait(lock, [this] { return m_busyWorkers == 0; });
+  m_checks = nullptr;
+  return m_firstFailure;
+}
+
+void RingSignatureVerifier::workerThread() {
+  uint64_t lastBatchId = 0;
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_haveBatch.wait(lock, [&] { return m_stopped || m_batchId != lastBatchId; });
+      if (m_stopped) {
+        return;
+      }
+
+      lastBatchId = m_batchId;
+    }
+
+    processChecks();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (--m_busyWorkers == 0) {
+      m_batchDone.notify_one();
+    }
+  }
+}
+
+void RingSignatureVerifier::processChecks() {
+  const std::vector<RingSignatureCheck>& checks = *m_checks;
+  for (;;) {
+    // indexes are handed out in increasing order, so once a failure is known every earlier check is already taken
+    size_t index = m_nextCheck++;
+    if (index >= checks.size() || index > m_firstFailure) {
+      return;
+    }
+
+    if (!checks[index].check()) {
+      size_t firstFailure = m_firstFailure;
+      while (index < firstFailure && !m_firstFailure.compare_exchange_weak(firstFailure, index)) {
+      }
+    }
+  }
+}
+
+}
@@ -0,0 +1,57 @@
+// Copyright (c) 2018-2022 The Cash2 developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "crypto/crypto.h"
+
+namespace CryptoNote {
+
+// Ring signature of one KeyInput with its output keys already resolved, so it can be verified
+// without access to the blockchain.
+struct RingSignatureCheck {
+  Crypto::Hash prefixHash;
+  Crypto::KeyImage keyImage;
+  std::vector<Crypto::PublicKey> outputKeys;
+  std::vector<Crypto::Signature> signatures;
+
+  bool check() const;
+};
+
+// Verifies batches of ring signatures on a fixed set of worker threads. The calling thread takes part
+// in the work, so a verifier with no workers checks everything on the caller.
+class RingSignatureVerifier {
+public:
+  explicit RingSignatureVerifier(size_t workerCount);
+  ~RingSignatureVerifier();
+
+  // Returns the index of the first failed check, or checks.size() if all signatures are valid.
+  // Checks after a known failure are skipped, but every check before the returned one has been verified,
+  // so the result does not depend on thread scheduling.
+  size_t verify(const std::vector<RingSignatureCheck>& checks);
+
+private:
+  void workerThread();
+  void processChecks();
+
+  std::vector<std::thread> m_workers;
+  std::mutex m_verifyMutex;
+  std::mutex m_mutex;
+  std::condition_variable m_haveBatch;
+  std::condition_variable m_batchDone;
+  const std::vector<RingSignatureCheck>* m_checks;
+  std::atomic<size_t> m_nextCheck;
+  std::atomic<size_t> m_firstFailure;
+  uint64_t m_batchId;
+  size_t m_busyWorkers;
+  bool m_stopped;
+};
+
+}
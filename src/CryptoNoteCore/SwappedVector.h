@@ -12,6 +12,8 @@
 #include <iostream>
 #include <list>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -150,13 +152,19 @@ public:
   void pop_back();
   void push_back(const T& item);
 
+  // Items evicted from the cache are kept alive until releaseRetired() is called, so references returned by
+  // operator[] stay valid while other threads keep loading items. The caller must guarantee that no such references
+  // are in use when releasing.
+  size_t retiredCount();
+  void releaseRetired();
+
 private:
   struct ItemEntry;
   struct CacheEntry;
 
   struct ItemEntry {
   public:
-    T item;
+    std::unique_ptr<T> item;
     typename std::list<CacheEntry>::iterator cacheIter;
   };
 
@@ -172,10 +180,13 @@ private:
   uint64_t m_itemsFileSize;
   std::map<uint64_t, ItemEntry> m_items;
   std::list<CacheEntry> m_cache;
+  std::vector<std::unique_ptr<T>> m_retired;
   uint64_t m_cacheHits;
   uint64_t m_cacheMisses;
+  std::mutex m_mutex;
 
   T* prepare(uint64_t index);
+  void retire(typename std::map<uint64_t, ItemEntry>::iterator itemIter);
 };
 
 template<class T> SwappedVector<T>::SwappedVector() {
@@ -234,6 +245,7 @@ template<class T> bool SwappedVector<T>::open(const std::string& itemFileName, c
   m_poolSize = poolSize;
   m_items.clear();
   m_cache.clear();
+  m_retired.clear();
   m_cacheHits = 0;
   m_cacheMisses = 0;
   return true;
@@ -260,6 +272,7 @@ template<class T> typename SwappedVector<T>::const_iterator SwappedVector<T>::en
 }
 
 template<class T> const T& SwappedVector<T>::operator[](uint64_t index) {
+  std::lock_guard<std::mutex> lock(m_mutex);
   auto itemIter = m_items.find(index);
   if (itemIter != m_items.end()) {
     if (itemIter->second.cacheIter != --m_cache.end()) {
@@ -267,7 +280,7 @@ template<class T> const T& SwappedVector<T>::operator[](uint64_t index) {
     }
 
     ++m_cacheHits;
-    return itemIter->second.item;
+    return *itemIter->second.item;
   }
 
   if (index >= m_offsets.size()) {
@@ -300,6 +313,7 @@ template<class T> const T& SwappedVector<T>::back() {
 }
 
 template<class T> void SwappedVector<T>::clear() {
+  std::lock_guard<std::mutex> lock(m_mutex);
   if (!m_indexesFile) {
     throw std::runtime_error("SwappedVector::clear");
   }
@@ -313,11 +327,16 @@ template<class T> void SwappedVector<T>::clear() {
 
   m_offsets.clear();
   m_itemsFileSize = 0;
+  for (auto& item : m_items) {
+    m_retired.emplace_back(std::move(item.second.item));
+  }
+
   m_items.clear();
   m_cache.clear();
 }
 
 template<class T> void SwappedVector<T>::pop_back() {
+  std::lock_guard<std::mutex> lock(m_mutex);
   if (!m_indexesFile) {
     throw std::runtime_error("SwappedVector::pop_back");
   }
@@ -333,12 +352,12 @@ template<class T> void SwappedVector<T>::pop_back() {
   m_offsets.pop_back();
   auto itemIter = m_items.find(m_offsets.size());
   if (itemIter != m_items.end()) {
-    m_cache.erase(itemIter->second.cacheIter);
-    m_items.erase(itemIter);
+    retire(itemIter);
   }
 }
 
 template<class T> void SwappedVector<T>::push_back(const T& item) {
+  std::lock_guard<std::mutex> lock(m_mutex);
   uint64_t itemsFileSize;
 
   {
@@ -382,16 +401,36 @@ template<class T> void SwappedVector<T>::push_back(const T& item) {
   *newItem = item;
 }
 
+template<class T> size_t SwappedVector<T>::retiredCount() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_retired.size();
+}
+
+template<class T> void SwappedVector<T>::releaseRetired() {
+  std::vector<std::unique_ptr<T>> retired;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    retired.swap(m_retired);
+  }
+}
+
+// Precondition: m_mutex is locked.
 template<class T> T* SwappedVector<T>::prepare(uint64_t index) {
   if (m_items.size() == m_poolSize) {
-    auto cacheIter = m_cache.begin();
-    m_items.erase(cacheIter->itemIter);
-    m_cache.erase(cacheIter);
+    retire(m_cache.begin()->itemIter);
   }
 
   auto itemIter = m_items.insert(std::make_pair(index, ItemEntry()));
+  itemIter.first->second.item.reset(new T());
   CacheEntry cacheEntry = { itemIter.first };
   auto cacheIter = m_cache.insert(m_cache.end(), cacheEntry);
   itemIter.first->second.cacheIter = cacheIter;
-  return &itemIter.first->second.item;
+  return itemIter.first->second.item.get();
+}
+
+// Precondition: m_mutex is locked.
+template<class T> void SwappedVector<T>::retire(typename std::map<uint64_t, ItemEntry>::iterator itemIter) {
+  m_retired.emplace_back(std::move(itemIter->second.item));
+  m_cache.erase(itemIter->second.cacheIter);
+  m_items.erase(itemIter);
 }
@@ -98,10 +98,15 @@ namespace CryptoNote {
     m_timeProvider(timeProvider), 
     m_txCheckInterval(60, timeProvider),
     m_fee_index(boost::get<1>(m_transactions)),
-    logger(log, "txpool") {
+    logger(log, "txpool"),
+    m_blockchainHeight(0),
+    m_blockTemplateCache() {
   }
   //---------------------------------------------------------------------------------
-  bool tx_memory_pool::add_tx(const Transaction &tx, /*const Crypto::Hash& tx_prefix_hash,*/ const Crypto::Hash &id, size_t blobSize, tx_verification_context& tvc, bool keptByBlock, uint32_t blockchainHeight) {
+  bool tx_memory_pool::add_tx(const CachedTransaction& transaction, tx_verification_context& tvc, bool keptByBlock, uint32_t blockchainHeight) {
+    const Transaction& tx = transaction.getTransaction();
+    const Crypto::Hash& id = transaction.getTransactionHash();
+    size_t blobSize = transaction.getTransactionBinarySize();
     if (!check_inputs_types_supported(tx)) {
       tvc.m_verification_failed = true;
       return false;
@@ -138,7 +143,7 @@ namespace CryptoNote {
     BlockInfo maxUsedBlock;
 
     // check inputs
-    bool inputsValid = m_validator.checkTransactionInputs(tx, maxUsedBlock);
+    bool inputsValid = m_validator.checkTransactionInputs(transaction, maxUsedBlock);
 
     if (!inputsValid) 
     {
@@ -181,6 +186,7 @@ namespace CryptoNote {
       TransactionDetails txd;
 
       txd.id = id;
+      txd.prefixHash = transaction.getTransactionPrefixHash();
       txd.blobSize = blobSize;
       txd.tx = tx;
       txd.fee = fee;
@@ -200,7 +206,7 @@ namespace CryptoNote {
       }
       m_paymentIdIndex.add(txd.tx);
       m_timestampIndex.add(txd.receiveTime, txd.id);
-
+      clearBlockTemplateCache();
     }
 
     tvc.m_added_to_pool = true;
@@ -226,29 +232,45 @@ namespace CryptoNote {
 
   //---------------------------------------------------------------------------------
   bool tx_memory_pool::add_tx(const Transaction &tx, tx_verification_context& tvc, bool kept_by_block, uint32_t blockchainHeight) {
-    Crypto::Hash h = NULL_HASH;
-    size_t blobSize = 0;
-    getObjectHash(tx, h, blobSize);
-    return add_tx(tx, h, blobSize, tvc, kept_by_block, blockchainHeight);
+    return add_tx(CachedTransaction(tx), tvc, kept_by_block, blockchainHeight);
   }
   //---------------------------------------------------------------------------------
   bool tx_memory_pool::take_tx(const Crypto::Hash &id, Transaction &tx, size_t& blobSize, uint64_t& fee) {
-    std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
-    auto it = m_transactions.find(id);
-    if (it == m_transactions.end()) {
+    TransactionDetails txd;
+    if (!take_tx(id, txd)) {
       return false;
     }
 
-    auto& txd = *it;
-
-    tx = txd.tx;
+    tx = std::move(txd.tx);
     blobSize = txd.blobSize;
     fee = txd.fee;
+    return true;
+  }
+  //---------------------------------------------------------------------------------
+  bool tx_memory_pool::take_tx(const Crypto::Hash& id, TransactionDetails& transaction) {
+    std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
+    auto it = m_transactions.find(id);
+    if (it == m_transactions.end()) {
+      return false;
+    }
 
+    transaction = *it;
     removeTransaction(it);
     return true;
   }
   //---------------------------------------------------------------------------------
+  void tx_memory_pool::getTransactionDetails(const std::vector<Crypto::Hash>& ids, std::vector<TransactionDetails>& transactions, std::vector<Crypto::Hash>& missedIds) const {
+    std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
+    for (const Crypto::Hash& id : ids) {
+      auto it = m_transactions.find(id);
+      if (it == m_transactions.end()) {
+        missedIds.push_back(id);
+      } else {
+        transactions.push_back(*it);
+      }
+    }
+  }
+  //---------------------------------------------------------------------------------
   size_t tx_memory_pool::get_transactions_count() const {
     std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
     return m_transactions.size();
@@ -282,7 +304,7 @@ namespace CryptoNote {
     std::unordered_set<Crypto::Hash> ready_tx_ids;
     for (const auto& tx : m_transactions) {
       TransactionCheckInfo checkInfo(tx);
-      if (is_transaction_ready_to_go(tx.tx, checkInfo)) {
+      if (is_transaction_ready_to_go(tx, checkInfo)) {
         ready_tx_ids.insert(tx.id);
       }
     }
@@ -304,10 +326,17 @@ namespace CryptoNote {
   }
   //---------------------------------------------------------------------------------
   bool tx_memory_pool::on_blockchain_inc(uint64_t new_block_height, const Crypto::Hash& top_block_id) {
+    std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
+    m_blockchainHeight = new_block_height;
+    clearBlockTemplateCache();
     return true;
   }
   //---------------------------------------------------------------------------------
   bool tx_memory_pool::on_blockchain_dec(uint64_t new_block_height, const Crypto::Hash& top_block_id) {
+    std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
+    m_blockchainHeight = new_block_height;
+    m_transactionsReadiness.clear();
+    clearBlockTemplateCache();
     return true;
   }
   //---------------------------------------------------------------------------------
@@ -332,9 +361,10 @@ namespace CryptoNote {
   }
 
   //---------------------------------------------------------------------------------
-  bool tx_memory_pool::is_transaction_ready_to_go(const Transaction& tx, TransactionCheckInfo& txd) const {
-
-    if (!m_validator.checkTransactionInputs(tx, txd.maxUsedBlock, txd.lastFailedBlock))
+  bool tx_memory_pool::is_transaction_ready_to_go(const TransactionDetails& txd, TransactionCheckInfo& checkInfo) const {
+    const Transaction& tx = txd.tx;
+    CachedTransaction transaction(tx, txd.id, txd.prefixHash, txd.blobSize);
+    if (!m_validator.checkTransactionInputs(transaction, checkInfo.maxUsedBlock, checkInfo.lastFailedBlock))
     {
       return false;
     }
@@ -354,6 +384,41 @@ namespace CryptoNote {
     return true;
   }
   //---------------------------------------------------------------------------------
+  // Transactions that aren't ready are only checked again after a new block, even if they are waiting for outputs
+  // unlocked by time
+  bool tx_memory_pool::isTransactionReady(const TransactionDetails& txd) {
+    auto readiness = m_transactionsReadiness.find(txd.id);
+    if (readiness != m_transactionsReadiness.end()) {
+      if (readiness->second.blockchainHeight == m_blockchainHeight) {
+        return readiness->second.ready;
+      }
+
+      if (readiness->second.ready) {
+        readiness->second.ready = m_validator.checkTransactionExtraSize(txd.tx.extra.size()) && !m_validator.haveSpentKeyImages(txd.tx);
+        readiness->second.blockchainHeight = m_blockchainHeight;
+        return readiness->second.ready;
+      }
+    }
+
+    TransactionCheckInfo checkInfo(txd);
+    bool ready = is_transaction_ready_to_go(txd, checkInfo);
+
+    // update item state
+    m_transactions.modify(m_transactions.find(txd.id), [&checkInfo](TransactionCheckInfo& item) {
+      item = checkInfo;
+    });
+
+    TransactionReadiness& entry = m_transactionsReadiness[txd.id];
+    entry.ready = ready;
+    entry.blockchainHeight = m_blockchainHeight;
+    return ready;
+  }
+  //---------------------------------------------------------------------------------
+  void tx_memory_pool::clearBlockTemplateCache() {
+    m_blockTemplateCache.valid = false;
+    m_blockTemplateCache.transactionHashes.clear();
+  }
+  //---------------------------------------------------------------------------------
   std::string tx_memory_pool::print_pool(bool short_format) const {
     std::stringstream ss;
     std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
@@ -396,8 +461,7 @@ namespace CryptoNote {
         continue;
       }
 
-      TransactionCheckInfo checkInfo(txd);
-      if (is_transaction_ready_to_go(txd.tx, checkInfo) && blockTemplate.addTransaction(txd.id, txd.tx)) {
+      if (isTransactionReady(txd) && blockTemplate.addTransaction(txd.id, txd.tx)) {
         total_size += txd.blobSize;
       }
     }
@@ -410,15 +474,7 @@ namespace CryptoNote {
         continue;
       }
 
-      TransactionCheckInfo checkInfo(txd);
-      bool ready = is_transaction_ready_to_go(txd.tx, checkInfo);
-
-      // update item state
-      m_fee_index.modify(i, [&checkInfo](TransactionCheckInfo& item) {
-        item = checkInfo;
-      });
-
-      if (ready && blockTemplate.addTransaction(txd.id, txd.tx)) {
+      if (isTransactionReady(txd) && blockTemplate.addTransaction(txd.id, txd.tx)) {
         total_size += txd.blobSize;
         fee += txd.fee;
       }
@@ -432,6 +488,13 @@ namespace CryptoNote {
                                            uint64_t already_generated_coins, size_t& total_size, uint64_t& fee) {
     std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
 
+    if (m_blockTemplateCache.valid && m_blockTemplateCache.maxCumulativeSize == maxBlockCumulativeSize) {
+      bl.transactionHashes = m_blockTemplateCache.transactionHashes;
+      total_size = m_blockTemplateCache.totalSize;
+      fee = m_blockTemplateCache.fee;
+      return true;
+    }
+
     total_size = 0;
     fee = 0;
 
@@ -444,8 +507,7 @@ namespace CryptoNote {
         continue;
       }
 
-      TransactionCheckInfo checkInfo(txd);
-      if (is_transaction_ready_to_go(txd.tx, checkInfo) && blockTemplate.addTransaction(txd.id, txd.tx)) {
+      if (isTransactionReady(txd) && blockTemplate.addTransaction(txd.id, txd.tx)) {
         total_size += txd.blobSize;
       }
     }
@@ -457,21 +519,19 @@ namespace CryptoNote {
         continue;
       }
 
-      TransactionCheckInfo checkInfo(txd);
-      bool ready = is_transaction_ready_to_go(txd.tx, checkInfo);
-
-      // update item state
-      m_fee_index.modify(i, [&checkInfo](TransactionCheckInfo& item) {
-        item = checkInfo;
-      });
-
-      if (ready && blockTemplate.addTransaction(txd.id, txd.tx)) {
+      if (isTransactionReady(txd) && blockTemplate.addTransaction(txd.id, txd.tx)) {
         total_size += txd.blobSize;
         fee += txd.fee;
       }
     }
 
     bl.transactionHashes = blockTemplate.getTransactions();
+
+    m_blockTemplateCache.valid = true;
+    m_blockTemplateCache.maxCumulativeSize = maxBlockCumulativeSize;
+    m_blockTemplateCache.transactionHashes = bl.transactionHashes;
+    m_blockTemplateCache.totalSize = total_size;
+    m_blockTemplateCache.fee = fee;
     return true;
   }
   //---------------------------------------------------------------------------------
@@ -494,6 +554,8 @@ namespace CryptoNote {
 
       m_paymentIdIndex.clear();
       m_timestampIndex.clear();
+      m_transactionsReadiness.clear();
+      clearBlockTemplateCache();
     } else {
       buildIndexes();
     }
@@ -535,6 +597,11 @@ namespace CryptoNote {
     s(td.lastFailedBlock.id, "lastFailedBlock.id");
     s(td.keptByBlock, "keptByBlock");
     s(reinterpret_cast<uint64_t&>(td.receiveTime), "receiveTime");
+
+    // the prefix hash isn't stored, so the pool file format stays the same
+    if (s.type() == ISerializer::INPUT) {
+      td.prefixHash = CachedTransaction(td.tx).getTransactionPrefixHash();
+    }
   }
 
   //---------------------------------------------------------------------------------
@@ -552,6 +619,8 @@ namespace CryptoNote {
 
     if (s.type() == ISerializer::INPUT) {
       m_transactions.clear();
+      m_transactionsReadiness.clear();
+      clearBlockTemplateCache();
       readSequence<TransactionDetails>(std::inserter(m_transactions, m_transactions.end()), "transactions", s);
     } else {
       writeSequence<TransactionDetails>(m_transactions.begin(), m_transactions.end(), "transactions", s);
@@ -610,6 +679,8 @@ namespace CryptoNote {
     removeTransactionInputs(i->id, i->tx, i->keptByBlock);
     m_paymentIdIndex.remove(i->tx);
     m_timestampIndex.remove(i->receiveTime, i->id);
+    m_transactionsReadiness.erase(i->id);
+    clearBlockTemplateCache();
     return m_transactions.erase(i);
   }
 
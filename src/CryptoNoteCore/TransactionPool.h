@@ -87,7 +87,7 @@ namespace CryptoNote {
     bool deinit();
 
     bool have_tx(const Crypto::Hash &id) const;
-    bool add_tx(const Transaction &tx, const Crypto::Hash &id, size_t blobSize, tx_verification_context& tvc, bool kept_by_block, uint32_t blockchainHeight);
+    bool add_tx(const CachedTransaction& transaction, tx_verification_context& tvc, bool kept_by_block, uint32_t blockchainHeight);
     bool add_tx(const Transaction &tx, tx_verification_context& tvc, bool kept_by_block, uint32_t blockchainHeight);
     //gets tx and remove it from pool
     bool take_tx(const Crypto::Hash &id, Transaction &tx, size_t& blobSize, uint64_t& fee);
@@ -134,12 +134,17 @@ namespace CryptoNote {
 
     struct TransactionDetails : public TransactionCheckInfo {
       Crypto::Hash id;
+      Crypto::Hash prefixHash;
       Transaction tx;
       size_t blobSize;
       uint64_t fee;
       bool keptByBlock;
       time_t receiveTime;
     };
+
+    // The same as take_tx() and getTransactions(), with the hashes and the size the pool keeps for the transactions
+    bool take_tx(const Crypto::Hash& id, TransactionDetails& transaction);
+    void getTransactionDetails(const std::vector<Crypto::Hash>& ids, std::vector<TransactionDetails>& transactions, std::vector<Crypto::Hash>& missedIds) const;
     
     void getMemoryPool(std::list<CryptoNote::tx_memory_pool::TransactionDetails> txs) const;
     std::list<CryptoNote::tx_memory_pool::TransactionDetails> getMemoryPool() const;
@@ -186,7 +191,9 @@ namespace CryptoNote {
 
     tx_container_t::iterator removeTransaction(tx_container_t::iterator i);
     bool removeExpiredTransactions();
-    bool is_transaction_ready_to_go(const Transaction& tx, TransactionCheckInfo& txd) const;
+    bool is_transaction_ready_to_go(const TransactionDetails& txd, TransactionCheckInfo& checkInfo) const;
+    bool isTransactionReady(const TransactionDetails& txd);
+    void clearBlockTemplateCache();
 
     void buildIndexes();
 
@@ -209,6 +216,27 @@ namespace CryptoNote {
 
     PaymentIdIndex m_paymentIdIndex;
     TimestampTransactionsIndex m_timestampIndex;
+
+    // Result of is_transaction_ready_to_go() for a pool transaction and the blockchain height it was found for. A new
+    // block can only make a ready transaction not ready by spending one of its key images, so only that is checked
+    // again for it, popping a block drops all results.
+    struct TransactionReadiness {
+      bool ready;
+      uint64_t blockchainHeight;
+    };
+
+    // Template built by fill_block_template2(), it is served again until the pool or the blockchain changes
+    struct BlockTemplateCache {
+      bool valid;
+      size_t maxCumulativeSize;
+      std::vector<Crypto::Hash> transactionHashes;
+      size_t totalSize;
+      uint64_t fee;
+    };
+
+    std::unordered_map<Crypto::Hash, TransactionReadiness> m_transactionsReadiness;
+    uint64_t m_blockchainHeight;
+    BlockTemplateCache m_blockTemplateCache;
   };
 }
 
@@ -0,0 +1,61 @@
+// Copyright (c) 2018-2022 The Cash2 developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "VerifiedTransactionCache.h"
+
+#include <iterator>
+
+namespace CryptoNote {
+
+VerifiedTransactionCache::VerifiedTransactionCache(size_t capacity) : m_capacity(capacity) {
+}
+
+void VerifiedTransactionCache::add(const Crypto::Hash& transactionHash, const BlockInfo& maxUsedBlock) {
+  if (m_capacity == 0) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_transactions.find(transactionHash);
+  if (it != m_transactions.end()) {
+    it->second.maxUsedBlock = maxUsedBlock;
+    return;
+  }
+
+  if (m_transactions.size() == m_capacity) {
+    m_transactions.erase(m_order.front());
+    m_order.pop_front();
+  }
+
+  m_order.push_back(transactionHash);
+  m_transactions.emplace(transactionHash, Entry{ maxUsedBlock, std::prev(m_order.end()) });
+}
+
+bool VerifiedTransactionCache::find(const Crypto::Hash& transactionHash, BlockInfo& maxUsedBlock) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_transactions.find(transactionHash);
+  if (it == m_transactions.end()) {
+    return false;
+  }
+
+  maxUsedBlock = it->second.maxUsedBlock;
+  return true;
+}
+
+void VerifiedTransactionCache::remove(const Crypto::Hash& transactionHash) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_transactions.find(transactionHash);
+  if (it != m_transactions.end()) {
+    m_order.erase(it->second.order);
+    m_transactions.erase(it);
+  }
+}
+
+void VerifiedTransactionCache::clear() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_transactions.clear();
+  m_order.clear();
+}
+
+}
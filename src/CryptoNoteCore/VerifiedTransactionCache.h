@@ -0,0 +1,40 @@
+// Copyright (c) 2018-2022 The Cash2 developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+#include "crypto/hash.h"
+#include "CryptoNoteCore/ITransactionValidator.h"
+
+namespace CryptoNote {
+
+// Transactions whose ring signatures have been verified, with the newest block holding one of the outputs they spend.
+// The verification stays valid as long as that block is in the main chain, which callers check on lookup.
+// When full, the oldest entry is evicted first.
+class VerifiedTransactionCache {
+public:
+  explicit VerifiedTransactionCache(size_t capacity);
+
+  void add(const Crypto::Hash& transactionHash, const BlockInfo& maxUsedBlock);
+  bool find(const Crypto::Hash& transactionHash, BlockInfo& maxUsedBlock) const;
+  void remove(const Crypto::Hash& transactionHash);
+  void clear();
+
+private:
+  struct Entry {
+    BlockInfo maxUsedBlock;
+    std::list<Crypto::Hash>::iterator order;
+  };
+
+  mutable std::mutex m_mutex;
+  size_t m_capacity;
+  std::unordered_map<Crypto::Hash, Entry> m_transactions;
+  std::list<Crypto::Hash> m_order;
+};
+
+}
@@ -7,10 +7,13 @@
 #include "CryptoNoteProtocolHandler.h"
 
 #include <future>
+#include <thread>
 #include <boost/scope_exit.hpp>
 #include <boost/uuid/uuid_io.hpp>
 #include <System/Dispatcher.h>
+#include <System/RemoteContext.h>
 
+#include "CryptoNoteCore/CachedTransaction.h"
 #include "CryptoNoteCore/CryptoNoteBasicImpl.h"
 #include "CryptoNoteCore/CryptoNoteFormatUtils.h"
 #include "CryptoNoteCore/CryptoNoteTools.h"
@@ -46,6 +49,7 @@ CryptoNoteProtocolHandler::CryptoNoteProtocolHandler(const Currency& currency, S
   m_stop(false),
   m_observedHeight(0),
   m_peersCount(0),
+  m_blocksAdded(dispatcher),
   logger(log, "protocol") {
   
   if (!m_p2p) {
@@ -68,6 +72,12 @@ void CryptoNoteProtocolHandler::onConnectionOpened(CryptoNoteConnectionContext&
 }
 
 void CryptoNoteProtocolHandler::onConnectionClosed(CryptoNoteConnectionContext& context) {
+  context.m_requested_objects.clear();
+  if (releaseBlockClaims(context)) {
+    //blocks this connection was downloading are left to the idle ones
+    resumeIdleConnections(context);
+  }
+
   bool updated = false;
   {
     std::lock_guard<std::mutex> lock(m_observedHeightMutex);
@@ -235,9 +245,14 @@ int CryptoNoteProtocolHandler::handle_notify_new_block(int command, NOTIFY_NEW_B
     return 1;
   }
 
-  for (auto tx_blob_it = arg.b.txs.begin(); tx_blob_it != arg.b.txs.end(); tx_blob_it++) {
-    CryptoNote::tx_verification_context tvc = boost::value_initialized<decltype(tvc)>();
-    m_core.handle_incoming_tx(asBinaryArray(*tx_blob_it), tvc, true);
+  std::vector<BinaryArray> txBlobs;
+  for (const std::string& txBlob : arg.b.txs) {
+    txBlobs.push_back(asBinaryArray(txBlob));
+  }
+
+  std::vector<tx_verification_context> tvcs;
+  m_core.handleIncomingTransactions(txBlobs, tvcs, true);
+  for (const tx_verification_context& tvc : tvcs) {
     if (tvc.m_verification_failed) {
       logger(Logging::INFO) << context << "Block verification failed: transaction verification failed, dropping connection";
       context.m_state = CryptoNoteConnectionContext::state_shutdown;
@@ -277,13 +292,20 @@ int CryptoNoteProtocolHandler::handle_notify_new_transactions(int command, NOTIF
   if (context.m_state != CryptoNoteConnectionContext::state_normal)
     return 1;
 
-  for (auto tx_blob_it = arg.txs.begin(); tx_blob_it != arg.txs.end();) {
-    CryptoNote::tx_verification_context tvc = boost::value_initialized<decltype(tvc)>();
-    m_core.handle_incoming_tx(asBinaryArray(*tx_blob_it), tvc, false);
-    if (tvc.m_verification_failed) {
+  std::vector<BinaryArray> txBlobs;
+  for (const std::string& txBlob : arg.txs) {
+    txBlobs.push_back(asBinaryArray(txBlob));
+  }
+
+  std::vector<tx_verification_context> tvcs;
+  m_core.handleIncomingTransactions(txBlobs, tvcs, false);
+
+  auto tvc = tvcs.begin();
+  for (auto tx_blob_it = arg.txs.begin(); tx_blob_it != arg.txs.end(); ++tvc) {
+    if (tvc->m_verification_failed) {
       logger(Logging::INFO) << context << "Tx verification failed";
     }
-    if (!tvc.m_verification_failed && tvc.m_should_be_relayed) {
+    if (!tvc->m_verification_failed && tvc->m_should_be_relayed) {
       ++tx_blob_it;
     } else {
       tx_blob_it = arg.txs.erase(tx_blob_it);
@@ -333,6 +355,12 @@ int CryptoNoteProtocolHandler::handle_request_get_objects(int command, NOTIFY_RE
 int CryptoNoteProtocolHandler::handle_response_get_objects(int command, NOTIFY_RESPONSE_GET_OBJECTS::request& arg, CryptoNoteConnectionContext& context) {
   logger(Logging::TRACE) << context << "NOTIFY_RESPONSE_GET_OBJECTS";
 
+  if (context.m_ignored_objects_responses > 0) {
+    --context.m_ignored_objects_responses;
+    logger(Logging::TRACE) << context << "NOTIFY_RESPONSE_GET_OBJECTS ignored, synchronization was interrupted after the request";
+    return 1;
+  }
+
   if (context.m_last_response_height > arg.current_blockchain_height) {
     logger(Logging::ERROR) << context << "sent wrong NOTIFY_HAVE_OBJECTS: arg.m_current_blockchain_height=" << arg.current_blockchain_height
       << " < m_last_response_height=" << context.m_last_response_height << ", dropping connection";
@@ -344,6 +372,10 @@ int CryptoNoteProtocolHandler::handle_response_get_objects(int command, NOTIFY_R
 
   context.m_remote_blockchain_height = arg.current_blockchain_height;
 
+  std::vector<uint32_t> blockHeights;
+  blockHeights.reserve(arg.blocks.size());
+  Crypto::Hash firstPreviousBlockHash = NULL_HASH;
+
   size_t count = 0;
   for (const block_complete_entry& block_entry : arg.blocks) {
     ++count;
@@ -358,14 +390,18 @@ int CryptoNoteProtocolHandler::handle_response_get_objects(int command, NOTIFY_R
     //to avoid concurrency in core between connections, suspend connections which delivered block later then first one
     if (count == 2) {
       if (m_core.have_block(get_block_hash(b))) {
-        context.m_state = CryptoNoteConnectionContext::state_idle;
-        context.m_needed_objects.clear();
+        // this is the response to everything requested, nothing else is in flight
         context.m_requested_objects.clear();
+        setIdle(context);
         logger(Logging::DEBUGGING) << context << "Connection set to idle state.";
         return 1;
       }
     }
 
+    if (count == 1) {
+      firstPreviousBlockHash = b.previousBlockHash;
+    }
+
     auto blockHash = get_block_hash(b);
     auto req_it = context.m_requested_objects.find(blockHash);
     if (req_it == context.m_requested_objects.end()) {
@@ -382,6 +418,7 @@ int CryptoNoteProtocolHandler::handle_response_get_objects(int command, NOTIFY_R
     }
 
     context.m_requested_objects.erase(req_it);
+    blockHeights.push_back(get_block_height(b));
   }
 
   if (context.m_requested_objects.size()) {
@@ -392,12 +429,45 @@ int CryptoNoteProtocolHandler::handle_response_get_objects(int command, NOTIFY_R
     return 1;
   }
 
+  updateObjectsSpan(context, arg.blocks);
+
+  // the blocks of this response stay claimed until they are added, the next request is claimed separately
+  BOOST_SCOPE_EXIT_ALL(this, &context) { releaseBlockClaims(context); };
+
+  // ask for the next blocks before verifying these, so the peer is sending while we are busy
+  if (!m_stop && !context.m_needed_objects.empty()) {
+    requestObjects(context, true);
+  }
+
+  // parsing and the checks that don't need the blockchain run on other threads, the dispatcher keeps serving connections
+  std::vector<PrevalidatedTransaction> transactions;
+  {
+    System::RemoteContext<std::vector<PrevalidatedTransaction>> prevalidation(m_dispatcher, [this, &arg, &blockHeights] {
+      return prevalidateTransactions(arg.blocks, blockHeights);
+    });
+
+    transactions = prevalidation.get();
+  }
+
+  // blocks are added strictly in chain order, so wait for the connections downloading the preceding blocks
+  while (!arg.blocks.empty() && !m_core.have_block(firstPreviousBlockHash)) {
+    auto claimIt = m_blockClaims.find(firstPreviousBlockHash);
+    if (m_stop || claimIt == m_blockClaims.end() || claimIt->second == context.m_connection_id) {
+      logger(Logging::DEBUGGING) << context << "Preceding blocks won't be delivered, restarting synchronization";
+      dropRequestedObjects(context);
+      start_sync(context);
+      return 1;
+    }
+
+    m_blocksAdded.wait();
+  }
+
   {
     m_core.pause_mining();
 
     BOOST_SCOPE_EXIT_ALL(this) { m_core.update_block_template_and_resume_mining(); };
 
-    int result = processObjects(context, arg.blocks);
+    int result = processObjects(context, arg.blocks, transactions);
     if (result != 0) {
       return result;
     }
@@ -409,14 +479,69 @@ int CryptoNoteProtocolHandler::handle_response_get_objects(int command, NOTIFY_R
   logger(DEBUGGING, BRIGHT_GREEN) << "Local blockchain updated, new height = " << height;
 
   if (!m_stop && context.m_state == CryptoNoteConnectionContext::state_synchronizing) {
-    request_missing_objects(context, true);
+    if (context.m_requested_objects.empty()) {
+      request_missing_objects(context, true);
+    } else {
+      // time spent here is ours, not the peer's
+      context.m_objects_requested_at = std::chrono::steady_clock::now();
+    }
   }
 
   return 1;
 }
 
-int CryptoNoteProtocolHandler::processObjects(CryptoNoteConnectionContext& context, const std::vector<block_complete_entry>& blocks) {
+std::vector<CryptoNoteProtocolHandler::PrevalidatedTransaction> CryptoNoteProtocolHandler::prevalidateTransactions(const std::vector<block_complete_entry>& blocks, const std::vector<uint32_t>& blockHeights) {
+  std::vector<std::pair<const std::string*, uint32_t>> blobs;
+  for (size_t i = 0; i < blocks.size(); ++i) {
+    for (const std::string& blob : blocks[i].txs) {
+      blobs.emplace_back(&blob, blockHeights[i]);
+    }
+  }
+
+  std::vector<PrevalidatedTransaction> transactions(blobs.size());
+  std::atomic<size_t> next(0);
+  auto worker = [&] {
+    for (size_t i = next++; i < blobs.size(); i = next++) {
+      PrevalidatedTransaction& transaction = transactions[i];
+      const std::string& blob = *blobs[i].first;
+      transaction.blobSize = blob.size();
+      transaction.blockHeight = blobs[i].second;
+      transaction.valid = false;
+
+      if (blob.size() > m_currency.maxTxSize()) {
+        logger(Logging::INFO) << "WRONG TRANSACTION BLOB, too big size " << blob.size() << ", rejected";
+        transaction.parsed = false;
+        continue;
+      }
+
+      transaction.parsed = parseAndValidateTransactionFromBinaryArray(asBinaryArray(blob), transaction.transaction, transaction.hash, transaction.prefixHash);
+      if (!transaction.parsed) {
+        logger(Logging::INFO) << "WRONG TRANSACTION BLOB, Failed to parse, rejected";
+        continue;
+      }
 
+      tx_verification_context tvc = boost::value_initialized<decltype(tvc)>();
+      transaction.valid = m_core.prevalidateTransaction(CachedTransaction(transaction.transaction, transaction.hash, transaction.prefixHash, transaction.blobSize),
+        tvc, true, transaction.blockHeight);
+    }
+  };
+
+  std::vector<std::thread> threads;
+  size_t threadCount = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), blobs.size());
+  for (size_t i = 1; i < threadCount; ++i) {
+    threads.emplace_back(worker);
+  }
+
+  worker();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  return transactions;
+}
+
+int CryptoNoteProtocolHandler::processObjects(CryptoNoteConnectionContext& context, const std::vector<block_complete_entry>& blocks, std::vector<PrevalidatedTransaction>& transactions) {
+  auto transactionIt = transactions.begin();
   for (const block_complete_entry& block_entry : blocks) {
     if (m_stop) {
       break;
@@ -424,8 +549,21 @@ int CryptoNoteProtocolHandler::processObjects(CryptoNoteConnectionContext& conte
 
     //process transactions
     for (auto& tx_blob : block_entry.txs) {
+      PrevalidatedTransaction& transaction = *transactionIt++;
+      CachedTransaction cachedTransaction(transaction.transaction, transaction.hash, transaction.prefixHash, transaction.blobSize);
       tx_verification_context tvc = boost::value_initialized<decltype(tvc)>();
-      m_core.handle_incoming_tx(asBinaryArray(tx_blob), tvc, true);
+      uint32_t height = m_core.get_current_blockchain_height();
+      if (transaction.parsed && transaction.blockHeight != height) {
+        // the height taken from the miner transaction was wrong, check again with the one the transaction is added at
+        transaction.valid = m_core.prevalidateTransaction(cachedTransaction, tvc, true, height);
+      }
+
+      if (transaction.valid) {
+        m_core.handlePrevalidatedTransaction(cachedTransaction, tvc, true);
+      } else {
+        tvc.m_verification_failed = true;
+      }
+
       if (tvc.m_verification_failed) {
         logger(Logging::ERROR) << context << "transaction verification failed on NOTIFY_RESPONSE_GET_OBJECTS, \r\ntx_id = "
           << Common::podToHex(getBinaryArrayHash(asBinaryArray(tx_blob))) << ", dropping connection";
@@ -448,9 +586,7 @@ int CryptoNoteProtocolHandler::processObjects(CryptoNoteConnectionContext& conte
       return 1;
     } else if (bvc.m_already_exists) {
       logger(Logging::DEBUGGING) << context << "Block already exists, switching to idle state";
-      context.m_state = CryptoNoteConnectionContext::state_idle;
-      context.m_needed_objects.clear();
-      context.m_requested_objects.clear();
+      setIdle(context);
       return 1;
     }
 
@@ -492,26 +628,21 @@ int CryptoNoteProtocolHandler::handle_request_chain(int command, NOTIFY_REQUEST_
 bool CryptoNoteProtocolHandler::request_missing_objects(CryptoNoteConnectionContext& context, bool check_having_blocks) {
   if (context.m_needed_objects.size()) {
     //we know objects that we need, request this objects
-    NOTIFY_REQUEST_GET_OBJECTS::request req;
-    size_t count = 0;
-    auto it = context.m_needed_objects.begin();
-
-    while (it != context.m_needed_objects.end() && count < BLOCKS_SYNCHRONIZING_DEFAULT_COUNT) {
-      if (!(check_having_blocks && m_core.have_block(*it))) {
-        req.blocks.push_back(*it);
-        ++count;
-        context.m_requested_objects.insert(*it);
-      }
-      it = context.m_needed_objects.erase(it);
+    if (!requestObjects(context, check_having_blocks) && !context.m_needed_objects.empty()) {
+      //the rest of this chain entry is downloaded by other connections, they resume this one when they are done
+      logger(Logging::DEBUGGING) << context << "Remaining blocks are requested from other peers, switching to idle state";
+      setIdle(context);
+    } else if (context.m_needed_objects.empty() && context.m_requested_objects.empty()) {
+      //all of them turned out to be in the blockchain already
+      return request_missing_objects(context, check_having_blocks);
     }
-    logger(Logging::TRACE) << context << "-->>NOTIFY_REQUEST_GET_OBJECTS: blocks.size()=" << req.blocks.size() << ", txs.size()=" << req.txs.size();
-    post_notify<NOTIFY_REQUEST_GET_OBJECTS>(*m_p2p, req, context);
   } else if (context.m_last_response_height < context.m_remote_blockchain_height - 1) {//we have to fetch more objects ids, request blockchain entry
 
     NOTIFY_REQUEST_CHAIN::request r = boost::value_initialized<NOTIFY_REQUEST_CHAIN::request>();
     r.block_ids = m_core.buildSparseChain();
     logger(Logging::TRACE) << context << "-->>NOTIFY_REQUEST_CHAIN: m_block_ids.size()=" << r.block_ids.size();
     post_notify<NOTIFY_REQUEST_CHAIN>(*m_p2p, r, context);
+    resumeIdleConnections(context);
   } else {
     if (!(context.m_last_response_height ==
       context.m_remote_blockchain_height - 1 &&
@@ -536,6 +667,107 @@ bool CryptoNoteProtocolHandler::request_missing_objects(CryptoNoteConnectionCont
   return true;
 }
 
+bool CryptoNoteProtocolHandler::requestObjects(CryptoNoteConnectionContext& context, bool check_having_blocks) {
+  NOTIFY_REQUEST_GET_OBJECTS::request req;
+  auto it = context.m_needed_objects.begin();
+
+  while (it != context.m_needed_objects.end() && req.blocks.size() < context.m_objects_span) {
+    if (check_having_blocks && m_core.have_block(*it)) {
+      it = context.m_needed_objects.erase(it);
+    } else if (claimBlock(*it, context)) {
+      req.blocks.push_back(*it);
+      context.m_requested_objects.insert(*it);
+      it = context.m_needed_objects.erase(it);
+    } else {
+      //downloaded by another connection, kept in case that one gives up
+      ++it;
+    }
+  }
+
+  if (req.blocks.empty()) {
+    return false;
+  }
+
+  logger(Logging::TRACE) << context << "-->>NOTIFY_REQUEST_GET_OBJECTS: blocks.size()=" << req.blocks.size() << ", txs.size()=" << req.txs.size();
+  context.m_objects_requested_at = std::chrono::steady_clock::now();
+  post_notify<NOTIFY_REQUEST_GET_OBJECTS>(*m_p2p, req, context);
+  return true;
+}
+
+void CryptoNoteProtocolHandler::updateObjectsSpan(CryptoNoteConnectionContext& context, const std::vector<block_complete_entry>& blocks) {
+  if (blocks.empty()) {
+    return;
+  }
+
+  uint64_t elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - context.m_objects_requested_at).count();
+  uint64_t size = 0;
+  for (const block_complete_entry& block_entry : blocks) {
+    size += block_entry.block.size();
+    for (const std::string& tx_blob : block_entry.txs) {
+      size += tx_blob.size();
+    }
+  }
+
+  // aim at the target response time, averaged with the previous span to smooth out single slow or fast responses
+  uint64_t span = blocks.size() * BLOCKS_SYNCHRONIZING_TARGET_TIME / std::max<uint64_t>(elapsed, 1);
+  span = (context.m_objects_span + span) / 2;
+  span = std::max<uint64_t>(std::min<uint64_t>(span, BLOCKS_SYNCHRONIZING_MAX_COUNT), BLOCKS_SYNCHRONIZING_DEFAULT_COUNT);
+  span = std::max<uint64_t>(std::min<uint64_t>(span, blocks.size() * BLOCKS_SYNCHRONIZING_MAX_SIZE / std::max<uint64_t>(size, 1)), 1);
+
+  if (span != context.m_objects_span) {
+    logger(Logging::TRACE) << context << "Blocks request size changed to " << span << " (" << blocks.size() << " blocks, " << size << " bytes in " << elapsed << " ms)";
+    context.m_objects_span = static_cast<size_t>(span);
+  }
+}
+
+bool CryptoNoteProtocolHandler::claimBlock(const Crypto::Hash& blockHash, const CryptoNoteConnectionContext& context) {
+  auto result = m_blockClaims.emplace(blockHash, context.m_connection_id);
+  return result.second || result.first->second == context.m_connection_id;
+}
+
+bool CryptoNoteProtocolHandler::releaseBlockClaims(const CryptoNoteConnectionContext& context) {
+  // blocks still requested from the peer stay claimed
+  bool released = false;
+  for (auto it = m_blockClaims.begin(); it != m_blockClaims.end();) {
+    if (it->second == context.m_connection_id && context.m_requested_objects.count(it->first) == 0) {
+      it = m_blockClaims.erase(it);
+      released = true;
+    } else {
+      ++it;
+    }
+  }
+
+  m_blocksAdded.set();
+  m_blocksAdded.clear();
+  return released;
+}
+
+void CryptoNoteProtocolHandler::dropRequestedObjects(CryptoNoteConnectionContext& context) {
+  if (!context.m_requested_objects.empty()) {
+    ++context.m_ignored_objects_responses;
+  }
+
+  context.m_needed_objects.clear();
+  context.m_requested_objects.clear();
+  releaseBlockClaims(context);
+}
+
+void CryptoNoteProtocolHandler::setIdle(CryptoNoteConnectionContext& context) {
+  context.m_state = CryptoNoteConnectionContext::state_idle;
+  dropRequestedObjects(context);
+}
+
+void CryptoNoteProtocolHandler::resumeIdleConnections(const CryptoNoteConnectionContext& context) {
+  uint32_t height = get_current_blockchain_height();
+  m_p2p->for_each_connection([&](CryptoNoteConnectionContext& ctx, PeerIdType peerId) {
+    if (ctx.m_connection_id != context.m_connection_id && ctx.m_state == CryptoNoteConnectionContext::state_idle &&
+        ctx.m_remote_blockchain_height > height + 1) {
+      ctx.m_state = CryptoNoteConnectionContext::state_synchronizing;
+      start_sync(ctx);
+    }
+  });
+}
+
 bool CryptoNoteProtocolHandler::on_connection_synchronized() {
   bool val_expected = false;
   if (m_synchronized.compare_exchange_strong(val_expected, true)) {
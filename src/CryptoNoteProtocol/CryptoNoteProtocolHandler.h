@@ -6,8 +6,10 @@
 #pragma once
 
 #include <atomic>
+#include <unordered_map>
 
 #include <Common/ObserverManager.h>
+#include <System/Event.h>
 #include "CryptoNoteConfig.h"
 #include "CryptoNoteCore/ICore.h"
 
@@ -77,10 +79,28 @@ namespace CryptoNote
     //----------------------------------------------------------------------------------
     uint32_t get_current_blockchain_height();
     bool request_missing_objects(CryptoNoteConnectionContext& context, bool check_having_blocks);
+    bool requestObjects(CryptoNoteConnectionContext& context, bool check_having_blocks);
     bool on_connection_synchronized();
     void updateObservedHeight(uint32_t peerHeight, const CryptoNoteConnectionContext& context);
     void recalculateMaxObservedHeight(const CryptoNoteConnectionContext& context);
-    int processObjects(CryptoNoteConnectionContext& context, const std::vector<block_complete_entry>& blocks);
+    struct PrevalidatedTransaction {
+      Transaction transaction;
+      Crypto::Hash hash;
+      Crypto::Hash prefixHash;
+      size_t blobSize;
+      uint32_t blockHeight;
+      bool parsed;
+      bool valid;
+    };
+
+    std::vector<PrevalidatedTransaction> prevalidateTransactions(const std::vector<block_complete_entry>& blocks, const std::vector<uint32_t>& blockHeights);
+    int processObjects(CryptoNoteConnectionContext& context, const std::vector<block_complete_entry>& blocks, std::vector<PrevalidatedTransaction>& transactions);
+    void updateObjectsSpan(CryptoNoteConnectionContext& context, const std::vector<block_complete_entry>& blocks);
+    bool claimBlock(const Crypto::Hash& blockHash, const CryptoNoteConnectionContext& context);
+    bool releaseBlockClaims(const CryptoNoteConnectionContext& context);
+    void dropRequestedObjects(CryptoNoteConnectionContext& context);
+    void setIdle(CryptoNoteConnectionContext& context);
+    void resumeIdleConnections(const CryptoNoteConnectionContext& context);
     Logging::LoggerRef logger;
 
   private:
@@ -98,6 +118,11 @@ namespace CryptoNote
     uint32_t m_observedHeight;
 
     std::atomic<size_t> m_peersCount;
+
+    // blocks requested by synchronizing connections and not added to the blockchain yet, so that every block is
+    // downloaded from a single peer; m_blocksAdded is signalled whenever claims are released
+    std::unordered_map<Crypto::Hash, boost::uuids::uuid> m_blockClaims;
+    System::Event m_blocksAdded;
     Tools::ObserverManager<ICryptoNoteProtocolObserver> m_observerManager;
   };
 }
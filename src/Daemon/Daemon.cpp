@@ -76,6 +76,7 @@ JsonValue buildLoggerConfiguration(Level level, const std::string& logfile) {
   fileLogger.insert("type", "file");
   fileLogger.insert("filename", logfile);
   fileLogger.insert("level", static_cast<int64_t>(TRACE));
+  fileLogger.insert("async", JsonValue(true));
 
   JsonValue& consoleLogger = cfgLoggers.pushBack(JsonValue::OBJECT);
   consoleLogger.insert("type", "console");
@@ -272,9 +273,13 @@ int main(int argc, char* argv[])
     }
 
     logger(INFO) << "Starting core rpc server on address " << rpcConfig.getBindAddress();
-    rpcServer.start(rpcConfig.bindIp, rpcConfig.bindPort);
+    rpcServer.setWorkerThreads(rpcConfig.workerThreads);
+    rpcServer.setMaxRequestBodySize(rpcConfig.maxRequestSize);
+    rpcServer.setMaxConnectionRequests(rpcConfig.maxConnectionRequests);
+    rpcServer.setMaxQueuedRequests(rpcConfig.maxQueuedRequests);
     rpcServer.restrictRPC(command_line::get_arg(vm, arg_restricted_rpc));
     rpcServer.enableCors(command_line::get_arg(vm, arg_enable_cors));
+    rpcServer.start(rpcConfig.bindIp, rpcConfig.bindPort);
     logger(INFO) << "Core rpc server started ok";
 
     Tools::SignalHandler::install([&dch, &p2psrv] {
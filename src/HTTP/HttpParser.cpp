@@ -28,7 +28,9 @@ namespace CryptoNote {
 HttpResponse::HTTP_STATUS HttpParser::parseResponseStatusFromString(const std::string& status) {
   if (status == "200 OK" || status == "200 Ok") return CryptoNote::HttpResponse::STATUS_200;
   else if (status == "404 Not Found") return CryptoNote::HttpResponse::STATUS_404;
+  else if (status == "413 Payload Too Large") return CryptoNote::HttpResponse::STATUS_413;
   else if (status == "500 Internal Server Error") return CryptoNote::HttpResponse::STATUS_500;
+  else if (status == "503 Service Unavailable") return CryptoNote::HttpResponse::STATUS_503;
   else throw std::system_error(make_error_code(CryptoNote::error::HttpParserErrorCodes::UNEXPECTED_SYMBOL),
       "Unknown HTTP status code is given");
 
@@ -36,7 +38,7 @@ HttpResponse::HTTP_STATUS HttpParser::parseResponseStatusFromString(const std::s
 }
 
 
-void HttpParser::receiveRequest(std::istream& stream, HttpRequest& request) {
+void HttpParser::receiveRequest(std::istream& stream, HttpRequest& request, size_t maxBodySize) {
   readWord(stream, request.method);
   readWord(stream, request.url);
 
@@ -45,8 +47,11 @@ void HttpParser::receiveRequest(std::istream& stream, HttpRequest& request) {
 
   readHeaders(stream, request.headers);
 
-  std::string body;
   size_t bodyLen = getBodyLen(request.headers);
+  if (bodyLen > maxBodySize) {
+    throw std::system_error(make_error_code(CryptoNote::error::HttpParserErrorCodes::BODY_TOO_LARGE));
+  }
+
   if (bodyLen) {
     readBody(stream, request.body, bodyLen);
   }
@@ -200,13 +205,8 @@ size_t HttpParser::getBodyLen(const HttpRequest::Headers& headers) {
 }
 
 void HttpParser::readBody(std::istream& stream, std::string& body, const size_t bodyLen) {
-  size_t read = 0;
-
-  while (stream.good() && read < bodyLen) {
-    body += stream.get();
-    ++read;
-  }
-
+  body.resize(bodyLen);
+  stream.read(&body[0], bodyLen);
   throwIfNotGood(stream);
 }
 
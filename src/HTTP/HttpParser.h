@@ -7,6 +7,7 @@
 #define HTTPPARSER_H_
 
 #include <iostream>
+#include <limits>
 #include <map>
 #include <string>
 #include "HttpRequest.h"
@@ -19,7 +20,8 @@ class HttpParser {
 public:
   HttpParser() {};
 
-  void receiveRequest(std::istream& stream, HttpRequest& request);
+  // Throws BODY_TOO_LARGE without reading the body if it is longer than maxBodySize, the request line and headers are set then
+  void receiveRequest(std::istream& stream, HttpRequest& request, size_t maxBodySize = std::numeric_limits<size_t>::max());
   void receiveResponse(std::istream& stream, HttpResponse& response);
   static HttpResponse::HTTP_STATUS parseResponseStatusFromString(const std::string& status);
 private:
@@ -15,7 +15,8 @@ enum HttpParserErrorCodes {
   STREAM_NOT_GOOD = 1,
   END_OF_STREAM,
   UNEXPECTED_SYMBOL,
-  EMPTY_HEADER
+  EMPTY_HEADER,
+  BODY_TOO_LARGE
 };
 
 // custom category:
@@ -37,6 +38,7 @@ public:
       case END_OF_STREAM: return "The stream is ended";
       case UNEXPECTED_SYMBOL: return "Unexpected symbol";
       case EMPTY_HEADER: return "The header name is empty";
+      case BODY_TOO_LARGE: return "The body is too large";
       default: return "Unknown error";
     }
   }
@@ -16,8 +16,12 @@ const char* getStatusString(CryptoNote::HttpResponse::HTTP_STATUS status) {
     return "200 OK";
   case CryptoNote::HttpResponse::STATUS_404:
     return "404 Not Found";
+  case CryptoNote::HttpResponse::STATUS_413:
+    return "413 Payload Too Large";
   case CryptoNote::HttpResponse::STATUS_500:
     return "500 Internal Server Error";
+  case CryptoNote::HttpResponse::STATUS_503:
+    return "503 Service Unavailable";
   default:
     throw std::runtime_error("Unknown HTTP status code is given");
   }
@@ -29,8 +33,12 @@ const char* getErrorBody(CryptoNote::HttpResponse::HTTP_STATUS status) {
   switch (status) {
   case CryptoNote::HttpResponse::STATUS_404:
     return "Requested url is not found\n";
+  case CryptoNote::HttpResponse::STATUS_413:
+    return "Request body is too large\n";
   case CryptoNote::HttpResponse::STATUS_500:
     return "Internal server error is occurred\n";
+  case CryptoNote::HttpResponse::STATUS_503:
+    return "Server is busy\n";
   default:
     throw std::runtime_error("Error body for given status is not available");
   }
@@ -61,7 +69,11 @@ void HttpResponse::addHeader(const std::string& name, const std::string& value)
 }
 
 void HttpResponse::setBody(const std::string& b) {
-  body = b;
+  setBody(std::string(b));
+}
+
+void HttpResponse::setBody(std::string&& b) {
+  body = std::move(b);
   if (!body.empty()) {
     headers["Content-Length"] = std::to_string(body.size());
   } else {
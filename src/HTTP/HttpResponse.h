@@ -16,7 +16,9 @@ namespace CryptoNote {
     enum HTTP_STATUS {
       STATUS_200,
       STATUS_404,
-      STATUS_500
+      STATUS_413,
+      STATUS_500,
+      STATUS_503
     };
 
     HttpResponse();
@@ -24,6 +26,7 @@ namespace CryptoNote {
     void setStatus(HTTP_STATUS s);
     void addHeader(const std::string& name, const std::string& value);
     void setBody(const std::string& b);
+    void setBody(std::string&& b);
 
     const std::map<std::string, std::string>& getHeaders() const { return headers; }
     HTTP_STATUS getStatus() const { return status; }
@@ -0,0 +1,128 @@
+// Copyright (c) 2018-2022 The Cash2 developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "AsyncLogWriter.h"
+
+#include <chrono>
+
+namespace Logging {
+
+namespace {
+
+// Only a safety net, a pushed message wakes the writer up
+const std::chrono::milliseconds WRITER_IDLE_TIMEOUT(100);
+const size_t WRITER_IDLE_YIELDS = 64;
+
+}
+
+AsyncLogWriter::AsyncLogWriter(std::function<void(const std::string&)> write, size_t capacity) :
+  write(std::move(write)), pushPosition(0), writePosition(0), writtenCount(0), writerSleeping(false), stopping(false) {
+  size_t slotCount = 2;
+  while (slotCount < capacity) {
+    slotCount <<= 1;
+  }
+
+  slots.reset(new Slot[slotCount]);
+  mask = slotCount - 1;
+  for (size_t i = 0; i < slotCount; ++i) {
+    slots[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  thread = std::thread(&AsyncLogWriter::writerThread, this);
+}
+
+AsyncLogWriter::~AsyncLogWriter() {
+  stopping = true;
+  {
+    std::lock_guard<std::mutex> lock(wakeMutex);
+    wakeCondition.notify_one();
+  }
+
+  thread.join();
+}
+
+// A slot is free for position p when its sequence is p and holds the message of position p when its sequence is p + 1,
+// the writer frees it for the next round by setting the sequence to p + slot count
+void AsyncLogWriter::push(std::string&& message) {
+  size_t position = pushPosition.load(std::memory_order_relaxed);
+  for (;;) {
+    Slot& slot = slots[position & mask];
+    size_t sequence = slot.sequence.load(std::memory_order_acquire);
+    if (sequence == position) {
+      if (pushPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (static_cast<ptrdiff_t>(sequence - position) < 0) {
+      // full, the writer is behind by a whole ring
+      std::this_thread::yield();
+      position = pushPosition.load(std::memory_order_relaxed);
+    } else {
+      position = pushPosition.load(std::memory_order_relaxed);
+    }
+  }
+
+  Slot& slot = slots[position & mask];
+  slot.message = std::move(message);
+  slot.sequence.store(position + 1);
+
+  if (writerSleeping) {
+    std::lock_guard<std::mutex> lock(wakeMutex);
+    wakeCondition.notify_one();
+  }
+}
+
+void AsyncLogWriter::flush() {
+  size_t pushed = pushPosition.load();
+  while (writtenCount.load(std::memory_order_acquire) < pushed) {
+    std::this_thread::yield();
+  }
+}
+
+bool AsyncLogWriter::writeNext() {
+  Slot& slot = slots[writePosition & mask];
+  if (slot.sequence.load() != writePosition + 1) {
+    return false;
+  }
+
+  std::string message = std::move(slot.message);
+  slot.message.clear();
+  slot.sequence.store(writePosition + mask + 1, std::memory_order_release);
+  ++writePosition;
+
+  write(message);
+  writtenCount.fetch_add(1, std::memory_order_release);
+  return true;
+}
+
+void AsyncLogWriter::writerThread() {
+  size_t idleRounds = 0;
+  for (;;) {
+    if (writeNext()) {
+      idleRounds = 0;
+      continue;
+    }
+
+    if (stopping) {
+      break;
+    }
+
+    // messages tend to come in bursts, yielding a while spares the loggers waking the writer up for each of them
+    if (idleRounds < WRITER_IDLE_YIELDS) {
+      ++idleRounds;
+      std::this_thread::yield();
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(wakeMutex);
+    writerSleeping = true;
+    if (slots[writePosition & mask].sequence.load() != writePosition + 1 && !stopping) {
+      wakeCondition.wait_for(lock, WRITER_IDLE_TIMEOUT);
+    }
+
+    writerSleeping = false;
+    idleRounds = 0;
+  }
+}
+
+}
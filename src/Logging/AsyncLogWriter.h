@@ -0,0 +1,53 @@
+// Copyright (c) 2018-2022 The Cash2 developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace Logging {
+
+// Hands formatted messages over to a thread of its own, which writes them in the order they were pushed. The messages
+// go through a bounded lock-free ring, when it is full push() waits for the writer instead of dropping the message.
+// Any number of threads may push. The destructor writes what is left and stops the thread.
+class AsyncLogWriter {
+public:
+  AsyncLogWriter(std::function<void(const std::string&)> write, size_t capacity = 4096);
+  ~AsyncLogWriter();
+  AsyncLogWriter(const AsyncLogWriter&) = delete;
+  AsyncLogWriter& operator=(const AsyncLogWriter&) = delete;
+
+  void push(std::string&& message);
+  // Waits until every message pushed before the call is written
+  void flush();
+
+private:
+  struct Slot {
+    std::atomic<size_t> sequence;
+    std::string message;
+  };
+
+  bool writeNext();
+  void writerThread();
+
+  std::function<void(const std::string&)> write;
+  std::unique_ptr<Slot[]> slots;
+  size_t mask;
+  std::atomic<size_t> pushPosition;
+  size_t writePosition;
+  std::atomic<size_t> writtenCount;
+  std::atomic<bool> writerSleeping;
+  std::atomic<bool> stopping;
+  std::mutex wakeMutex;
+  std::condition_variable wakeCondition;
+  std::thread thread;
+};
+
+}
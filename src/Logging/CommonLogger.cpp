@@ -58,10 +58,18 @@ void CommonLogger::operator()(const std::string& category, Level level, boost::p
       body2.insert(insertPos, formatPattern(pattern, category, level, time));
     }
 
-    doLogString(body2);
+    if (asyncWriter) {
+      asyncWriter->push(std::move(body2));
+    } else {
+      doLogString(body2);
+    }
   }
 }
 
+bool CommonLogger::isEnabled(Level level) const {
+  return level <= logLevel;
+}
+
 void CommonLogger::setPattern(const std::string& pattern) {
   this->pattern = pattern;
 }
@@ -78,10 +86,21 @@ void CommonLogger::setMaxLevel(Level level) {
   logLevel = level;
 }
 
+void CommonLogger::enableAsyncWriting(size_t capacity) {
+  asyncWriter.reset(new AsyncLogWriter([this](const std::string& message) { doLogString(message); }, capacity));
+}
+
 CommonLogger::CommonLogger(Level level) : logLevel(level), pattern("%D %T %L [%C] ") {
 }
 
+CommonLogger::~CommonLogger() {
+}
+
 void CommonLogger::doLogString(const std::string& message) {
 }
 
+void CommonLogger::stopAsyncWriting() {
+  asyncWriter.reset();
+}
+
 }
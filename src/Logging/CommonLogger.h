@@ -5,28 +5,42 @@
 
 #pragma once
 
+#include <atomic>
+#include <memory>
 #include <set>
+#include "AsyncLogWriter.h"
 #include "ILogger.h"
 
 namespace Logging {
 
 class CommonLogger : public ILogger {
 public:
+  virtual ~CommonLogger();
 
   virtual void operator()(const std::string& category, Level level, boost::posix_time::ptime time, const std::string& body) override;
+  virtual bool isEnabled(Level level) const override;
   virtual void enableCategory(const std::string& category);
   virtual void disableCategory(const std::string& category);
   virtual void setMaxLevel(Level level);
 
   void setPattern(const std::string& pattern);
+  // From then on doLogString() is called on a thread of its own, the caller only formats the message. Has to be called
+  // before the logger is used.
+  void enableAsyncWriting(size_t capacity = 4096);
 
 protected:
   std::set<std::string> disabledCategories;
-  Level logLevel;
+  std::atomic<Level> logLevel;
   std::string pattern;
 
   CommonLogger(Level level);
   virtual void doLogString(const std::string& message);
+  // Writes the messages still queued and stops the writer thread. Loggers writing asynchronously have to call it in
+  // their destructor, while what doLogString() uses is still there.
+  void stopAsyncWriting();
+
+private:
+  std::unique_ptr<AsyncLogWriter> asyncWriter;
 };
 
 }
@@ -16,6 +16,10 @@ using Common::Console::Color;
 ConsoleLogger::ConsoleLogger(Level level) : CommonLogger(level) {
 }
 
+ConsoleLogger::~ConsoleLogger() {
+  stopAsyncWriting();
+}
+
 void ConsoleLogger::doLogString(const std::string& message) {
   std::lock_guard<std::mutex> lock(mutex);
   bool readingText = true;
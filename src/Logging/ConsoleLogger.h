@@ -13,6 +13,7 @@ namespace Logging {
 class ConsoleLogger : public CommonLogger {
 public:
   ConsoleLogger(Level level = DEBUGGING);
+  ~ConsoleLogger();
 
 protected:
   virtual void doLogString(const std::string& message) override;
@@ -10,6 +10,10 @@ namespace Logging {
 FileLogger::FileLogger(Level level) : StreamLogger(level) {
 }
 
+FileLogger::~FileLogger() {
+  stopAsyncWriting();
+}
+
 void FileLogger::init(const std::string& fileName) {
   fileStream.open(fileName, std::ios::app);
   StreamLogger::attachToStream(fileStream);
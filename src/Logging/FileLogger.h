@@ -13,6 +13,7 @@ namespace Logging {
 class FileLogger : public StreamLogger {
 public:
   FileLogger(Level level = DEBUGGING);
+  ~FileLogger();
   void init(const std::string& filename);
 
 private:
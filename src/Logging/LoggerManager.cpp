@@ -81,6 +81,10 @@ void LoggerManager::configure(const JsonValue& val) {
           throw std::runtime_error("Unknown logger type: " + type);
         }
 
+        if (loggerConfiguration.contains("async") && loggerConfiguration("async").getBool()) {
+          logger->enableAsyncWriting();
+        }
+
         if (loggerConfiguration.contains("pattern")) {
           logger->setPattern(loggerConfiguration("pattern").getString());
         }
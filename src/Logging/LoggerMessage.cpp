@@ -13,9 +13,14 @@ LoggerMessage::LoggerMessage(ILogger& logger, const std::string& category, Level
   , logger(logger)
   , category(category)
   , logLevel(level)
-  , message(color)
-  , timestamp(boost::posix_time::microsec_clock::local_time())
-  , gotText(false) {
+  , gotText(false)
+  , enabled(logger.isEnabled(level)) {
+  if (enabled) {
+    message = color;
+    timestamp = boost::posix_time::microsec_clock::local_time();
+  } else {
+    setstate(std::ios::badbit);
+  }
 }
 
 LoggerMessage::~LoggerMessage() {
@@ -32,8 +37,9 @@ LoggerMessage::LoggerMessage(LoggerMessage&& other)
   , logLevel(other.logLevel)
   , logger(other.logger)
   , message(other.message)
-  , timestamp(boost::posix_time::microsec_clock::local_time())
-  , gotText(false) {
+  , timestamp(other.timestamp)
+  , gotText(false)
+  , enabled(other.enabled) {
   this->set_rdbuf(this);
 }
 #else
@@ -44,8 +50,9 @@ LoggerMessage::LoggerMessage(LoggerMessage&& other)
   , logLevel(other.logLevel)
   , logger(other.logger)
   , message(other.message)
-  , timestamp(boost::posix_time::microsec_clock::local_time())
-  , gotText(false) {
+  , timestamp(other.timestamp)
+  , gotText(false)
+  , enabled(other.enabled) {
   if (this != &other) {
     _M_tie = nullptr;
     _M_streambuf = nullptr;
@@ -86,9 +93,12 @@ LoggerMessage::LoggerMessage(LoggerMessage&& other)
 #endif
 
 int LoggerMessage::sync() {
-  logger(category, logLevel, timestamp, message);
+  if (enabled) {
+    logger(category, logLevel, timestamp, message);
+    message = DEFAULT;
+  }
+
   gotText = false;
-  message = DEFAULT;
   return 0;
 }
 
@@ -98,4 +108,10 @@ int LoggerMessage::overflow(int c) {
   return 0;
 }
 
+std::streamsize LoggerMessage::xsputn(const char* s, std::streamsize n) {
+  gotText = true;
+  message.append(s, static_cast<size_t>(n));
+  return n;
+}
+
 }
@@ -10,6 +10,7 @@
 
 namespace Logging {
 
+// A message of a level the logger doesn't enable leaves the stream failed, so nothing streamed into it is formatted
 class LoggerMessage : public std::ostream, std::streambuf {
 public:
   LoggerMessage(ILogger& logger, const std::string& category, Level level, const std::string& color);
@@ -21,6 +22,7 @@ public:
 private:
   int sync() override;
   int overflow(int c) override;
+  std::streamsize xsputn(const char* s, std::streamsize n) override;
 
   std::string message;
   const std::string category;
@@ -28,6 +30,7 @@ private:
   ILogger& logger;
   boost::posix_time::ptime timestamp;
   bool gotText;
+  bool enabled;
 };
 
 }
@@ -15,6 +15,10 @@ StreamLogger::StreamLogger(Level level) : CommonLogger(level), stream(nullptr) {
 StreamLogger::StreamLogger(std::ostream& stream, Level level) : CommonLogger(level), stream(&stream) {
 }
 
+StreamLogger::~StreamLogger() {
+  stopAsyncWriting();
+}
+
 void StreamLogger::attachToStream(std::ostream& stream) {
   this->stream = &stream;
 }
@@ -23,14 +27,22 @@ void StreamLogger::doLogString(const std::string& message) {
   if (stream != nullptr && stream->good()) {
     std::lock_guard<std::mutex> lock(mutex);
     bool readingText = true;
+    size_t textStart = 0;
     for (size_t charPos = 0; charPos < message.size(); ++charPos) {
       if (message[charPos] == ILogger::COLOR_DELIMETER) {
+        if (readingText) {
+          stream->write(message.data() + textStart, charPos - textStart);
+        }
+
         readingText = !readingText;
-      } else if (readingText) {
-        *stream << message[charPos];
+        textStart = charPos + 1;
       }
     }
 
+    if (readingText) {
+      stream->write(message.data() + textStart, message.size() - textStart);
+    }
+
     *stream << std::flush;
   }
 }
@@ -14,6 +14,7 @@ class StreamLogger : public CommonLogger {
 public:
   StreamLogger(Level level = DEBUGGING);
   StreamLogger(std::ostream& stream, Level level = DEBUGGING);
+  ~StreamLogger();
   void attachToStream(std::ostream& stream);
 
 protected:
@@ -5,10 +5,15 @@
 
 #include "Miner.h"
 
+#include <algorithm>
+#include <chrono>
 #include <functional>
 
+#include <boost/scope_exit.hpp>
+
 #include "crypto/crypto.h"
 #include "CryptoNoteCore/CryptoNoteFormatUtils.h"
+#include "CryptoNoteCore/NonceSearcher.h"
 
 #include "CryptoNoteConfig.h"
 
@@ -63,7 +68,9 @@ void Miner::stop() {
 void Miner::runWorkers(BlockMiningParameters blockMiningParameters, size_t threadCount) {
   assert(threadCount > 0);
 
-  m_logger(Logging::INFO) << "Starting mining for difficulty " << blockMiningParameters.difficulty;
+  Crypto::NonceHashingMode mode = Crypto::Blake2bNonceHasher::bestMode();
+  m_logger(Logging::INFO) << "Starting mining for difficulty " << blockMiningParameters.difficulty << " using " << Crypto::Blake2bNonceHasher::modeName(mode) << " hashing, "
+    << Crypto::Blake2bNonceHasher::lanes(mode) << " nonces per call";
 
   try {
     blockMiningParameters.blockTemplate.nonce = Crypto::rand<uint64_t>();
@@ -89,29 +96,20 @@ void Miner::runWorkers(BlockMiningParameters blockMiningParameters, size_t threa
 void Miner::workerFunc(const Block& blockTemplate, difficulty_type difficulty, uint64_t nonceStep) {
   try {
     Block block = blockTemplate;
-    Crypto::cn_context cryptoContext;
-
-    while (m_state == MiningState::MINING_IN_PROGRESS) {
-      Crypto::Hash hash;
-      if (!get_block_longhash(cryptoContext, block, hash)) {
-        //error occured
-        m_logger(Logging::DEBUGGING) << "calculating long hash error occured";
-        m_state = MiningState::MINING_STOPPED;
-        return;
-      }
+    uint32_t blockHeight = boost::get<BaseInput>(block.baseTransaction.inputs[0]).blockIndex;
+    NonceSearcher searcher(block, difficulty, blockHeight >= parameters::HARD_FORK_HEIGHT_2);
 
-      uint32_t blockHeight = boost::get<BaseInput>(block.baseTransaction.inputs[0]).blockIndex;
+    auto startTime = std::chrono::steady_clock::now();
+    uint64_t hashes = 0;
+    BOOST_SCOPE_EXIT_ALL(&) {
+      uint64_t elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+      m_logger(Logging::DEBUGGING) << "Mining thread hashrate: " << hashes * 1000 / std::max<uint64_t>(elapsed, 1) << " H/s";
+    };
 
-      bool checkHashSuccess = false;
-
-      if (blockHeight < parameters::HARD_FORK_HEIGHT_2)
-      {
-        checkHashSuccess = check_hash1(hash, difficulty);
-      }
-      else
-      {
-        checkHashSuccess = check_hash2(hash, difficulty);
-      }
+    for (uint64_t nonce = block.nonce; m_state == MiningState::MINING_IN_PROGRESS; nonce += nonceStep * searcher.noncesPerCall()) {
+      uint64_t foundNonce;
+      bool checkHashSuccess = searcher.search(nonce, nonceStep, foundNonce);
+      hashes += searcher.noncesPerCall();
 
       if (checkHashSuccess) {
         m_logger(Logging::INFO) << "Found block for difficulty " << difficulty;
@@ -121,11 +119,10 @@ void Miner::workerFunc(const Block& blockTemplate, difficulty_type difficulty, u
           return;
         }
 
+        block.nonce = foundNonce;
         m_block = block;
         return;
       }
-
-      block.nonce += nonceStep;
     }
   } catch (std::exception& e) {
     m_logger(Logging::ERROR) << "Miner got error: " << e.what();
@@ -5,6 +5,7 @@
 
 #pragma once
 
+#include <chrono>
 #include <list>
 #include <ostream>
 #include <unordered_set>
@@ -12,6 +13,7 @@
 #include <boost/uuid/uuid.hpp>
 #include "Common/StringTools.h"
 #include "crypto/hash.h"
+#include "CryptoNoteConfig.h"
 
 namespace CryptoNote {
 
@@ -38,6 +40,9 @@ struct CryptoNoteConnectionContext {
   std::unordered_set<Crypto::Hash> m_requested_objects;
   uint32_t m_remote_blockchain_height = 0;
   uint32_t m_last_response_height = 0;
+  size_t m_objects_span = BLOCKS_SYNCHRONIZING_DEFAULT_COUNT; //blocks per NOTIFY_REQUEST_GET_OBJECTS, adapted to the peer's speed
+  std::chrono::steady_clock::time_point m_objects_requested_at;
+  uint32_t m_ignored_objects_responses = 0; //responses still expected for requests dropped when synchronization was interrupted
 };
 
 inline std::string get_protocol_state_string(CryptoNoteConnectionContext::state s) {
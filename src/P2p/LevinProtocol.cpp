@@ -49,14 +49,7 @@ void LevinProtocol::sendMessage(uint32_t command, const BinaryArray& out, bool n
   head.m_flags = LEVIN_PACKET_REQUEST;
 
   // write header and body in one operation
-  BinaryArray writeBuffer;
-  writeBuffer.reserve(sizeof(head) + out.size());
-
-  Common::VectorOutputStream stream(writeBuffer);
-  stream.writeSome(&head, sizeof(head));
-  stream.writeSome(out.data(), out.size());
-
-  writeStrict(writeBuffer.data(), writeBuffer.size());
+  writeStrict(reinterpret_cast<const uint8_t*>(&head), sizeof(head), out.data(), out.size());
 }
 
 bool LevinProtocol::readCommand(Command& cmd) {
@@ -101,14 +94,7 @@ void LevinProtocol::sendReply(uint32_t command, const BinaryArray& out, int32_t
   head.m_flags = LEVIN_PACKET_RESPONSE;
   head.m_return_code = returnCode;
 
-  BinaryArray writeBuffer;
-  writeBuffer.reserve(sizeof(head) + out.size());
-
-  Common::VectorOutputStream stream(writeBuffer);
-  stream.writeSome(&head, sizeof(head));
-  stream.writeSome(out.data(), out.size());
-
-  writeStrict(writeBuffer.data(), writeBuffer.size());
+  writeStrict(reinterpret_cast<const uint8_t*>(&head), sizeof(head), out.data(), out.size());
 }
 
 void LevinProtocol::writeStrict(const uint8_t* ptr, size_t size) {
@@ -118,6 +104,17 @@ void LevinProtocol::writeStrict(const uint8_t* ptr, size_t size) {
   }
 }
 
+// The header and the body are gathered into one write, only what a partial write leaves is written separately
+void LevinProtocol::writeStrict(const uint8_t* header, size_t headerSize, const uint8_t* body, size_t bodySize) {
+  size_t offset = m_conn.write(header, headerSize, body, bodySize);
+  if (offset < headerSize) {
+    writeStrict(header + offset, headerSize - offset);
+    offset = headerSize;
+  }
+
+  writeStrict(body + (offset - headerSize), bodySize - (offset - headerSize));
+}
+
 bool LevinProtocol::readStrict(uint8_t* ptr, size_t size) {
   size_t offset = 0;
   while (offset < size) {
@@ -22,8 +22,10 @@ WalletFactory::WalletFactory() {
 WalletFactory::~WalletFactory() {
 }
 
-CryptoNote::IWallet* WalletFactory::createWallet(const CryptoNote::Currency& currency, CryptoNote::INode& node, System::Dispatcher& dispatcher) {
-  CryptoNote::IWallet* wallet = new CryptoNote::WalletGreen(dispatcher, currency, node);
+CryptoNote::IWallet* WalletFactory::createWallet(const CryptoNote::Currency& currency, CryptoNote::INode& node, System::Dispatcher& dispatcher,
+  size_t syncPrefetchDepth) {
+  CryptoNote::WalletGreen* wallet = new CryptoNote::WalletGreen(dispatcher, currency, node);
+  wallet->setSyncPrefetchDepth(syncPrefetchDepth);
   return wallet;
 }
 
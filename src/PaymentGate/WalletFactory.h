@@ -20,7 +20,8 @@ namespace PaymentService {
 
 class WalletFactory {
 public:
-  static CryptoNote::IWallet* createWallet(const CryptoNote::Currency& currency, CryptoNote::INode& node, System::Dispatcher& dispatcher);
+  static CryptoNote::IWallet* createWallet(const CryptoNote::Currency& currency, CryptoNote::INode& node, System::Dispatcher& dispatcher,
+    size_t syncPrefetchDepth = 0);
 private:
   WalletFactory();
   ~WalletFactory();
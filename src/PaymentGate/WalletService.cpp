@@ -101,6 +101,11 @@ struct TransactionsInBlockInfoFilter {
     } else {
       havePaymentId = false;
     }
+
+    walletFilter.addresses.assign(addresses.begin(), addresses.end());
+    if (havePaymentId) {
+      walletFilter.paymentId = paymentId;
+    }
   }
 
   bool checkTransaction(const CryptoNote::WalletTransactionWithTransfers& transaction) const {
@@ -133,6 +138,7 @@ struct TransactionsInBlockInfoFilter {
   std::unordered_set<std::string> addresses;
   bool havePaymentId = false;
   Crypto::Hash paymentId;
+  CryptoNote::TransactionsFilter walletFilter;
 };
 
 namespace {
@@ -526,7 +532,17 @@ void WalletService::init() {
 }
 
 void WalletService::saveWallet() {
-  secureSaveWallet(config.walletFile, true, true);
+  // the changes are appended to the file in place, a save that gets cut off is ignored when the file is loaded
+  bool saved = false;
+  if (m_initialized) {
+    std::fstream walletFile(config.walletFile, std::ios_base::binary | std::ios_base::in | std::ios_base::out);
+    saved = walletFile && wallet.saveChanges(walletFile);
+  }
+
+  if (!saved) {
+    secureSaveWallet(config.walletFile, true, true);
+  }
+
   logger(Logging::INFO) << "Wallet is saved";
 }
 
@@ -1297,46 +1313,40 @@ void WalletService::replaceWithNewWallet(const Crypto::SecretKey& viewSecretKey)
   m_initialized = true;
 }
 
-std::vector<CryptoNote::TransactionsInBlockInfo> WalletService::getTransactions(const Crypto::Hash& blockHash, size_t blockCount) const {
-  std::vector<CryptoNote::TransactionsInBlockInfo> result = wallet.getTransactions(blockHash, blockCount);
-  if (result.empty()) {
+// The wallet looks the transactions up in its payment ID and address indexes, only the blocks holding matching
+// transactions come back. When there are none the range is checked to exist, at the cost of a single block.
+std::vector<CryptoNote::TransactionsInBlockInfo> WalletService::getTransactions(const Crypto::Hash& blockHash, size_t blockCount, const TransactionsInBlockInfoFilter& filter) const {
+  std::vector<CryptoNote::TransactionsInBlockInfo> result = wallet.getTransactions(blockHash, blockCount, filter.walletFilter);
+  if (result.empty() && wallet.getTransactions(blockHash, 1).empty()) {
     throw std::system_error(make_error_code(CryptoNote::error::WalletServiceErrorCode::OBJECT_NOT_FOUND));
   }
 
-  return result;
+  return filterTransactions(result, filter);
 }
 
-std::vector<CryptoNote::TransactionsInBlockInfo> WalletService::getTransactions(uint32_t firstBlockIndex, size_t blockCount) const {
-  std::vector<CryptoNote::TransactionsInBlockInfo> result = wallet.getTransactions(firstBlockIndex, blockCount);
-  if (result.empty()) {
+std::vector<CryptoNote::TransactionsInBlockInfo> WalletService::getTransactions(uint32_t firstBlockIndex, size_t blockCount, const TransactionsInBlockInfoFilter& filter) const {
+  std::vector<CryptoNote::TransactionsInBlockInfo> result = wallet.getTransactions(firstBlockIndex, blockCount, filter.walletFilter);
+  if (result.empty() && wallet.getTransactions(firstBlockIndex, 1).empty()) {
     throw std::system_error(make_error_code(CryptoNote::error::WalletServiceErrorCode::OBJECT_NOT_FOUND));
   }
 
-  return result;
+  return filterTransactions(result, filter);
 }
 
 std::vector<TransactionHashesInBlockRpcInfo> WalletService::getRpcTransactionHashes(const Crypto::Hash& blockHash, size_t blockCount, const TransactionsInBlockInfoFilter& filter) const {
-  std::vector<CryptoNote::TransactionsInBlockInfo> allTransactions = getTransactions(blockHash, blockCount);
-  std::vector<CryptoNote::TransactionsInBlockInfo> filteredTransactions = filterTransactions(allTransactions, filter);
-  return convertTransactionsInBlockInfoToTransactionHashesInBlockRpcInfo(filteredTransactions);
+  return convertTransactionsInBlockInfoToTransactionHashesInBlockRpcInfo(getTransactions(blockHash, blockCount, filter));
 }
 
 std::vector<TransactionHashesInBlockRpcInfo> WalletService::getRpcTransactionHashes(uint32_t firstBlockIndex, size_t blockCount, const TransactionsInBlockInfoFilter& filter) const {
-  std::vector<CryptoNote::TransactionsInBlockInfo> allTransactions = getTransactions(firstBlockIndex, blockCount);
-  std::vector<CryptoNote::TransactionsInBlockInfo> filteredTransactions = filterTransactions(allTransactions, filter);
-  return convertTransactionsInBlockInfoToTransactionHashesInBlockRpcInfo(filteredTransactions);
+  return convertTransactionsInBlockInfoToTransactionHashesInBlockRpcInfo(getTransactions(firstBlockIndex, blockCount, filter));
 }
 
 std::vector<TransactionsInBlockRpcInfo> WalletService::getRpcTransactions(const Crypto::Hash& blockHash, size_t blockCount, const TransactionsInBlockInfoFilter& filter) const {
-  std::vector<CryptoNote::TransactionsInBlockInfo> allTransactions = getTransactions(blockHash, blockCount);
-  std::vector<CryptoNote::TransactionsInBlockInfo> filteredTransactions = filterTransactions(allTransactions, filter);
-  return convertTransactionsInBlockInfoToTransactionsInBlockRpcInfo(filteredTransactions);
+  return convertTransactionsInBlockInfoToTransactionsInBlockRpcInfo(getTransactions(blockHash, blockCount, filter));
 }
 
 std::vector<TransactionsInBlockRpcInfo> WalletService::getRpcTransactions(uint32_t firstBlockIndex, size_t blockCount, const TransactionsInBlockInfoFilter& filter) const {
-  std::vector<CryptoNote::TransactionsInBlockInfo> allTransactions = getTransactions(firstBlockIndex, blockCount);
-  std::vector<CryptoNote::TransactionsInBlockInfo> filteredTransactions = filterTransactions(allTransactions, filter);
-  return convertTransactionsInBlockInfoToTransactionsInBlockRpcInfo(filteredTransactions);
+  return convertTransactionsInBlockInfoToTransactionsInBlockRpcInfo(getTransactions(firstBlockIndex, blockCount, filter));
 }
 
 } //namespace PaymentService
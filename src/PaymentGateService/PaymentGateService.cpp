@@ -214,7 +214,7 @@ void PaymentGateService::runWalletService(const CryptoNote::Currency& currency,
     config.gateConfiguration.viewPrivateKey
   };
 
-  std::unique_ptr<CryptoNote::IWallet> wallet (WalletFactory::createWallet(currency, node, *dispatcher));
+  std::unique_ptr<CryptoNote::IWallet> wallet (WalletFactory::createWallet(currency, node, *dispatcher, config.gateConfiguration.syncPrefetchDepth));
 
   service = new PaymentService::WalletService(currency, *dispatcher, node, *wallet, walletConfiguration, logger);
   std::unique_ptr<PaymentService::WalletService> serviceGuard(service);
@@ -30,6 +30,7 @@ Configuration::Configuration() {
   bindAddress = "";
   bindPort = 0;
   rpcConfigurationPassword = "";
+  syncPrefetchDepth = 0;
 }
 
 void Configuration::initOptions(boost::program_options::options_description& desc) {
@@ -48,6 +49,7 @@ void Configuration::initOptions(boost::program_options::options_description& des
       ("log-file,l", po::value<std::string>(), "log file")
       ("server-root", po::value<std::string>(), "server root. The service will use it as working directory. Don't set it if don't want to change it")
       ("log-level", po::value<size_t>(), "log level")
+      ("sync-prefetch", po::value<size_t>(), "number of block requests made ahead while the wallet synchronizes, 0 to disable")
       ("spend-private-key", po::value<std::string>(), "Specify the spend private key that you want your first wallet file to have")
       ("view-private-key", po::value<std::string>(), "Specify the view private key that you want your wallet container")
       ("address", "print wallet addresses and exit");
@@ -86,6 +88,10 @@ void Configuration::init(const boost::program_options::variables_map& options) {
     }
   }
 
+  if (options.count("sync-prefetch") != 0) {
+    syncPrefetchDepth = options["sync-prefetch"].as<size_t>();
+  }
+
   if (options.count("server-root") != 0) {
     serverRoot = options["server-root"].as<std::string>();
   }
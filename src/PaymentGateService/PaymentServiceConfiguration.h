@@ -45,6 +45,7 @@ struct Configuration {
   bool printAddresses;
 
   size_t logLevel;
+  size_t syncPrefetchDepth;
 };
 
 } //namespace PaymentService
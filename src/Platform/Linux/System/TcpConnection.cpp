@@ -7,7 +7,10 @@
 
 #include <arpa/inet.h>
 #include <cassert>
+#include <netinet/tcp.h>
 #include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include <System/ErrorMessage.h>
@@ -154,7 +157,6 @@ std::size_t TcpConnection::write(const uint8_t* data, size_t size) {
     throw InterruptedException();
   }
 
-  std::string message;
   if(size == 0) {
     if(shutdown(connection, SHUT_WR) == -1) {
       throw std::runtime_error("TcpConnection::write, shutdown failed, " + lastErrorMessage());
@@ -163,7 +165,25 @@ std::size_t TcpConnection::write(const uint8_t* data, size_t size) {
     return 0;
   }
 
-  ssize_t transferred = ::send(connection, (void *)data, size, MSG_NOSIGNAL);
+  return write(data, size, nullptr, 0);
+}
+
+std::size_t TcpConnection::write(const uint8_t* header, size_t headerSize, const uint8_t* data, size_t size) {
+  assert(dispatcher != nullptr);
+  assert(contextPair.writeContext == nullptr);
+  assert(headerSize != 0);
+  if (dispatcher->interrupted()) {
+    throw InterruptedException();
+  }
+
+  iovec buffers[2] = { { const_cast<uint8_t*>(header), headerSize }, { const_cast<uint8_t*>(data), size } };
+  msghdr buffersMessage = {};
+  buffersMessage.msg_iov = buffers;
+  buffersMessage.msg_iovlen = size == 0 ? 1 : 2;
+  size = headerSize + size;
+
+  std::string message;
+  ssize_t transferred = ::sendmsg(connection, &buffersMessage, MSG_NOSIGNAL);
   if (transferred == -1) {
     if (errno != EAGAIN  && errno != EWOULDBLOCK) {
       message = "send failed, " + lastErrorMessage();
@@ -226,7 +246,7 @@ std::size_t TcpConnection::write(const uint8_t* data, size_t size) {
           throw std::runtime_error("TcpConnection::write, events & (EPOLLERR | EPOLLHUP) != 0");
         }
 
-        ssize_t transferred = ::send(connection, (void *)data, size, 0);
+        ssize_t transferred = ::sendmsg(connection, &buffersMessage, MSG_NOSIGNAL);
         if (transferred == -1) {
           message = "send failed, "  + lastErrorMessage();
         } else {
@@ -254,6 +274,13 @@ std::pair<Ipv4Address, uint16_t> TcpConnection::getPeerAddressAndPort() const {
   return std::make_pair(Ipv4Address(htonl(addr.sin_addr.s_addr)), htons(addr.sin_port));
 }
 
+void TcpConnection::setNoDelay(bool noDelay) {
+  int value = noDelay ? 1 : 0;
+  if (setsockopt(connection, IPPROTO_TCP, TCP_NODELAY, &value, sizeof value) == -1) {
+    throw std::runtime_error("TcpConnection::setNoDelay, setsockopt failed, " + lastErrorMessage());
+  }
+}
+
 TcpConnection::TcpConnection(Dispatcher& dispatcher, int socket) : dispatcher(&dispatcher), connection(socket) {
   contextPair.readContext = nullptr;
   contextPair.writeContext = nullptr;
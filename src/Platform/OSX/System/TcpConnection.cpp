@@ -7,9 +7,11 @@
 #include <cassert>
 
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <sys/event.h>
 #include <sys/errno.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include "Dispatcher.h"
@@ -138,7 +140,6 @@ size_t TcpConnection::write(const uint8_t* data, size_t size) {
     throw InterruptedException();
   }
 
-  std::string message;
   if (size == 0) {
     if (shutdown(connection, SHUT_WR) == -1) {
       throw std::runtime_error("TcpConnection::write, shutdown failed, " + lastErrorMessage());
@@ -147,7 +148,23 @@ size_t TcpConnection::write(const uint8_t* data, size_t size) {
     return 0;
   }
 
-  ssize_t transferred = ::send(connection, (void *)data, size, 0);
+  return write(data, size, nullptr, 0);
+}
+
+size_t TcpConnection::write(const uint8_t* header, size_t headerSize, const uint8_t* data, size_t size) {
+  assert(dispatcher != nullptr);
+  assert(writeContext == nullptr);
+  assert(headerSize != 0);
+  if (dispatcher->interrupted()) {
+    throw InterruptedException();
+  }
+
+  iovec buffers[2] = { { const_cast<uint8_t*>(header), headerSize }, { const_cast<uint8_t*>(data), size } };
+  int bufferCount = size == 0 ? 1 : 2;
+  size = headerSize + size;
+
+  std::string message;
+  ssize_t transferred = ::writev(connection, buffers, bufferCount);
   if (transferred == -1) {
     if (errno != EAGAIN  && errno != EWOULDBLOCK) {
       message = "send failed, " + lastErrorMessage();
@@ -189,7 +206,7 @@ size_t TcpConnection::write(const uint8_t* data, size_t size) {
           throw InterruptedException();
         }
 
-        ssize_t transferred = ::send(connection, (void *)data, size, 0);
+        ssize_t transferred = ::writev(connection, buffers, bufferCount);
         if (transferred == -1) {
           message = "send failed, " + lastErrorMessage();
         } else {
@@ -217,6 +234,13 @@ std::pair<Ipv4Address, uint16_t> TcpConnection::getPeerAddressAndPort() const {
   return std::make_pair(Ipv4Address(htonl(addr.sin_addr.s_addr)), htons(addr.sin_port));
 }
 
+void TcpConnection::setNoDelay(bool noDelay) {
+  int value = noDelay ? 1 : 0;
+  if (setsockopt(connection, IPPROTO_TCP, TCP_NODELAY, &value, sizeof value) == -1) {
+    throw std::runtime_error("TcpConnection::setNoDelay, setsockopt failed, " + lastErrorMessage());
+  }
+}
+
 TcpConnection::TcpConnection(Dispatcher& dispatcher, int socket) : dispatcher(&dispatcher), connection(socket), readContext(nullptr), writeContext(nullptr) {
   int val = 1;
   if (setsockopt(connection, SOL_SOCKET, SO_NOSIGPIPE, (void*)&val, sizeof val) == -1) {
@@ -24,7 +24,10 @@ public:
   TcpConnection& operator=(TcpConnection&& other);
   std::size_t read(uint8_t* data, std::size_t size);
   std::size_t write(const uint8_t* data, std::size_t size);
+  // Writes the header and the data in one operation, returns how much of them, header first, has been written
+  std::size_t write(const uint8_t* header, std::size_t headerSize, const uint8_t* data, std::size_t size);
   std::pair<Ipv4Address, uint16_t> getPeerAddressAndPort() const;
+  void setNoDelay(bool noDelay);
 
 private:
   friend class TcpConnector;
@@ -149,10 +149,27 @@ size_t TcpConnection::write(const uint8_t* data, size_t size) {
     return 0;
   }
 
-  WSABUF buf{static_cast<ULONG>(size), reinterpret_cast<char*>(const_cast<uint8_t*>(data))};
+  return write(data, size, nullptr, 0);
+}
+
+size_t TcpConnection::write(const uint8_t* header, size_t headerSize, const uint8_t* data, size_t size) {
+  assert(dispatcher != nullptr);
+  assert(writeContext == nullptr);
+  assert(headerSize != 0);
+  if (dispatcher->interrupted()) {
+    throw InterruptedException();
+  }
+
+  WSABUF buffers[2] = {
+    { static_cast<ULONG>(headerSize), reinterpret_cast<char*>(const_cast<uint8_t*>(header)) },
+    { static_cast<ULONG>(size), reinterpret_cast<char*>(const_cast<uint8_t*>(data)) }
+  };
+  DWORD bufferCount = size == 0 ? 1 : 2;
+  size = headerSize + size;
+
   TcpConnectionContext context;
   context.hEvent = NULL;
-  if (WSASend(connection, &buf, 1, NULL, 0, &context, NULL) != 0) {
+  if (WSASend(connection, buffers, bufferCount, NULL, 0, &context, NULL) != 0) {
     int lastError = WSAGetLastError();
     if (lastError != WSA_IO_PENDING) {
       throw std::runtime_error("TcpConnection::write, WSASend failed, " + errorMessage(lastError));
@@ -214,6 +231,13 @@ std::pair<Ipv4Address, uint16_t> TcpConnection::getPeerAddressAndPort() const {
   return std::make_pair(Ipv4Address(htonl(address.sin_addr.S_un.S_addr)), htons(address.sin_port));
 }
 
+void TcpConnection::setNoDelay(bool noDelay) {
+  BOOL value = noDelay ? TRUE : FALSE;
+  if (setsockopt(connection, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<char*>(&value), sizeof(value)) != 0) {
+    throw std::runtime_error("TcpConnection::setNoDelay, setsockopt failed, " + errorMessage(WSAGetLastError()));
+  }
+}
+
 TcpConnection::TcpConnection(Dispatcher& dispatcher, size_t connection) : dispatcher(&dispatcher), connection(connection), readContext(nullptr), writeContext(nullptr) {
 }
 
@@ -23,7 +23,10 @@ public:
   TcpConnection& operator=(TcpConnection&& other);
   size_t read(uint8_t* data, size_t size);
   size_t write(const uint8_t* data, size_t size);
+  // Writes the header and the data in one operation, returns how much of them, header first, has been written
+  size_t write(const uint8_t* header, size_t headerSize, const uint8_t* data, size_t size);
   std::pair<Ipv4Address, uint16_t> getPeerAddressAndPort() const;
+  void setNoDelay(bool noDelay);
 
 private:
   friend class TcpConnector;
@@ -290,6 +290,38 @@ struct COMMAND_RPC_GET_INFO {
   };
 };
 
+//-----------------------------------------------
+struct COMMAND_RPC_GET_RPC_STATS {
+  typedef EMPTY_STRUCT request;
+
+  // times are in microseconds
+  struct response {
+    std::string status;
+    uint64_t requests;
+    uint64_t rejected_requests;
+    uint64_t worker_requests;
+    uint32_t queued_requests;
+    uint32_t max_queued_requests;
+    uint32_t active_workers;
+    uint64_t average_queue_time;
+    uint64_t average_latency;
+    uint64_t max_latency;
+
+    void serialize(ISerializer &s) {
+      KV_MEMBER(status)
+      KV_MEMBER(requests)
+      KV_MEMBER(rejected_requests)
+      KV_MEMBER(worker_requests)
+      KV_MEMBER(queued_requests)
+      KV_MEMBER(max_queued_requests)
+      KV_MEMBER(active_workers)
+      KV_MEMBER(average_queue_time)
+      KV_MEMBER(average_latency)
+      KV_MEMBER(max_latency)
+    }
+  };
+};
+
 //-----------------------------------------------
 struct COMMAND_RPC_STOP_MINING {
   typedef EMPTY_STRUCT request;
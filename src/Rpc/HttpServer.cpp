@@ -5,9 +5,14 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "HttpServer.h"
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <limits>
 #include <boost/scope_exit.hpp>
 
 #include <HTTP/HttpParser.h>
+#include <HTTP/HttpParserErrorCodes.h>
 #include <System/InterruptedException.h>
 #include <System/TcpStream.h>
 #include <System/Ipv4Address.h>
@@ -16,19 +21,90 @@ using namespace Logging;
 
 namespace CryptoNote {
 
+namespace {
+
+uint64_t microsecondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Waits until the condition holds even if the context gets interrupted, the interruption is reported in interrupted
+template<class Condition>
+void waitUninterrupted(System::Event& event, Condition condition, bool& interrupted) {
+  while (!condition()) {
+    try {
+      event.clear();
+      event.wait();
+    } catch (System::InterruptedException&) {
+      interrupted = true;
+    }
+  }
+}
+
+}
+
+struct HttpServer::PendingRequest {
+  HttpRequest request;
+  HttpResponse response;
+  std::chrono::steady_clock::time_point received;
+  bool ready;
+};
+
 HttpServer::HttpServer(System::Dispatcher& dispatcher, Logging::ILogger& log)
-  : m_dispatcher(dispatcher), workingContextGroup(dispatcher), logger(log, "HttpServer") {
+  : m_dispatcher(dispatcher), workingContextGroup(dispatcher), logger(log, "HttpServer"),
+  m_workerCount(0),
+  m_maxRequestBodySize(std::numeric_limits<size_t>::max()),
+  m_maxConnectionRequests(16),
+  m_maxQueuedRequests(1024),
+  m_statistics() {
 
 }
 
+HttpServer::~HttpServer() {
+  stopWorkers();
+}
+
+void HttpServer::setWorkerThreads(size_t count) {
+  m_workerCount = count;
+}
+
+void HttpServer::setMaxRequestBodySize(size_t size) {
+  m_maxRequestBodySize = size;
+}
+
+void HttpServer::setMaxConnectionRequests(size_t count) {
+  m_maxConnectionRequests = std::max<size_t>(count, 1);
+}
+
+void HttpServer::setMaxQueuedRequests(size_t count) {
+  m_maxQueuedRequests = std::max<size_t>(count, 1);
+}
+
 void HttpServer::start(const std::string& address, uint16_t port) {
   m_listener = System::TcpListener(m_dispatcher, System::Ipv4Address(address), port);
+
+  if (m_workerCount > 0) {
+    m_jobs.reset(new BlockingQueue<std::function<void()>>(m_maxQueuedRequests));
+    for (size_t i = 0; i < m_workerCount; ++i) {
+      m_workers.emplace_back(&HttpServer::workerThread, this);
+    }
+  }
+
   workingContextGroup.spawn(std::bind(&HttpServer::acceptLoop, this));
 }
 
 void HttpServer::stop() {
   workingContextGroup.interrupt();
   workingContextGroup.wait();
+  stopWorkers();
+}
+
+HttpServerStatistics HttpServer::getStatistics() const {
+  std::lock_guard<std::mutex> lock(m_statisticsMutex);
+  return m_statistics;
+}
+
+bool HttpServer::isConcurrentRequest(const HttpRequest& request) {
+  return false;
 }
 
 void HttpServer::acceptLoop() {
@@ -48,7 +124,7 @@ void HttpServer::acceptLoop() {
     }
 
     m_connections.insert(&connection);
-    BOOST_SCOPE_EXIT_ALL(this, &connection) { 
+    BOOST_SCOPE_EXIT_ALL(this, &connection) {
       m_connections.erase(&connection); };
 
     workingContextGroup.spawn(std::bind(&HttpServer::acceptLoop, this));
@@ -63,33 +139,236 @@ void HttpServer::acceptLoop() {
 
     logger(DEBUGGING) << "Incoming connection from " << addr.first.toDottedDecimal() << ":" << addr.second;
 
-    System::TcpStreambuf streambuf(connection);
-    std::iostream stream(&streambuf);
+    // pipelined responses are written as they get ready, Nagle's algorithm would hold them back
+    try {
+      connection.setNoDelay(true);
+    } catch (std::runtime_error&) {
+      logger(WARNING) << "Could not disable Nagle's algorithm on connection";
+    }
+
+    processConnection(connection);
+
+    logger(DEBUGGING) << "Closing connection from " << addr.first.toDottedDecimal() << ":" << addr.second << " total=" << m_connections.size();
+
+  } catch (System::InterruptedException&) {
+  } catch (std::exception& e) {
+    logger(WARNING) << "Connection error: " << e.what();
+  }
+}
+
+// This context reads the requests and a second one writes the responses. At most m_maxConnectionRequests requests
+// of the connection are read but not yet answered.
+void HttpServer::processConnection(System::TcpConnection& connection) {
+  System::TcpStreambuf streambuf(connection);
+  std::istream inputStream(&streambuf);
+  std::ostream outputStream(&streambuf);
+
+  std::deque<std::unique_ptr<PendingRequest>> requests;
+  size_t runningRequests = 0;
+  bool readingDone = false;
+  bool writingDone = false;
+  System::Event requestReady(m_dispatcher);
+  System::Event requestWritten(m_dispatcher);
+
+  workingContextGroup.spawn([&] {
+    try {
+      for (;;) {
+        while (requests.empty() || !requests.front()->ready) {
+          if (requests.empty() && readingDone) {
+            break;
+          }
+
+          requestReady.clear();
+          requestReady.wait();
+        }
+
+        if (requests.empty()) {
+          break;
+        }
+
+        // the responses ready by now go out together, small separate writes get delayed by the peer's acknowledgements
+        while (!requests.empty() && requests.front()->ready) {
+          outputStream << requests.front()->response;
+          requests.pop_front();
+        }
+
+        outputStream.flush();
+        if (!outputStream) {
+          throw std::runtime_error("Failed to write response");
+        }
+
+        requestWritten.set();
+      }
+    } catch (System::InterruptedException&) {
+    } catch (std::exception& e) {
+      logger(DEBUGGING) << "Connection error: " << e.what();
+    }
+
+    writingDone = true;
+    requestWritten.set();
+  });
+
+  bool interrupted = false;
+  try {
     HttpParser parser;
 
     for (;;) {
-      HttpRequest req;
-      HttpResponse resp;
-      resp.addHeader("Access-Control-Allow-Origin", "*");
-      resp.addHeader("content-type", "application/json");
+      while (requests.size() >= m_maxConnectionRequests && !writingDone) {
+        requestWritten.clear();
+        requestWritten.wait();
+      }
 
-      parser.receiveRequest(stream, req);
-      processRequest(req, resp);
+      if (writingDone || inputStream.peek() == std::istream::traits_type::eof()) {
+        break;
+      }
 
-      stream << resp;
-      stream.flush();
+      std::unique_ptr<PendingRequest> request(new PendingRequest());
+      request->response.addHeader("Access-Control-Allow-Origin", "*");
+      request->response.addHeader("content-type", "application/json");
+      request->ready = false;
 
-      if (stream.peek() == std::iostream::traits_type::eof()) {
-        break;
+      bool bodyTooLarge = false;
+      try {
+        parser.receiveRequest(inputStream, request->request, m_maxRequestBodySize);
+      } catch (std::system_error& e) {
+        if (e.code() != make_error_code(error::HttpParserErrorCodes::BODY_TOO_LARGE)) {
+          throw;
+        }
+
+        bodyTooLarge = true;
       }
-    }
 
-    logger(DEBUGGING) << "Closing connection from " << addr.first.toDottedDecimal() << ":" << addr.second << " total=" << m_connections.size();
+      request->received = std::chrono::steady_clock::now();
+
+      if (bodyTooLarge) {
+        // the body is left unread, so the connection can't be used any further
+        request->response.setStatus(HttpResponse::STATUS_413);
+        request->response.addHeader("Connection", "close");
+        request->ready = true;
+
+        std::lock_guard<std::mutex> lock(m_statisticsMutex);
+        ++m_statistics.rejectedRequests;
+      } else {
+        startRequest(*request, runningRequests, requestReady);
+      }
+
+      auto connectionHeader = request->request.getHeaders().find("connection");
+      bool keepAlive = !bodyTooLarge && (connectionHeader == request->request.getHeaders().end() || connectionHeader->second != "close");
 
+      requests.push_back(std::move(request));
+      requestReady.set();
+
+      if (!keepAlive) {
+        break;
+      }
+    }
   } catch (System::InterruptedException&) {
+    interrupted = true;
   } catch (std::exception& e) {
-    logger(WARNING) << "Connection error: " << e.what();
+    logger(DEBUGGING) << "Connection error: " << e.what();
   }
+
+  readingDone = true;
+  requestReady.set();
+
+  // the worker threads and the writer still reference the requests
+  waitUninterrupted(requestWritten, [&] { return writingDone; }, interrupted);
+  waitUninterrupted(requestReady, [&] { return runningRequests == 0; }, interrupted);
+
+  if (interrupted) {
+    throw System::InterruptedException();
+  }
+}
+
+void HttpServer::startRequest(PendingRequest& request, size_t& runningRequests, System::Event& requestReady) {
+  if (!m_jobs || !isConcurrentRequest(request.request)) {
+    try {
+      processRequest(request.request, request.response);
+    } catch (std::exception& e) {
+      logger(WARNING) << "Failed to process request " << request.request.getUrl() << ": " << e.what();
+      request.response.setStatus(HttpResponse::STATUS_500);
+    }
+
+    finishRequest(request);
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_statisticsMutex);
+    if (m_statistics.queuedRequests >= m_maxQueuedRequests) {
+      ++m_statistics.rejectedRequests;
+      request.response.setStatus(HttpResponse::STATUS_503);
+      request.ready = true;
+      return;
+    }
+
+    ++m_statistics.queuedRequests;
+    m_statistics.maxQueuedRequests = std::max(m_statistics.maxQueuedRequests, m_statistics.queuedRequests);
+  }
+
+  // the queue never blocks, it has room for m_maxQueuedRequests jobs
+  ++runningRequests;
+  PendingRequest* pendingRequest = &request;
+  size_t* running = &runningRequests;
+  System::Event* ready = &requestReady;
+  m_jobs->push([this, pendingRequest, running, ready] {
+    auto started = std::chrono::steady_clock::now();
+    {
+      std::lock_guard<std::mutex> lock(m_statisticsMutex);
+      --m_statistics.queuedRequests;
+      ++m_statistics.activeWorkers;
+      ++m_statistics.workerRequests;
+      m_statistics.queueTime += std::chrono::duration_cast<std::chrono::microseconds>(started - pendingRequest->received).count();
+    }
+
+    try {
+      processRequest(pendingRequest->request, pendingRequest->response);
+    } catch (std::exception& e) {
+      logger(WARNING) << "Failed to process request " << pendingRequest->request.getUrl() << ": " << e.what();
+      pendingRequest->response.setStatus(HttpResponse::STATUS_500);
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(m_statisticsMutex);
+      --m_statistics.activeWorkers;
+    }
+
+    m_dispatcher.remoteSpawn([this, pendingRequest, running, ready] {
+      finishRequest(*pendingRequest);
+      --*running;
+      ready->set();
+    });
+  });
+}
+
+void HttpServer::finishRequest(PendingRequest& request) {
+  uint64_t latency = microsecondsSince(request.received);
+  request.ready = true;
+
+  std::lock_guard<std::mutex> lock(m_statisticsMutex);
+  ++m_statistics.requests;
+  m_statistics.processingTime += latency;
+  m_statistics.maxLatency = std::max(m_statistics.maxLatency, latency);
+}
+
+void HttpServer::workerThread() {
+  std::function<void()> job;
+  while (m_jobs->pop(job)) {
+    job();
+  }
+}
+
+void HttpServer::stopWorkers() {
+  if (m_jobs) {
+    m_jobs->close();
+  }
+
+  for (auto& worker : m_workers) {
+    worker.join();
+  }
+
+  m_workers.clear();
+  m_jobs.reset();
 }
 
 }
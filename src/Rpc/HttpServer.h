@@ -3,9 +3,16 @@
 // Distributed under the MIT/X11 software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
-#pragma once 
+#pragma once
 
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <unordered_set>
+#include <vector>
+
+#include <Common/BlockingQueue.h>
 
 #include <HTTP/HttpRequest.h>
 #include <HTTP/HttpResponse.h>
@@ -20,30 +27,74 @@
 
 namespace CryptoNote {
 
+// Times are in microseconds
+struct HttpServerStatistics {
+  uint64_t requests;
+  uint64_t rejectedRequests;
+  uint64_t workerRequests;
+  uint32_t queuedRequests;
+  uint32_t maxQueuedRequests;
+  uint32_t activeWorkers;
+  uint64_t queueTime;
+  uint64_t processingTime;
+  uint64_t maxLatency;
+};
+
+// Connections are served on the dispatcher. Requests of a connection are read while earlier ones are still being
+// processed (HTTP/1.1 pipelining) and their responses are written in order. Requests for which isConcurrentRequest()
+// is true are processed on a pool of worker threads if there is one, all other requests on the dispatcher.
 class HttpServer {
 
 public:
 
   HttpServer(System::Dispatcher& dispatcher, Logging::ILogger& log);
+  virtual ~HttpServer();
+
+  // These take effect on start()
+  void setWorkerThreads(size_t count);
+  void setMaxRequestBodySize(size_t size);
+  void setMaxConnectionRequests(size_t count);
+  void setMaxQueuedRequests(size_t count);
 
   void start(const std::string& address, uint16_t port);
   void stop();
 
+  HttpServerStatistics getStatistics() const;
+
   virtual void processRequest(const HttpRequest& request, HttpResponse& response) = 0;
 
 protected:
 
+  // Must not depend on the state of the dispatcher thread if it returns true
+  virtual bool isConcurrentRequest(const HttpRequest& request);
+
   System::Dispatcher& m_dispatcher;
 
 private:
 
+  struct PendingRequest;
+
   void acceptLoop();
-  void connectionHandler(System::TcpConnection&& conn);
+  void processConnection(System::TcpConnection& connection);
+  void startRequest(PendingRequest& request, size_t& runningRequests, System::Event& requestReady);
+  void finishRequest(PendingRequest& request);
+  void workerThread();
+  void stopWorkers();
 
   System::ContextGroup workingContextGroup;
   Logging::LoggerRef logger;
   System::TcpListener m_listener;
   std::unordered_set<System::TcpConnection*> m_connections;
+
+  size_t m_workerCount;
+  size_t m_maxRequestBodySize;
+  size_t m_maxConnectionRequests;
+  size_t m_maxQueuedRequests;
+  std::unique_ptr<BlockingQueue<std::function<void()>>> m_jobs;
+  std::vector<std::thread> m_workers;
+
+  mutable std::mutex m_statisticsMutex;
+  HttpServerStatistics m_statistics;
 };
 
 }
@@ -0,0 +1,106 @@
+// Copyright (c) 2018-2022 The Cash2 developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "RawBlocksResponse.h"
+
+#include "Common/StringOutputStream.h"
+#include "Serialization/KVBinaryOutputStreamSerializer.h"
+
+#include "CoreRpcServerCommandsDefinitions.h"
+
+namespace CryptoNote {
+
+namespace {
+
+// Room for the names and sizes around the blobs, the body is written without reallocations
+const size_t FIELDS_SIZE = 256;
+const size_t ITEM_FIELDS_SIZE = 64;
+const size_t BLOB_SIZE_SIZE = 8;
+
+size_t estimateSize(const std::vector<Blockchain::RawBlock>& blocks) {
+  size_t size = FIELDS_SIZE;
+  for (const Blockchain::RawBlock& block : blocks) {
+    size += ITEM_FIELDS_SIZE + block.block.getSize();
+    for (const Common::StringView& transaction : block.transactions) {
+      size += BLOB_SIZE_SIZE + transaction.getSize();
+    }
+  }
+
+  return size;
+}
+
+// Fields of block_complete_entry, the ones of BlockFullInfo follow the block id
+void writeBlockFields(KVBinaryStreamWriter& writer, const Blockchain::RawBlock& block) {
+  writer.writeString("block", block.block);
+  if (!block.transactions.empty()) {
+    writer.writeStringArray("txs", block.transactions.size());
+    for (const Common::StringView& transaction : block.transactions) {
+      writer.writeStringItem(transaction);
+    }
+  }
+}
+
+size_t blockFieldCount(const Blockchain::RawBlock& block) {
+  return block.transactions.empty() ? 1 : 2;
+}
+
+Common::StringView hashView(const Crypto::Hash& hash) {
+  return Common::StringView(reinterpret_cast<const char*>(&hash), sizeof(hash));
+}
+
+}
+
+std::string storeRawGetBlocksResponse(const std::vector<Blockchain::RawBlock>& blocks, uint64_t startHeight, uint64_t currentHeight) {
+  std::string body;
+  body.reserve(estimateSize(blocks));
+  Common::StringOutputStream stream(body);
+
+  KVBinaryStreamWriter writer(stream, blocks.empty() ? 3 : 4);
+  if (!blocks.empty()) {
+    writer.writeObjectArray("blocks", blocks.size());
+    for (const Blockchain::RawBlock& block : blocks) {
+      writer.writeObjectItem(blockFieldCount(block));
+      writeBlockFields(writer, block);
+    }
+  }
+
+  writer.writeUint64("start_height", startHeight);
+  writer.writeUint64("current_height", currentHeight);
+  writer.writeString("status", CORE_RPC_STATUS_OK);
+  return body;
+}
+
+std::string storeRawQueryBlocksResponse(const std::vector<Crypto::Hash>& shortBlockIds, const std::vector<Blockchain::RawBlock>& blocks,
+  uint64_t startHeight, uint64_t currentHeight, uint64_t fullOffset) {
+
+  std::string body;
+  body.reserve(estimateSize(blocks) + shortBlockIds.size() * ITEM_FIELDS_SIZE);
+  Common::StringOutputStream stream(body);
+
+  size_t itemCount = shortBlockIds.size() + blocks.size();
+  KVBinaryStreamWriter writer(stream, itemCount == 0 ? 4 : 5);
+  writer.writeString("status", CORE_RPC_STATUS_OK);
+  writer.writeUint64("start_height", startHeight);
+  writer.writeUint64("current_height", currentHeight);
+  writer.writeUint64("full_offset", fullOffset);
+
+  if (itemCount != 0) {
+    writer.writeObjectArray("items", itemCount);
+    for (const Crypto::Hash& blockId : shortBlockIds) {
+      writer.writeObjectItem(2);
+      writer.writeString("block_id", hashView(blockId));
+      writer.writeString("block", Common::StringView::EMPTY);
+    }
+
+    for (const Blockchain::RawBlock& block : blocks) {
+      writer.writeObjectItem(1 + blockFieldCount(block));
+      writer.writeString("block_id", hashView(block.id));
+      writeBlockFields(writer, block);
+    }
+  }
+
+  return body;
+}
+
+}
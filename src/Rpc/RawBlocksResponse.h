@@ -0,0 +1,20 @@
+// Copyright (c) 2018-2022 The Cash2 developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "CryptoNoteCore/Blockchain.h"
+
+namespace CryptoNote {
+
+// KV binary bodies of the COMMAND_RPC_GET_BLOCKS_FAST and COMMAND_RPC_QUERY_BLOCKS responses, written from the blobs in
+// the block storage. They are the same as storeToBinaryKeyValue() of the responses filled with the re-serialized blocks.
+std::string storeRawGetBlocksResponse(const std::vector<Blockchain::RawBlock>& blocks, uint64_t startHeight, uint64_t currentHeight);
+std::string storeRawQueryBlocksResponse(const std::vector<Crypto::Hash>& shortBlockIds, const std::vector<Blockchain::RawBlock>& blocks,
+  uint64_t startHeight, uint64_t currentHeight, uint64_t fullOffset);
+
+}
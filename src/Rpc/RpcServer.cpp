@@ -25,6 +25,7 @@
 
 #include "CoreRpcServerErrorCodes.h"
 #include "JsonRpc.h"
+#include "RawBlocksResponse.h"
 
 #undef ERROR
 
@@ -53,6 +54,21 @@ RpcServer::HandlerFunction binMethod(bool (RpcServer::*handler)(typename Command
   };
 }
 
+// For the binary handlers which write the response body themselves
+template <typename Command>
+RpcServer::HandlerFunction rawBinMethod(bool (RpcServer::*handler)(typename Command::request const&, HttpResponse&)) {
+  return [handler](RpcServer* obj, const HttpRequest& request, HttpResponse& response) {
+
+    boost::value_initialized<typename Command::request> req;
+
+    if (!loadFromBinaryKeyValue(static_cast<typename Command::request&>(req), request.getBody())) {
+      return false;
+    }
+
+    return (obj->*handler)(req, response);
+  };
+}
+
 template <typename Command>
 RpcServer::HandlerFunction jsonMethod(bool (RpcServer::*handler)(typename Command::request const&, typename Command::response&)) {
   return [handler](RpcServer* obj, const HttpRequest& request, HttpResponse& response) {
@@ -83,27 +99,45 @@ RpcServer::HandlerFunction jsonMethod(bool (RpcServer::*handler)(typename Comman
 std::unordered_map<std::string, RpcServer::RpcHandler<RpcServer::HandlerFunction>> RpcServer::s_handlers = {
   
   // binary handlers
-  { "/getblocks.bin", { binMethod<COMMAND_RPC_GET_BLOCKS_FAST>(&RpcServer::on_get_blocks), false } },
-  { "/queryblocks.bin", { binMethod<COMMAND_RPC_QUERY_BLOCKS>(&RpcServer::on_query_blocks), false } },
-  { "/queryblockslite.bin", { binMethod<COMMAND_RPC_QUERY_BLOCKS_LITE>(&RpcServer::on_query_blocks_lite), false } },
-  { "/get_o_indexes.bin", { binMethod<COMMAND_RPC_GET_TX_GLOBAL_OUTPUTS_INDEXES>(&RpcServer::on_get_indexes), false } },
-  { "/getrandom_outs.bin", { binMethod<COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS>(&RpcServer::on_get_random_outs), false } },
-  { "/get_pool_changes.bin", { binMethod<COMMAND_RPC_GET_POOL_CHANGES>(&RpcServer::onGetPoolChanges), false } },
-  { "/get_pool_changes_lite.bin", { binMethod<COMMAND_RPC_GET_POOL_CHANGES_LITE>(&RpcServer::onGetPoolChangesLite), false } },
+  { "/getblocks.bin", { rawBinMethod<COMMAND_RPC_GET_BLOCKS_FAST>(&RpcServer::on_get_blocks), false, true } },
+  { "/queryblocks.bin", { rawBinMethod<COMMAND_RPC_QUERY_BLOCKS>(&RpcServer::on_query_blocks), false, true } },
+  { "/queryblockslite.bin", { binMethod<COMMAND_RPC_QUERY_BLOCKS_LITE>(&RpcServer::on_query_blocks_lite), false, true } },
+  { "/get_o_indexes.bin", { binMethod<COMMAND_RPC_GET_TX_GLOBAL_OUTPUTS_INDEXES>(&RpcServer::on_get_indexes), false, true } },
+  { "/getrandom_outs.bin", { binMethod<COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS>(&RpcServer::on_get_random_outs), false, true } },
+  { "/get_pool_changes.bin", { binMethod<COMMAND_RPC_GET_POOL_CHANGES>(&RpcServer::onGetPoolChanges), false, true } },
+  { "/get_pool_changes_lite.bin", { binMethod<COMMAND_RPC_GET_POOL_CHANGES_LITE>(&RpcServer::onGetPoolChangesLite), false, true } },
 
   // json handlers
-  { "/getinfo", { jsonMethod<COMMAND_RPC_GET_INFO>(&RpcServer::on_get_info), true } },
-  { "/getheight", { jsonMethod<COMMAND_RPC_GET_HEIGHT>(&RpcServer::on_get_height), true } },
-  { "/gettransactions", { jsonMethod<COMMAND_RPC_GET_TRANSACTIONS>(&RpcServer::on_get_transactions), false } },
-  { "/sendrawtransaction", { jsonMethod<COMMAND_RPC_SEND_RAW_TX>(&RpcServer::on_send_raw_tx), false } },
+  { "/getinfo", { jsonMethod<COMMAND_RPC_GET_INFO>(&RpcServer::on_get_info), true, false } },
+  { "/getheight", { jsonMethod<COMMAND_RPC_GET_HEIGHT>(&RpcServer::on_get_height), true, true } },
+  { "/gettransactions", { jsonMethod<COMMAND_RPC_GET_TRANSACTIONS>(&RpcServer::on_get_transactions), false, true } },
+  { "/sendrawtransaction", { jsonMethod<COMMAND_RPC_SEND_RAW_TX>(&RpcServer::on_send_raw_tx), false, false } },
+  { "/getrpcstats", { jsonMethod<COMMAND_RPC_GET_RPC_STATS>(&RpcServer::on_get_rpc_stats), true, true } },
   
   // disabled in restricted rpc mode
-  { "/start_mining", { jsonMethod<COMMAND_RPC_START_MINING>(&RpcServer::on_start_mining), false } },
-  { "/stop_mining", { jsonMethod<COMMAND_RPC_STOP_MINING>(&RpcServer::on_stop_mining), false } },
-  { "/stop_daemon", { jsonMethod<COMMAND_RPC_STOP_DAEMON>(&RpcServer::on_stop_daemon), true } },
+  { "/start_mining", { jsonMethod<COMMAND_RPC_START_MINING>(&RpcServer::on_start_mining), false, false } },
+  { "/stop_mining", { jsonMethod<COMMAND_RPC_STOP_MINING>(&RpcServer::on_stop_mining), false, false } },
+  { "/stop_daemon", { jsonMethod<COMMAND_RPC_STOP_DAEMON>(&RpcServer::on_stop_daemon), true, false } },
 
   // json rpc
-  { "/json_rpc", { std::bind(&RpcServer::processJsonRpcRequest, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3), true } }
+  { "/json_rpc", { std::bind(&RpcServer::processJsonRpcRequest, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3), true, true } }
+};
+
+std::unordered_map<std::string, RpcServer::RpcHandler<JsonRpc::JsonMemberMethod>> RpcServer::s_jsonRpcHandlers = {
+  { "getblockcount", { JsonRpc::makeMemberMethod(&RpcServer::on_getblockcount), true, true } },
+  { "on_getblockhash", { JsonRpc::makeMemberMethod(&RpcServer::on_getblockhash), false, true } },
+  { "getblocktemplate", { JsonRpc::makeMemberMethod(&RpcServer::on_getblocktemplate), false, true } },
+  { "getcurrencyid", { JsonRpc::makeMemberMethod(&RpcServer::on_get_currency_id), true, true } },
+  { "submitblock", { JsonRpc::makeMemberMethod(&RpcServer::on_submitblock), false, false } },
+  { "getlastblockheader", { JsonRpc::makeMemberMethod(&RpcServer::on_get_last_block_header), false, true } },
+  { "getblockheaderbyhash", { JsonRpc::makeMemberMethod(&RpcServer::on_get_block_header_by_hash), false, true } },
+  { "getblockheaderbyheight", { JsonRpc::makeMemberMethod(&RpcServer::on_get_block_header_by_height), false, true } },
+  { "f_blocks_list_json", { JsonRpc::makeMemberMethod(&RpcServer::f_on_blocks_list_json), false, true } },
+  { "f_block_json", { JsonRpc::makeMemberMethod(&RpcServer::f_on_block_json), false, true } },
+  { "f_transaction_json", { JsonRpc::makeMemberMethod(&RpcServer::f_on_transaction_json), false, true } },
+  { "f_mempool_json", { JsonRpc::makeMemberMethod(&RpcServer::f_on_mempool_json), false, true } },
+  { "check_tx_key", { JsonRpc::makeMemberMethod(&RpcServer::k_on_check_tx_key), false, true } },
+  { "validate_address", { JsonRpc::makeMemberMethod(&RpcServer::on_validate_address), false, true } },
 };
 
 RpcServer::RpcServer(System::Dispatcher& dispatcher, Logging::ILogger& log, core& c, NodeServer& p2p, const ICryptoNoteProtocolQuery& protocolQuery) :
@@ -128,6 +162,28 @@ void RpcServer::processRequest(const HttpRequest& request, HttpResponse& respons
   it->second.handler(this, request, response);
 }
 
+bool RpcServer::isConcurrentRequest(const HttpRequest& request) {
+  auto it = s_handlers.find(request.getUrl());
+  if (it == s_handlers.end() || !it->second.allowConcurrent) {
+    return false;
+  }
+
+  if (request.getUrl() != "/json_rpc") {
+    return true;
+  }
+
+  // requests that fail to parse are answered on the dispatcher
+  JsonRpc::JsonRpcRequest jsonRequest;
+  try {
+    jsonRequest.parseRequest(request.getBody());
+  } catch (std::exception&) {
+    return false;
+  }
+
+  auto jsonIt = s_jsonRpcHandlers.find(jsonRequest.getMethod());
+  return jsonIt != s_jsonRpcHandlers.end() && jsonIt->second.allowConcurrent;
+}
+
 bool RpcServer::processJsonRpcRequest(const HttpRequest& request, HttpResponse& response) {
 
   using namespace JsonRpc;
@@ -146,25 +202,8 @@ bool RpcServer::processJsonRpcRequest(const HttpRequest& request, HttpResponse&
     jsonRequest.parseRequest(request.getBody());
     jsonResponse.setId(jsonRequest.getId()); // copy id
 
-    static std::unordered_map<std::string, RpcServer::RpcHandler<JsonMemberMethod>> jsonRpcHandlers = {
-      { "getblockcount", { makeMemberMethod(&RpcServer::on_getblockcount), true } },
-      { "on_getblockhash", { makeMemberMethod(&RpcServer::on_getblockhash), false } },
-      { "getblocktemplate", { makeMemberMethod(&RpcServer::on_getblocktemplate), false } },
-      { "getcurrencyid", { makeMemberMethod(&RpcServer::on_get_currency_id), true } },
-      { "submitblock", { makeMemberMethod(&RpcServer::on_submitblock), false } },
-      { "getlastblockheader", { makeMemberMethod(&RpcServer::on_get_last_block_header), false } },
-      { "getblockheaderbyhash", { makeMemberMethod(&RpcServer::on_get_block_header_by_hash), false } },
-      { "getblockheaderbyheight", { makeMemberMethod(&RpcServer::on_get_block_header_by_height), false } },
-      { "f_blocks_list_json", { makeMemberMethod(&RpcServer::f_on_blocks_list_json), false } },
-      { "f_block_json", { makeMemberMethod(&RpcServer::f_on_block_json), false } },
-      { "f_transaction_json", { makeMemberMethod(&RpcServer::f_on_transaction_json), false } },
-      { "f_mempool_json", { makeMemberMethod(&RpcServer::f_on_mempool_json), false } },
-      { "check_tx_key", { makeMemberMethod(&RpcServer::k_on_check_tx_key), false } },
-      { "validate_address", { makeMemberMethod(&RpcServer::on_validate_address), false } },
-    };
-
-    auto it = jsonRpcHandlers.find(jsonRequest.getMethod());
-    if (it == jsonRpcHandlers.end()) {
+    auto it = s_jsonRpcHandlers.find(jsonRequest.getMethod());
+    if (it == s_jsonRpcHandlers.end()) {
       throw JsonRpcError(JsonRpc::errMethodNotFound);
     }
 
@@ -181,7 +220,7 @@ bool RpcServer::processJsonRpcRequest(const HttpRequest& request, HttpResponse&
   }
 
   response.setBody(jsonResponse.getBody());
-  logger(TRACE) << "JSON-RPC response: " << jsonResponse.getBody();
+  logger(TRACE) << "JSON-RPC response: " << response.getBody();
   return true;
 }
 
@@ -207,58 +246,48 @@ bool RpcServer::isCoreReady() {
 // Binary handlers
 //
 
-bool RpcServer::on_get_blocks(const COMMAND_RPC_GET_BLOCKS_FAST::request& req, COMMAND_RPC_GET_BLOCKS_FAST::response& res) {
+// The stored blobs of the blocks and transactions are written into the body as they are
+bool RpcServer::on_get_blocks(const COMMAND_RPC_GET_BLOCKS_FAST::request& req, HttpResponse& response) {
   // TODO code duplication see InProcessNode::doGetNewBlocks()
-  if (req.block_ids.empty()) {
-    res.status = "Failed";
-    return false;
-  }
+  boost::value_initialized<COMMAND_RPC_GET_BLOCKS_FAST::response> res;
+  static_cast<COMMAND_RPC_GET_BLOCKS_FAST::response&>(res).status = "Failed";
 
-  if (req.block_ids.back() != m_core.getBlockIdByHeight(0)) {
-    res.status = "Failed";
+  if (req.block_ids.empty() || req.block_ids.back() != m_core.getBlockIdByHeight(0)) {
+    response.setBody(storeToBinaryKeyValue(res.data()));
     return false;
   }
 
   uint32_t totalBlockCount;
   uint32_t startBlockIndex;
-  std::vector<Crypto::Hash> supplement = m_core.findBlockchainSupplement(req.block_ids, COMMAND_RPC_GET_BLOCKS_FAST_MAX_COUNT, totalBlockCount, startBlockIndex);
-
-  res.current_height = totalBlockCount;
-  res.start_height = startBlockIndex;
-
-  for (const auto& blockId : supplement) {
-    assert(m_core.have_block(blockId));
-    auto completeBlock = m_core.getBlock(blockId);
-    assert(completeBlock != nullptr);
-
-    res.blocks.resize(res.blocks.size() + 1);
-    res.blocks.back().block = asString(toBinaryArray(completeBlock->getBlock()));
+  bool result = m_core.getRawBlockchainSupplement(req.block_ids, COMMAND_RPC_GET_BLOCKS_FAST_MAX_COUNT, totalBlockCount, startBlockIndex,
+    [&](const std::vector<Blockchain::RawBlock>& blocks) {
+      response.setBody(storeRawGetBlocksResponse(blocks, startBlockIndex, totalBlockCount));
+    });
 
-    res.blocks.back().txs.reserve(completeBlock->getTransactionCount());
-    for (size_t i = 0; i < completeBlock->getTransactionCount(); ++i) {
-      res.blocks.back().txs.push_back(asString(toBinaryArray(completeBlock->getTransaction(i))));
-    }
+  if (!result) {
+    response.setBody(storeToBinaryKeyValue(res.data()));
   }
 
-  res.status = CORE_RPC_STATUS_OK;
-  return true;
+  return result;
 }
 
-bool RpcServer::on_query_blocks(const COMMAND_RPC_QUERY_BLOCKS::request& req, COMMAND_RPC_QUERY_BLOCKS::response& res) {
+bool RpcServer::on_query_blocks(const COMMAND_RPC_QUERY_BLOCKS::request& req, HttpResponse& response) {
   uint32_t startHeight;
   uint32_t currentHeight;
   uint32_t fullOffset;
 
-  if (!m_core.queryBlocks(req.block_ids, req.timestamp, startHeight, currentHeight, fullOffset, res.items)) {
-    res.status = "Failed to perform query";
-    return false;
+  bool result = m_core.queryRawBlocks(req.block_ids, req.timestamp, startHeight, currentHeight, fullOffset,
+    [&](const std::vector<Crypto::Hash>& shortBlockIds, const std::vector<Blockchain::RawBlock>& blocks) {
+      response.setBody(storeRawQueryBlocksResponse(shortBlockIds, blocks, startHeight, currentHeight, fullOffset));
+    });
+
+  if (!result) {
+    boost::value_initialized<COMMAND_RPC_QUERY_BLOCKS::response> res;
+    static_cast<COMMAND_RPC_QUERY_BLOCKS::response&>(res).status = "Failed to perform query";
+    response.setBody(storeToBinaryKeyValue(res.data()));
   }
 
-  res.start_height = startHeight;
-  res.current_height = currentHeight;
-  res.full_offset = fullOffset;
-  res.status = CORE_RPC_STATUS_OK;
-  return true;
+  return result;
 }
 
 bool RpcServer::on_query_blocks_lite(const COMMAND_RPC_QUERY_BLOCKS_LITE::request& req, COMMAND_RPC_QUERY_BLOCKS_LITE::response& res) {
@@ -495,6 +524,21 @@ bool RpcServer::on_stop_daemon(const COMMAND_RPC_STOP_DAEMON::request& req, COMM
   return true;
 }
 
+bool RpcServer::on_get_rpc_stats(const COMMAND_RPC_GET_RPC_STATS::request& req, COMMAND_RPC_GET_RPC_STATS::response& res) {
+  HttpServerStatistics statistics = getStatistics();
+  res.requests = statistics.requests;
+  res.rejected_requests = statistics.rejectedRequests;
+  res.worker_requests = statistics.workerRequests;
+  res.queued_requests = statistics.queuedRequests;
+  res.max_queued_requests = statistics.maxQueuedRequests;
+  res.active_workers = statistics.activeWorkers;
+  res.average_queue_time = statistics.workerRequests == 0 ? 0 : statistics.queueTime / statistics.workerRequests;
+  res.average_latency = statistics.requests == 0 ? 0 : statistics.processingTime / statistics.requests;
+  res.max_latency = statistics.maxLatency;
+  res.status = CORE_RPC_STATUS_OK;
+  return true;
+}
+
 //------------------------------------------------------------------------------------------------------------------------------
 // JSON RPC methods
 //------------------------------------------------------------------------------------------------------------------------------
@@ -16,10 +16,18 @@ namespace CryptoNote {
 
     const command_line::arg_descriptor<std::string> arg_rpc_bind_ip = { "rpc-bind-ip", "", DEFAULT_RPC_IP };
     const command_line::arg_descriptor<uint16_t> arg_rpc_bind_port = { "rpc-bind-port", "", DEFAULT_RPC_PORT };
+    const command_line::arg_descriptor<size_t> arg_rpc_worker_threads = { "rpc-worker-threads", "Threads processing the rpc requests off the network thread, 0 to process them all on it", RPC_DEFAULT_WORKER_THREADS };
+    const command_line::arg_descriptor<size_t> arg_rpc_max_request_size = { "rpc-max-request-size", "Maximum size of an rpc request body in bytes", RPC_DEFAULT_MAX_REQUEST_SIZE };
+    const command_line::arg_descriptor<size_t> arg_rpc_max_connection_requests = { "rpc-max-connection-requests", "Maximum number of pipelined rpc requests of a connection in progress", RPC_DEFAULT_MAX_CONNECTION_REQUESTS };
+    const command_line::arg_descriptor<size_t> arg_rpc_max_queued_requests = { "rpc-max-queued-requests", "Maximum number of rpc requests waiting for a worker thread", RPC_DEFAULT_MAX_QUEUED_REQUESTS };
   }
 
 
-  RpcServerConfig::RpcServerConfig() : bindIp(DEFAULT_RPC_IP), bindPort(DEFAULT_RPC_PORT) {
+  RpcServerConfig::RpcServerConfig() : bindIp(DEFAULT_RPC_IP), bindPort(DEFAULT_RPC_PORT),
+    workerThreads(RPC_DEFAULT_WORKER_THREADS),
+    maxRequestSize(RPC_DEFAULT_MAX_REQUEST_SIZE),
+    maxConnectionRequests(RPC_DEFAULT_MAX_CONNECTION_REQUESTS),
+    maxQueuedRequests(RPC_DEFAULT_MAX_QUEUED_REQUESTS) {
   }
 
   std::string RpcServerConfig::getBindAddress() const {
@@ -29,11 +37,19 @@ namespace CryptoNote {
   void RpcServerConfig::initOptions(boost::program_options::options_description& desc) {
     command_line::add_arg(desc, arg_rpc_bind_ip);
     command_line::add_arg(desc, arg_rpc_bind_port);
+    command_line::add_arg(desc, arg_rpc_worker_threads);
+    command_line::add_arg(desc, arg_rpc_max_request_size);
+    command_line::add_arg(desc, arg_rpc_max_connection_requests);
+    command_line::add_arg(desc, arg_rpc_max_queued_requests);
   }
 
   void RpcServerConfig::init(const boost::program_options::variables_map& vm)  {
     bindIp = command_line::get_arg(vm, arg_rpc_bind_ip);
     bindPort = command_line::get_arg(vm, arg_rpc_bind_port);
+    workerThreads = command_line::get_arg(vm, arg_rpc_worker_threads);
+    maxRequestSize = command_line::get_arg(vm, arg_rpc_max_request_size);
+    maxConnectionRequests = command_line::get_arg(vm, arg_rpc_max_connection_requests);
+    maxQueuedRequests = command_line::get_arg(vm, arg_rpc_max_queued_requests);
   }
 
 }
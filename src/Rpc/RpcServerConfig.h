@@ -21,6 +21,10 @@ public:
 
   std::string bindIp;
   uint16_t bindPort;
+  size_t workerThreads;
+  size_t maxRequestSize;
+  size_t maxConnectionRequests;
+  size_t maxQueuedRequests;
 };
 
 }
@@ -192,3 +192,414 @@ bool KVBinaryInputStreamSerializer::binary(std::string& value, Common::StringVie
   return (*this)(value, name); // load as string
 }
 
+
+namespace {
+
+const uint8_t* advance(const uint8_t* p, const uint8_t* end, size_t size) {
+  if (size > static_cast<size_t>(end - p)) {
+    throw std::runtime_error("Unexpected end of binary storage");
+  }
+
+  return p + size;
+}
+
+template <typename T>
+T readPodAt(const uint8_t* p, const uint8_t* end) {
+  T v;
+  memcpy(&v, p, advance(p, end, sizeof(T)) - p);
+  return v;
+}
+
+const uint8_t* readVarintAt(const uint8_t* p, const uint8_t* end, size_t& value) {
+  size_t bytes = size_t(1) << (readPodAt<uint8_t>(p, end) & PORTABLE_RAW_SIZE_MARK_MASK);
+  const uint8_t* next = advance(p, end, bytes);
+
+  value = 0;
+  for (size_t i = 0; i < bytes; ++i) {
+    value |= static_cast<size_t>(p[i]) << (i * 8);
+  }
+
+  value >>= 2;
+  return next;
+}
+
+// Size of a value of the type, 0 if it has no fixed size
+size_t fixedSize(uint8_t type) {
+  switch (type) {
+  case BIN_KV_SERIALIZE_TYPE_INT64:  return sizeof(int64_t);
+  case BIN_KV_SERIALIZE_TYPE_INT32:  return sizeof(int32_t);
+  case BIN_KV_SERIALIZE_TYPE_INT16:  return sizeof(int16_t);
+  case BIN_KV_SERIALIZE_TYPE_INT8:   return sizeof(int8_t);
+  case BIN_KV_SERIALIZE_TYPE_UINT64: return sizeof(uint64_t);
+  case BIN_KV_SERIALIZE_TYPE_UINT32: return sizeof(uint32_t);
+  case BIN_KV_SERIALIZE_TYPE_UINT16: return sizeof(uint16_t);
+  case BIN_KV_SERIALIZE_TYPE_UINT8:  return sizeof(uint8_t);
+  case BIN_KV_SERIALIZE_TYPE_DOUBLE: return sizeof(double);
+  case BIN_KV_SERIALIZE_TYPE_BOOL:   return sizeof(uint8_t);
+  case BIN_KV_SERIALIZE_TYPE_STRING:
+  case BIN_KV_SERIALIZE_TYPE_OBJECT:
+  case BIN_KV_SERIALIZE_TYPE_ARRAY:  return 0;
+  default:
+    throw std::runtime_error("Unknown data type");
+  }
+}
+
+const uint8_t* skipValue(const uint8_t* p, const uint8_t* end, uint8_t type);
+
+const uint8_t* skipArray(const uint8_t* p, const uint8_t* end, uint8_t itemType) {
+  size_t count;
+  p = readVarintAt(p, end, count);
+
+  size_t itemSize = fixedSize(itemType);
+  if (itemSize != 0) {
+    if (count > static_cast<size_t>(end - p) / itemSize) {
+      throw std::runtime_error("Unexpected end of binary storage");
+    }
+
+    return p + count * itemSize;
+  }
+
+  while (count--) {
+    p = skipValue(p, end, itemType);
+  }
+
+  return p;
+}
+
+const uint8_t* skipSection(const uint8_t* p, const uint8_t* end) {
+  size_t count;
+  p = readVarintAt(p, end, count);
+
+  while (count--) {
+    uint8_t nameSize = readPodAt<uint8_t>(p, end);
+    p = advance(p + 1, end, nameSize);
+    uint8_t type = readPodAt<uint8_t>(p, end);
+    p = skipValue(p + 1, end, type);
+  }
+
+  return p;
+}
+
+const uint8_t* skipValue(const uint8_t* p, const uint8_t* end, uint8_t type) {
+  if (type & BIN_KV_SERIALIZE_FLAG_ARRAY) {
+    return skipArray(p, end, type & ~BIN_KV_SERIALIZE_FLAG_ARRAY);
+  }
+
+  switch (type) {
+  case BIN_KV_SERIALIZE_TYPE_STRING: {
+    size_t size;
+    p = readVarintAt(p, end, size);
+    return advance(p, end, size);
+  }
+  case BIN_KV_SERIALIZE_TYPE_OBJECT: return skipSection(p, end);
+  case BIN_KV_SERIALIZE_TYPE_ARRAY:  return skipArray(p, end, type);
+  default:
+    return advance(p, end, fixedSize(type));
+  }
+}
+
+bool isArray(uint8_t type) {
+  return (type & BIN_KV_SERIALIZE_FLAG_ARRAY) != 0 || type == BIN_KV_SERIALIZE_TYPE_ARRAY;
+}
+
+template <typename T>
+T integerAt(const uint8_t* p, const uint8_t* end, uint8_t type) {
+  switch (type) {
+  case BIN_KV_SERIALIZE_TYPE_INT64:  return static_cast<T>(readPodAt<int64_t>(p, end));
+  case BIN_KV_SERIALIZE_TYPE_INT32:  return static_cast<T>(readPodAt<int32_t>(p, end));
+  case BIN_KV_SERIALIZE_TYPE_INT16:  return static_cast<T>(readPodAt<int16_t>(p, end));
+  case BIN_KV_SERIALIZE_TYPE_INT8:   return static_cast<T>(readPodAt<int8_t>(p, end));
+  case BIN_KV_SERIALIZE_TYPE_UINT64: return static_cast<T>(readPodAt<uint64_t>(p, end));
+  case BIN_KV_SERIALIZE_TYPE_UINT32: return static_cast<T>(readPodAt<uint32_t>(p, end));
+  case BIN_KV_SERIALIZE_TYPE_UINT16: return static_cast<T>(readPodAt<uint16_t>(p, end));
+  case BIN_KV_SERIALIZE_TYPE_UINT8:  return static_cast<T>(readPodAt<uint8_t>(p, end));
+  default:
+    throw std::runtime_error("Integer value expected");
+  }
+}
+
+}
+
+KVBinaryInputBufferSerializer::KVBinaryInputBufferSerializer(const void* data, size_t size) :
+  m_end(static_cast<const uint8_t*>(data) + size) {
+  const uint8_t* p = static_cast<const uint8_t*>(data);
+  auto hdr = readPodAt<KVBinaryStorageBlockHeader>(p, m_end);
+
+  if (
+    hdr.m_signature_a != PORTABLE_STORAGE_SIGNATUREA ||
+    hdr.m_signature_b != PORTABLE_STORAGE_SIGNATUREB) {
+    throw std::runtime_error("Invalid binary storage signature");
+  }
+
+  if (hdr.m_ver != PORTABLE_STORAGE_FORMAT_VER) {
+    throw std::runtime_error("Unknown binary storage format version");
+  }
+
+  pushLevel(p + sizeof(hdr), BIN_KV_SERIALIZE_TYPE_OBJECT);
+}
+
+ISerializer::SerializerType KVBinaryInputBufferSerializer::type() const {
+  return ISerializer::INPUT;
+}
+
+bool KVBinaryInputBufferSerializer::beginObject(Common::StringView name) {
+  uint8_t type;
+  const uint8_t* value = findValue(name, type);
+  if (value == nullptr) {
+    return false;
+  }
+
+  if (type != BIN_KV_SERIALIZE_TYPE_OBJECT) {
+    throw std::runtime_error("Object expected");
+  }
+
+  pushLevel(value, type);
+  return true;
+}
+
+void KVBinaryInputBufferSerializer::endObject() {
+  assert(m_stack.size() > 1 && !m_stack.back().isArray);
+  popLevel();
+}
+
+bool KVBinaryInputBufferSerializer::beginArray(size_t& size, Common::StringView name) {
+  uint8_t type;
+  const uint8_t* value = findValue(name, type);
+  if (value == nullptr) {
+    size = 0;
+    return false;
+  }
+
+  if (!isArray(type)) {
+    throw std::runtime_error("Array expected");
+  }
+
+  pushLevel(value, type);
+  size = m_stack.back().count;
+  return true;
+}
+
+void KVBinaryInputBufferSerializer::endArray() {
+  assert(m_stack.size() > 1 && m_stack.back().isArray);
+  popLevel();
+}
+
+bool KVBinaryInputBufferSerializer::operator()(uint8_t& value, Common::StringView name) {
+  return readInteger(value, name);
+}
+
+bool KVBinaryInputBufferSerializer::operator()(int16_t& value, Common::StringView name) {
+  return readInteger(value, name);
+}
+
+bool KVBinaryInputBufferSerializer::operator()(uint16_t& value, Common::StringView name) {
+  return readInteger(value, name);
+}
+
+bool KVBinaryInputBufferSerializer::operator()(int32_t& value, Common::StringView name) {
+  return readInteger(value, name);
+}
+
+bool KVBinaryInputBufferSerializer::operator()(uint32_t& value, Common::StringView name) {
+  return readInteger(value, name);
+}
+
+bool KVBinaryInputBufferSerializer::operator()(int64_t& value, Common::StringView name) {
+  return readInteger(value, name);
+}
+
+bool KVBinaryInputBufferSerializer::operator()(uint64_t& value, Common::StringView name) {
+  return readInteger(value, name);
+}
+
+bool KVBinaryInputBufferSerializer::operator()(double& value, Common::StringView name) {
+  uint8_t type;
+  const uint8_t* p = findValue(name, type);
+  if (p == nullptr) {
+    return false;
+  }
+
+  value = type == BIN_KV_SERIALIZE_TYPE_DOUBLE ? readPodAt<double>(p, m_end) : integerAt<double>(p, m_end, type);
+  valueRead(p, p + fixedSize(type));
+  return true;
+}
+
+bool KVBinaryInputBufferSerializer::operator()(bool& value, Common::StringView name) {
+  uint8_t type;
+  const uint8_t* p = findValue(name, type);
+  if (p == nullptr) {
+    return false;
+  }
+
+  if (type != BIN_KV_SERIALIZE_TYPE_BOOL) {
+    throw std::runtime_error("Bool value expected");
+  }
+
+  value = readPodAt<uint8_t>(p, m_end) != 0;
+  valueRead(p, p + 1);
+  return true;
+}
+
+bool KVBinaryInputBufferSerializer::operator()(std::string& value, Common::StringView name) {
+  Common::StringView view;
+  if (!readString(view, name)) {
+    return false;
+  }
+
+  value.assign(view.getData(), view.getSize());
+  return true;
+}
+
+bool KVBinaryInputBufferSerializer::binary(void* value, size_t size, Common::StringView name) {
+  Common::StringView view;
+  if (!readString(view, name)) {
+    return false;
+  }
+
+  if (view.getSize() != size) {
+    throw std::runtime_error("Binary block size mismatch");
+  }
+
+  memcpy(value, view.getData(), size);
+  return true;
+}
+
+bool KVBinaryInputBufferSerializer::binary(std::string& value, Common::StringView name) {
+  return (*this)(value, name);
+}
+
+void KVBinaryInputBufferSerializer::pushLevel(const uint8_t* value, uint8_t type) {
+  Level level;
+  level.start = value;
+  level.isArray = isArray(type);
+  level.itemType = type == BIN_KV_SERIALIZE_TYPE_ARRAY ? type : type & ~BIN_KV_SERIALIZE_FLAG_ARRAY;
+  level.next = readVarintAt(value, m_end, level.count);
+  level.read = 0;
+  level.last = nullptr;
+  level.lastType = 0;
+  level.firstField = m_fields.size();
+  level.hint = level.firstField;
+
+  // every field and item takes a byte at least, a count can't make the caller allocate more than that
+  if (level.count > static_cast<size_t>(m_end - level.next)) {
+    throw std::runtime_error("Unexpected end of binary storage");
+  }
+
+  m_stack.push_back(level);
+}
+
+void KVBinaryInputBufferSerializer::popLevel() {
+  Level level = m_stack.back();
+  m_stack.pop_back();
+  m_fields.resize(level.firstField);
+
+  if (level.read == level.count && level.next != nullptr) {
+    valueRead(level.start, level.next);
+  }
+}
+
+const uint8_t* KVBinaryInputBufferSerializer::findValue(Common::StringView name, uint8_t& type) {
+  Level& level = m_stack.back();
+  if (level.isArray) {
+    if (level.read == level.count) {
+      throw std::runtime_error("Reading past the end of an array");
+    }
+
+    if (level.next == nullptr) {
+      level.next = skipValue(level.last, m_end, level.lastType);
+    }
+
+    level.last = level.next;
+    level.lastType = level.itemType;
+    level.next = nullptr;
+    ++level.read;
+    type = level.itemType;
+    return level.last;
+  }
+
+  // fields are usually asked for in the order they were written, the one asked for is the one after the last found
+  for (size_t i = level.hint; i < m_fields.size(); ++i) {
+    if (m_fields[i].name == name) {
+      level.hint = i + 1;
+      type = m_fields[i].type;
+      return m_fields[i].value;
+    }
+  }
+
+  while (level.read < level.count) {
+    if (level.next == nullptr) {
+      level.next = skipValue(level.last, m_end, level.lastType);
+    }
+
+    const uint8_t* p = level.next;
+    uint8_t nameSize = readPodAt<uint8_t>(p, m_end);
+    p = advance(p + 1, m_end, nameSize);
+
+    Field field;
+    field.name = Common::StringView(reinterpret_cast<const char*>(p - nameSize), nameSize);
+    field.type = readPodAt<uint8_t>(p, m_end);
+    field.value = p + 1;
+    m_fields.push_back(field);
+
+    ++level.read;
+    level.last = field.value;
+    level.lastType = field.type;
+    level.next = nullptr;
+
+    if (field.name == name) {
+      level.hint = m_fields.size();
+      type = field.type;
+      return field.value;
+    }
+  }
+
+  for (size_t i = level.firstField; i < level.hint; ++i) {
+    if (m_fields[i].name == name) {
+      level.hint = i + 1;
+      type = m_fields[i].type;
+      return m_fields[i].value;
+    }
+  }
+
+  return nullptr;
+}
+
+// Lets the level go on from the end of the value without skipping it again, if it's the last one it looked at
+void KVBinaryInputBufferSerializer::valueRead(const uint8_t* value, const uint8_t* end) {
+  Level& level = m_stack.back();
+  if (level.next == nullptr && level.last == value) {
+    level.next = end;
+  }
+}
+
+bool KVBinaryInputBufferSerializer::readString(Common::StringView& value, Common::StringView name) {
+  uint8_t type;
+  const uint8_t* p = findValue(name, type);
+  if (p == nullptr) {
+    return false;
+  }
+
+  if (type != BIN_KV_SERIALIZE_TYPE_STRING) {
+    throw std::runtime_error("String value expected");
+  }
+
+  size_t size;
+  const uint8_t* data = readVarintAt(p, m_end, size);
+  const uint8_t* end = advance(data, m_end, size);
+  value = Common::StringView(reinterpret_cast<const char*>(data), size);
+  valueRead(p, end);
+  return true;
+}
+
+template<typename T>
+bool KVBinaryInputBufferSerializer::readInteger(T& value, Common::StringView name) {
+  uint8_t type;
+  const uint8_t* p = findValue(name, type);
+  if (p == nullptr) {
+    return false;
+  }
+
+  value = integerAt<T>(p, m_end, type);
+  valueRead(p, p + fixedSize(type));
+  return true;
+}
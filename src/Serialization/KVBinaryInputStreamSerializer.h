@@ -5,6 +5,7 @@
 
 #pragma once
 
+#include <vector>
 #include <Common/IInputStream.h>
 #include "ISerializer.h"
 #include "JsonInputValueSerializer.h"
@@ -19,4 +20,76 @@ public:
   virtual bool binary(std::string& value, Common::StringView name) override;
 };
 
+// Reads a storage where it lies instead of building a JsonValue of it first. The fields of an object are looked up as
+// they are asked for and remembered as views into the buffer, so fields asked for in the order they were written are
+// read in one pass, and strings are copied once, from the buffer to the value. The buffer has to outlive the serializer.
+class KVBinaryInputBufferSerializer : public ISerializer {
+public:
+  KVBinaryInputBufferSerializer(const void* data, size_t size);
+  virtual ~KVBinaryInputBufferSerializer() {}
+
+  virtual ISerializer::SerializerType type() const override;
+
+  virtual bool beginObject(Common::StringView name) override;
+  virtual void endObject() override;
+
+  virtual bool beginArray(size_t& size, Common::StringView name) override;
+  virtual void endArray() override;
+
+  virtual bool operator()(uint8_t& value, Common::StringView name) override;
+  virtual bool operator()(int16_t& value, Common::StringView name) override;
+  virtual bool operator()(uint16_t& value, Common::StringView name) override;
+  virtual bool operator()(int32_t& value, Common::StringView name) override;
+  virtual bool operator()(uint32_t& value, Common::StringView name) override;
+  virtual bool operator()(int64_t& value, Common::StringView name) override;
+  virtual bool operator()(uint64_t& value, Common::StringView name) override;
+  virtual bool operator()(double& value, Common::StringView name) override;
+  virtual bool operator()(bool& value, Common::StringView name) override;
+  virtual bool operator()(std::string& value, Common::StringView name) override;
+  virtual bool binary(void* value, size_t size, Common::StringView name) override;
+  virtual bool binary(std::string& value, Common::StringView name) override;
+
+  template<typename T>
+  bool operator()(T& value, Common::StringView name) {
+    return ISerializer::operator()(value, name);
+  }
+
+private:
+  struct Field {
+    Common::StringView name;
+    uint8_t type;
+    const uint8_t* value;
+  };
+
+  // An object or an array being read
+  struct Level {
+    const uint8_t* start;
+    bool isArray;
+    uint8_t itemType;
+    size_t count;
+    // Fields of an object looked at so far, items of an array read so far
+    size_t read;
+    const uint8_t* last;
+    uint8_t lastType;
+    // Where the field or item after the last one starts, null until the end of the last one is known
+    const uint8_t* next;
+    // The fields of an object looked at so far are in m_fields from here on
+    size_t firstField;
+    size_t hint;
+  };
+
+  void pushLevel(const uint8_t* value, uint8_t type);
+  void popLevel();
+  const uint8_t* findValue(Common::StringView name, uint8_t& type);
+  void valueRead(const uint8_t* value, const uint8_t* end);
+  bool readString(Common::StringView& value, Common::StringView name);
+
+  template<typename T>
+  bool readInteger(T& value, Common::StringView name);
+
+  const uint8_t* m_end;
+  std::vector<Level> m_stack;
+  std::vector<Field> m_fields;
+};
+
 }
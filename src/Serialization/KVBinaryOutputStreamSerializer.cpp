@@ -235,4 +235,55 @@ MemoryStream& KVBinaryOutputStreamSerializer::stream() {
   return m_objectsStack.back();
 }
 
+KVBinaryStreamWriter::KVBinaryStreamWriter(IOutputStream& target, size_t fieldCount) : m_target(target) {
+  KVBinaryStorageBlockHeader hdr;
+  hdr.m_signature_a = PORTABLE_STORAGE_SIGNATUREA;
+  hdr.m_signature_b = PORTABLE_STORAGE_SIGNATUREB;
+  hdr.m_ver = PORTABLE_STORAGE_FORMAT_VER;
+
+  Common::write(m_target, &hdr, sizeof(hdr));
+  writeArraySize(m_target, fieldCount);
+}
+
+void KVBinaryStreamWriter::writeObject(Common::StringView name, size_t fieldCount) {
+  writeElementName(m_target, name);
+  writePod(m_target, BIN_KV_SERIALIZE_TYPE_OBJECT);
+  writeArraySize(m_target, fieldCount);
+}
+
+void KVBinaryStreamWriter::writeObjectArray(Common::StringView name, size_t count) {
+  assert(count > 0);
+  writeElementName(m_target, name);
+  writePod(m_target, static_cast<uint8_t>(BIN_KV_SERIALIZE_FLAG_ARRAY | BIN_KV_SERIALIZE_TYPE_OBJECT));
+  writeArraySize(m_target, count);
+}
+
+void KVBinaryStreamWriter::writeObjectItem(size_t fieldCount) {
+  writeArraySize(m_target, fieldCount);
+}
+
+void KVBinaryStreamWriter::writeStringArray(Common::StringView name, size_t count) {
+  assert(count > 0);
+  writeElementName(m_target, name);
+  writePod(m_target, static_cast<uint8_t>(BIN_KV_SERIALIZE_FLAG_ARRAY | BIN_KV_SERIALIZE_TYPE_STRING));
+  writeArraySize(m_target, count);
+}
+
+void KVBinaryStreamWriter::writeStringItem(Common::StringView value) {
+  writeArraySize(m_target, value.getSize());
+  write(m_target, value.getData(), value.getSize());
+}
+
+void KVBinaryStreamWriter::writeString(Common::StringView name, Common::StringView value) {
+  writeElementName(m_target, name);
+  writePod(m_target, BIN_KV_SERIALIZE_TYPE_STRING);
+  writeStringItem(value);
+}
+
+void KVBinaryStreamWriter::writeUint64(Common::StringView name, uint64_t value) {
+  writeElementName(m_target, name);
+  writePod(m_target, BIN_KV_SERIALIZE_TYPE_UINT64);
+  writePod(m_target, value);
+}
+
 }
@@ -83,4 +83,23 @@ private:
   std::vector<Level> m_stack;
 };
 
+// Writes a storage straight to the stream, for large responses whose blobs are not worth copying into objects first.
+// The number of fields of every object and of the items of every array is given up front. The output is the same as the
+// one of KVBinaryOutputStreamSerializer as long as the fields come in the same order and empty arrays are left out.
+class KVBinaryStreamWriter {
+public:
+  KVBinaryStreamWriter(Common::IOutputStream& target, size_t fieldCount);
+
+  void writeObject(Common::StringView name, size_t fieldCount);
+  void writeObjectArray(Common::StringView name, size_t count);
+  void writeObjectItem(size_t fieldCount);
+  void writeStringArray(Common::StringView name, size_t count);
+  void writeStringItem(Common::StringView value);
+  void writeString(Common::StringView name, Common::StringView value);
+  void writeUint64(Common::StringView name, uint64_t value);
+
+private:
+  Common::IOutputStream& m_target;
+};
+
 }
@@ -4,6 +4,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "TcpStream.h"
+#include <cstring>
 #include <System/TcpConnection.h>
 
 namespace System {
@@ -37,6 +38,35 @@ int TcpStreambuf::sync() {
   return dumpBuffer(true) ? 0 : -1;
 }
 
+// Writes that don't fit into the buffer go to the connection directly instead of in buffer-sized pieces
+std::streamsize TcpStreambuf::xsputn(const char* s, std::streamsize n) {
+  if (n <= epptr() - pptr()) {
+    std::memcpy(pptr(), s, static_cast<size_t>(n));
+    pbump(static_cast<int>(n));
+    return n;
+  }
+
+  if (!dumpBuffer(true)) {
+    return 0;
+  }
+
+  if (n < static_cast<std::streamsize>(writeBuf.max_size())) {
+    std::memcpy(pptr(), s, static_cast<size_t>(n));
+    pbump(static_cast<int>(n));
+    return n;
+  }
+
+  std::streamsize offset = 0;
+  try {
+    while (offset != n) {
+      offset += connection.write(reinterpret_cast<const uint8_t*>(s) + offset, static_cast<size_t>(n - offset));
+    }
+  } catch (std::exception&) {
+  }
+
+  return offset;
+}
+
 std::streambuf::int_type TcpStreambuf::underflow() {
   if (gptr() < egptr()) {
     return traits_type::to_int_type(*gptr());
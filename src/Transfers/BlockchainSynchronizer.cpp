@@ -5,6 +5,7 @@
 
 #include "BlockchainSynchronizer.h"
 
+#include <chrono>
 #include <functional>
 #include <iostream>
 #include <sstream>
@@ -12,6 +13,7 @@
 
 #include "CryptoNoteCore/TransactionApi.h"
 #include "CryptoNoteCore/CryptoNoteFormatUtils.h"
+#include "CryptoNoteCore/CryptoNoteTools.h"
 
 using namespace Crypto;
 
@@ -24,6 +26,27 @@ inline std::vector<uint8_t> stringToVector(const std::string& s) {
   return vec;
 }
 
+uint64_t microsecondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Adds the hashes of the blocks to the history, newest first and sparser the older they get, like
+// SynchronizationState::getShortHistory() does. The first block is always added, it is known to the node.
+void addShortHistory(const std::vector<CryptoNote::BlockShortEntry>& blocks, std::vector<Hash>& history) {
+  size_t backOffset = 1;
+  size_t multiplier = 1;
+  for (size_t i = 0; backOffset < blocks.size(); ++i) {
+    history.push_back(blocks[blocks.size() - backOffset].blockHash);
+    if (i < 10) {
+      ++backOffset;
+    } else {
+      backOffset += multiplier *= 2;
+    }
+  }
+
+  history.push_back(blocks.front().blockHash);
+}
+
 }
 
 namespace CryptoNote {
@@ -32,7 +55,19 @@ BlockchainSynchronizer::BlockchainSynchronizer(INode& node, const Hash& genesisB
   m_node(node),
   m_genesisBlockHash(genesisBlockHash),
   m_currentState(State::stopped),
-  m_futureState(State::stopped) {
+  m_futureState(State::stopped),
+  m_prefetchDepth(0),
+  m_statistics() {
+}
+
+double BlockchainSynchronizerStatistics::blocksPerSecond() const {
+  uint64_t time = waitTime + processingTime;
+  return time == 0 ? 0 : blocks * 1000000.0 / time;
+}
+
+double BlockchainSynchronizerStatistics::bytesPerSecond() const {
+  uint64_t time = waitTime + processingTime;
+  return time == 0 ? 0 : bytes * 1000000.0 / time;
 }
 
 BlockchainSynchronizer::~BlockchainSynchronizer() {
@@ -136,6 +171,19 @@ void BlockchainSynchronizer::doRemoveUnconfirmedTransaction(const Crypto::Hash&
   }
 }
 
+void BlockchainSynchronizer::setPrefetchDepth(size_t depth) {
+  if (!(checkIfStopped() && checkIfShouldStop())) {
+    throw std::runtime_error("Can't set prefetch depth, because BlockchainSynchronizer isn't stopped");
+  }
+
+  m_prefetchDepth = depth;
+}
+
+BlockchainSynchronizerStatistics BlockchainSynchronizer::getStatistics() const {
+  std::lock_guard<std::mutex> lock(m_statisticsMutex);
+  return m_statistics;
+}
+
 void BlockchainSynchronizer::save(std::ostream& os) {
   os.write(reinterpret_cast<const char*>(&m_genesisBlockHash), sizeof(m_genesisBlockHash));
 }
@@ -245,6 +293,7 @@ void BlockchainSynchronizer::workingProcedure() {
   }
 
   actualizeFutureState();
+  clearPrefetchedQueries();
 }
 
 void BlockchainSynchronizer::start() {
@@ -333,43 +382,134 @@ BlockchainSynchronizer::GetBlocksRequest BlockchainSynchronizer::getCommonHistor
 }
 
 void BlockchainSynchronizer::startBlockchainSync() {
-  GetBlocksResponse response;
   GetBlocksRequest req = getCommonHistory();
 
   try {
     if (!req.knownBlocks.empty()) {
-      auto queryBlocksCompleted = std::promise<std::error_code>();
-      auto queryBlocksWaitFuture = queryBlocksCompleted.get_future();
-
-      m_node.queryBlocks(
-        std::move(req.knownBlocks),
-        req.syncStart.timestamp,
-        response.newBlocks,
-        response.startHeight,
-        [&queryBlocksCompleted](std::error_code ec) {
-          auto detachedPromise = std::move(queryBlocksCompleted);
-          detachedPromise.set_value(ec);
-        });
+      std::unique_ptr<BlocksQuery> query = takePrefetchedQuery(req.knownBlocks.front());
+      if (!query) {
+        query = startQuery(std::move(req));
+      }
 
-      std::error_code ec = queryBlocksWaitFuture.get();
+      auto waitStart = std::chrono::steady_clock::now();
+      std::error_code ec = query->result.get();
+      uint64_t waitTime = microsecondsSince(waitStart);
+      {
+        std::lock_guard<std::mutex> lock(m_statisticsMutex);
+        m_statistics.waitTime += waitTime;
+      }
 
       if (ec) {
+        clearPrefetchedQueries();
         setFutureStateIf(State::idle, [this] { return m_futureState != State::stopped; });
         m_observerManager.notify(&IBlockchainSynchronizerObserver::synchronizationCompleted, ec);
       } else {
-        processBlocks(response);
+        // the next blocks are on their way while these are processed
+        prefetchBlocks(*query);
+
+        auto processingStart = std::chrono::steady_clock::now();
+        processBlocks(query->response);
+        uint64_t processingTime = microsecondsSince(processingStart);
+
+        std::lock_guard<std::mutex> lock(m_statisticsMutex);
+        m_statistics.processingTime += processingTime;
       }
     }
   } catch (std::exception&) {
+    clearPrefetchedQueries();
     setFutureStateIf(State::idle,  [this] { return m_futureState != State::stopped; });
     m_observerManager.notify(&IBlockchainSynchronizerObserver::synchronizationCompleted, std::make_error_code(std::errc::invalid_argument));
   }
 }
 
+std::unique_ptr<BlockchainSynchronizer::BlocksQuery> BlockchainSynchronizer::startQuery(GetBlocksRequest&& request) {
+  std::unique_ptr<BlocksQuery> query(new BlocksQuery());
+  query->knownTip = request.knownBlocks.front();
+  query->result = query->completed.get_future().share();
+
+  BlocksQuery* queryPtr = query.get();
+  m_node.queryBlocks(
+    std::move(request.knownBlocks),
+    request.syncStart.timestamp,
+    queryPtr->response.newBlocks,
+    queryPtr->response.startHeight,
+    [queryPtr](std::error_code ec) {
+      auto detachedPromise = std::move(queryPtr->completed);
+      detachedPromise.set_value(ec);
+    });
+
+  std::lock_guard<std::mutex> lock(m_statisticsMutex);
+  ++m_statistics.queries;
+  return query;
+}
+
+// The oldest prefetched query can be used if it was made for the consumer the synchronizer would query for now,
+// otherwise the consumers did not take the blocks before it or the node switched to another chain. Then all the
+// prefetched queries are stale.
+std::unique_ptr<BlockchainSynchronizer::BlocksQuery> BlockchainSynchronizer::takePrefetchedQuery(const Crypto::Hash& knownTip) {
+  if (m_prefetchedQueries.empty()) {
+    return nullptr;
+  }
+
+  if (m_prefetchedQueries.front()->knownTip != knownTip) {
+    clearPrefetchedQueries();
+    return nullptr;
+  }
+
+  std::unique_ptr<BlocksQuery> query = std::move(m_prefetchedQueries.front());
+  m_prefetchedQueries.pop_front();
+
+  std::lock_guard<std::mutex> lock(m_statisticsMutex);
+  ++m_statistics.prefetchedQueries;
+  return query;
+}
+
+// Up to m_prefetchDepth queries follow the one being processed. A query asks for the blocks after the ones of the
+// query before it, so it is made once that one is answered and is not the last of the node's blocks.
+void BlockchainSynchronizer::prefetchBlocks(const BlocksQuery& query) {
+  while (m_prefetchedQueries.size() < m_prefetchDepth) {
+    const BlocksQuery& previous = m_prefetchedQueries.empty() ? query : *m_prefetchedQueries.back();
+    if (previous.result.wait_for(std::chrono::seconds(0)) != std::future_status::ready || previous.result.get()) {
+      break;
+    }
+
+    const std::vector<BlockShortEntry>& blocks = previous.response.newBlocks;
+    if (blocks.size() < 2 || previous.response.startHeight + blocks.size() - 1 >= m_node.getLastLocalBlockHeight()) {
+      break;
+    }
+
+    GetBlocksRequest request = getCommonHistory();
+    std::vector<Crypto::Hash> knownBlocks;
+    addShortHistory(blocks, knownBlocks);
+    knownBlocks.insert(knownBlocks.end(), request.knownBlocks.begin(), request.knownBlocks.end());
+    request.knownBlocks = std::move(knownBlocks);
+
+    m_prefetchedQueries.push_back(startQuery(std::move(request)));
+  }
+}
+
+// The node still fills the responses of the queries in flight
+void BlockchainSynchronizer::clearPrefetchedQueries() {
+  if (m_prefetchedQueries.empty()) {
+    return;
+  }
+
+  size_t count = m_prefetchedQueries.size();
+  for (auto& query : m_prefetchedQueries) {
+    query->result.wait();
+  }
+
+  m_prefetchedQueries.clear();
+
+  std::lock_guard<std::mutex> lock(m_statisticsMutex);
+  m_statistics.discardedQueries += count;
+}
+
 void BlockchainSynchronizer::processBlocks(GetBlocksResponse& response) {
   BlockchainInterval interval;
   interval.startHeight = response.startHeight;
   std::vector<CompleteBlock> blocks;
+  uint64_t bytes = 0;
 
   for (auto& block : response.newBlocks) {
     if (checkIfShouldStop()) {
@@ -379,7 +519,13 @@ void BlockchainSynchronizer::processBlocks(GetBlocksResponse& response) {
     CompleteBlock completeBlock;
     completeBlock.blockHash = block.blockHash;
     interval.blocks.push_back(completeBlock.blockHash);
+    bytes += sizeof(block.blockHash);
     if (block.hasBlock) {
+      bytes += getObjectBinarySize(block.block);
+      for (const auto& txShortInfo : block.txsShortInfo) {
+        bytes += sizeof(txShortInfo.txId) + getObjectBinarySize(txShortInfo.txPrefix);
+      }
+
       completeBlock.block = std::move(block.block);
       completeBlock.transactions.push_back(createTransactionPrefix(completeBlock.block->baseTransaction));
 
@@ -388,6 +534,7 @@ void BlockchainSynchronizer::processBlocks(GetBlocksResponse& response) {
           completeBlock.transactions.push_back(createTransactionPrefix(txShortInfo.txPrefix, reinterpret_cast<const Hash&>(txShortInfo.txId)));
         }
       } catch (std::exception&) {
+        clearPrefetchedQueries();
         setFutureStateIf(State::idle, [this] { return m_futureState != State::stopped; });
         m_observerManager.notify(&IBlockchainSynchronizerObserver::synchronizationCompleted, std::make_error_code(std::errc::invalid_argument));
         return;
@@ -397,6 +544,12 @@ void BlockchainSynchronizer::processBlocks(GetBlocksResponse& response) {
     blocks.push_back(std::move(completeBlock));
   }
 
+  {
+    std::lock_guard<std::mutex> lock(m_statisticsMutex);
+    m_statistics.blocks += blocks.size();
+    m_statistics.bytes += bytes;
+  }
+
   uint32_t processedBlockCount = response.startHeight + static_cast<uint32_t>(response.newBlocks.size());
   if (!checkIfShouldStop()) {
     response.newBlocks.clear();
@@ -404,10 +557,17 @@ void BlockchainSynchronizer::processBlocks(GetBlocksResponse& response) {
     auto result = updateConsumers(interval, blocks);
     lk.unlock();
 
+    // the prefetched queries are for the blocks after these ones
+    if (result != UpdateConsumersResult::addedNewBlocks) {
+      clearPrefetchedQueries();
+    }
+
     switch (result) {
     case UpdateConsumersResult::errorOccurred:
+      // the synchronization has ended, a stop coming now must not report it again as interrupted
       if (setFutureStateIf(State::idle, [this] { return m_futureState != State::stopped; })) {
         m_observerManager.notify(&IBlockchainSynchronizerObserver::synchronizationCompleted, std::make_error_code(std::errc::invalid_argument));
+        return;
       }
       break;
 
@@ -12,12 +12,28 @@
 #include "IStreamSerializable.h"
 
 #include <condition_variable>
+#include <deque>
 #include <mutex>
 #include <atomic>
 #include <future>
 
 namespace CryptoNote {
 
+// Times are in microseconds. waitTime is the time spent waiting for queryBlocks() responses, a prefetched response
+// that arrived while the blocks before it were processed costs no waiting.
+struct BlockchainSynchronizerStatistics {
+  uint64_t queries;
+  uint64_t prefetchedQueries;
+  uint64_t discardedQueries;
+  uint64_t blocks;
+  uint64_t bytes;
+  uint64_t waitTime;
+  uint64_t processingTime;
+
+  double blocksPerSecond() const;
+  double bytesPerSecond() const;
+};
+
 class BlockchainSynchronizer :
   public IObservableImpl<IBlockchainSynchronizerObserver, IBlockchainSynchronizer>,
   public INodeObserver {
@@ -38,6 +54,11 @@ public:
   virtual void start() override;
   virtual void stop() override;
 
+  // Number of queryBlocks() calls made ahead of the blocks being processed, 0 turns prefetching off.
+  // Can only be changed while the synchronizer is stopped.
+  void setPrefetchDepth(size_t depth);
+  BlockchainSynchronizerStatistics getStatistics() const;
+
   // IStreamSerializable
   virtual void save(std::ostream& os) override;
   virtual void load(std::istream& in) override;
@@ -54,6 +75,14 @@ private:
     std::vector<BlockShortEntry> newBlocks;
   };
 
+  // A queryBlocks() call, prefetched ones are made for a consumer whose last block is knownTip
+  struct BlocksQuery {
+    Crypto::Hash knownTip;
+    GetBlocksResponse response;
+    std::promise<std::error_code> completed;
+    std::shared_future<std::error_code> result;
+  };
+
   struct GetBlocksRequest {
     GetBlocksRequest() {
       syncStart.timestamp = 0;
@@ -91,6 +120,11 @@ private:
   void startPoolSync();
   void startBlockchainSync();
 
+  std::unique_ptr<BlocksQuery> startQuery(GetBlocksRequest&& request);
+  std::unique_ptr<BlocksQuery> takePrefetchedQuery(const Crypto::Hash& knownTip);
+  void prefetchBlocks(const BlocksQuery& query);
+  void clearPrefetchedQueries();
+
   void processBlocks(GetBlocksResponse& response);
   UpdateConsumersResult updateConsumers(const BlockchainInterval& interval, const std::vector<CompleteBlock>& blocks);
   std::error_code processPoolTxs(GetPoolResponse& response);
@@ -129,6 +163,12 @@ private:
   mutable std::mutex m_consumersMutex;
   mutable std::mutex m_stateMutex;
   std::condition_variable m_hasWork;
+
+  size_t m_prefetchDepth;
+  std::deque<std::unique_ptr<BlocksQuery>> m_prefetchedQueries;
+
+  mutable std::mutex m_statisticsMutex;
+  BlockchainSynchronizerStatistics m_statistics;
 };
 
 }
@@ -11,13 +11,16 @@
 
 #include "CommonTypes.h"
 #include "Common/StringTools.h"
-#include "Common/BlockingQueue.h"
+#include "Common/WorkerPool.h"
 #include "CryptoNoteCore/CryptoNoteFormatUtils.h"
 #include "CryptoNoteCore/TransactionApi.h"
 
 #include "IWallet.h"
 #include "INode.h"
+#include <algorithm>
+#include <atomic>
 #include <future>
+#include <mutex>
 
 using namespace Crypto;
 
@@ -87,6 +90,16 @@ void findMyOutputs(
   }
 }
 
+// Transactions handed to a thread at least, fewer are preprocessed on the calling thread
+const size_t MIN_TRANSACTIONS_PER_WORKER = 4;
+
+// Shared by the consumers of all the wallets, its threads are started with the first one. The thread calling
+// onNewBlocks() works along with them.
+Tools::WorkerPool& preprocessingPool() {
+  static Tools::WorkerPool pool(std::max<size_t>(std::thread::hardware_concurrency(), 2) - 1);
+  return pool;
+}
+
 std::vector<Crypto::Hash> getBlockHashes(const CryptoNote::CompleteBlock* blocks, size_t count) {
   std::vector<Crypto::Hash> result;
   result.reserve(count);
@@ -192,99 +205,84 @@ bool TransfersConsumer::onNewBlocks(const CompleteBlock* blocks, uint32_t startH
 
   struct PreprocessedTx : Tx, PreprocessInfo {};
 
+  // the transactions in block order, every worker writes the results of a transaction to its own slot
   std::vector<PreprocessedTx> preprocessedTransactions;
-  std::mutex preprocessedTransactionsMutex;
 
-  size_t workers = std::thread::hardware_concurrency();
-  if (workers == 0) {
-    workers = 2;
-  }
-
-  BlockingQueue<Tx> inputQueue(workers * 2);
+  for (uint32_t i = 0; i < count; ++i) {
+    const auto& block = blocks[i].block;
 
-  std::atomic<bool> stopProcessing(false);
+    if (!block.is_initialized()) {
+      continue;
+    }
 
-  auto pushingThread = std::async(std::launch::async, [&] {
-    for( uint32_t i = 0; i < count && !stopProcessing; ++i) {
-      const auto& block = blocks[i].block;
+    // filter by syncStartTimestamp
+    if (m_syncStart.timestamp && block->timestamp < m_syncStart.timestamp) {
+      continue;
+    }
 
-      if (!block.is_initialized()) {
-        continue;
-      }
+    TransactionBlockInfo blockInfo;
+    blockInfo.height = startHeight + i;
+    blockInfo.timestamp = block->timestamp;
+    blockInfo.transactionIndex = 0; // position in block
 
-      // filter by syncStartTimestamp
-      if (m_syncStart.timestamp && block->timestamp < m_syncStart.timestamp) {
+    for (const auto& tx : blocks[i].transactions) {
+      auto pubKey = tx->getTransactionPublicKey();
+      if (pubKey == NULL_PUBLIC_KEY) {
+        ++blockInfo.transactionIndex;
         continue;
       }
 
-      TransactionBlockInfo blockInfo;
-      blockInfo.height = startHeight + i;
-      blockInfo.timestamp = block->timestamp;
-      blockInfo.transactionIndex = 0; // position in block
+      preprocessedTransactions.emplace_back();
+      preprocessedTransactions.back().blockInfo = blockInfo;
+      preprocessedTransactions.back().tx = tx.get();
+      ++blockInfo.transactionIndex;
+    }
+  }
 
-      for (const auto& tx : blocks[i].transactions) {
-        auto pubKey = tx->getTransactionPublicKey();
-        if (pubKey == NULL_PUBLIC_KEY) {
-          ++blockInfo.transactionIndex;
-          continue;
-        }
+  std::atomic<bool> stopProcessing(false);
+  std::mutex processingErrorMutex;
+  std::error_code processingError;
 
-        Tx item = { blockInfo, tx.get() };
-        inputQueue.push(item);
-        ++blockInfo.transactionIndex;
-      }
+  auto processingFunction = [&](size_t index) {
+    if (stopProcessing) {
+      return;
     }
 
-    inputQueue.close();
-  });
-
-  auto processingFunction = [&] {
-    Tx item;
+    PreprocessedTx& output = preprocessedTransactions[index];
     std::error_code ec;
-    while (!stopProcessing && inputQueue.pop(item)) {
-      PreprocessedTx output;
-      static_cast<Tx&>(output) = item;
-
-      ec = preprocessOutputs(item.blockInfo, *item.tx, output);
-      if (ec) {
-        stopProcessing = true;
-        break;
-      }
-
-      std::lock_guard<std::mutex> lk(preprocessedTransactionsMutex);
-      preprocessedTransactions.push_back(std::move(output));
+    try {
+      ec = preprocessOutputs(output.blockInfo, *output.tx, output);
+    } catch (const std::system_error& e) {
+      ec = e.code();
+    } catch (const std::exception&) {
+      ec = std::make_error_code(std::errc::operation_canceled);
     }
-    return ec;
-  };
 
-  std::vector<std::future<std::error_code>> processingThreads;
-  for (size_t i = 0; i < workers; ++i) {
-    processingThreads.push_back(std::async(std::launch::async, processingFunction));
-  }
+    if (ec) {
+      stopProcessing = true;
 
-  std::error_code processingError;
-  for (auto& f : processingThreads) {
-    try {
-      std::error_code ec = f.get();
-      if (!processingError && ec) {
+      std::lock_guard<std::mutex> lk(processingErrorMutex);
+      if (!processingError) {
         processingError = ec;
       }
-    } catch (const std::system_error& e) {
-      processingError = e.code();
-    } catch (const std::exception&) {
-      processingError = std::make_error_code(std::errc::operation_canceled);
     }
+  };
+
+  // a block or two are processed on this thread, handing them to the pool would cost more than it saves
+  Tools::WorkerPool& pool = preprocessingPool();
+  size_t workers = std::min(pool.threadCount() + 1, preprocessedTransactions.size() / MIN_TRANSACTIONS_PER_WORKER);
+  if (workers <= 1) {
+    for (size_t i = 0; i < preprocessedTransactions.size(); ++i) {
+      processingFunction(i);
+    }
+  } else {
+    pool.parallelFor(preprocessedTransactions.size(), workers - 1, processingFunction);
   }
 
   std::vector<Crypto::Hash> blockHashes = getBlockHashes(blocks, count);
   if (!processingError) {
     m_observerManager.notify(&IBlockchainConsumerObserver::onBlocksAdded, this, blockHashes);
 
-    // sort by block height and transaction index in block
-    std::sort(preprocessedTransactions.begin(), preprocessedTransactions.end(), [](const PreprocessedTx& a, const PreprocessedTx& b) {
-      return std::tie(a.blockInfo.height, a.blockInfo.transactionIndex) < std::tie(b.blockInfo.height, b.blockInfo.transactionIndex);
-    });
-
     for (const auto& tx : preprocessedTransactions) {
       processTransaction(tx.blockInfo, *tx.tx, tx);
     }
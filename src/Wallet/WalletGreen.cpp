@@ -32,6 +32,7 @@
 #include "CryptoNoteCore/CryptoNoteFormatUtils.h"
 #include "CryptoNoteCore/CryptoNoteTools.h"
 #include "CryptoNoteCore/TransactionApi.h"
+#include "CryptoNoteCore/TransactionExtra.h"
 #include "crypto/crypto.h"
 #include "Transfers/TransfersContainer.h"
 #include "WalletSerialization.h"
@@ -305,11 +306,14 @@ void WalletGreen::clearCaches() {
   m_unlockTransactionsJob.clear();
   m_transactions.clear();
   m_transfers.clear();
+  m_transactionPaymentIds.clear();
+  m_transactionAddresses.clear();
   m_uncommitedTransactions.clear();
   m_actualBalance = 0;
   m_pendingBalance = 0;
   m_fusionTxsCache.clear();
   m_blockchain.clear();
+  m_fileState = WalletFileState();
 }
 
 void WalletGreen::initWithKeys(const Crypto::PublicKey& viewPublicKey, const Crypto::SecretKey& viewSecretKey, const std::string& password) {
@@ -372,7 +376,46 @@ void WalletGreen::unsafeSave(std::ostream& destination, bool saveDetails, bool s
   );
 
   StdOutputStream output(destination);
-  s.save(m_password, output, saveDetails, saveCache);
+  s.save(m_password, output, saveDetails, saveCache, m_fileState);
+}
+
+bool WalletGreen::saveChanges(std::iostream& destination) {
+  throwIfNotInitialized();
+  throwIfStopped();
+
+  stopBlockchainSynchronizer();
+
+  bool saved = unsafeSaveChanges(destination);
+
+  startBlockchainSynchronizer();
+
+  return saved;
+}
+
+bool WalletGreen::unsafeSaveChanges(std::iostream& destination) {
+  WalletTransactions transactions;
+  WalletTransfers transfers;
+
+  filterOutTransactions(transactions, transfers, [] (const WalletTransaction& tx) {
+    return tx.state == WalletTransactionState::DELETED;
+  });
+
+  WalletSerializer s(
+    *this,
+    m_viewPublicKey,
+    m_viewSecretKey,
+    m_actualBalance,
+    m_pendingBalance,
+    m_walletsContainer,
+    m_synchronizer,
+    m_unlockTransactionsJob,
+    transactions,
+    transfers,
+    m_transactionSoftLockTime,
+    m_uncommitedTransactions
+  );
+
+  return s.saveChanges(destination, m_fileState);
 }
 
 void WalletGreen::load(std::istream& source, const std::string& password) {
@@ -439,7 +482,8 @@ void WalletGreen::unsafeLoad(std::istream& source, const std::string& password)
   );
 
   StdInputStream inputStream(source);
-  s.load(password, inputStream);
+  s.load(password, inputStream, m_fileState);
+  rebuildTransactionIndexes();
 
   m_password = password;
   m_blockchainSynchronizer.addObserver(this);
@@ -454,6 +498,8 @@ void WalletGreen::changePassword(const std::string& oldPassword, const std::stri
   }
 
   m_password = newPassword;
+  // the pages in the file are encrypted with the old password
+  m_fileState = WalletFileState();
 }
 
 size_t WalletGreen::getAddressCount() const {
@@ -1013,6 +1059,34 @@ void WalletGreen::pushBackOutgoingTransfers(size_t txId, const std::vector<Walle
   }
 }
 
+// Has to be called whenever the extra or the transfers of the transaction change
+void WalletGreen::indexTransaction(size_t transactionId) {
+  const WalletTransaction& transaction = m_transactions.get<RandomAccessIndex>()[transactionId];
+
+  m_transactionPaymentIds.get<TransactionIndex>().erase(transactionId);
+  Crypto::Hash paymentId;
+  if (getPaymentIdFromTxExtra(Common::asBinaryArray(transaction.extra), paymentId)) {
+    m_transactionPaymentIds.insert(TransactionPaymentId{ paymentId, transactionId });
+  }
+
+  auto bounds = getTransactionTransfersRange(transactionId);
+  for (auto it = bounds.first; it != bounds.second; ++it) {
+    if (!it->second.address.empty()) {
+      m_transactionAddresses.insert(TransactionAddress{ it->second.address, transactionId });
+    }
+  }
+}
+
+// The indexes aren't stored in the wallet file, they are made again from the loaded transactions and transfers
+void WalletGreen::rebuildTransactionIndexes() {
+  m_transactionPaymentIds.clear();
+  m_transactionAddresses.clear();
+
+  for (size_t transactionId = 0; transactionId < m_transactions.size(); ++transactionId) {
+    indexTransaction(transactionId);
+  }
+}
+
 size_t WalletGreen::insertOutgoingTransactionAndPushEvent(const Hash& transactionHash, uint64_t fee, const BinaryArray& extra, uint64_t unlockTimestamp, Crypto::SecretKey& txSecretKey) {
   WalletTransaction insertTx;
   insertTx.state = WalletTransactionState::CREATED;
@@ -1402,6 +1476,7 @@ size_t WalletGreen::validateSaveAndSendTransaction(const ITransactionReader& tra
 
   m_fusionTxsCache.emplace(transactionId, isFusion);
   pushBackOutgoingTransfers(transactionId, destinations);
+  indexTransaction(transactionId);
 
   addUnconfirmedTransaction(transaction);
   Tools::ScopeExit rollbackAddingUnconfirmedTransaction([this, &transaction] {
@@ -1672,15 +1747,11 @@ std::vector<TransactionsInBlockInfo> WalletGreen::getTransactions(const Crypto::
   throwIfNotInitialized();
   throwIfStopped();
 
-  auto& hashIndex = m_blockchain.get<BlockHashIndex>();
-  auto it = hashIndex.find(blockHash);
-  if (it == hashIndex.end()) {
+  uint32_t blockIndex;
+  if (!findBlockIndex(blockHash, blockIndex)) {
     return std::vector<TransactionsInBlockInfo>();
   }
 
-  auto heightIt = m_blockchain.project<BlockHeightIndex>(it);
-
-  uint32_t blockIndex = static_cast<uint32_t>(std::distance(m_blockchain.get<BlockHeightIndex>().begin(), heightIt));
   return getTransactionsInBlocks(blockIndex, count);
 }
 
@@ -1691,6 +1762,25 @@ std::vector<TransactionsInBlockInfo> WalletGreen::getTransactions(uint32_t block
   return getTransactionsInBlocks(blockIndex, count);
 }
 
+std::vector<TransactionsInBlockInfo> WalletGreen::getTransactions(const Crypto::Hash& blockHash, size_t count, const TransactionsFilter& filter) const {
+  throwIfNotInitialized();
+  throwIfStopped();
+
+  uint32_t blockIndex;
+  if (!findBlockIndex(blockHash, blockIndex)) {
+    return std::vector<TransactionsInBlockInfo>();
+  }
+
+  return getFilteredTransactionsInBlocks(blockIndex, count, filter);
+}
+
+std::vector<TransactionsInBlockInfo> WalletGreen::getTransactions(uint32_t blockIndex, size_t count, const TransactionsFilter& filter) const {
+  throwIfNotInitialized();
+  throwIfStopped();
+
+  return getFilteredTransactionsInBlocks(blockIndex, count, filter);
+}
+
 std::vector<Crypto::Hash> WalletGreen::getBlockHashes(uint32_t blockIndex, size_t count) const {
   throwIfNotInitialized();
   throwIfStopped();
@@ -1773,6 +1863,14 @@ void WalletGreen::stop() {
   m_eventOccurred.set();
 }
 
+void WalletGreen::setSyncPrefetchDepth(size_t depth) {
+  m_blockchainSynchronizer.setPrefetchDepth(depth);
+}
+
+BlockchainSynchronizerStatistics WalletGreen::getSyncStatistics() const {
+  return m_blockchainSynchronizer.getStatistics();
+}
+
 WalletEvent WalletGreen::getEvent() {
   throwIfNotInitialized();
   throwIfStopped();
@@ -1963,6 +2061,7 @@ void WalletGreen::transactionUpdated(const TransactionInformation& transactionIn
 
   updated |= updateTransactionTransfers(transactionId, containerAmountsList, -static_cast<int64_t>(transactionInfo.totalAmountIn),
     static_cast<int64_t>(transactionInfo.totalAmountOut));
+  indexTransaction(transactionId);
 
   if (isNew) {
     pushEvent(makeTransactionCreatedEvent(transactionId));
@@ -2441,6 +2540,91 @@ std::vector<TransactionsInBlockInfo> WalletGreen::getTransactionsInBlocks(uint32
   return result;
 }
 
+// The transactions are looked up in the payment ID or address index instead of going through all the transactions of
+// the blocks, a wallet polled for one payment ID over a long history only gets the transactions having it
+std::vector<TransactionsInBlockInfo> WalletGreen::getFilteredTransactionsInBlocks(uint32_t blockIndex, size_t count, const TransactionsFilter& filter) const {
+  if (count == 0) {
+    throw std::system_error(make_error_code(error::WRONG_PARAMETERS), "blocks count must be greater than zero");
+  }
+
+  std::vector<TransactionsInBlockInfo> result;
+
+  if (blockIndex >= m_blockchain.size()) {
+    return result;
+  }
+
+  std::vector<size_t> transactionIds;
+  if (filter.paymentId) {
+    auto range = m_transactionPaymentIds.get<TransactionPaymentIdIndex>().equal_range(*filter.paymentId);
+    for (auto it = range.first; it != range.second; ++it) {
+      transactionIds.push_back(it->transactionId);
+    }
+  } else if (!filter.addresses.empty()) {
+    for (const std::string& address: filter.addresses) {
+      auto range = m_transactionAddresses.get<TransactionAddressIndex>().equal_range(address);
+      for (auto it = range.first; it != range.second; ++it) {
+        transactionIds.push_back(it->transactionId);
+      }
+    }
+  } else {
+    for (auto& block: getTransactionsInBlocks(blockIndex, count)) {
+      if (!block.transactions.empty()) {
+        result.emplace_back(std::move(block));
+      }
+    }
+
+    return result;
+  }
+
+  uint32_t stopIndex = static_cast<uint32_t>(std::min(m_blockchain.size(), blockIndex + count));
+  auto& transactionIdIndex = m_transactions.get<RandomAccessIndex>();
+
+  // by block, the transactions of a block in the order the wallet got them
+  std::vector<std::pair<uint32_t, size_t>> transactions;
+  for (size_t transactionId: transactionIds) {
+    const WalletTransaction& transaction = transactionIdIndex[transactionId];
+    if (transaction.state == WalletTransactionState::SUCCEEDED && transaction.blockHeight >= blockIndex && transaction.blockHeight < stopIndex) {
+      transactions.emplace_back(transaction.blockHeight, transactionId);
+    }
+  }
+
+  std::sort(transactions.begin(), transactions.end());
+  transactions.erase(std::unique(transactions.begin(), transactions.end()), transactions.end());
+
+  std::unordered_set<std::string> addresses(filter.addresses.begin(), filter.addresses.end());
+  for (const auto& item: transactions) {
+    WalletTransactionWithTransfers transaction;
+    transaction.transaction = transactionIdIndex[item.second];
+    transaction.transfers = getTransactionTransfers(transactionIdIndex[item.second]);
+
+    if (!addresses.empty() && std::none_of(transaction.transfers.begin(), transaction.transfers.end(),
+      [&addresses](const WalletTransfer& transfer) { return addresses.count(transfer.address) != 0; })) {
+      continue;
+    }
+
+    if (result.empty() || result.back().blockHash != m_blockchain[item.first]) {
+      result.emplace_back();
+      result.back().blockHash = m_blockchain[item.first];
+    }
+
+    result.back().transactions.emplace_back(std::move(transaction));
+  }
+
+  return result;
+}
+
+bool WalletGreen::findBlockIndex(const Crypto::Hash& blockHash, uint32_t& blockIndex) const {
+  auto& hashIndex = m_blockchain.get<BlockHashIndex>();
+  auto it = hashIndex.find(blockHash);
+  if (it == hashIndex.end()) {
+    return false;
+  }
+
+  auto heightIt = m_blockchain.project<BlockHeightIndex>(it);
+  blockIndex = static_cast<uint32_t>(std::distance(m_blockchain.get<BlockHeightIndex>().begin(), heightIt));
+  return true;
+}
+
 Crypto::Hash WalletGreen::getBlockHashByIndex(uint32_t blockIndex) const {
   assert(blockIndex < m_blockchain.size());
   return m_blockchain.get<BlockHeightIndex>()[blockIndex];
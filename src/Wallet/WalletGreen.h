@@ -13,6 +13,7 @@
 
 #include "IFusionManager.h"
 #include "WalletIndexes.h"
+#include "WalletSerialization.h"
 
 #include <System/Dispatcher.h>
 #include <System/Event.h>
@@ -39,6 +40,7 @@ public:
 
   virtual void changePassword(const std::string& oldPassword, const std::string& newPassword) override;
   virtual void save(std::ostream& destination, bool saveDetails = true, bool saveCache = true) override;
+  virtual bool saveChanges(std::iostream& destination) override;
 
   virtual size_t getAddressCount() const override;
   virtual std::string getAddress(size_t index) const override;
@@ -65,6 +67,8 @@ public:
   virtual WalletTransactionWithTransfers getTransaction(const Crypto::Hash& transactionHash) const override;
   virtual std::vector<TransactionsInBlockInfo> getTransactions(const Crypto::Hash& blockHash, size_t count) const override;
   virtual std::vector<TransactionsInBlockInfo> getTransactions(uint32_t blockIndex, size_t count) const override;
+  virtual std::vector<TransactionsInBlockInfo> getTransactions(const Crypto::Hash& blockHash, size_t count, const TransactionsFilter& filter) const override;
+  virtual std::vector<TransactionsInBlockInfo> getTransactions(uint32_t blockIndex, size_t count, const TransactionsFilter& filter) const override;
   virtual std::vector<Crypto::Hash> getBlockHashes(uint32_t blockIndex, size_t count) const override;
   virtual uint32_t getBlockCount() const override;
   virtual std::vector<WalletTransactionWithTransfers> getUnconfirmedTransactions() const override;
@@ -84,6 +88,10 @@ public:
   virtual bool isFusionTransaction(size_t transactionId) const override;
   virtual IFusionManager::EstimateResult estimate(uint64_t threshold) const override;
 
+  // See BlockchainSynchronizer::setPrefetchDepth(), has to be called before the wallet is initialized or loaded
+  void setSyncPrefetchDepth(size_t depth);
+  BlockchainSynchronizerStatistics getSyncStatistics() const;
+
 protected:
   void throwIfNotInitialized() const;
   void throwIfStopped() const;
@@ -236,6 +244,8 @@ protected:
   bool eraseTransfersByAddress(size_t transactionId, size_t firstTransferIdx, const std::string& address, bool eraseOutputTransfers);
   bool eraseForeignTransfers(size_t transactionId, size_t firstTransferIdx, const std::unordered_set<std::string>& knownAddresses, bool eraseOutputTransfers);
   void pushBackOutgoingTransfers(size_t txId, const std::vector<WalletTransfer>& destinations);
+  void indexTransaction(size_t transactionId);
+  void rebuildTransactionIndexes();
   void insertUnlockTransactionJob(const Crypto::Hash& transactionHash, uint32_t blockHeight, CryptoNote::ITransfersContainer* container);
   void deleteUnlockTransactionJob(const Crypto::Hash& transactionHash);
   void startBlockchainSynchronizer();
@@ -245,6 +255,7 @@ protected:
 
   void unsafeLoad(std::istream& source, const std::string& password);
   void unsafeSave(std::ostream& destination, bool saveDetails, bool saveCache);
+  bool unsafeSaveChanges(std::iostream& destination);
 
   std::vector<OutputToTransfer> pickRandomFusionInputs(uint64_t threshold, size_t minInputCount, size_t maxInputCount);
   ReceiverAmounts decomposeFusionOutputs(uint64_t inputsAmount);
@@ -264,6 +275,8 @@ protected:
 
   TransfersRange getTransactionTransfersRange(size_t transactionIndex) const;
   std::vector<TransactionsInBlockInfo> getTransactionsInBlocks(uint32_t blockIndex, size_t count) const;
+  std::vector<TransactionsInBlockInfo> getFilteredTransactionsInBlocks(uint32_t blockIndex, size_t count, const TransactionsFilter& filter) const;
+  bool findBlockIndex(const Crypto::Hash& blockHash, uint32_t& blockIndex) const;
   Crypto::Hash getBlockHashByIndex(uint32_t blockIndex) const;
 
   std::vector<WalletTransfer> getTransactionTransfers(const WalletTransaction& transaction) const;
@@ -288,6 +301,8 @@ protected:
   UnlockTransactionJobs m_unlockTransactionsJob;
   WalletTransactions m_transactions;
   WalletTransfers m_transfers; //sorted
+  TransactionPaymentIds m_transactionPaymentIds;
+  TransactionAddresses m_transactionAddresses;
   mutable std::unordered_map<size_t, bool> m_fusionTxsCache; // txIndex -> isFusion
   UncommitedTransactions m_uncommitedTransactions;
 
@@ -302,6 +317,7 @@ protected:
   WalletState m_state;
 
   std::string m_password;
+  WalletFileState m_fileState;
 
   Crypto::PublicKey m_viewPublicKey;
   Crypto::SecretKey m_viewSecretKey;
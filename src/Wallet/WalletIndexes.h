@@ -44,6 +44,9 @@ struct TransactionHashIndex {};
 struct TransactionIndex {};
 struct BlockHashIndex {};
 
+struct TransactionPaymentIdIndex {};
+struct TransactionAddressIndex {};
+
 typedef boost::multi_index_container <
   WalletRecord,
   boost::multi_index::indexed_by <
@@ -90,6 +93,47 @@ typedef std::pair<size_t, CryptoNote::WalletTransfer> TransactionTransferPair;
 typedef std::vector<TransactionTransferPair> WalletTransfers;
 typedef std::map<size_t, CryptoNote::Transaction> UncommitedTransactions;
 
+struct TransactionPaymentId {
+  Crypto::Hash paymentId;
+  size_t transactionId;
+};
+
+// The payment ID found in the extra of a transaction
+typedef boost::multi_index_container <
+  TransactionPaymentId,
+  boost::multi_index::indexed_by <
+    boost::multi_index::hashed_non_unique < boost::multi_index::tag <TransactionPaymentIdIndex>,
+      BOOST_MULTI_INDEX_MEMBER(TransactionPaymentId, Crypto::Hash, paymentId)
+    >,
+    boost::multi_index::hashed_unique < boost::multi_index::tag <TransactionIndex>,
+      BOOST_MULTI_INDEX_MEMBER(TransactionPaymentId, size_t, transactionId)
+    >
+  >
+> TransactionPaymentIds;
+
+struct TransactionAddress {
+  std::string address;
+  size_t transactionId;
+};
+
+// Addresses a transaction has or had transfers for. Entries are not removed when transfers are, so the transfers of
+// the transaction have to be checked.
+typedef boost::multi_index_container <
+  TransactionAddress,
+  boost::multi_index::indexed_by <
+    boost::multi_index::hashed_non_unique < boost::multi_index::tag <TransactionAddressIndex>,
+      BOOST_MULTI_INDEX_MEMBER(TransactionAddress, std::string, address)
+    >,
+    boost::multi_index::hashed_unique < boost::multi_index::tag <TransactionIndex>,
+      boost::multi_index::composite_key <
+        TransactionAddress,
+        BOOST_MULTI_INDEX_MEMBER(TransactionAddress, std::string, address),
+        BOOST_MULTI_INDEX_MEMBER(TransactionAddress, size_t, transactionId)
+      >
+    >
+  >
+> TransactionAddresses;
+
 typedef boost::multi_index_container<
   Crypto::Hash,
   boost::multi_index::indexed_by <
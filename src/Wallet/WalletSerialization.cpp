@@ -6,6 +6,9 @@
 
 #include "WalletSerialization.h"
 
+#include <algorithm>
+#include <cstring>
+#include <functional>
 #include <string>
 #include <sstream>
 #include <type_traits>
@@ -13,6 +16,8 @@
 #include "Common/MemoryInputStream.h"
 #include "Common/StdInputStream.h"
 #include "Common/StdOutputStream.h"
+#include "Common/StreamTools.h"
+#include "Common/StringOutputStream.h"
 #include "CryptoNoteCore/CryptoNoteSerialization.h"
 #include "CryptoNoteCore/CryptoNoteTools.h"
 
@@ -167,19 +172,7 @@ void serialize(WalletTransferDto& value, CryptoNote::ISerializer& serializer) {
   }
 }
 
-template <typename Object>
-std::string serialize(Object& obj, const std::string& name) {
-  std::stringstream stream;
-  StdOutputStream output(stream);
-  CryptoNote::BinaryOutputStreamSerializer s(output);
-
-  s(obj, Common::StringView(name));
-
-  stream.flush();
-  return stream.str();
-}
-
-std::string encrypt(const std::string& plain, CryptoNote::CryptoContext& cryptoContext) {
+std::string encrypt(const std::string& plain, const CryptoNote::CryptoContext& cryptoContext) {
   std::string cipher;
   cipher.resize(plain.size());
 
@@ -188,19 +181,6 @@ std::string encrypt(const std::string& plain, CryptoNote::CryptoContext& cryptoC
   return cipher;
 }
 
-void addToStream(const std::string& cipher, const std::string& name, Common::IOutputStream& destination) {
-  CryptoNote::BinaryOutputStreamSerializer s(destination);
-  s(const_cast<std::string& >(cipher), name);
-}
-
-template<typename Object>
-void serializeEncrypted(Object& obj, const std::string& name, CryptoNote::CryptoContext& cryptoContext, Common::IOutputStream& destination) {
-  std::string plain = serialize(obj, name);
-  std::string cipher = encrypt(plain, cryptoContext);
-
-  addToStream(cipher, name, destination);
-}
-
 std::string readCipher(Common::IInputStream& source, const std::string& name) {
   std::string cipher;
   CryptoNote::BinaryInputStreamSerializer s(source);
@@ -209,7 +189,7 @@ std::string readCipher(Common::IInputStream& source, const std::string& name) {
   return cipher;
 }
 
-std::string decrypt(const std::string& cipher, CryptoNote::CryptoContext& cryptoContext) {
+std::string decrypt(const std::string& cipher, const CryptoNote::CryptoContext& cryptoContext) {
   std::string plain;
   plain.resize(cipher.size());
 
@@ -274,11 +254,152 @@ CryptoNote::WalletTransfer convert(const CryptoNote::WalletLegacyTransfer& tr) {
   return mtr;
 }
 
+CryptoNote::WalletRecord convert(const WalletRecordDto& dto, bool firstWallet, bool& isTrackingMode) {
+  if (firstWallet) {
+    isTrackingMode = dto.spendSecretKey == CryptoNote::NULL_SECRET_KEY;
+  } else if ((isTrackingMode && dto.spendSecretKey != CryptoNote::NULL_SECRET_KEY) || (!isTrackingMode && dto.spendSecretKey == CryptoNote::NULL_SECRET_KEY)) {
+    throw std::system_error(make_error_code(CryptoNote::error::BAD_ADDRESS), "All addresses must be whether tracking or not");
+  }
+
+  if (dto.spendSecretKey != CryptoNote::NULL_SECRET_KEY) {
+    Crypto::PublicKey restoredPublicKey;
+    bool r = Crypto::secret_key_to_public_key(dto.spendSecretKey, restoredPublicKey);
+
+    if (!r || dto.spendPublicKey != restoredPublicKey) {
+      throw std::system_error(make_error_code(CryptoNote::error::WRONG_PASSWORD), "Restored spend public key doesn't correspond to secret key");
+    }
+  } else {
+    if (!Crypto::check_key(dto.spendPublicKey)) {
+      throw std::system_error(make_error_code(CryptoNote::error::WRONG_PASSWORD), "Public spend key is incorrect");
+    }
+  }
+
+  CryptoNote::WalletRecord wallet;
+  wallet.spendPublicKey = dto.spendPublicKey;
+  wallet.spendSecretKey = dto.spendSecretKey;
+  wallet.actualBalance = dto.actualBalance;
+  wallet.pendingBalance = dto.pendingBalance;
+  wallet.creationTimestamp = static_cast<time_t>(dto.creationTimestamp);
+
+  return wallet;
+}
+
+CryptoNote::WalletTransaction convert(const WalletTransactionDto& dto) {
+  CryptoNote::WalletTransaction tx;
+
+  tx.state = dto.state;
+  tx.timestamp = dto.timestamp;
+  tx.blockHeight = dto.blockHeight;
+  tx.hash = dto.hash;
+  tx.totalAmount = dto.totalAmount;
+  tx.fee = dto.fee;
+  tx.creationTime = dto.creationTime;
+  tx.unlockTime = dto.unlockTime;
+  tx.extra = dto.extra;
+  tx.isBase = false;
+  if (dto.secretKey)
+  {
+    tx.secretKey = reinterpret_cast<const Crypto::SecretKey&>(dto.secretKey.get());
+  }
+
+  return tx;
+}
+
+CryptoNote::WalletTransfer convert(const WalletTransferDto& dto) {
+  CryptoNote::WalletTransfer tr;
+
+  tr.address = dto.address;
+  tr.amount = dto.amount;
+
+  if (dto.version > 2) {
+    tr.type = static_cast<CryptoNote::WalletTransferType>(dto.type);
+  } else {
+    tr.type = CryptoNote::WalletTransferType::USUAL;
+  }
+
+  return tr;
+}
+
+// Since version 6 the file is a log of records. A page record holds a part of the wallet, encrypted on its own, and a
+// commit record ends a save. Pages of a type have the indexes [0, count) given by the last commit, a page read later
+// replaces the one with the same type and index. Records after the last commit are left from an unfinished save.
+enum class WalletRecordType : uint8_t {
+  PAGE = 1,
+  COMMIT = 2
+};
+
+enum class WalletPageType : uint8_t {
+  KEYS,
+  FLAGS,
+  WALLETS,
+  TRANSACTIONS,
+  TRANSFERS, // of the transactions of the transactions page with the same index
+  BALANCES,
+  TRANSFERS_SYNCHRONIZER,
+  UNLOCK_TRANSACTIONS_JOBS,
+  UNCOMMITED_TRANSACTIONS,
+  COUNT
+};
+
+const size_t WALLETS_PER_PAGE = 256;
+const size_t TRANSACTIONS_PER_PAGE = 256;
+const size_t TRANSFERS_SYNCHRONIZER_PAGE_SIZE = 64 * 1024;
+
+std::pair<uint8_t, uint64_t> pageKey(WalletPageType type, uint64_t index) {
+  return std::make_pair(static_cast<uint8_t>(type), index);
+}
+
+// Every page is encrypted with its own iv, the one of the file plus the iv counter of the page
+CryptoNote::CryptoContext pageCryptoContext(const CryptoNote::CryptoContext& fileCryptoContext, uint64_t ivCounter) {
+  CryptoNote::CryptoContext cryptoContext = fileCryptoContext;
+  uint64_t* i = reinterpret_cast<uint64_t*>(&cryptoContext.iv.data[0]);
+  *i += ivCounter;
+
+  return cryptoContext;
+}
+
+template<typename Writer>
+std::string writePage(Writer writer) {
+  std::string plain;
+  StringOutputStream stream(plain);
+  CryptoNote::BinaryOutputStreamSerializer s(stream);
+  writer(s);
+
+  return plain;
+}
+
+template<typename Reader>
+void readPage(const std::string& plain, Reader reader) {
+  MemoryInputStream stream(plain.data(), plain.size());
+  CryptoNote::BinaryInputStreamSerializer s(stream);
+  reader(s);
+}
+
+class CountingInputStream : public Common::IInputStream {
+public:
+  CountingInputStream(Common::IInputStream& source, uint64_t count) : m_source(source), m_count(count) {
+  }
+
+  size_t readSome(void* data, size_t size) override {
+    size_t read = m_source.readSome(data, size);
+    m_count += read;
+    return read;
+  }
+
+  uint64_t count() const {
+    return m_count;
+  }
+
+private:
+  Common::IInputStream& m_source;
+  uint64_t m_count;
+};
+
 }
 
 namespace CryptoNote {
 
-const uint32_t WalletSerializer::SERIALIZATION_VERSION = 5;
+const uint32_t WalletSerializer::SERIALIZATION_VERSION = 6;
 
 void CryptoContext::incIv() {
   uint64_t * i = reinterpret_cast<uint64_t *>(&iv.data[0]);
@@ -313,32 +434,131 @@ WalletSerializer::WalletSerializer(
   uncommitedTransactions(uncommitedTransactions)
 { }
 
-void WalletSerializer::save(const std::string& password, Common::IOutputStream& destination, bool saveDetails, bool saveCache) {
+struct WalletSerializer::PlainPage {
+  std::pair<uint8_t, uint64_t> key;
+  std::string data;
+};
+
+struct WalletSerializer::LoadedPage {
+  uint64_t ivCounter;
+  std::string cipher;
+  uint64_t size;
+};
+
+void WalletSerializer::save(const std::string& password, Common::IOutputStream& destination, bool saveDetails, bool saveCache, WalletFileState& fileState) {
+  fileState = WalletFileState();
   CryptoContext cryptoContext = generateCryptoContext(password);
 
-  CryptoNote::BinaryOutputStreamSerializer s(destination);
-  s.beginObject("wallet");
+  std::string header;
+  StringOutputStream headerStream(header);
+  saveVersion(headerStream);
+  saveIv(headerStream, cryptoContext.iv);
+  write(destination, header.data(), header.size());
+
+  std::vector<PlainPage> pages = makePages(saveDetails, saveCache);
+  uint64_t size = header.size();
+  uint64_t ivCounter = 0;
+  std::map<std::pair<uint8_t, uint64_t>, WalletFileState::Page> savedPages;
+  for (const PlainPage& page : pages) {
+    WalletFileState::Page savedPage;
+    savedPage.hash = cn_fast_hash(page.data.data(), page.data.size());
+    savedPage.size = savePage(page, ivCounter++, cryptoContext, destination);
+
+    savedPages[page.key] = savedPage;
+    size += savedPage.size;
+  }
+
+  uint64_t liveSize = size;
+  size += saveCommit(pages, ivCounter, destination);
 
-  saveVersion(destination);
-  saveIv(destination, cryptoContext.iv);
+  fileState.valid = true;
+  fileState.cryptoContext = cryptoContext;
+  fileState.nextIvCounter = ivCounter;
+  fileState.size = size;
+  fileState.liveSize = liveSize;
+  fileState.pages = std::move(savedPages);
+}
 
-  saveKeys(destination, cryptoContext);
-  saveWallets(destination, saveCache, cryptoContext);
-  saveFlags(saveDetails, saveCache, destination, cryptoContext);
+bool WalletSerializer::saveChanges(std::iostream& file, WalletFileState& fileState) {
+  if (!fileState.valid || fileState.size - fileState.liveSize > fileState.liveSize) {
+    return false;
+  }
 
-  if (saveDetails) {
-    saveTransactions(destination, cryptoContext);
-    saveTransfers(destination, cryptoContext);
+  file.clear();
+  file.seekg(0, std::ios::end);
+  if (!file || static_cast<uint64_t>(file.tellg()) != fileState.size) {
+    file.clear();
+    return false;
   }
 
-  if (saveCache) {
-    saveBalances(destination, saveCache, cryptoContext);
-    saveTransfersSynchronizer(destination, cryptoContext);
-    saveUnlockTransactionsJobs(destination, cryptoContext);
-    saveUncommitedTransactions(destination, cryptoContext);
+  file.seekg(0);
+  try {
+    StdInputStream input(file);
+    Crypto::chacha8_iv iv;
+    if (loadVersion(input) != SERIALIZATION_VERSION) {
+      return false;
+    }
+
+    loadIv(input, iv);
+    if (memcmp(&iv, &fileState.cryptoContext.iv, sizeof(iv)) != 0) {
+      return false;
+    }
+  } catch (std::exception&) {
+    file.clear();
+    return false;
   }
 
-  s.endObject();
+  std::vector<PlainPage> pages = makePages(true, true);
+
+  std::string records;
+  StringOutputStream recordsStream(records);
+  uint64_t ivCounter = fileState.nextIvCounter;
+  uint64_t liveSize = fileState.liveSize;
+  bool changed = pages.size() != fileState.pages.size();
+  std::map<std::pair<uint8_t, uint64_t>, WalletFileState::Page> savedPages;
+  for (const PlainPage& page : pages) {
+    Hash hash = cn_fast_hash(page.data.data(), page.data.size());
+    auto it = fileState.pages.find(page.key);
+    if (it != fileState.pages.end() && it->second.hash == hash) {
+      savedPages[page.key] = it->second;
+      continue;
+    }
+
+    WalletFileState::Page savedPage;
+    savedPage.hash = hash;
+    savedPage.size = savePage(page, ivCounter++, fileState.cryptoContext, recordsStream);
+
+    savedPages[page.key] = savedPage;
+    liveSize += savedPage.size;
+    changed = true;
+  }
+
+  if (!changed) {
+    return true;
+  }
+
+  for (const auto& page : fileState.pages) {
+    auto it = savedPages.find(page.first);
+    if (it == savedPages.end() || it->second.hash != page.second.hash) {
+      liveSize -= page.second.size;
+    }
+  }
+
+  saveCommit(pages, ivCounter, recordsStream);
+
+  file.seekp(0, std::ios::end);
+  file.write(records.data(), records.size());
+  file.flush();
+  if (!file) {
+    throw std::system_error(make_error_code(error::INTERNAL_WALLET_ERROR), "Failed to write the wallet file");
+  }
+
+  fileState.nextIvCounter = ivCounter;
+  fileState.size += records.size();
+  fileState.liveSize = liveSize;
+  fileState.pages = std::move(savedPages);
+
+  return true;
 }
 
 CryptoContext WalletSerializer::generateCryptoContext(const std::string& password) {
@@ -364,141 +584,186 @@ void WalletSerializer::saveIv(Common::IOutputStream& destination, Crypto::chacha
   s.binary(reinterpret_cast<void *>(&iv.data), sizeof(iv.data), "chacha_iv");
 }
 
-void WalletSerializer::saveKeys(Common::IOutputStream& destination, CryptoContext& cryptoContext) {
-  savePublicKey(destination, cryptoContext);
-  saveSecretKey(destination, cryptoContext);
-}
-
-void WalletSerializer::savePublicKey(Common::IOutputStream& destination, CryptoContext& cryptoContext) {
-  serializeEncrypted(m_viewPublicKey, "public_key", cryptoContext, destination);
-  cryptoContext.incIv();
-}
-
-void WalletSerializer::saveSecretKey(Common::IOutputStream& destination, CryptoContext& cryptoContext) {
-  serializeEncrypted(m_viewSecretKey, "secret_key", cryptoContext, destination);
-  cryptoContext.incIv();
-}
-
-void WalletSerializer::saveFlags(bool saveDetails, bool saveCache, Common::IOutputStream& destination, CryptoContext& cryptoContext) {
-  serializeEncrypted(saveDetails, "details", cryptoContext, destination);
-  cryptoContext.incIv();
+std::vector<WalletSerializer::PlainPage> WalletSerializer::makePages(bool saveDetails, bool saveCache) {
+  std::vector<PlainPage> pages;
+  auto addPage = [&pages](WalletPageType type, uint64_t index, std::string&& data) {
+    PlainPage page;
+    page.key = pageKey(type, index);
+    page.data = std::move(data);
+    pages.push_back(std::move(page));
+  };
+
+  addPage(WalletPageType::KEYS, 0, writePage([this](ISerializer& s) {
+    s(m_viewPublicKey, "public_key");
+    s(m_viewSecretKey, "secret_key");
+  }));
+
+  addPage(WalletPageType::FLAGS, 0, writePage([&saveDetails, &saveCache](ISerializer& s) {
+    s(saveDetails, "details");
+    s(saveCache, "cache");
+  }));
+
+  auto& wallets = m_walletsContainer.get<RandomAccessIndex>();
+  for (size_t first = 0; first < wallets.size(); first += WALLETS_PER_PAGE) {
+    size_t last = std::min(wallets.size(), first + WALLETS_PER_PAGE);
+    addPage(WalletPageType::WALLETS, first / WALLETS_PER_PAGE, writePage([&](ISerializer& s) {
+      uint64_t count = last - first;
+      s(count, "wallets_count");
+
+      for (size_t i = first; i < last; ++i) {
+        const WalletRecord& w = wallets[i];
+
+        WalletRecordDto dto;
+        dto.spendPublicKey = w.spendPublicKey;
+        dto.spendSecretKey = w.spendSecretKey;
+        dto.pendingBalance = saveCache ? w.pendingBalance : 0;
+        dto.actualBalance = saveCache ? w.actualBalance : 0;
+        dto.creationTimestamp = static_cast<uint64_t>(w.creationTimestamp);
+
+        s(dto, "");
+      }
+    }));
+  }
 
-  serializeEncrypted(saveCache, "cache", cryptoContext, destination);
-  cryptoContext.incIv();
-}
+  if (saveDetails) {
+    auto& transactions = m_transactions.get<RandomAccessIndex>();
+    auto transfer = m_transfers.begin();
+    for (size_t first = 0; first < transactions.size(); first += TRANSACTIONS_PER_PAGE) {
+      size_t last = std::min(transactions.size(), first + TRANSACTIONS_PER_PAGE);
+      addPage(WalletPageType::TRANSACTIONS, first / TRANSACTIONS_PER_PAGE, writePage([&](ISerializer& s) {
+        uint64_t count = last - first;
+        s(count, "transactions_count");
+
+        for (size_t i = first; i < last; ++i) {
+          WalletTransactionDto dto(transactions[i]);
+          s(dto, "");
+        }
+      }));
+
+      // transfers are sorted by transaction
+      auto transfersEnd = m_transfers.end();
+      if (last < transactions.size()) {
+        transfersEnd = std::find_if(transfer, m_transfers.end(), [last](const TransactionTransferPair& pair) { return pair.first >= last; });
+      }
 
-void WalletSerializer::saveWallets(Common::IOutputStream& destination, bool saveCache, CryptoContext& cryptoContext) {
-  auto& index = m_walletsContainer.get<RandomAccessIndex>();
+      addPage(WalletPageType::TRANSFERS, first / TRANSACTIONS_PER_PAGE, writePage([&](ISerializer& s) {
+        uint64_t count = std::distance(transfer, transfersEnd);
+        s(count, "transfers_count");
 
-  uint64_t count = index.size();
-  serializeEncrypted(count, "wallets_count", cryptoContext, destination);
-  cryptoContext.incIv();
+        for (auto it = transfer; it != transfersEnd; ++it) {
+          uint64_t txId = it->first;
+          WalletTransferDto dto(it->second, SERIALIZATION_VERSION);
 
-  for (const auto& w: index) {
-    WalletRecordDto dto;
-    dto.spendPublicKey = w.spendPublicKey;
-    dto.spendSecretKey = w.spendSecretKey;
-    dto.pendingBalance = saveCache ? w.pendingBalance : 0;
-    dto.actualBalance = saveCache ? w.actualBalance : 0;
-    dto.creationTimestamp = static_cast<uint64_t>(w.creationTimestamp);
+          s(txId, "transaction_id");
+          s(dto, "transfer");
+        }
+      }));
 
-    serializeEncrypted(dto, "", cryptoContext, destination);
-    cryptoContext.incIv();
+      transfer = transfersEnd;
+    }
   }
-}
 
-void WalletSerializer::saveBalances(Common::IOutputStream& destination, bool saveCache, CryptoContext& cryptoContext) {
-  uint64_t actual = saveCache ? m_actualBalance : 0;
-  uint64_t pending = saveCache ? m_pendingBalance : 0;
+  if (saveCache) {
+    addPage(WalletPageType::BALANCES, 0, writePage([this](ISerializer& s) {
+      s(m_actualBalance, "actual_balance");
+      s(m_pendingBalance, "pending_balance");
+    }));
+
+    // the synchronizer is saved as it is, its pages only split it
+    std::stringstream stream;
+    m_synchronizer.save(stream);
+    stream.flush();
+
+    std::string synchronizer = stream.str();
+    for (size_t offset = 0; offset < synchronizer.size(); offset += TRANSFERS_SYNCHRONIZER_PAGE_SIZE) {
+      addPage(WalletPageType::TRANSFERS_SYNCHRONIZER, offset / TRANSFERS_SYNCHRONIZER_PAGE_SIZE, synchronizer.substr(offset, TRANSFERS_SYNCHRONIZER_PAGE_SIZE));
+    }
 
-  serializeEncrypted(actual, "actual_balance", cryptoContext, destination);
-  cryptoContext.incIv();
+    addPage(WalletPageType::UNLOCK_TRANSACTIONS_JOBS, 0, writePage([this](ISerializer& s) {
+      auto& index = m_unlockTransactions.get<TransactionHashIndex>();
+      auto& wallets = m_walletsContainer.get<TransfersContainerIndex>();
 
-  serializeEncrypted(pending, "pending_balance", cryptoContext, destination);
-  cryptoContext.incIv();
-}
+      uint64_t jobsCount = index.size();
+      s(jobsCount, "unlock_transactions_jobs_count");
 
-void WalletSerializer::saveTransfersSynchronizer(Common::IOutputStream& destination, CryptoContext& cryptoContext) {
-  std::stringstream stream;
-  m_synchronizer.save(stream);
-  stream.flush();
+      for (const auto& j: index) {
+        auto containerIt = wallets.find(j.container);
+        assert(containerIt != wallets.end());
 
-  std::string plain = stream.str();
-  serializeEncrypted(plain, "transfers_synchronizer", cryptoContext, destination);
-  cryptoContext.incIv();
-}
+        auto rndIt = m_walletsContainer.project<RandomAccessIndex>(containerIt);
+        assert(rndIt != m_walletsContainer.get<RandomAccessIndex>().end());
 
-void WalletSerializer::saveUnlockTransactionsJobs(Common::IOutputStream& destination, CryptoContext& cryptoContext) {
-  auto& index = m_unlockTransactions.get<TransactionHashIndex>();
-  auto& wallets = m_walletsContainer.get<TransfersContainerIndex>();
+        UnlockTransactionJobDto dto;
+        dto.blockHeight = j.blockHeight;
+        dto.transactionHash = j.transactionHash;
+        dto.walletIndex = std::distance(m_walletsContainer.get<RandomAccessIndex>().begin(), rndIt);
 
-  uint64_t jobsCount = index.size();
-  serializeEncrypted(jobsCount, "unlock_transactions_jobs_count", cryptoContext, destination);
-  cryptoContext.incIv();
+        s(dto, "");
+      }
+    }));
 
-  for (const auto& j: index) {
-    auto containerIt = wallets.find(j.container);
-    assert(containerIt != wallets.end());
+    addPage(WalletPageType::UNCOMMITED_TRANSACTIONS, 0, writePage([this](ISerializer& s) {
+      s(uncommitedTransactions, "uncommited_transactions");
+    }));
+  }
 
-    auto rndIt = m_walletsContainer.project<RandomAccessIndex>(containerIt);
-    assert(rndIt != m_walletsContainer.get<RandomAccessIndex>().end());
+  return pages;
+}
 
-    uint64_t walletIndex = std::distance(m_walletsContainer.get<RandomAccessIndex>().begin(), rndIt);
+uint64_t WalletSerializer::savePage(const PlainPage& page, uint64_t ivCounter, const CryptoContext& cryptoContext, Common::IOutputStream& destination) {
+  std::string cipher = encrypt(page.data, pageCryptoContext(cryptoContext, ivCounter));
 
-    UnlockTransactionJobDto dto;
-    dto.blockHeight = j.blockHeight;
-    dto.transactionHash = j.transactionHash;
-    dto.walletIndex = walletIndex;
+  std::string record;
+  StringOutputStream stream(record);
+  BinaryOutputStreamSerializer s(stream);
 
-    serializeEncrypted(dto, "", cryptoContext, destination);
-    cryptoContext.incIv();
-  }
-}
+  uint8_t recordType = static_cast<uint8_t>(WalletRecordType::PAGE);
+  uint8_t pageType = page.key.first;
+  uint64_t pageIndex = page.key.second;
+  s(recordType, "record_type");
+  s(pageType, "page_type");
+  s(pageIndex, "page_index");
+  s(ivCounter, "iv_counter");
+  s(cipher, "page");
 
-void WalletSerializer::saveUncommitedTransactions(Common::IOutputStream& destination, CryptoContext& cryptoContext) {
-  serializeEncrypted(uncommitedTransactions, "uncommited_transactions", cryptoContext, destination);
+  write(destination, record.data(), record.size());
+  return record.size();
 }
 
-void WalletSerializer::saveTransactions(Common::IOutputStream& destination, CryptoContext& cryptoContext) {
-  uint64_t count = m_transactions.size();
-  serializeEncrypted(count, "transactions_count", cryptoContext, destination);
-  cryptoContext.incIv();
-
-  for (const auto& tx: m_transactions) {
-    WalletTransactionDto dto(tx);
-    serializeEncrypted(dto, "", cryptoContext, destination);
-    cryptoContext.incIv();
+uint64_t WalletSerializer::saveCommit(const std::vector<PlainPage>& pages, uint64_t nextIvCounter, Common::IOutputStream& destination) {
+  std::vector<uint64_t> pageCounts(static_cast<size_t>(WalletPageType::COUNT), 0);
+  for (const PlainPage& page : pages) {
+    pageCounts[page.key.first] = std::max(pageCounts[page.key.first], page.key.second + 1);
   }
-}
-
-void WalletSerializer::saveTransfers(Common::IOutputStream& destination, CryptoContext& cryptoContext) {
-  uint64_t count = m_transfers.size();
-  serializeEncrypted(count, "transfers_count", cryptoContext, destination);
-  cryptoContext.incIv();
 
-  for (const auto& kv: m_transfers) {
-    uint64_t txId = kv.first;
+  std::string record;
+  StringOutputStream stream(record);
+  BinaryOutputStreamSerializer s(stream);
 
-    WalletTransferDto tr(kv.second, SERIALIZATION_VERSION);
+  uint8_t recordType = static_cast<uint8_t>(WalletRecordType::COMMIT);
+  s(recordType, "record_type");
+  s(nextIvCounter, "next_iv_counter");
+  s(pageCounts, "page_counts");
 
-    serializeEncrypted(txId, "transaction_id", cryptoContext, destination);
-    cryptoContext.incIv();
-
-    serializeEncrypted(tr, "transfer", cryptoContext, destination);
-    cryptoContext.incIv();
-  }
+  write(destination, record.data(), record.size());
+  return record.size();
 }
 
-void WalletSerializer::load(const std::string& password, Common::IInputStream& source) {
+void WalletSerializer::load(const std::string& password, Common::IInputStream& source, WalletFileState& fileState) {
+  fileState = WalletFileState();
+
   CryptoNote::BinaryInputStreamSerializer s(source);
   s.beginObject("wallet");
 
-  uint32_t version = loadVersion(source);
+  CountingInputStream versionSource(source, 0);
+  uint32_t version = loadVersion(versionSource);
 
   CryptoNote::WALLET_LEGACY_SERIALIZATION_VERSION = version;
                                                           
   if (version > SERIALIZATION_VERSION) {
     throw std::system_error(make_error_code(error::WRONG_VERSION));
+  } else if (version == SERIALIZATION_VERSION) {
+    loadPagedWallet(source, password, versionSource.count(), fileState);
   } else if (version > 2) {
     loadWallet(source, password, version);
   } else {
@@ -564,6 +829,216 @@ void WalletSerializer::loadWallet(Common::IInputStream& source, const std::strin
   }
 }
 
+void WalletSerializer::loadPagedWallet(Common::IInputStream& source, const std::string& password, uint64_t offset, WalletFileState& fileState) {
+  CountingInputStream input(source, offset);
+
+  loadIv(input, fileState.cryptoContext.iv);
+  generateKey(password, fileState.cryptoContext.key);
+  fileState.liveSize = input.count();
+
+  std::map<std::pair<uint8_t, uint64_t>, LoadedPage> pages;
+  std::map<std::pair<uint8_t, uint64_t>, LoadedPage> uncommitedPages;
+  bool commited = false;
+  for (;;) {
+    uint64_t recordStart = input.count();
+    CryptoNote::BinaryInputStreamSerializer s(input);
+
+    try {
+      uint8_t recordType = 0;
+      s(recordType, "record_type");
+
+      if (recordType == static_cast<uint8_t>(WalletRecordType::PAGE)) {
+        uint8_t pageType = 0;
+        uint64_t pageIndex = 0;
+        LoadedPage page;
+        s(pageType, "page_type");
+        s(pageIndex, "page_index");
+        s(page.ivCounter, "iv_counter");
+        s(page.cipher, "page");
+        page.size = input.count() - recordStart;
+
+        uncommitedPages[std::make_pair(pageType, pageIndex)] = std::move(page);
+      } else if (recordType == static_cast<uint8_t>(WalletRecordType::COMMIT)) {
+        uint64_t nextIvCounter = 0;
+        std::vector<uint64_t> pageCounts;
+        s(nextIvCounter, "next_iv_counter");
+        s(pageCounts, "page_counts");
+
+        for (auto& page : uncommitedPages) {
+          pages[page.first] = std::move(page.second);
+        }
+
+        uncommitedPages.clear();
+
+        for (auto it = pages.begin(); it != pages.end();) {
+          if (it->first.first >= pageCounts.size() || it->first.second >= pageCounts[it->first.first]) {
+            it = pages.erase(it);
+          } else {
+            ++it;
+          }
+        }
+
+        commited = true;
+        fileState.nextIvCounter = nextIvCounter;
+        fileState.size = input.count();
+      } else {
+        break;
+      }
+    } catch (std::exception&) {
+      // the end of the file, or the records of a save that didn't finish
+      break;
+    }
+  }
+
+  if (!commited) {
+    throw std::system_error(make_error_code(error::INTERNAL_WALLET_ERROR), "Wallet file holds no saved wallet");
+  }
+
+  loadPages(pages, fileState);
+  fileState.valid = true;
+}
+
+void WalletSerializer::loadPages(const std::map<std::pair<uint8_t, uint64_t>, LoadedPage>& pages, WalletFileState& fileState) {
+  std::map<std::pair<uint8_t, uint64_t>, std::string> plainPages;
+  for (const auto& page : pages) {
+    std::string plain = decrypt(page.second.cipher, pageCryptoContext(fileState.cryptoContext, page.second.ivCounter));
+
+    WalletFileState::Page loadedPage;
+    loadedPage.hash = cn_fast_hash(plain.data(), plain.size());
+    loadedPage.size = page.second.size;
+
+    fileState.pages[page.first] = loadedPage;
+    fileState.liveSize += loadedPage.size;
+    plainPages[page.first] = std::move(plain);
+  }
+
+  // calls reader for every page of the type, in the order of their indexes
+  auto readPages = [&plainPages](WalletPageType type, std::function<void(ISerializer&)> reader) {
+    uint64_t index = 0;
+    for (auto it = plainPages.lower_bound(pageKey(type, 0)); it != plainPages.end() && it->first.first == static_cast<uint8_t>(type); ++it, ++index) {
+      if (it->first.second != index) {
+        throw std::system_error(make_error_code(error::INTERNAL_WALLET_ERROR), "Wallet file misses a page");
+      }
+
+      readPage(it->second, reader);
+    }
+
+    return index;
+  };
+
+  if (readPages(WalletPageType::KEYS, [this](ISerializer& s) {
+    s(m_viewPublicKey, "public_key");
+    s(m_viewSecretKey, "secret_key");
+  }) == 0) {
+    throw std::system_error(make_error_code(error::INTERNAL_WALLET_ERROR), "Wallet file misses the keys");
+  }
+
+  checkKeys();
+
+  auto& wallets = m_walletsContainer.get<RandomAccessIndex>();
+  bool isTrackingMode = false;
+  readPages(WalletPageType::WALLETS, [&](ISerializer& s) {
+    uint64_t count = 0;
+    s(count, "wallets_count");
+
+    for (uint64_t i = 0; i < count; ++i) {
+      WalletRecordDto dto;
+      s(dto, "");
+
+      WalletRecord wallet = convert(dto, wallets.empty(), isTrackingMode);
+      wallet.container = reinterpret_cast<CryptoNote::ITransfersContainer*>(wallets.size()); //dirty hack. container field must be unique
+      wallets.push_back(wallet);
+    }
+  });
+
+  subscribeWallets();
+
+  bool details = false;
+  bool cache = false;
+  readPages(WalletPageType::FLAGS, [&details, &cache](ISerializer& s) {
+    s(details, "details");
+    s(cache, "cache");
+  });
+
+  if (details) {
+    auto& transactions = m_transactions.get<RandomAccessIndex>();
+    readPages(WalletPageType::TRANSACTIONS, [&transactions](ISerializer& s) {
+      uint64_t count = 0;
+      s(count, "transactions_count");
+
+      for (uint64_t i = 0; i < count; ++i) {
+        WalletTransactionDto dto;
+        s(dto, "");
+
+        transactions.push_back(convert(dto));
+      }
+    });
+
+    readPages(WalletPageType::TRANSFERS, [this](ISerializer& s) {
+      uint64_t count = 0;
+      s(count, "transfers_count");
+
+      for (uint64_t i = 0; i < count; ++i) {
+        uint64_t txId = 0;
+        WalletTransferDto dto(SERIALIZATION_VERSION);
+        s(txId, "transaction_id");
+        s(dto, "transfer");
+
+        m_transfers.push_back(std::make_pair(txId, convert(dto)));
+      }
+    });
+  }
+
+  if (cache) {
+    readPages(WalletPageType::BALANCES, [this](ISerializer& s) {
+      s(m_actualBalance, "actual_balance");
+      s(m_pendingBalance, "pending_balance");
+    });
+
+    std::string synchronizer;
+    for (auto it = plainPages.lower_bound(pageKey(WalletPageType::TRANSFERS_SYNCHRONIZER, 0));
+      it != plainPages.end() && it->first.first == static_cast<uint8_t>(WalletPageType::TRANSFERS_SYNCHRONIZER); ++it) {
+      synchronizer += it->second;
+    }
+
+    std::stringstream stream(synchronizer);
+    synchronizer.clear();
+    m_synchronizer.load(stream);
+
+    auto& jobs = m_unlockTransactions.get<TransactionHashIndex>();
+    readPages(WalletPageType::UNLOCK_TRANSACTIONS_JOBS, [&jobs, &wallets](ISerializer& s) {
+      uint64_t jobsCount = 0;
+      s(jobsCount, "unlock_transactions_jobs_count");
+
+      for (uint64_t i = 0; i < jobsCount; ++i) {
+        UnlockTransactionJobDto dto;
+        s(dto, "");
+
+        assert(dto.walletIndex < wallets.size());
+
+        UnlockTransactionJob job;
+        job.blockHeight = dto.blockHeight;
+        job.transactionHash = dto.transactionHash;
+        job.container = wallets[dto.walletIndex].container;
+
+        jobs.insert(std::move(job));
+      }
+    });
+
+    readPages(WalletPageType::UNCOMMITED_TRANSACTIONS, [this](ISerializer& s) {
+      s(uncommitedTransactions, "uncommited_transactions");
+    });
+
+    initTransactionPool();
+  } else {
+    resetCachedBalance();
+  }
+
+  if (details && cache) {
+    updateTransactionsBaseStatus();
+  }
+}
+
 void WalletSerializer::loadWalletV1(Common::IInputStream& source, const std::string& password) {
   CryptoNote::CryptoContext cryptoContext;
 
@@ -674,38 +1149,14 @@ void WalletSerializer::loadWallets(Common::IInputStream& source, CryptoContext&
   deserializeEncrypted(count, "wallets_count", cryptoContext, source);
   cryptoContext.incIv();
 
-  bool isTrackingMode;
+  bool isTrackingMode = false;
 
   for (uint64_t i = 0; i < count; ++i) {
     WalletRecordDto dto;
     deserializeEncrypted(dto, "", cryptoContext, source);
     cryptoContext.incIv();
 
-    if (i == 0) {
-      isTrackingMode = dto.spendSecretKey == NULL_SECRET_KEY;
-    } else if ((isTrackingMode && dto.spendSecretKey != NULL_SECRET_KEY) || (!isTrackingMode && dto.spendSecretKey == NULL_SECRET_KEY)) {
-      throw std::system_error(make_error_code(error::BAD_ADDRESS), "All addresses must be whether tracking or not");
-    }
-
-    if (dto.spendSecretKey != NULL_SECRET_KEY) {
-      Crypto::PublicKey restoredPublicKey;
-      bool r = Crypto::secret_key_to_public_key(dto.spendSecretKey, restoredPublicKey);
-
-      if (!r || dto.spendPublicKey != restoredPublicKey) {
-        throw std::system_error(make_error_code(error::WRONG_PASSWORD), "Restored spend public key doesn't correspond to secret key");
-      }
-    } else {
-      if (!Crypto::check_key(dto.spendPublicKey)) {
-        throw std::system_error(make_error_code(error::WRONG_PASSWORD), "Public spend key is incorrect");
-      }
-    }
-
-    WalletRecord wallet;
-    wallet.spendPublicKey = dto.spendPublicKey;
-    wallet.spendSecretKey = dto.spendSecretKey;
-    wallet.actualBalance = dto.actualBalance;
-    wallet.pendingBalance = dto.pendingBalance;
-    wallet.creationTimestamp = static_cast<time_t>(dto.creationTimestamp);
+    WalletRecord wallet = convert(dto, i == 0, isTrackingMode);
     wallet.container = reinterpret_cast<CryptoNote::ITransfersContainer*>(i); //dirty hack. container field must be unique
 
     index.push_back(wallet);
@@ -868,22 +1319,7 @@ void WalletSerializer::loadTransactions(Common::IInputStream& source, CryptoCont
     deserializeEncrypted(dto, "", cryptoContext, source);
     cryptoContext.incIv();
 
-    WalletTransaction tx;
-    tx.state = dto.state;
-    tx.timestamp = dto.timestamp;
-    tx.blockHeight = dto.blockHeight;
-    tx.hash = dto.hash;
-    tx.totalAmount = dto.totalAmount;
-    tx.fee = dto.fee;
-    tx.creationTime = dto.creationTime;
-    tx.unlockTime = dto.unlockTime;
-    tx.extra = dto.extra;
-    tx.isBase = false;
-    if (dto.secretKey)
-    {
-      tx.secretKey = reinterpret_cast<const Crypto::SecretKey&>(dto.secretKey.get());
-    }
-
+    WalletTransaction tx = convert(dto);
     m_transactions.get<RandomAccessIndex>().push_back(std::move(tx));
   }
 }
@@ -904,15 +1340,7 @@ void WalletSerializer::loadTransfers(Common::IInputStream& source, CryptoContext
     deserializeEncrypted(dto, "transfer", cryptoContext, source);
     cryptoContext.incIv();
 
-    WalletTransfer tr;
-    tr.address = dto.address;
-    tr.amount = dto.amount;
-
-    if (version > 2) {
-      tr.type = static_cast<WalletTransferType>(dto.type);
-    } else {
-      tr.type = WalletTransferType::USUAL;
-    }
+    WalletTransfer tr = convert(dto);
 
     m_transfers.push_back(std::make_pair(txId, tr));
   }
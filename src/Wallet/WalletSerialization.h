@@ -5,6 +5,9 @@
 
 #pragma once
 
+#include <iostream>
+#include <map>
+
 #include "IWallet.h"
 #include "WalletIndexes.h"
 #include "Common/IInputStream.h"
@@ -23,6 +26,21 @@ struct CryptoContext {
   void incIv();
 };
 
+// The pages of a wallet file as it was last written or read, so that a later save appends only the pages that changed
+struct WalletFileState {
+  struct Page {
+    Crypto::Hash hash; // of the plain page
+    uint64_t size;     // of the record holding it in the file
+  };
+
+  bool valid = false;
+  CryptoContext cryptoContext; // the iv is the one of the file, pages are encrypted with it plus their iv counter
+  uint64_t nextIvCounter = 0;
+  uint64_t size = 0;           // up to the end of the last commit
+  uint64_t liveSize = 0;       // of the header and the pages in use
+  std::map<std::pair<uint8_t, uint64_t>, Page> pages;
+};
+
 class WalletSerializer {
 public:
   WalletSerializer(
@@ -40,30 +58,34 @@ public:
     UncommitedTransactions& uncommitedTransactions
   );
   
-  void save(const std::string& password, Common::IOutputStream& destination, bool saveDetails, bool saveCache);
-  void load(const std::string& password, Common::IInputStream& source);
+  // Writes the whole file, fileState is set to describe it
+  void save(const std::string& password, Common::IOutputStream& destination, bool saveDetails, bool saveCache, WalletFileState& fileState);
+  // Appends the pages that changed since fileState was taken to the file it describes, with details and cache.
+  // Returns false without writing if file isn't that file or holds mostly replaced pages, then it has to be saved whole.
+  bool saveChanges(std::iostream& file, WalletFileState& fileState);
+  // fileState is left invalid for files of earlier versions
+  void load(const std::string& password, Common::IInputStream& source, WalletFileState& fileState);
 
 private:
   static const uint32_t SERIALIZATION_VERSION;
 
+  struct PlainPage;
+  struct LoadedPage;
+
   void loadWallet(Common::IInputStream& source, const std::string& password, uint32_t version);
   void loadWalletV1(Common::IInputStream& source, const std::string& password);
+  // offset is the position of source in the file
+  void loadPagedWallet(Common::IInputStream& source, const std::string& password, uint64_t offset, WalletFileState& fileState);
 
   CryptoContext generateCryptoContext(const std::string& password);
 
   void saveVersion(Common::IOutputStream& destination);
   void saveIv(Common::IOutputStream& destination, Crypto::chacha8_iv& iv);
-  void saveKeys(Common::IOutputStream& destination, CryptoContext& cryptoContext);
-  void savePublicKey(Common::IOutputStream& destination, CryptoContext& cryptoContext);
-  void saveSecretKey(Common::IOutputStream& destination, CryptoContext& cryptoContext);
-  void saveFlags(bool saveDetails, bool saveCache, Common::IOutputStream& destination, CryptoContext& cryptoContext);
-  void saveWallets(Common::IOutputStream& destination, bool saveCache, CryptoContext& cryptoContext);
-  void saveBalances(Common::IOutputStream& destination, bool saveCache, CryptoContext& cryptoContext);
-  void saveTransfersSynchronizer(Common::IOutputStream& destination, CryptoContext& cryptoContext);
-  void saveUnlockTransactionsJobs(Common::IOutputStream& destination, CryptoContext& cryptoContext);
-  void saveUncommitedTransactions(Common::IOutputStream& destination, CryptoContext& cryptoContext);
-  void saveTransactions(Common::IOutputStream& destination, CryptoContext& cryptoContext);
-  void saveTransfers(Common::IOutputStream& destination, CryptoContext& cryptoContext);
+  std::vector<PlainPage> makePages(bool saveDetails, bool saveCache);
+  uint64_t savePage(const PlainPage& page, uint64_t ivCounter, const CryptoContext& cryptoContext, Common::IOutputStream& destination);
+  uint64_t saveCommit(const std::vector<PlainPage>& pages, uint64_t nextIvCounter, Common::IOutputStream& destination);
+
+  void loadPages(const std::map<std::pair<uint8_t, uint64_t>, LoadedPage>& pages, WalletFileState& fileState);
 
   uint32_t loadVersion(Common::IInputStream& source);
   void loadIv(Common::IInputStream& source, Crypto::chacha8_iv& iv);
@@ -0,0 +1,388 @@
+// Copyright (c) 2018-2022 The Cash2 developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blake2b-nonce.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "Common/int-util.h"
+
+#if defined(__x86_64__) || (defined(_MSC_VER) && defined(_WIN64))
+#define BLAKE2B_NONCE_SIMD
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define BLAKE2B_TARGET(x)
+#else
+#define BLAKE2B_TARGET(x) __attribute__((target(x)))
+#endif
+#endif
+
+namespace Crypto {
+
+namespace {
+
+  const uint64_t IV[8] = {
+    0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL,
+    0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+    0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL,
+    0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
+  };
+
+  const uint8_t SIGMA[12][16] = {
+    {  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
+    { 14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3 },
+    { 11,  8, 12,  0,  5,  2, 15, 13, 10, 14,  3,  6,  7,  1,  9,  4 },
+    {  7,  9,  3,  1, 13, 12, 11, 14,  2,  6,  5, 10,  4,  0, 15,  8 },
+    {  9,  0,  5,  7,  2,  4, 10, 15, 14,  1, 11, 12,  6,  8,  3, 13 },
+    {  2, 12,  6, 10,  0, 11,  8,  3,  4, 13,  7,  5, 15, 14,  1,  9 },
+    { 12,  5,  1, 15, 14, 13,  4, 10,  0,  7,  6,  3,  9,  2,  8, 11 },
+    { 13, 11,  7, 14, 12,  1,  3,  9,  5,  0, 15,  4,  8,  6,  2, 10 },
+    {  6, 15, 14,  9, 11,  3,  0,  8, 12,  2, 13,  7,  1,  4, 10,  5 },
+    { 10,  2,  8,  4,  7,  6,  1,  5, 15, 11,  9, 14,  3, 12, 13,  0 },
+    {  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
+    { 14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3 }
+  };
+
+  // parameter block of unkeyed blake2b with a 32 byte digest, xored into the first state word
+  const uint64_t PARAMETERS = 0x01010020;
+
+  const size_t WORDS = 16;
+  const size_t SCALAR_LANES = 4;
+  const size_t SSE41_LANES = 4;
+  const size_t AVX2_LANES = 8;
+
+  // The kernels share the compression function below, each defines ADD, XOR and the rotations for its lane type.
+  // v is the working state and m the message, both arrays of 16 lane words.
+#define BLAKE2B_G(r, i, a, b, c, d)                  \
+  do {                                               \
+    a = ADD(ADD(a, b), m[SIGMA[r][2 * i + 0]]);      \
+    d = ROR32(XOR(d, a));                            \
+    c = ADD(c, d);                                   \
+    b = ROR24(XOR(b, c));                            \
+    a = ADD(ADD(a, b), m[SIGMA[r][2 * i + 1]]);      \
+    d = ROR16(XOR(d, a));                            \
+    c = ADD(c, d);                                   \
+    b = ROR63(XOR(b, c));                            \
+  } while (0)
+
+#define BLAKE2B_ROUND(r)                             \
+  do {                                               \
+    BLAKE2B_G(r, 0, v[ 0], v[ 4], v[ 8], v[12]);     \
+    BLAKE2B_G(r, 1, v[ 1], v[ 5], v[ 9], v[13]);     \
+    BLAKE2B_G(r, 2, v[ 2], v[ 6], v[10], v[14]);     \
+    BLAKE2B_G(r, 3, v[ 3], v[ 7], v[11], v[15]);     \
+    BLAKE2B_G(r, 4, v[ 0], v[ 5], v[10], v[15]);     \
+    BLAKE2B_G(r, 5, v[ 1], v[ 6], v[11], v[12]);     \
+    BLAKE2B_G(r, 6, v[ 2], v[ 7], v[ 8], v[13]);     \
+    BLAKE2B_G(r, 7, v[ 3], v[ 4], v[ 9], v[14]);     \
+  } while (0)
+
+#define BLAKE2B_COMPRESS()                           \
+  do {                                               \
+    BLAKE2B_ROUND(0);                                \
+    BLAKE2B_ROUND(1);                                \
+    BLAKE2B_ROUND(2);                                \
+    BLAKE2B_ROUND(3);                                \
+    BLAKE2B_ROUND(4);                                \
+    BLAKE2B_ROUND(5);                                \
+    BLAKE2B_ROUND(6);                                \
+    BLAKE2B_ROUND(7);                                \
+    BLAKE2B_ROUND(8);                                \
+    BLAKE2B_ROUND(9);                                \
+    BLAKE2B_ROUND(10);                               \
+    BLAKE2B_ROUND(11);                               \
+  } while (0)
+
+  inline uint64_t rotateRight(uint64_t x, unsigned bits) {
+    return (x >> bits) | (x << (64 - bits));
+  }
+
+  // Initial working state of the only (and last) block of a size byte message.
+  void initialState(uint64_t size, uint64_t state[WORDS]) {
+    for (size_t i = 0; i < 8; ++i) {
+      state[i] = IV[i];
+      state[i + 8] = IV[i];
+    }
+
+    state[0] ^= PARAMETERS;
+    state[12] ^= size;
+    state[14] = ~state[14];
+  }
+
+  // The target check: the hash is read as a big endian number, so its first word is byte swapped.
+  bool finishLane(uint64_t h0, uint64_t h1, uint64_t h2, uint64_t h3, uint64_t prefixLimit, Hash& hash) {
+    if (swap64(h0) > prefixLimit) {
+      return false;
+    }
+
+    uint64_t words[4] = { swap64le(h0), swap64le(h1), swap64le(h2), swap64le(h3) };
+    memcpy(&hash, words, sizeof(words));
+    return true;
+  }
+
+  uint32_t hashScalar(const uint64_t message[WORDS], size_t nonceWord, uint64_t size, uint64_t firstNonce, uint64_t nonceStep, uint64_t prefixLimit, Hash* hashes) {
+#define ADD(a, b) ((a) + (b))
+#define XOR(a, b) ((a) ^ (b))
+#define ROR32(x) rotateRight(x, 32)
+#define ROR24(x) rotateRight(x, 24)
+#define ROR16(x) rotateRight(x, 16)
+#define ROR63(x) rotateRight(x, 63)
+    uint64_t initial[WORDS];
+    initialState(size, initial);
+
+    uint64_t m[WORDS];
+    memcpy(m, message, sizeof(m));
+
+    uint32_t found = 0;
+    for (size_t lane = 0; lane < SCALAR_LANES; ++lane) {
+      m[nonceWord] = firstNonce + lane * nonceStep;
+
+      uint64_t v[WORDS];
+      memcpy(v, initial, sizeof(v));
+      BLAKE2B_COMPRESS();
+
+      if (finishLane(initial[0] ^ v[0] ^ v[8], initial[1] ^ v[1] ^ v[9], initial[2] ^ v[2] ^ v[10], initial[3] ^ v[3] ^ v[11], prefixLimit, hashes[lane])) {
+        found |= 1u << lane;
+      }
+    }
+
+    return found;
+#undef ADD
+#undef XOR
+#undef ROR32
+#undef ROR24
+#undef ROR16
+#undef ROR63
+  }
+
+#ifdef BLAKE2B_NONCE_SIMD
+
+  BLAKE2B_TARGET("sse4.1")
+  uint32_t hashSse41(const uint64_t message[WORDS], size_t nonceWord, uint64_t size, uint64_t firstNonce, uint64_t nonceStep, uint64_t prefixLimit, Hash* hashes) {
+#define ADD(a, b) _mm_add_epi64(a, b)
+#define XOR(a, b) _mm_xor_si128(a, b)
+#define ROR32(x) _mm_shuffle_epi32(x, _MM_SHUFFLE(2, 3, 0, 1))
+#define ROR24(x) _mm_shuffle_epi8(x, rotate24)
+#define ROR16(x) _mm_shuffle_epi8(x, rotate16)
+#define ROR63(x) _mm_xor_si128(_mm_srli_epi64(x, 63), _mm_add_epi64(x, x))
+    const __m128i rotate24 = _mm_setr_epi8(3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10);
+    const __m128i rotate16 = _mm_setr_epi8(2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9);
+
+    uint64_t initial[WORDS];
+    initialState(size, initial);
+
+    __m128i m[WORDS];
+    for (size_t i = 0; i < WORDS; ++i) {
+      m[i] = _mm_set1_epi64x(message[i]);
+    }
+
+    // two lanes per register, the registers are hashed one after the other to keep the state in registers
+    uint32_t found = 0;
+    for (size_t lane = 0; lane < SSE41_LANES; lane += 2) {
+      uint64_t nonce = firstNonce + lane * nonceStep;
+      m[nonceWord] = _mm_set_epi64x(nonce + nonceStep, nonce);
+
+      __m128i v[WORDS];
+      for (size_t i = 0; i < WORDS; ++i) {
+        v[i] = _mm_set1_epi64x(initial[i]);
+      }
+
+      BLAKE2B_COMPRESS();
+
+      uint64_t h[4][2];
+      for (size_t i = 0; i < 4; ++i) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(h[i]), _mm_xor_si128(_mm_set1_epi64x(initial[i]), _mm_xor_si128(v[i], v[i + 8])));
+      }
+
+      for (size_t i = 0; i < 2; ++i) {
+        if (finishLane(h[0][i], h[1][i], h[2][i], h[3][i], prefixLimit, hashes[lane + i])) {
+          found |= 1u << (lane + i);
+        }
+      }
+    }
+
+    return found;
+#undef ADD
+#undef XOR
+#undef ROR32
+#undef ROR24
+#undef ROR16
+#undef ROR63
+  }
+
+  BLAKE2B_TARGET("avx2")
+  uint32_t hashAvx2(const uint64_t message[WORDS], size_t nonceWord, uint64_t size, uint64_t firstNonce, uint64_t nonceStep, uint64_t prefixLimit, Hash* hashes) {
+#define ADD(a, b) _mm256_add_epi64(a, b)
+#define XOR(a, b) _mm256_xor_si256(a, b)
+#define ROR32(x) _mm256_shuffle_epi32(x, _MM_SHUFFLE(2, 3, 0, 1))
+#define ROR24(x) _mm256_shuffle_epi8(x, rotate24)
+#define ROR16(x) _mm256_shuffle_epi8(x, rotate16)
+#define ROR63(x) _mm256_xor_si256(_mm256_srli_epi64(x, 63), _mm256_add_epi64(x, x))
+    const __m256i rotate24 = _mm256_setr_epi8(3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10,
+                                              3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10);
+    const __m256i rotate16 = _mm256_setr_epi8(2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9,
+                                              2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9);
+
+    uint64_t initial[WORDS];
+    initialState(size, initial);
+
+    __m256i m[WORDS];
+    for (size_t i = 0; i < WORDS; ++i) {
+      m[i] = _mm256_set1_epi64x(message[i]);
+    }
+
+    uint32_t found = 0;
+    for (size_t lane = 0; lane < AVX2_LANES; lane += 4) {
+      uint64_t nonce = firstNonce + lane * nonceStep;
+      m[nonceWord] = _mm256_set_epi64x(nonce + 3 * nonceStep, nonce + 2 * nonceStep, nonce + nonceStep, nonce);
+
+      __m256i v[WORDS];
+      for (size_t i = 0; i < WORDS; ++i) {
+        v[i] = _mm256_set1_epi64x(initial[i]);
+      }
+
+      BLAKE2B_COMPRESS();
+
+      uint64_t h[4][4];
+      for (size_t i = 0; i < 4; ++i) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(h[i]), _mm256_xor_si256(_mm256_set1_epi64x(initial[i]), _mm256_xor_si256(v[i], v[i + 8])));
+      }
+
+      for (size_t i = 0; i < 4; ++i) {
+        if (finishLane(h[0][i], h[1][i], h[2][i], h[3][i], prefixLimit, hashes[lane + i])) {
+          found |= 1u << (lane + i);
+        }
+      }
+    }
+
+    return found;
+#undef ADD
+#undef XOR
+#undef ROR32
+#undef ROR24
+#undef ROR16
+#undef ROR63
+  }
+
+  bool cpuSupportsSse41() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 19)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.1");
+#endif
+  }
+
+  bool cpuSupportsAvx2() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    // the OS has to save the ymm registers too
+    if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) {
+      return false;
+    }
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+  }
+
+#endif
+
+#undef BLAKE2B_G
+#undef BLAKE2B_ROUND
+#undef BLAKE2B_COMPRESS
+
+}
+
+  Blake2bNonceHasher::Blake2bNonceHasher(const void* message, size_t size, size_t nonceOffset, NonceHashingMode mode) :
+    m_nonceWord(nonceOffset / sizeof(uint64_t)),
+    m_size(size),
+    m_mode(mode) {
+    if (size > sizeof(m_message) || nonceOffset % sizeof(uint64_t) != 0 || nonceOffset + sizeof(uint64_t) > size) {
+      throw std::invalid_argument("Message doesn't fit in one blake2b block or nonce isn't word aligned");
+    }
+
+    if (!isSupported(mode)) {
+      throw std::invalid_argument(std::string("Nonce hashing mode isn't supported by this CPU: ") + modeName(mode));
+    }
+
+    memset(m_message, 0, sizeof(m_message));
+    memcpy(m_message, message, size);
+    for (size_t i = 0; i < WORDS; ++i) {
+      m_message[i] = swap64le(m_message[i]);
+    }
+  }
+
+  NonceHashingMode Blake2bNonceHasher::bestMode() {
+    static const NonceHashingMode best = isSupported(NonceHashingMode::AVX2) ? NonceHashingMode::AVX2 :
+      isSupported(NonceHashingMode::SSE41) ? NonceHashingMode::SSE41 : NonceHashingMode::SCALAR;
+    return best;
+  }
+
+  bool Blake2bNonceHasher::isSupported(NonceHashingMode mode) {
+    switch (mode) {
+#ifdef BLAKE2B_NONCE_SIMD
+    case NonceHashingMode::SSE41: {
+      static const bool supported = cpuSupportsSse41();
+      return supported;
+    }
+    case NonceHashingMode::AVX2: {
+      static const bool supported = cpuSupportsAvx2();
+      return supported;
+    }
+#endif
+    case NonceHashingMode::SCALAR:
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  size_t Blake2bNonceHasher::lanes(NonceHashingMode mode) {
+    switch (mode) {
+    case NonceHashingMode::SSE41:
+      return SSE41_LANES;
+    case NonceHashingMode::AVX2:
+      return AVX2_LANES;
+    default:
+      return SCALAR_LANES;
+    }
+  }
+
+  const char* Blake2bNonceHasher::modeName(NonceHashingMode mode) {
+    switch (mode) {
+    case NonceHashingMode::SSE41:
+      return "SSE4.1";
+    case NonceHashingMode::AVX2:
+      return "AVX2";
+    default:
+      return "scalar";
+    }
+  }
+
+  uint32_t Blake2bNonceHasher::hash(uint64_t firstNonce, uint64_t nonceStep, uint64_t prefixLimit, Hash* hashes) const {
+    switch (m_mode) {
+#ifdef BLAKE2B_NONCE_SIMD
+    case NonceHashingMode::SSE41:
+      return hashSse41(m_message, m_nonceWord, m_size, firstNonce, nonceStep, prefixLimit, hashes);
+    case NonceHashingMode::AVX2:
+      return hashAvx2(m_message, m_nonceWord, m_size, firstNonce, nonceStep, prefixLimit, hashes);
+#endif
+    default:
+      return hashScalar(m_message, m_nonceWord, m_size, firstNonce, nonceStep, prefixLimit, hashes);
+    }
+  }
+
+}
@@ -0,0 +1,50 @@
+// Copyright (c) 2018-2022 The Cash2 developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <CryptoTypes.h>
+
+namespace Crypto {
+
+  enum class NonceHashingMode {
+    SCALAR,
+    SSE41,
+    AVX2
+  };
+
+  /*
+    blake2b-256 of a message that fits in a single blake2b block and only changes in a 64 bit little endian
+    nonce word, such as a block hashing blob. The message is laid out once, every call hashes lanes() nonces.
+  */
+  class Blake2bNonceHasher {
+  public:
+    static const size_t MAX_LANES = 8;
+
+    // nonceOffset has to be a multiple of 8, std::invalid_argument is thrown otherwise or if the message is too long
+    Blake2bNonceHasher(const void* message, size_t size, size_t nonceOffset, NonceHashingMode mode = bestMode());
+
+    static NonceHashingMode bestMode();
+    static bool isSupported(NonceHashingMode mode);
+    static size_t lanes(NonceHashingMode mode);
+    static const char* modeName(NonceHashingMode mode);
+
+    NonceHashingMode mode() const { return m_mode; }
+    size_t lanes() const { return lanes(m_mode); }
+
+    // Hashes the nonces firstNonce + i * nonceStep for i < lanes(). Returns the mask of lanes whose hash starts with
+    // a big endian 64 bit word not above prefixLimit, only the hashes of those lanes are stored to hashes[i].
+    uint32_t hash(uint64_t firstNonce, uint64_t nonceStep, uint64_t prefixLimit, Hash* hashes) const;
+
+  private:
+    uint64_t m_message[16];
+    size_t m_nonceWord;
+    uint64_t m_size;
+    NonceHashingMode m_mode;
+  };
+
+}
@@ -101,7 +101,7 @@ struct EllipticCurveScalar {
   public:
     typedef T result_type;
 
-#ifdef __clang__
+#if 1 // LOCALBUILD
     constexpr static T min() {
       return (std::numeric_limits<T>::min)();
     }
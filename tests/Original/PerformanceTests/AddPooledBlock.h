@@ -0,0 +1,140 @@
+// Copyright (c) 2018-2022 The Cash2 developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <algorithm>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <vector>
+
+#include <boost/chrono.hpp>
+
+#include "BlockchainContention.h"
+
+// Latency of addNewBlock() for blocks whose a_transactions transactions are already in the pool, as they are for
+// blocks relayed after their transactions. Every transaction spends one output with a ring of ring_size.
+template<size_t a_transactions>
+class test_add_pooled_block
+{
+public:
+  static const size_t loop_count = 10;
+  static const size_t ring_size = 4;
+  static const size_t split_blocks = 20;
+
+  test_add_pooled_block() :
+    m_amount(0), m_unspent(0), m_blocks(0), m_elapsed(0)
+  {
+  }
+
+  ~test_add_pooled_block()
+  {
+    if (m_blocks == 0)
+      return;
+
+    std::cout << "  addNewBlock: " << boost::chrono::duration_cast<boost::chrono::microseconds>(m_elapsed).count() / m_blocks <<
+      " us per block with " << a_transactions << " pooled transactions" << std::endl;
+  }
+
+  bool init()
+  {
+    m_chain.reset(new blockchain_bench_chain());
+    if (!m_chain->init())
+      return false;
+
+    // the coinbase outputs of the first split_blocks blocks are unlocked once the chain is this long
+    for (size_t i = 0; i < split_blocks + m_chain->currency().minedMoneyUnlockWindow(); ++i)
+    {
+      if (!m_chain->add_block())
+        return false;
+    }
+
+    // coinbase transactions have a single output, so split them into outputs of one amount the rings are taken from
+    std::list<CryptoNote::Block> blocks;
+    if (!m_chain->blockchain().getBlocks(1, static_cast<uint32_t>(split_blocks), blocks))
+      return false;
+
+    m_amount = 2 * m_chain->currency().minimumFee();
+    std::vector<CryptoNote::Transaction> splits;
+    for (const CryptoNote::Block& block : blocks)
+    {
+      std::vector<blockchain_bench_chain::output> outputs;
+      if (!m_chain->get_outputs(block.baseTransaction, outputs))
+        return false;
+
+      uint64_t amount = block.baseTransaction.outputs[0].amount - m_chain->currency().minimumFee();
+      std::vector<CryptoNote::TransactionDestinationEntry> destinations(amount / m_amount,
+        CryptoNote::TransactionDestinationEntry(m_amount, m_chain->miner().getAccountKeys().address));
+      if (amount % m_amount != 0)
+        destinations.push_back(CryptoNote::TransactionDestinationEntry(amount % m_amount, m_chain->miner().getAccountKeys().address));
+
+      CryptoNote::Transaction split;
+      if (!m_chain->construct_transaction(outputs, 0, block.baseTransaction.outputs[0].amount, destinations, split) || !m_chain->add_to_pool(split))
+        return false;
+
+      splits.push_back(split);
+    }
+
+    CryptoNote::Block block;
+    if (!m_chain->make_block(splits, block) || !m_chain->add_block(block))
+      return false;
+
+    for (const CryptoNote::Transaction& split : splits)
+    {
+      std::vector<blockchain_bench_chain::output> outputs;
+      if (!m_chain->get_outputs(split, outputs))
+        return false;
+
+      for (size_t i = 0; i < outputs.size(); ++i)
+      {
+        if (split.outputs[i].amount == m_amount)
+          m_outputs.push_back(outputs[i]);
+      }
+    }
+
+    m_unspent = m_outputs.size();
+    return m_unspent >= loop_count * a_transactions && m_outputs.size() >= ring_size;
+  }
+
+  bool test()
+  {
+    std::vector<CryptoNote::Transaction> transactions;
+    for (size_t i = 0; i < a_transactions; ++i)
+    {
+      // the real output and the ones following it, in global index order
+      size_t real = --m_unspent;
+      size_t first = std::min(real, m_outputs.size() - ring_size);
+      std::vector<blockchain_bench_chain::output> ring(m_outputs.begin() + first, m_outputs.begin() + first + ring_size);
+
+      std::vector<CryptoNote::TransactionDestinationEntry> destinations(1,
+        CryptoNote::TransactionDestinationEntry(m_amount - m_chain->currency().minimumFee(), m_chain->miner().getAccountKeys().address));
+
+      CryptoNote::Transaction transaction;
+      if (!m_chain->construct_transaction(ring, real - first, m_amount, destinations, transaction) || !m_chain->add_to_pool(transaction))
+        return false;
+
+      transactions.push_back(transaction);
+    }
+
+    CryptoNote::Block block;
+    if (!m_chain->make_block(transactions, block))
+      return false;
+
+    auto start = boost::chrono::high_resolution_clock::now();
+    bool added = m_chain->add_block(block);
+    m_elapsed += boost::chrono::high_resolution_clock::now() - start;
+    ++m_blocks;
+
+    return added;
+  }
+
+private:
+  std::unique_ptr<blockchain_bench_chain> m_chain;
+  uint64_t m_amount;
+  std::vector<blockchain_bench_chain::output> m_outputs;
+  size_t m_unspent;
+  size_t m_blocks;
+  boost::chrono::high_resolution_clock::duration m_elapsed;
+};
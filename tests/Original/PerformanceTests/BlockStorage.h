@@ -0,0 +1,103 @@
+// Copyright (c) 2018-2022 The Cash2 developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "crypto/crypto.h"
+#include "CryptoNoteCore/CryptoNoteSerialization.h"
+#include "CryptoNoteCore/MappedVector.h"
+#include "CryptoNoteCore/SwappedVector.h"
+
+// operator[] throughput of a block storage holding item_count blocks with a cache of cache_size of them.
+// Lookups are either spread randomly over the whole storage or walk it from the first block to the last.
+template<class Vector, bool a_random>
+class test_block_storage
+{
+public:
+  static const size_t loop_count = 10;
+  static const size_t item_count = 20000;
+  static const size_t cache_size = 1024;
+
+  test_block_storage() :
+    m_blocks(new Vector())
+  {
+    m_folder = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+  }
+
+  ~test_block_storage()
+  {
+    print_cache_stats(*m_blocks);
+    m_blocks.reset();
+
+    boost::system::error_code ignore;
+    boost::filesystem::remove_all(m_folder, ignore);
+  }
+
+  bool init()
+  {
+    if (!boost::filesystem::create_directories(m_folder))
+      return false;
+
+    if (!m_blocks->open((m_folder / "blocks.dat").string(), (m_folder / "blockindexes.dat").string(), cache_size))
+      return false;
+
+    for (size_t i = 0; i < item_count; ++i)
+    {
+      CryptoNote::Block block;
+      block.timestamp = i;
+      block.nonce = i;
+      block.previousBlockHash = Crypto::rand<Crypto::Hash>();
+      block.merkleRoot = Crypto::rand<Crypto::Hash>();
+      block.baseTransaction.version = 1;
+      block.baseTransaction.unlockTime = i;
+      block.transactionHashes.resize(i % 32);
+      for (auto& hash : block.transactionHashes)
+        hash = Crypto::rand<Crypto::Hash>();
+
+      m_blocks->push_back(block);
+    }
+
+    std::mt19937_64 engine(item_count);
+    std::uniform_int_distribution<size_t> distribution(0, item_count - 1);
+    for (size_t i = 0; i < item_count; ++i)
+      m_indexes.push_back(a_random ? distribution(engine) : i);
+
+    m_blocks->releaseRetired();
+    return true;
+  }
+
+  bool test()
+  {
+    for (size_t index : m_indexes)
+    {
+      if ((*m_blocks)[index].timestamp != index)
+        return false;
+    }
+
+    m_blocks->releaseRetired();
+    return true;
+  }
+
+private:
+  template<class T> static void print_cache_stats(MappedVector<T>& blocks)
+  {
+    std::cout << "MappedVector cache hits: " << blocks.cacheHits() << ", misses: " << blocks.cacheMisses() << std::endl;
+  }
+
+  // SwappedVector prints its own statistics when closed
+  template<class T> static void print_cache_stats(SwappedVector<T>& blocks)
+  {
+  }
+
+  boost::filesystem::path m_folder;
+  std::unique_ptr<Vector> m_blocks;
+  std::vector<size_t> m_indexes;
+};
@@ -0,0 +1,165 @@
+// Copyright (c) 2018-2022 The Cash2 developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <algorithm>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <vector>
+
+#include <boost/chrono.hpp>
+
+#include "BlockchainContention.h"
+
+// Latency of filling a block template from a pool of a_pool_size transactions, as getblocktemplate does. It is
+// measured for a poll with nothing changed since the last one, and for a poll right after a transaction entered the
+// pool. Every transaction spends one output with a ring of ring_size.
+template<size_t a_pool_size>
+class test_block_template
+{
+public:
+  static const size_t loop_count = 50;
+  static const size_t ring_size = 4;
+  static const size_t split_blocks = 40;
+
+  test_block_template() :
+    m_polls(0), m_transactionsInTemplate(0), m_unchangedElapsed(0), m_changedElapsed(0)
+  {
+  }
+
+  ~test_block_template()
+  {
+    if (m_polls == 0)
+      return;
+
+    std::cout << "  " << a_pool_size << " pooled transactions, " << m_transactionsInTemplate << " in the template: " <<
+      boost::chrono::duration_cast<boost::chrono::microseconds>(m_unchangedElapsed).count() / m_polls << " us per poll, " <<
+      boost::chrono::duration_cast<boost::chrono::microseconds>(m_changedElapsed).count() / m_polls << " us after the pool changed" << std::endl;
+  }
+
+  bool init()
+  {
+    m_chain.reset(new blockchain_bench_chain());
+    if (!m_chain->init())
+      return false;
+
+    // the coinbase outputs of the first split_blocks blocks are unlocked once the chain is this long
+    for (size_t i = 0; i < split_blocks + m_chain->currency().minedMoneyUnlockWindow(); ++i)
+    {
+      if (!m_chain->add_block())
+        return false;
+    }
+
+    // coinbase transactions have a single output, so split them into outputs of one amount the rings are taken from
+    std::list<CryptoNote::Block> blocks;
+    if (!m_chain->blockchain().getBlocks(1, static_cast<uint32_t>(split_blocks), blocks))
+      return false;
+
+    uint64_t amount = 2 * m_chain->currency().minimumFee();
+    std::vector<CryptoNote::Transaction> splits;
+    for (const CryptoNote::Block& block : blocks)
+    {
+      std::vector<blockchain_bench_chain::output> outputs;
+      if (!m_chain->get_outputs(block.baseTransaction, outputs))
+        return false;
+
+      uint64_t splitAmount = block.baseTransaction.outputs[0].amount - m_chain->currency().minimumFee();
+      std::vector<CryptoNote::TransactionDestinationEntry> destinations(splitAmount / amount,
+        CryptoNote::TransactionDestinationEntry(amount, m_chain->miner().getAccountKeys().address));
+      if (splitAmount % amount != 0)
+        destinations.push_back(CryptoNote::TransactionDestinationEntry(splitAmount % amount, m_chain->miner().getAccountKeys().address));
+
+      CryptoNote::Transaction split;
+      if (!m_chain->construct_transaction(outputs, 0, block.baseTransaction.outputs[0].amount, destinations, split) || !m_chain->add_to_pool(split))
+        return false;
+
+      splits.push_back(split);
+    }
+
+    CryptoNote::Block block;
+    if (!m_chain->make_block(splits, block) || !m_chain->add_block(block))
+      return false;
+
+    std::vector<blockchain_bench_chain::output> unspent;
+    for (const CryptoNote::Transaction& split : splits)
+    {
+      std::vector<blockchain_bench_chain::output> outputs;
+      if (!m_chain->get_outputs(split, outputs))
+        return false;
+
+      for (size_t i = 0; i < outputs.size(); ++i)
+      {
+        if (split.outputs[i].amount == amount)
+          unspent.push_back(outputs[i]);
+      }
+    }
+
+    if (unspent.size() < a_pool_size || unspent.size() < ring_size)
+      return false;
+
+    for (size_t real = 0; real < a_pool_size; ++real)
+    {
+      // the real output and the ones following it, in global index order
+      size_t first = std::min(real, unspent.size() - ring_size);
+      std::vector<blockchain_bench_chain::output> ring(unspent.begin() + first, unspent.begin() + first + ring_size);
+
+      std::vector<CryptoNote::TransactionDestinationEntry> destinations(1,
+        CryptoNote::TransactionDestinationEntry(amount - m_chain->currency().minimumFee(), m_chain->miner().getAccountKeys().address));
+
+      CryptoNote::Transaction transaction;
+      if (!m_chain->construct_transaction(ring, real - first, amount, destinations, transaction) || !m_chain->add_to_pool(transaction))
+        return false;
+
+      m_transactions.push_back(transaction);
+    }
+
+    CryptoNote::Block templateBlock;
+    return fill_template(templateBlock) && !templateBlock.transactionHashes.empty();
+  }
+
+  bool test()
+  {
+    CryptoNote::Block block;
+    auto start = boost::chrono::high_resolution_clock::now();
+    bool filled = fill_template(block);
+    m_unchangedElapsed += boost::chrono::high_resolution_clock::now() - start;
+    if (!filled)
+      return false;
+
+    m_transactionsInTemplate = block.transactionHashes.size();
+
+    // the transaction leaves the pool and comes back as if it was relayed again
+    const CryptoNote::Transaction& changed = m_transactions[m_polls % m_transactions.size()];
+    CryptoNote::Transaction taken;
+    size_t blobSize;
+    uint64_t fee;
+    if (!m_chain->pool().take_tx(CryptoNote::getObjectHash(changed), taken, blobSize, fee) || !m_chain->add_to_pool(taken))
+      return false;
+
+    start = boost::chrono::high_resolution_clock::now();
+    filled = fill_template(block);
+    m_changedElapsed += boost::chrono::high_resolution_clock::now() - start;
+    ++m_polls;
+
+    return filled && block.transactionHashes.size() == m_transactionsInTemplate;
+  }
+
+private:
+  bool fill_template(CryptoNote::Block& block)
+  {
+    uint32_t height = m_chain->blockchain().getCurrentBlockchainHeight();
+    size_t totalSize;
+    uint64_t fee;
+    return m_chain->pool().fill_block_template2(block, m_chain->currency().maxBlockCumulativeSize(height), 0, totalSize, fee);
+  }
+
+  std::unique_ptr<blockchain_bench_chain> m_chain;
+  std::vector<CryptoNote::Transaction> m_transactions;
+  size_t m_polls;
+  size_t m_transactionsInTemplate;
+  boost::chrono::high_resolution_clock::duration m_unchangedElapsed;
+  boost::chrono::high_resolution_clock::duration m_changedElapsed;
+};
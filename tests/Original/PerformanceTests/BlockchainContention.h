@@ -0,0 +1,270 @@
+// Copyright (c) 2018-2022 The Cash2 developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "Common/Math.h"
+#include "CryptoNoteCore/Account.h"
+#include "CryptoNoteCore/Blockchain.h"
+#include "CryptoNoteCore/CachedTransaction.h"
+#include "CryptoNoteCore/CryptoNoteFormatUtils.h"
+#include "CryptoNoteCore/CryptoNoteTools.h"
+#include "CryptoNoteCore/Currency.h"
+#include "CryptoNoteCore/ITimeProvider.h"
+#include "CryptoNoteCore/TransactionExtra.h"
+#include "CryptoNoteCore/TransactionPool.h"
+#include "Logging/ConsoleLogger.h"
+
+// Chain used by the blockchain benchmarks. Blocks are added inside the checkpoint zone so no proof of work
+// has to be found for them.
+class blockchain_bench_chain
+{
+public:
+  blockchain_bench_chain() :
+    m_logger(Logging::ERROR),
+    m_currency(CryptoNote::CurrencyBuilder(m_logger).currency()),
+    m_pool(m_currency, m_blockchain, m_timeProvider, m_logger),
+    m_blockchain(m_currency, m_pool, m_logger),
+    m_timestamp(0)
+  {
+    m_folder = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).string();
+    m_miner.generate();
+  }
+
+  ~blockchain_bench_chain()
+  {
+    boost::system::error_code ignore;
+    boost::filesystem::remove_all(m_folder, ignore);
+  }
+
+  bool init()
+  {
+    CryptoNote::Checkpoints checkpoints(m_logger);
+    checkpoints.add_checkpoint(std::numeric_limits<uint32_t>::max() - 1, Common::podToHex(CryptoNote::NULL_HASH));
+    m_blockchain.setCheckpoints(std::move(checkpoints));
+
+    if (!m_blockchain.init(m_folder, false))
+      return false;
+
+    m_timestamp = m_currency.genesisBlock().timestamp;
+    return true;
+  }
+
+  bool add_block()
+  {
+    CryptoNote::Block block;
+    return make_block(std::vector<CryptoNote::Transaction>(), block) && add_block(block);
+  }
+
+  bool add_block(const CryptoNote::Block& block)
+  {
+    CryptoNote::block_verification_context bvc = boost::value_initialized<CryptoNote::block_verification_context>();
+    return m_blockchain.addNewBlock(block, bvc) && bvc.m_added_to_main_chain;
+  }
+
+  // Block on the current tail with the given transactions, which have to be in the pool when it is added
+  bool make_block(const std::vector<CryptoNote::Transaction>& transactions, CryptoNote::Block& block)
+  {
+    using namespace CryptoNote;
+
+    uint32_t height = m_blockchain.getCurrentBlockchainHeight();
+
+    block.nonce = 0;
+    // blocks at the target interval keep the difficulty from overflowing on long chains
+    m_timestamp += m_currency.difficultyTarget();
+    block.timestamp = m_timestamp;
+    block.previousBlockHash = m_blockchain.getTailId();
+
+    uint64_t alreadyGeneratedCoins;
+    if (!m_blockchain.getAlreadyGeneratedCoins(block.previousBlockHash, alreadyGeneratedCoins))
+      return false;
+
+    std::vector<size_t> blockSizes;
+    m_blockchain.getBackwardBlocksSize(height - 1, blockSizes, m_currency.rewardBlocksWindow());
+    size_t medianSize = Common::medianValue(blockSizes);
+
+    size_t transactionsSize = 0;
+    uint64_t fee = 0;
+    block.transactionHashes.clear();
+    for (const Transaction& transaction : transactions)
+    {
+      transactionsSize += getObjectBinarySize(transaction);
+      fee += get_tx_fee(transaction);
+      block.transactionHashes.push_back(getObjectHash(transaction));
+    }
+
+    size_t coinbaseSize = 0;
+    for (;;)
+    {
+      if (!m_currency.constructMinerTx1(height, medianSize, alreadyGeneratedCoins, transactionsSize + coinbaseSize, fee, m_miner.getAccountKeys().address, block.baseTransaction))
+        return false;
+
+      size_t actualSize = getObjectBinarySize(block.baseTransaction);
+      if (actualSize == coinbaseSize)
+        break;
+
+      coinbaseSize = actualSize;
+    }
+
+    block.merkleRoot = get_tx_tree_hash(block);
+    return true;
+  }
+
+  struct output
+  {
+    uint32_t globalIndex;
+    Crypto::PublicKey key;
+    Crypto::PublicKey transactionPublicKey;
+    size_t indexInTransaction;
+  };
+
+  // Outputs of a transaction in the main chain
+  bool get_outputs(const CryptoNote::Transaction& transaction, std::vector<output>& outputs)
+  {
+    std::vector<uint32_t> globalIndexes;
+    if (!m_blockchain.getTransactionOutputGlobalIndexes(CryptoNote::getObjectHash(transaction), globalIndexes))
+      return false;
+
+    for (size_t i = 0; i < transaction.outputs.size(); ++i)
+    {
+      output out = { globalIndexes[i], boost::get<CryptoNote::KeyOutput>(transaction.outputs[i].target).key,
+        CryptoNote::getTransactionPublicKeyFromExtra(transaction.extra), i };
+      outputs.push_back(out);
+    }
+
+    return true;
+  }
+
+  // Transaction of the miner spending ring[real] with the other outputs of the ring as decoys
+  bool construct_transaction(const std::vector<output>& ring, size_t real, uint64_t amount,
+    const std::vector<CryptoNote::TransactionDestinationEntry>& destinations, CryptoNote::Transaction& transaction)
+  {
+    CryptoNote::TransactionSourceEntry source;
+    source.amount = amount;
+    for (const output& out : ring)
+      source.outputs.push_back(std::make_pair(out.globalIndex, out.key));
+
+    source.realOutput = real;
+    source.realTransactionPublicKey = ring[real].transactionPublicKey;
+    source.realOutputIndexInTransaction = ring[real].indexInTransaction;
+
+    Crypto::SecretKey transactionKey;
+    return CryptoNote::constructTransaction(m_miner.getAccountKeys(), std::vector<CryptoNote::TransactionSourceEntry>(1, source),
+      destinations, std::vector<uint8_t>(), transaction, 0, transactionKey, m_logger);
+  }
+
+  bool add_to_pool(const CryptoNote::Transaction& transaction)
+  {
+    return add_to_pool(CryptoNote::CachedTransaction(transaction));
+  }
+
+  bool add_to_pool(const CryptoNote::CachedTransaction& transaction)
+  {
+    CryptoNote::tx_verification_context tvc = boost::value_initialized<CryptoNote::tx_verification_context>();
+    return m_pool.add_tx(transaction, tvc, false, m_blockchain.getCurrentBlockchainHeight()) && tvc.m_added_to_pool;
+  }
+
+  const CryptoNote::Currency& currency() const { return m_currency; }
+  CryptoNote::tx_memory_pool& pool() { return m_pool; }
+  const CryptoNote::AccountBase& miner() const { return m_miner; }
+  CryptoNote::Blockchain& blockchain() { return m_blockchain; }
+
+private:
+  Logging::ConsoleLogger m_logger;
+  CryptoNote::Currency m_currency;
+  CryptoNote::RealTimeProvider m_timeProvider;
+  CryptoNote::tx_memory_pool m_pool;
+  CryptoNote::Blockchain m_blockchain;
+  CryptoNote::AccountBase m_miner;
+  std::string m_folder;
+  uint64_t m_timestamp;
+};
+
+// Read throughput of a_readers threads querying the blockchain while, if a_with_writer is set,
+// another thread keeps adding blocks.
+template<size_t a_readers, bool a_with_writer>
+class test_blockchain_contention
+{
+public:
+  static const size_t loop_count = 10;
+  static const size_t chain_length = 2000;
+  static const size_t queries_per_reader = 2000;
+
+  bool init()
+  {
+    m_chain.reset(new blockchain_bench_chain());
+    if (!m_chain->init())
+      return false;
+
+    for (size_t i = 0; i < chain_length; ++i)
+    {
+      if (!m_chain->add_block())
+        return false;
+    }
+
+    m_blockIds = m_chain->blockchain().getBlockIds(0, chain_length);
+    return true;
+  }
+
+  bool test()
+  {
+    std::atomic<bool> failed(false);
+    std::atomic<bool> readersDone(false);
+
+    std::thread writer;
+    if (a_with_writer)
+    {
+      writer = std::thread([&] {
+        while (!readersDone && !failed)
+        {
+          if (!m_chain->add_block())
+            failed = true;
+        }
+      });
+    }
+
+    std::vector<std::thread> readers;
+    for (size_t r = 0; r < a_readers; ++r)
+    {
+      readers.emplace_back([&, r] {
+        CryptoNote::Blockchain& blockchain = m_chain->blockchain();
+        for (size_t i = 0; i < queries_per_reader && !failed; ++i)
+        {
+          const Crypto::Hash& id = m_blockIds[(i * 7919 + r * 104729) % m_blockIds.size()];
+          uint32_t height;
+          if (!blockchain.getBlockHeight(id, height))
+          {
+            failed = true;
+            break;
+          }
+
+          std::list<CryptoNote::Block> blocks;
+          blockchain.getBlocks(height, 5, blocks);
+          blockchain.haveTransaction(CryptoNote::getObjectHash(blocks.front().baseTransaction));
+        }
+      });
+    }
+
+    for (auto& reader : readers)
+      reader.join();
+
+    readersDone = true;
+    if (writer.joinable())
+      writer.join();
+
+    return !failed;
+  }
+
+private:
+  std::unique_ptr<blockchain_bench_chain> m_chain;
+  std::vector<Crypto::Hash> m_blockIds;
+};
@@ -5,15 +5,18 @@
 
 #pragma once
 
+#include <memory>
 #include <vector>
 
 #include "CryptoNoteCore/Account.h"
 #include "CryptoNoteCore/CryptoNoteBasic.h"
 #include "CryptoNoteCore/CryptoNoteFormatUtils.h"
 #include "CryptoNoteCore/CryptoNoteTools.h"
+#include "CryptoNoteCore/RingSignatureVerifier.h"
 #include "crypto/crypto.h"
 
 #include "MultiTransactionTestBase.h"
+#include "PerformanceUtils.h"
 
 template<size_t a_ring_size>
 class test_check_ring_signature : private multi_tx_test_base<a_ring_size>
@@ -59,3 +62,61 @@ private:
   CryptoNote::Transaction m_tx;
   Crypto::Hash m_tx_prefix_hash;
 };
+
+// Verifies the ring signatures of a whole block, input_count inputs with a_ring_size keys each,
+// the way Blockchain does it: in one batch on a RingSignatureVerifier with a_threads threads.
+template<size_t a_ring_size, size_t a_threads>
+class test_check_block_ring_signatures : private multi_tx_test_base<a_ring_size>
+{
+  static_assert(0 < a_ring_size, "ring_size must be greater than 0");
+  static_assert(0 < a_threads, "threads must be greater than 0");
+
+public:
+  static const size_t loop_count = a_ring_size < 100 ? 50 : 5;
+  static const size_t ring_size = a_ring_size;
+  static const size_t input_count = 64;
+
+  typedef multi_tx_test_base<a_ring_size> base_class;
+
+  bool init()
+  {
+    using namespace CryptoNote;
+
+    if (!base_class::init())
+      return false;
+
+    m_alice.generate();
+
+    std::vector<TransactionDestinationEntry> destinations;
+    destinations.push_back(TransactionDestinationEntry(this->m_source_amount, m_alice.getAccountKeys().address));
+
+    for (size_t i = 0; i < input_count; ++i)
+    {
+      Transaction tx;
+      Crypto::SecretKey transactionSecretKeyIgnore;
+      if (!constructTransaction(this->m_miners[this->real_source_idx].getAccountKeys(), this->m_sources, destinations, std::vector<uint8_t>(), tx, 0, transactionSecretKeyIgnore, this->m_logger))
+        return false;
+
+      RingSignatureCheck check;
+      getObjectHash(*static_cast<TransactionPrefix*>(&tx), check.prefixHash);
+      check.keyImage = boost::get<KeyInput>(tx.inputs[0]).keyImage;
+      check.outputKeys.assign(this->m_public_keys, this->m_public_keys + ring_size);
+      check.signatures = tx.signatures[0];
+      m_checks.push_back(check);
+    }
+
+    unpinned_thread_scope unpinned;
+    m_verifier.reset(new RingSignatureVerifier(a_threads - 1));
+    return true;
+  }
+
+  bool test()
+  {
+    return m_verifier->verify(m_checks) == m_checks.size();
+  }
+
+private:
+  CryptoNote::AccountBase m_alice;
+  std::vector<CryptoNote::RingSignatureCheck> m_checks;
+  std::unique_ptr<CryptoNote::RingSignatureVerifier> m_verifier;
+};
@@ -0,0 +1,90 @@
+// Copyright (c) 2018-2022 The Cash2 developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <iostream>
+#include <string>
+
+#include <boost/chrono.hpp>
+
+#include "Common/MemoryInputStream.h"
+#include "Rpc/CoreRpcServerCommandsDefinitions.h"
+#include "Serialization/KVBinaryInputStreamSerializer.h"
+#include "Serialization/SerializationTools.h"
+
+// Time to deserialize a /getblocks.bin response of a_block_count blocks with transactions_per_block transactions
+// each. If a_buffer is set it's read in place by KVBinaryInputBufferSerializer, otherwise KVBinaryInputStreamSerializer
+// builds a JsonValue of it first.
+template<size_t a_block_count, bool a_buffer>
+class test_decode_blocks_response
+{
+public:
+  static const size_t loop_count = 100;
+  static const size_t transactions_per_block = 4;
+  static const size_t block_size = 400;
+  static const size_t transaction_size = 2000;
+
+  test_decode_blocks_response() :
+    m_calls(0), m_elapsed(0)
+  {
+  }
+
+  ~test_decode_blocks_response()
+  {
+    if (m_calls == 0)
+      return;
+
+    std::cout << "  " << (a_buffer ? "in place: " : "through JsonValue: ") << boost::chrono::duration_cast<boost::chrono::microseconds>(m_elapsed).count() / m_calls <<
+      " us per body of " << m_body.size() << " bytes" << std::endl;
+  }
+
+  bool init()
+  {
+    CryptoNote::COMMAND_RPC_GET_BLOCKS_FAST::response response;
+    response.blocks.resize(a_block_count);
+    for (size_t i = 0; i < a_block_count; ++i)
+    {
+      response.blocks[i].block.assign(block_size, static_cast<char>(i));
+      response.blocks[i].txs.assign(transactions_per_block, std::string(transaction_size, static_cast<char>(i + 1)));
+    }
+
+    response.start_height = 1000;
+    response.current_height = 1000 + a_block_count;
+    response.status = CORE_RPC_STATUS_OK;
+    m_body = CryptoNote::storeToBinaryKeyValue(response);
+
+    return test() && m_response.blocks.size() == a_block_count && m_response.blocks.back().txs == response.blocks.back().txs &&
+      m_response.current_height == response.current_height;
+  }
+
+  bool test()
+  {
+    m_response = CryptoNote::COMMAND_RPC_GET_BLOCKS_FAST::response();
+
+    auto start = boost::chrono::high_resolution_clock::now();
+    if (a_buffer)
+    {
+      CryptoNote::KVBinaryInputBufferSerializer serializer(m_body.data(), m_body.size());
+      serialize(m_response, serializer);
+    }
+    else
+    {
+      Common::MemoryInputStream stream(m_body.data(), m_body.size());
+      CryptoNote::KVBinaryInputStreamSerializer serializer(stream);
+      serialize(m_response, serializer);
+    }
+
+    m_elapsed += boost::chrono::high_resolution_clock::now() - start;
+    ++m_calls;
+
+    return true;
+  }
+
+private:
+  std::string m_body;
+  CryptoNote::COMMAND_RPC_GET_BLOCKS_FAST::response m_response;
+  size_t m_calls;
+  boost::chrono::high_resolution_clock::duration m_elapsed;
+};
@@ -0,0 +1,214 @@
+// Copyright (c) 2018-2022 The Cash2 developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <iostream>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/chrono.hpp>
+
+#include "BlockchainContention.h"
+#include "Rpc/CoreRpcServerCommandsDefinitions.h"
+#include "Rpc/RawBlocksResponse.h"
+#include "Serialization/SerializationTools.h"
+
+// Time to build the body of a /getblocks.bin response for the last response_blocks blocks of a chain whose last
+// blocks_with_transactions blocks hold a transaction with outputs_per_transaction outputs. If a_raw is set the body
+// is written from the stored blobs, otherwise the blocks and transactions are deserialized and serialized again.
+template<bool a_raw>
+class test_get_blocks_response
+{
+public:
+  static const size_t loop_count = 100;
+  static const size_t blocks_with_transactions = 20;
+  static const size_t outputs_per_transaction = 16;
+  static const size_t response_blocks = 100;
+
+  test_get_blocks_response() :
+    m_height(0), m_startHeight(0), m_calls(0), m_elapsed(0)
+  {
+  }
+
+  ~test_get_blocks_response()
+  {
+    if (m_calls == 0)
+      return;
+
+    std::cout << "  " << (a_raw ? "stored blobs: " : "re-serialized: ") << boost::chrono::duration_cast<boost::chrono::microseconds>(m_elapsed).count() / m_calls <<
+      " us per body of " << m_body.size() << " bytes" << std::endl;
+  }
+
+  bool init()
+  {
+    m_chain.reset(new blockchain_bench_chain());
+    if (!m_chain->init())
+      return false;
+
+    // the coinbase outputs of the first blocks_with_transactions blocks are unlocked once the chain is this long
+    for (size_t i = 0; i < blocks_with_transactions + m_chain->currency().minedMoneyUnlockWindow(); ++i)
+    {
+      if (!m_chain->add_block())
+        return false;
+    }
+
+    std::list<CryptoNote::Block> coinbases;
+    if (!m_chain->blockchain().getBlocks(1, static_cast<uint32_t>(blocks_with_transactions), coinbases))
+      return false;
+
+    for (const CryptoNote::Block& coinbase : coinbases)
+    {
+      std::vector<blockchain_bench_chain::output> outputs;
+      if (!m_chain->get_outputs(coinbase.baseTransaction, outputs))
+        return false;
+
+      uint64_t amount = (coinbase.baseTransaction.outputs[0].amount - m_chain->currency().minimumFee()) / outputs_per_transaction;
+      std::vector<CryptoNote::TransactionDestinationEntry> destinations(outputs_per_transaction,
+        CryptoNote::TransactionDestinationEntry(amount, m_chain->miner().getAccountKeys().address));
+
+      CryptoNote::Transaction transaction;
+      if (!m_chain->construct_transaction(outputs, 0, coinbase.baseTransaction.outputs[0].amount, destinations, transaction) ||
+        !m_chain->add_to_pool(transaction))
+        return false;
+
+      CryptoNote::Block block;
+      if (!m_chain->make_block(std::vector<CryptoNote::Transaction>(1, transaction), block) || !m_chain->add_block(block))
+        return false;
+    }
+
+    m_height = m_chain->blockchain().getCurrentBlockchainHeight();
+    m_startHeight = m_height - static_cast<uint32_t>(response_blocks);
+
+    // both ways have to give the same bytes, for the getblocks and the queryblocks responses
+    std::string raw;
+    std::string serialized;
+    if (!get_blocks_raw(raw) || !get_blocks_serialized(serialized) || raw != serialized)
+      return false;
+
+    return query_blocks_raw(raw) && query_blocks_serialized(serialized) && raw == serialized;
+  }
+
+  bool test()
+  {
+    auto start = boost::chrono::high_resolution_clock::now();
+    bool result = a_raw ? get_blocks_raw(m_body) : get_blocks_serialized(m_body);
+    m_elapsed += boost::chrono::high_resolution_clock::now() - start;
+    ++m_calls;
+
+    return result;
+  }
+
+private:
+  bool get_raw_blocks(std::vector<CryptoNote::Blockchain::RawBlock>& blocks)
+  {
+    for (uint32_t height = m_startHeight; height < m_height; ++height)
+    {
+      CryptoNote::Blockchain::RawBlock block;
+      if (!m_chain->blockchain().getRawBlock(height, block))
+        return false;
+
+      blocks.push_back(std::move(block));
+    }
+
+    return true;
+  }
+
+  bool get_complete_entries(std::vector<CryptoNote::block_complete_entry>& entries)
+  {
+    std::list<CryptoNote::Block> blocks;
+    if (!m_chain->blockchain().getBlocks(m_startHeight, m_height - m_startHeight, blocks))
+      return false;
+
+    for (const CryptoNote::Block& block : blocks)
+    {
+      std::list<CryptoNote::Transaction> transactions;
+      std::list<Crypto::Hash> missed;
+      m_chain->blockchain().getTransactions(block.transactionHashes, transactions, missed);
+      if (!missed.empty())
+        return false;
+
+      entries.resize(entries.size() + 1);
+      entries.back().block = Common::asString(CryptoNote::toBinaryArray(block));
+      for (const CryptoNote::Transaction& transaction : transactions)
+        entries.back().txs.push_back(Common::asString(CryptoNote::toBinaryArray(transaction)));
+    }
+
+    return true;
+  }
+
+  bool get_blocks_raw(std::string& body)
+  {
+    std::vector<CryptoNote::Blockchain::RawBlock> blocks;
+    if (!get_raw_blocks(blocks))
+      return false;
+
+    body = CryptoNote::storeRawGetBlocksResponse(blocks, m_startHeight, m_height);
+    return true;
+  }
+
+  bool get_blocks_serialized(std::string& body)
+  {
+    CryptoNote::COMMAND_RPC_GET_BLOCKS_FAST::response response;
+    if (!get_complete_entries(response.blocks))
+      return false;
+
+    response.start_height = m_startHeight;
+    response.current_height = m_height;
+    response.status = CORE_RPC_STATUS_OK;
+    body = CryptoNote::storeToBinaryKeyValue(response);
+    return true;
+  }
+
+  // The first half of the blocks are short entries
+  bool query_blocks_raw(std::string& body)
+  {
+    std::vector<CryptoNote::Blockchain::RawBlock> blocks;
+    if (!get_raw_blocks(blocks))
+      return false;
+
+    std::vector<Crypto::Hash> shortBlockIds;
+    for (size_t i = 0; i < blocks.size() / 2; ++i)
+      shortBlockIds.push_back(blocks[i].id);
+
+    blocks.erase(blocks.begin(), blocks.begin() + blocks.size() / 2);
+    body = CryptoNote::storeRawQueryBlocksResponse(shortBlockIds, blocks, m_startHeight, m_height, m_startHeight + shortBlockIds.size());
+    return true;
+  }
+
+  bool query_blocks_serialized(std::string& body)
+  {
+    std::vector<CryptoNote::block_complete_entry> entries;
+    if (!get_complete_entries(entries))
+      return false;
+
+    std::vector<Crypto::Hash> blockIds = m_chain->blockchain().getBlockIds(m_startHeight, static_cast<uint32_t>(entries.size()));
+    CryptoNote::COMMAND_RPC_QUERY_BLOCKS::response response;
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+      CryptoNote::BlockFullInfo item;
+      item.block_id = blockIds[i];
+      if (i >= entries.size() / 2)
+        static_cast<CryptoNote::block_complete_entry&>(item) = entries[i];
+
+      response.items.push_back(item);
+    }
+
+    response.status = CORE_RPC_STATUS_OK;
+    response.start_height = m_startHeight;
+    response.current_height = m_height;
+    response.full_offset = m_startHeight + entries.size() / 2;
+    body = CryptoNote::storeToBinaryKeyValue(response);
+    return true;
+  }
+
+  std::unique_ptr<blockchain_bench_chain> m_chain;
+  uint32_t m_height;
+  uint32_t m_startHeight;
+  std::string m_body;
+  size_t m_calls;
+  boost::chrono::high_resolution_clock::duration m_elapsed;
+};
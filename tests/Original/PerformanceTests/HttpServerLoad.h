@@ -0,0 +1,231 @@
+// Copyright (c) 2018-2022 The Cash2 developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "HTTP/HttpParser.h"
+#include "Logging/ConsoleLogger.h"
+#include "Rpc/HttpServer.h"
+#include "System/Event.h"
+#include "System/Ipv4Address.h"
+#include "System/TcpConnector.h"
+#include "System/TcpStream.h"
+
+#include "PerformanceUtils.h"
+
+namespace http_server_load {
+
+  const char* const address = "127.0.0.1";
+  const uint16_t port = 32276;
+  const size_t client_count = 4;
+  const size_t calls_per_client = 64;
+  const size_t heavy_call_interval = 4; // every fourth call is a heavy one
+  const std::chrono::microseconds heavy_call_time(2000);
+
+  // "/light" stands for the calls answered from the dispatcher, like getinfo, and "/heavy" for the ones that keep a
+  // core lock for a while, like getblocks.bin, and may run on the workers
+  class load_server : public CryptoNote::HttpServer
+  {
+  public:
+    load_server(System::Dispatcher& dispatcher, Logging::ILogger& log) : CryptoNote::HttpServer(dispatcher, log)
+    {
+    }
+
+    virtual void processRequest(const CryptoNote::HttpRequest& request, CryptoNote::HttpResponse& response) override
+    {
+      if (request.getUrl() == "/heavy")
+      {
+        auto start = std::chrono::steady_clock::now();
+        while (std::chrono::steady_clock::now() - start < heavy_call_time)
+        {
+        }
+      }
+      else if (request.getUrl() != "/light")
+      {
+        response.setStatus(CryptoNote::HttpResponse::STATUS_404);
+        return;
+      }
+
+      response.setBody(request.getBody());
+    }
+
+  protected:
+    virtual bool isConcurrentRequest(const CryptoNote::HttpRequest& request) override
+    {
+      return request.getUrl() == "/heavy";
+    }
+  };
+
+}
+
+// Throughput of an HttpServer with a_workers worker threads loaded by client_count clients sending a mix of light and
+// heavy calls, a_pipeline of them at a time on every connection, and the latency of the light calls.
+template<size_t a_workers, size_t a_pipeline>
+class test_http_server_load
+{
+public:
+  static const size_t loop_count = 10;
+
+  test_http_server_load() :
+    m_logger(Logging::ERROR), m_dispatcher(nullptr), m_stopped(nullptr), m_statistics(), m_calls(0), m_lightCalls(0), m_lightLatency(0), m_elapsed(0)
+  {
+  }
+
+  ~test_http_server_load()
+  {
+    if (m_dispatcher != nullptr)
+    {
+      m_dispatcher->remoteSpawn([this] { m_stopped->set(); });
+      m_serverThread.join();
+    }
+
+    if (m_calls == 0)
+      return;
+
+    double seconds = std::chrono::duration<double>(m_elapsed).count();
+    std::cout << "  " << a_workers << " workers, pipeline of " << a_pipeline << ": " << static_cast<uint64_t>(m_calls / seconds) <<
+      " calls/s, light call latency " << m_lightLatency.count() / m_lightCalls << " us, max queued " << m_statistics.maxQueuedRequests << std::endl;
+  }
+
+  bool init()
+  {
+    std::promise<bool> started;
+    auto startedFuture = started.get_future();
+
+    unpinned_thread_scope unpinned;
+    m_serverThread = std::thread([this, &started] {
+      System::Dispatcher dispatcher;
+      System::Event stopped(dispatcher);
+      http_server_load::load_server server(dispatcher, m_logger);
+      server.setWorkerThreads(a_workers);
+      server.setMaxConnectionRequests(a_pipeline);
+
+      try
+      {
+        server.start(http_server_load::address, http_server_load::port);
+      }
+      catch (std::exception& e)
+      {
+        std::cout << "Failed to start the server: " << e.what() << std::endl;
+        started.set_value(false);
+        return;
+      }
+
+      m_dispatcher = &dispatcher;
+      m_stopped = &stopped;
+      started.set_value(true);
+
+      stopped.wait();
+      m_statistics = server.getStatistics();
+      server.stop();
+    });
+
+    if (!startedFuture.get())
+    {
+      m_serverThread.join();
+      return false;
+    }
+
+    return true;
+  }
+
+  bool test()
+  {
+    std::vector<std::future<bool>> clients;
+    auto start = std::chrono::steady_clock::now();
+    {
+      unpinned_thread_scope unpinned;
+      for (size_t i = 0; i < http_server_load::client_count; ++i)
+        clients.push_back(std::async(std::launch::async, &test_http_server_load::run_client, this));
+    }
+
+    bool result = true;
+    for (auto& client : clients)
+      result = client.get() && result;
+
+    m_elapsed += std::chrono::steady_clock::now() - start;
+    m_calls += http_server_load::client_count * http_server_load::calls_per_client;
+    return result;
+  }
+
+private:
+  bool run_client()
+  {
+    try
+    {
+      System::Dispatcher dispatcher;
+      System::TcpConnection connection = System::TcpConnector(dispatcher).connect(System::Ipv4Address(http_server_load::address), http_server_load::port);
+      System::TcpStreambuf streambuf(connection);
+      std::iostream stream(&streambuf);
+      CryptoNote::HttpParser parser;
+
+      std::vector<std::chrono::steady_clock::time_point> sent(a_pipeline);
+      std::chrono::microseconds lightLatency(0);
+      size_t lightCalls = 0;
+      for (size_t call = 0; call < http_server_load::calls_per_client; call += a_pipeline)
+      {
+        for (size_t i = 0; i < a_pipeline; ++i)
+        {
+          CryptoNote::HttpRequest request;
+          request.setUrl(is_heavy(call + i) ? "/heavy" : "/light");
+          request.setBody("{}");
+          stream << request;
+          sent[i] = std::chrono::steady_clock::now();
+        }
+
+        stream.flush();
+
+        for (size_t i = 0; i < a_pipeline; ++i)
+        {
+          CryptoNote::HttpResponse response;
+          parser.receiveResponse(stream, response);
+          if (response.getStatus() != CryptoNote::HttpResponse::STATUS_200)
+            return false;
+
+          if (!is_heavy(call + i))
+          {
+            lightLatency += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - sent[i]);
+            ++lightCalls;
+          }
+        }
+      }
+
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_lightLatency += lightLatency;
+      m_lightCalls += lightCalls;
+      return true;
+    }
+    catch (std::exception& e)
+    {
+      std::cout << "Client failed: " << e.what() << std::endl;
+      return false;
+    }
+  }
+
+  static bool is_heavy(size_t call)
+  {
+    return call % http_server_load::heavy_call_interval == http_server_load::heavy_call_interval - 1;
+  }
+
+  static_assert(http_server_load::calls_per_client % a_pipeline == 0, "calls_per_client must be a multiple of a_pipeline");
+
+  Logging::ConsoleLogger m_logger;
+  std::thread m_serverThread;
+  System::Dispatcher* m_dispatcher;
+  System::Event* m_stopped;
+  CryptoNote::HttpServerStatistics m_statistics;
+  std::mutex m_mutex;
+  size_t m_calls;
+  size_t m_lightCalls;
+  std::chrono::microseconds m_lightLatency;
+  std::chrono::steady_clock::duration m_elapsed;
+};
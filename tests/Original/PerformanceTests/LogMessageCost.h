@@ -0,0 +1,80 @@
+// Copyright (c) 2018-2022 The Cash2 developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <iostream>
+#include <streambuf>
+#include <string>
+
+#include <boost/chrono.hpp>
+
+#include "Logging/LoggerGroup.h"
+#include "Logging/LoggerRef.h"
+#include "Logging/StreamLogger.h"
+
+// Cost to the caller of logging a message with a body_size body at a_level, through a group at INFO in front of a
+// stream logger at TRACE, as the daemon sets them up. If a_async is set the stream logger writes on its own thread.
+template<Logging::Level a_level, bool a_async>
+class test_logger_message
+{
+public:
+  static const size_t loop_count = 10;
+  static const size_t message_count = 10000;
+  static const size_t body_size = 1024;
+
+  // takes whatever is written and drops it
+  class null_buffer : public std::streambuf
+  {
+  protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+  };
+
+  test_logger_message() :
+    m_stream(&m_buffer), m_streamLogger(m_stream, Logging::TRACE), m_group(Logging::INFO), m_log(m_group, "bench"),
+    m_body(body_size, 'x'), m_messageCount(0), m_elapsed(0)
+  {
+    if (a_async)
+      m_streamLogger.enableAsyncWriting();
+
+    m_group.addLogger(m_streamLogger);
+  }
+
+  ~test_logger_message()
+  {
+    if (m_messageCount == 0)
+      return;
+
+    std::cout << "  " << Logging::ILogger::LEVEL_NAMES[a_level] << (a_level <= Logging::INFO ? " (enabled)" : " (disabled)") <<
+      (a_async ? ", async writer: " : ", sync writer: ") <<
+      boost::chrono::duration_cast<boost::chrono::nanoseconds>(m_elapsed).count() / m_messageCount << " ns per message" << std::endl;
+  }
+
+  bool init()
+  {
+    return true;
+  }
+
+  bool test()
+  {
+    auto start = boost::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < message_count; ++i)
+      m_log(a_level) << "Request " << i << " answered: " << m_body;
+
+    m_elapsed += boost::chrono::high_resolution_clock::now() - start;
+    m_messageCount += message_count;
+    return true;
+  }
+
+private:
+  null_buffer m_buffer;
+  std::ostream m_stream;
+  Logging::StreamLogger m_streamLogger;
+  Logging::LoggerGroup m_group;
+  Logging::LoggerRef m_log;
+  std::string m_body;
+  size_t m_messageCount;
+  boost::chrono::high_resolution_clock::duration m_elapsed;
+};
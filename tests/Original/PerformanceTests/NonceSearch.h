@@ -0,0 +1,201 @@
+// Copyright (c) 2018-2022 The Cash2 developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <atomic>
+#include <iostream>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#include <boost/chrono.hpp>
+
+#include "crypto/crypto.h"
+#include "CryptoNoteCore/CryptoNoteFormatUtils.h"
+#include "CryptoNoteCore/NonceSearcher.h"
+
+namespace nonce_search {
+
+  const size_t nonces_per_thread = 1 << 20;
+  const size_t longhash_nonces_per_thread = 1 << 14;
+  const size_t transaction_count = 100;
+
+  inline CryptoNote::Block make_block()
+  {
+    CryptoNote::Block block;
+    block.timestamp = 1;
+    block.nonce = 0;
+    block.previousBlockHash = Crypto::rand<Crypto::Hash>();
+    block.baseTransaction.version = 1;
+    block.baseTransaction.unlockTime = 0;
+    CryptoNote::BaseInput input;
+    input.blockIndex = 1;
+    block.baseTransaction.inputs.push_back(input);
+    block.transactionHashes.resize(transaction_count);
+    for (auto& hash : block.transactionHashes)
+      hash = Crypto::rand<Crypto::Hash>();
+
+    return block;
+  }
+
+  template<class F>
+  void run_threads(size_t thread_count, F f)
+  {
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < thread_count; ++i)
+      threads.emplace_back(f, i);
+
+    for (auto& thread : threads)
+      thread.join();
+  }
+
+  class hashrate_report
+  {
+  public:
+    hashrate_report(const char* name, size_t thread_count) :
+      m_name(name), m_thread_count(thread_count), m_hashes(0), m_elapsed(0)
+    {
+    }
+
+    ~hashrate_report()
+    {
+      if (m_elapsed.count() == 0)
+        return;
+
+      double seconds = boost::chrono::duration<double>(m_elapsed).count();
+      std::cout << "  " << m_name << ": " << static_cast<uint64_t>(m_hashes / seconds) << " H/s, "
+        << static_cast<uint64_t>(m_hashes / seconds / m_thread_count) << " H/s per thread" << std::endl;
+    }
+
+    template<class F>
+    void measure(F f)
+    {
+      auto start = boost::chrono::high_resolution_clock::now();
+      m_hashes += f();
+      m_elapsed += boost::chrono::high_resolution_clock::now() - start;
+    }
+
+  private:
+    const char* m_name;
+    size_t m_thread_count;
+    uint64_t m_hashes;
+    boost::chrono::high_resolution_clock::duration m_elapsed;
+  };
+
+}
+
+// Nonce search with the blob built once per template and several nonces hashed per call.
+// The difficulty is never met, so every thread hashes nonces_per_thread nonces per test.
+template<Crypto::NonceHashingMode a_mode, size_t a_thread_count>
+class test_nonce_search
+{
+public:
+  static const size_t loop_count = 10;
+
+  test_nonce_search() :
+    m_report(Crypto::Blake2bNonceHasher::modeName(a_mode), a_thread_count)
+  {
+  }
+
+  bool init()
+  {
+    if (!Crypto::Blake2bNonceHasher::isSupported(a_mode))
+    {
+      std::cout << Crypto::Blake2bNonceHasher::modeName(a_mode) << " is not supported by this CPU" << std::endl;
+      return false;
+    }
+
+    m_block = nonce_search::make_block();
+
+    // the kernel has to agree with get_block_longhash
+    CryptoNote::BinaryArray blob;
+    if (!CryptoNote::get_block_hashing_blob(m_block, blob))
+      return false;
+
+    Crypto::Blake2bNonceHasher hasher(blob.data(), blob.size(), sizeof(Crypto::Hash), a_mode);
+    Crypto::Hash hashes[Crypto::Blake2bNonceHasher::MAX_LANES];
+    if (hasher.hash(0, 1, std::numeric_limits<uint64_t>::max(), hashes) != (1u << hasher.lanes()) - 1)
+      return false;
+
+    Crypto::cn_context context;
+    for (size_t i = 0; i < hasher.lanes(); ++i)
+    {
+      CryptoNote::Block block = m_block;
+      block.nonce = i;
+      Crypto::Hash expected;
+      if (!CryptoNote::get_block_longhash(context, block, expected) || expected != hashes[i])
+        return false;
+    }
+
+    return true;
+  }
+
+  bool test()
+  {
+    std::atomic<bool> found(false);
+    m_report.measure([&] {
+      nonce_search::run_threads(a_thread_count, [&](size_t thread) {
+        CryptoNote::NonceSearcher searcher(m_block, std::numeric_limits<CryptoNote::difficulty_type>::max(), true, a_mode);
+        uint64_t nonce;
+        for (uint64_t first = thread; first < nonce_search::nonces_per_thread * a_thread_count; first += a_thread_count * searcher.noncesPerCall())
+          if (searcher.search(first, a_thread_count, nonce))
+            found = true;
+      });
+
+      return nonce_search::nonces_per_thread * a_thread_count;
+    });
+
+    return !found;
+  }
+
+private:
+  CryptoNote::Block m_block;
+  nonce_search::hashrate_report m_report;
+};
+
+// The same search calling get_block_longhash for every nonce, as the miners did before.
+template<size_t a_thread_count>
+class test_block_longhash_search
+{
+public:
+  static const size_t loop_count = 10;
+
+  test_block_longhash_search() :
+    m_report("get_block_longhash", a_thread_count)
+  {
+  }
+
+  bool init()
+  {
+    m_block = nonce_search::make_block();
+    return true;
+  }
+
+  bool test()
+  {
+    std::atomic<bool> found(false);
+    m_report.measure([&] {
+      nonce_search::run_threads(a_thread_count, [&](size_t thread) {
+        Crypto::cn_context context;
+        CryptoNote::Block block = m_block;
+        Crypto::Hash hash;
+        for (uint64_t nonce = thread; nonce < nonce_search::longhash_nonces_per_thread * a_thread_count; nonce += a_thread_count)
+        {
+          block.nonce = nonce;
+          if (!CryptoNote::get_block_longhash(context, block, hash) || CryptoNote::check_hash2(hash, std::numeric_limits<CryptoNote::difficulty_type>::max()))
+            found = true;
+        }
+      });
+
+      return nonce_search::longhash_nonces_per_thread * a_thread_count;
+    });
+
+    return !found;
+  }
+
+private:
+  CryptoNote::Block m_block;
+  nonce_search::hashrate_report m_report;
+};
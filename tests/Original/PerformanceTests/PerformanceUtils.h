@@ -58,3 +58,37 @@ void set_thread_high_priority()
   ::pthread_attr_destroy(&attr);
 #endif
 }
+
+// Threads inherit the affinity of the thread that starts them. Multi-threaded tests start their workers
+// inside this scope so they are not all pinned to the core chosen by set_process_affinity().
+class unpinned_thread_scope
+{
+public:
+  unpinned_thread_scope()
+  {
+#if defined(BOOST_HAS_PTHREADS) && !defined(__APPLE__)
+    ::pthread_getaffinity_np(::pthread_self(), sizeof(m_saved), &m_saved);
+
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    for (int i = 0; i < CPU_SETSIZE; ++i)
+    {
+      CPU_SET(i, &cpuset);
+    }
+
+    ::pthread_setaffinity_np(::pthread_self(), sizeof(cpuset), &cpuset);
+#endif
+  }
+
+  ~unpinned_thread_scope()
+  {
+#if defined(BOOST_HAS_PTHREADS) && !defined(__APPLE__)
+    ::pthread_setaffinity_np(::pthread_self(), sizeof(m_saved), &m_saved);
+#endif
+  }
+
+private:
+#if defined(BOOST_HAS_PTHREADS) && !defined(__APPLE__)
+  cpu_set_t m_saved;
+#endif
+};
@@ -0,0 +1,172 @@
+// Copyright (c) 2018-2022 The Cash2 developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <algorithm>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <vector>
+
+#include <boost/chrono.hpp>
+
+#include "BlockchainContention.h"
+
+// Throughput of the pool admitting a flood of a_batch relayed transactions, each spending one output with a ring of
+// ring_size. If a_batched is set the ring signatures of the batch are verified together first, as
+// core::handleIncomingTransactions() does, otherwise every transaction is verified when it is added.
+template<size_t a_batch, bool a_batched>
+class test_pool_admission
+{
+public:
+  static const size_t loop_count = 10;
+  static const size_t ring_size = 4;
+  static const size_t split_blocks = 20;
+
+  test_pool_admission() :
+    m_amount(0), m_admitted(0), m_elapsed(0)
+  {
+  }
+
+  ~test_pool_admission()
+  {
+    if (m_admitted == 0)
+      return;
+
+    double seconds = boost::chrono::duration<double>(m_elapsed).count();
+    std::cout << "  " << a_batch << " transactions, " << (a_batched ? "batched: " : "one at a time: ") <<
+      static_cast<uint64_t>(m_admitted / seconds) << " transactions/s" << std::endl;
+  }
+
+  bool init()
+  {
+    m_chain.reset(new blockchain_bench_chain());
+    if (!m_chain->init())
+      return false;
+
+    // the coinbase outputs of the first split_blocks blocks are unlocked once the chain is this long
+    for (size_t i = 0; i < split_blocks + m_chain->currency().minedMoneyUnlockWindow(); ++i)
+    {
+      if (!m_chain->add_block())
+        return false;
+    }
+
+    // coinbase transactions have a single output, so split them into outputs of one amount the rings are taken from
+    std::list<CryptoNote::Block> blocks;
+    if (!m_chain->blockchain().getBlocks(1, static_cast<uint32_t>(split_blocks), blocks))
+      return false;
+
+    m_amount = 2 * m_chain->currency().minimumFee();
+    std::vector<CryptoNote::Transaction> splits;
+    for (const CryptoNote::Block& block : blocks)
+    {
+      std::vector<blockchain_bench_chain::output> outputs;
+      if (!m_chain->get_outputs(block.baseTransaction, outputs))
+        return false;
+
+      uint64_t splitAmount = block.baseTransaction.outputs[0].amount - m_chain->currency().minimumFee();
+      std::vector<CryptoNote::TransactionDestinationEntry> destinations(splitAmount / m_amount,
+        CryptoNote::TransactionDestinationEntry(m_amount, m_chain->miner().getAccountKeys().address));
+      if (splitAmount % m_amount != 0)
+        destinations.push_back(CryptoNote::TransactionDestinationEntry(splitAmount % m_amount, m_chain->miner().getAccountKeys().address));
+
+      CryptoNote::Transaction split;
+      if (!m_chain->construct_transaction(outputs, 0, block.baseTransaction.outputs[0].amount, destinations, split) || !m_chain->add_to_pool(split))
+        return false;
+
+      splits.push_back(split);
+    }
+
+    CryptoNote::Block block;
+    if (!m_chain->make_block(splits, block) || !m_chain->add_block(block))
+      return false;
+
+    for (const CryptoNote::Transaction& split : splits)
+    {
+      std::vector<blockchain_bench_chain::output> outputs;
+      if (!m_chain->get_outputs(split, outputs))
+        return false;
+
+      for (size_t i = 0; i < outputs.size(); ++i)
+      {
+        if (split.outputs[i].amount == m_amount)
+          m_unspent.push_back(outputs[i]);
+      }
+    }
+
+    return m_unspent.size() >= a_batch && m_unspent.size() >= ring_size;
+  }
+
+  bool test()
+  {
+    // new transactions every time, verified ones are remembered by the blockchain
+    std::vector<CryptoNote::Transaction> transactions;
+    transactions.reserve(a_batch);
+    for (size_t real = 0; real < a_batch; ++real)
+    {
+      // the real output and the ones following it, in global index order
+      size_t first = std::min(real, m_unspent.size() - ring_size);
+      std::vector<blockchain_bench_chain::output> ring(m_unspent.begin() + first, m_unspent.begin() + first + ring_size);
+
+      std::vector<CryptoNote::TransactionDestinationEntry> destinations(1,
+        CryptoNote::TransactionDestinationEntry(m_amount - m_chain->currency().minimumFee(), m_chain->miner().getAccountKeys().address));
+
+      transactions.resize(transactions.size() + 1);
+      if (!m_chain->construct_transaction(ring, real - first, m_amount, destinations, transactions.back()))
+        return false;
+    }
+
+    // the hashes of a relayed transaction come with it from parsing, so they are worked out before the clock starts
+    std::vector<CryptoNote::CachedTransaction> cachedTransactions;
+    std::vector<const CryptoNote::CachedTransaction*> batch;
+    cachedTransactions.reserve(transactions.size());
+    for (const CryptoNote::Transaction& transaction : transactions)
+    {
+      cachedTransactions.emplace_back(transaction);
+      cachedTransactions.back().getTransactionPrefixHash();
+      batch.push_back(&cachedTransactions.back());
+    }
+
+    auto start = boost::chrono::high_resolution_clock::now();
+    if (a_batched)
+    {
+      std::vector<bool> invalidSignatures;
+      m_chain->blockchain().preverifyRingSignatures(batch, invalidSignatures);
+      for (size_t i = 0; i < transactions.size(); ++i)
+      {
+        if (invalidSignatures[i])
+          return false;
+      }
+    }
+
+    for (const CryptoNote::CachedTransaction& transaction : cachedTransactions)
+    {
+      if (!m_chain->add_to_pool(transaction))
+        return false;
+    }
+
+    m_elapsed += boost::chrono::high_resolution_clock::now() - start;
+    m_admitted += transactions.size();
+
+    // the next transactions spend the same outputs
+    for (const CryptoNote::CachedTransaction& transaction : cachedTransactions)
+    {
+      CryptoNote::Transaction taken;
+      size_t blobSize;
+      uint64_t fee;
+      if (!m_chain->pool().take_tx(transaction.getTransactionHash(), taken, blobSize, fee))
+        return false;
+    }
+
+    return true;
+  }
+
+private:
+  std::unique_ptr<blockchain_bench_chain> m_chain;
+  std::vector<blockchain_bench_chain::output> m_unspent;
+  uint64_t m_amount;
+  size_t m_admitted;
+  boost::chrono::high_resolution_clock::duration m_elapsed;
+};
@@ -0,0 +1,117 @@
+// Copyright (c) 2018-2022 The Cash2 developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <iostream>
+#include <list>
+#include <memory>
+#include <vector>
+
+#include <boost/chrono.hpp>
+
+#include "BlockchainContention.h"
+#include "Rpc/CoreRpcServerCommandsDefinitions.h"
+
+// Latency of getRandomOutsByAmount() picking a_outs_count mixins for each of amount_count amounts, as a wallet asks
+// for a transaction with amount_count inputs. Every amount has the outputs of split_blocks transactions spread over
+// as many blocks.
+template<size_t a_outs_count>
+class test_random_outputs
+{
+public:
+  static const size_t loop_count = 1000;
+  static const size_t amount_count = 4;
+  static const size_t split_blocks = 100;
+
+  test_random_outputs() :
+    m_calls(0), m_elapsed(0)
+  {
+  }
+
+  ~test_random_outputs()
+  {
+    if (m_calls == 0)
+      return;
+
+    std::cout << "  " << amount_count << " amounts, " << a_outs_count << " outputs each: " <<
+      boost::chrono::duration_cast<boost::chrono::microseconds>(m_elapsed).count() / m_calls << " us per request" << std::endl;
+  }
+
+  bool init()
+  {
+    m_chain.reset(new blockchain_bench_chain());
+    if (!m_chain->init())
+      return false;
+
+    // the coinbase outputs of the first split_blocks blocks are unlocked once the chain is this long
+    for (size_t i = 0; i < split_blocks + m_chain->currency().minedMoneyUnlockWindow(); ++i)
+    {
+      if (!m_chain->add_block())
+        return false;
+    }
+
+    std::list<CryptoNote::Block> blocks;
+    if (!m_chain->blockchain().getBlocks(1, static_cast<uint32_t>(split_blocks), blocks))
+      return false;
+
+    // every coinbase is split into amount_count outputs of the requested amounts, a block for each
+    uint64_t amountStep = m_chain->currency().minimumFee();
+    for (size_t i = 0; i < amount_count; ++i)
+      m_request.amounts.push_back((i + 1) * amountStep);
+
+    for (const CryptoNote::Block& block : blocks)
+    {
+      std::vector<blockchain_bench_chain::output> outputs;
+      if (!m_chain->get_outputs(block.baseTransaction, outputs))
+        return false;
+
+      std::vector<CryptoNote::TransactionDestinationEntry> destinations;
+      uint64_t change = block.baseTransaction.outputs[0].amount - m_chain->currency().minimumFee();
+      for (uint64_t amount : m_request.amounts)
+      {
+        destinations.push_back(CryptoNote::TransactionDestinationEntry(amount, m_chain->miner().getAccountKeys().address));
+        change -= amount;
+      }
+
+      destinations.push_back(CryptoNote::TransactionDestinationEntry(change, m_chain->miner().getAccountKeys().address));
+
+      CryptoNote::Transaction split;
+      CryptoNote::Block splitBlock;
+      if (!m_chain->construct_transaction(outputs, 0, block.baseTransaction.outputs[0].amount, destinations, split) ||
+        !m_chain->add_to_pool(split) || !m_chain->make_block(std::vector<CryptoNote::Transaction>(1, split), splitBlock) ||
+        !m_chain->add_block(splitBlock))
+        return false;
+    }
+
+    // the split outputs are old enough to be picked
+    for (size_t i = 0; i < m_chain->currency().minedMoneyUnlockWindow(); ++i)
+    {
+      if (!m_chain->add_block())
+        return false;
+    }
+
+    m_request.outs_count = a_outs_count;
+    return test() && m_response.outs.size() == amount_count && m_response.outs[0].outs.size() == a_outs_count;
+  }
+
+  bool test()
+  {
+    m_response = CryptoNote::COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::response();
+
+    auto start = boost::chrono::high_resolution_clock::now();
+    bool result = m_chain->blockchain().getRandomOutsByAmount(m_request, m_response);
+    m_elapsed += boost::chrono::high_resolution_clock::now() - start;
+    ++m_calls;
+
+    return result;
+  }
+
+private:
+  std::unique_ptr<blockchain_bench_chain> m_chain;
+  CryptoNote::COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::request m_request;
+  CryptoNote::COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::response m_response;
+  size_t m_calls;
+  boost::chrono::high_resolution_clock::duration m_elapsed;
+};
@@ -0,0 +1,91 @@
+// Copyright (c) 2018-2022 The Cash2 developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include <boost/chrono.hpp>
+
+#include "Logging/ConsoleLogger.h"
+#include "P2p/NetNode.h"
+#include "System/Dispatcher.h"
+
+// Cost of queueing a notification of relay_size bytes, about a large block, to the write queues of a_peers
+// connections, as NodeServer::relay_notify_to_all() does. If a_shared is set the connections share one buffer,
+// otherwise every connection gets its own copy.
+template<size_t a_peers, bool a_shared>
+class test_relay_notify
+{
+public:
+  static const size_t loop_count = 1000;
+  static const size_t relay_size = 100 * 1024;
+  static const uint32_t command = 2001;
+
+  test_relay_notify() :
+    m_logger(Logging::ERROR), m_payload(relay_size, 0x5a), m_relays(0), m_elapsed(0)
+  {
+  }
+
+  ~test_relay_notify()
+  {
+    if (m_relays == 0)
+      return;
+
+    std::cout << "  " << a_peers << " peers, " << (a_shared ? "shared buffer: " : "buffer per peer: ") <<
+      boost::chrono::duration_cast<boost::chrono::microseconds>(m_elapsed).count() / m_relays << " us per relay" << std::endl;
+  }
+
+  bool init()
+  {
+    for (size_t i = 0; i < a_peers; ++i)
+      m_connections.emplace_back(new CryptoNote::P2pConnectionContext(m_dispatcher, m_logger, System::TcpConnection()));
+
+    return true;
+  }
+
+  bool test()
+  {
+    auto start = boost::chrono::high_resolution_clock::now();
+    if (a_shared)
+    {
+      auto buffer = std::make_shared<const CryptoNote::BinaryArray>(m_payload);
+      for (auto& connection : m_connections)
+      {
+        if (!connection->pushMessage(CryptoNote::P2pMessage(CryptoNote::P2pMessage::NOTIFY, command, buffer)))
+          return false;
+      }
+    }
+    else
+    {
+      for (auto& connection : m_connections)
+      {
+        if (!connection->pushMessage(CryptoNote::P2pMessage(CryptoNote::P2pMessage::NOTIFY, command, m_payload)))
+          return false;
+      }
+    }
+
+    m_elapsed += boost::chrono::high_resolution_clock::now() - start;
+    ++m_relays;
+
+    // the write handlers of the connections take the messages
+    for (auto& connection : m_connections)
+    {
+      if (connection->popBuffer().size() != 1)
+        return false;
+    }
+
+    return true;
+  }
+
+private:
+  Logging::ConsoleLogger m_logger;
+  System::Dispatcher m_dispatcher;
+  std::vector<std::unique_ptr<CryptoNote::P2pConnectionContext>> m_connections;
+  CryptoNote::BinaryArray m_payload;
+  size_t m_relays;
+  boost::chrono::high_resolution_clock::duration m_elapsed;
+};
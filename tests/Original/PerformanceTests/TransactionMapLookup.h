@@ -0,0 +1,95 @@
+// Copyright (c) 2018-2022 The Cash2 developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/chrono.hpp>
+
+#include "crypto/crypto.h"
+#include "crypto/hash.h"
+#include "CryptoNoteCore/FlatHashMap.h"
+
+// Latency of looking up a transaction hash in a map of transaction_count transactions, half of the lookups for
+// transactions that aren't there, as Blockchain::haveTransaction() does for relayed ones. If a_flat is set the map is
+// the FlatHashMap the blockchain keeps, otherwise an std::unordered_map.
+template<bool a_flat>
+class test_transaction_map_lookup
+{
+public:
+  static const size_t loop_count = 10;
+  static const size_t transaction_count = 1000000;
+  static const size_t lookup_count = 100000;
+
+  struct TransactionIndex
+  {
+    uint32_t block;
+    uint16_t transaction;
+  };
+
+  test_transaction_map_lookup() :
+    m_flatMap(Crypto::rand<uint64_t>()), m_lookupCount(0), m_elapsed(0)
+  {
+  }
+
+  ~test_transaction_map_lookup()
+  {
+    if (m_lookupCount == 0)
+      return;
+
+    std::cout << "  " << transaction_count << " transactions, " << (a_flat ? "flat map: " : "unordered map: ") <<
+      boost::chrono::duration_cast<boost::chrono::nanoseconds>(m_elapsed).count() / m_lookupCount << " ns per lookup" << std::endl;
+  }
+
+  bool init()
+  {
+    for (uint32_t i = 0; i < transaction_count; ++i)
+    {
+      Crypto::Hash hash = Crypto::rand<Crypto::Hash>();
+      TransactionIndex index = { i, 0 };
+      if (a_flat)
+        m_flatMap.insert(hash, index);
+      else
+        m_map.insert(std::make_pair(hash, index));
+
+      if (m_lookups.size() < lookup_count / 2)
+        m_lookups.push_back(hash);
+    }
+
+    while (m_lookups.size() < lookup_count)
+      m_lookups.push_back(Crypto::rand<Crypto::Hash>());
+
+    std::shuffle(m_lookups.begin(), m_lookups.end(), std::default_random_engine());
+    return true;
+  }
+
+  bool test()
+  {
+    size_t found = 0;
+    auto start = boost::chrono::high_resolution_clock::now();
+    for (const Crypto::Hash& hash : m_lookups)
+    {
+      if (a_flat)
+        found += m_flatMap.find(hash) != nullptr ? 1 : 0;
+      else
+        found += m_map.find(hash) != m_map.end() ? 1 : 0;
+    }
+
+    m_elapsed += boost::chrono::high_resolution_clock::now() - start;
+    m_lookupCount += m_lookups.size();
+    return found == lookup_count / 2;
+  }
+
+private:
+  std::unordered_map<Crypto::Hash, TransactionIndex> m_map;
+  CryptoNote::FlatHashMap<Crypto::Hash, TransactionIndex> m_flatMap;
+  std::vector<Crypto::Hash> m_lookups;
+  size_t m_lookupCount;
+  boost::chrono::high_resolution_clock::duration m_elapsed;
+};
@@ -0,0 +1,111 @@
+// Copyright (c) 2018-2022 The Cash2 developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include <boost/chrono.hpp>
+
+#include "CryptoNoteCore/Account.h"
+#include "CryptoNoteCore/Currency.h"
+#include "CryptoNoteCore/TransactionApi.h"
+#include "Logging/LoggerGroup.h"
+#include "NodeRpcProxy/NodeRpcProxy.h"
+#include "Transfers/CommonTypes.h"
+#include "Transfers/TransfersConsumer.h"
+
+// Time TransfersConsumer::onNewBlocks() takes for a_blocks blocks with transactions_per_block transactions besides
+// the coinbase. A wallet following the chain gets a block at a time, one catching up gets thousands of them.
+template<size_t a_blocks>
+class test_transfers_consumer_scan
+{
+public:
+  static const size_t loop_count = a_blocks == 1 ? 1000 : 3;
+  static const size_t transactions_per_block = 2;
+  static const size_t distinct_transactions = 16;
+
+  test_transfers_consumer_scan() :
+    m_currency(CryptoNote::CurrencyBuilder(m_logger).currency()),
+    // the transactions don't pay to the wallet, so the consumer never asks the node for their global output indexes
+    m_node("127.0.0.1", 0),
+    m_height(1),
+    m_calls(0),
+    m_elapsed(0)
+  {
+  }
+
+  ~test_transfers_consumer_scan()
+  {
+    if (m_calls == 0)
+      return;
+
+    uint64_t microseconds = boost::chrono::duration_cast<boost::chrono::microseconds>(m_elapsed).count();
+    std::cout << "  " << a_blocks << " blocks: " << microseconds / m_calls << " us per call, " <<
+      static_cast<uint64_t>(a_blocks * m_calls * 1000000.0 / std::max<uint64_t>(microseconds, 1)) << " blocks/s" << std::endl;
+  }
+
+  bool init()
+  {
+    CryptoNote::AccountBase wallet;
+    wallet.generate();
+
+    CryptoNote::AccountSubscription subscription;
+    subscription.keys = wallet.getAccountKeys();
+    subscription.syncStart.height = 0;
+    subscription.syncStart.timestamp = 0;
+    subscription.transactionSpendableAge = 1;
+
+    m_consumer.reset(new CryptoNote::TransfersConsumer(m_currency, m_node, subscription.keys.viewSecretKey));
+    m_consumer->addSubscription(subscription);
+
+    std::vector<std::shared_ptr<CryptoNote::ITransactionReader>> transactions;
+    for (size_t i = 0; i < distinct_transactions; ++i)
+    {
+      CryptoNote::AccountBase receiver;
+      receiver.generate();
+
+      CryptoNote::Transaction transaction;
+      if (!m_currency.constructMinerTx1(static_cast<uint32_t>(i), 0, 0, 0, 0, receiver.getAccountKeys().address, transaction, CryptoNote::BinaryArray(), 4))
+        return false;
+
+      transactions.push_back(CryptoNote::createTransactionPrefix(transaction));
+    }
+
+    m_blocks.resize(a_blocks);
+    for (size_t i = 0; i < a_blocks; ++i)
+    {
+      m_blocks[i].blockHash = Crypto::rand<Crypto::Hash>();
+      m_blocks[i].block = CryptoNote::Block();
+      m_blocks[i].block->timestamp = 1;
+      for (size_t j = 0; j <= transactions_per_block; ++j)
+        m_blocks[i].transactions.push_back(transactions[(i * (transactions_per_block + 1) + j) % distinct_transactions]);
+    }
+
+    return true;
+  }
+
+  bool test()
+  {
+    auto start = boost::chrono::high_resolution_clock::now();
+    bool result = m_consumer->onNewBlocks(m_blocks.data(), m_height, static_cast<uint32_t>(a_blocks));
+    m_elapsed += boost::chrono::high_resolution_clock::now() - start;
+    ++m_calls;
+    m_height += static_cast<uint32_t>(a_blocks);
+
+    return result;
+  }
+
+private:
+  Logging::LoggerGroup m_logger;
+  CryptoNote::Currency m_currency;
+  CryptoNote::NodeRpcProxy m_node;
+  std::unique_ptr<CryptoNote::TransfersConsumer> m_consumer;
+  std::vector<CryptoNote::CompleteBlock> m_blocks;
+  uint32_t m_height;
+  size_t m_calls;
+  boost::chrono::high_resolution_clock::duration m_elapsed;
+};
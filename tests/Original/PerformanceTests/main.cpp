@@ -7,15 +7,29 @@
 #include "PerformanceUtils.h"
 
 // tests
+#include "AddPooledBlock.h"
+#include "BlockchainContention.h"
+#include "BlockStorage.h"
+#include "BlockTemplate.h"
 #include "ConstructTransaction.h"
 #include "CheckRingSignature.h"
 #include "CryptoNoteSlowHash.h"
+#include "DecodeBlocksResponse.h"
 #include "DerivePublicKey.h"
 #include "DeriveSecretKey.h"
 #include "GenerateKeyDerivation.h"
 #include "GenerateKeyImage.h"
 #include "GenerateKeyImageHelper.h"
+#include "GetBlocksResponse.h"
+#include "HttpServerLoad.h"
 #include "IsOutToAccount.h"
+#include "LogMessageCost.h"
+#include "NonceSearch.h"
+#include "PoolAdmission.h"
+#include "RandomOutputs.h"
+#include "RelayNotify.h"
+#include "TransactionMapLookup.h"
+#include "TransfersConsumerScan.h"
 
 int main(int argc, char** argv)
 {
@@ -51,6 +65,11 @@ int main(int argc, char** argv)
   TEST_PERFORMANCE1(test_check_ring_signature, 10);
   TEST_PERFORMANCE1(test_check_ring_signature, 100);
 
+  TEST_PERFORMANCE2(test_check_block_ring_signatures, 10, 1);
+  TEST_PERFORMANCE2(test_check_block_ring_signatures, 10, 4);
+  TEST_PERFORMANCE2(test_check_block_ring_signatures, 100, 1);
+  TEST_PERFORMANCE2(test_check_block_ring_signatures, 100, 4);
+
   TEST_PERFORMANCE0(test_is_out_to_acc);
   TEST_PERFORMANCE0(test_generate_key_image_helper);
   TEST_PERFORMANCE0(test_generate_key_derivation);
@@ -60,6 +79,61 @@ int main(int argc, char** argv)
 
   TEST_PERFORMANCE0(test_cn_slow_hash);
 
+  TEST_PERFORMANCE1(test_block_longhash_search, 1);
+  TEST_PERFORMANCE2(test_nonce_search, Crypto::NonceHashingMode::SCALAR, 1);
+  TEST_PERFORMANCE2(test_nonce_search, Crypto::NonceHashingMode::SSE41, 1);
+  TEST_PERFORMANCE2(test_nonce_search, Crypto::NonceHashingMode::AVX2, 1);
+  TEST_PERFORMANCE1(test_block_longhash_search, 4);
+  TEST_PERFORMANCE2(test_nonce_search, Crypto::NonceHashingMode::AVX2, 4);
+
+  TEST_PERFORMANCE2(test_blockchain_contention, 1, false);
+  TEST_PERFORMANCE2(test_blockchain_contention, 1, true);
+  TEST_PERFORMANCE2(test_blockchain_contention, 4, false);
+  TEST_PERFORMANCE2(test_blockchain_contention, 4, true);
+
+  TEST_PERFORMANCE1(test_add_pooled_block, 10);
+  TEST_PERFORMANCE1(test_add_pooled_block, 50);
+
+  TEST_PERFORMANCE1(test_get_blocks_response, false);
+  TEST_PERFORMANCE1(test_get_blocks_response, true);
+
+  TEST_PERFORMANCE2(test_decode_blocks_response, 100, false);
+  TEST_PERFORMANCE2(test_decode_blocks_response, 100, true);
+  TEST_PERFORMANCE2(test_decode_blocks_response, 1000, false);
+  TEST_PERFORMANCE2(test_decode_blocks_response, 1000, true);
+
+  TEST_PERFORMANCE2(test_http_server_load, 0, 1);
+  TEST_PERFORMANCE2(test_http_server_load, 4, 1);
+  TEST_PERFORMANCE2(test_http_server_load, 0, 8);
+  TEST_PERFORMANCE2(test_http_server_load, 4, 8);
+
+  TEST_PERFORMANCE2(test_relay_notify, 8, false);
+  TEST_PERFORMANCE2(test_relay_notify, 8, true);
+  TEST_PERFORMANCE2(test_relay_notify, 64, false);
+  TEST_PERFORMANCE2(test_relay_notify, 64, true);
+
+  TEST_PERFORMANCE1(test_transfers_consumer_scan, 1);
+  TEST_PERFORMANCE1(test_transfers_consumer_scan, 10000);
+
+  TEST_PERFORMANCE2(test_block_storage, SwappedVector<CryptoNote::Block>, false);
+  TEST_PERFORMANCE2(test_block_storage, MappedVector<CryptoNote::Block>, false);
+  TEST_PERFORMANCE2(test_block_storage, SwappedVector<CryptoNote::Block>, true);
+  TEST_PERFORMANCE2(test_block_storage, MappedVector<CryptoNote::Block>, true);
+
+  TEST_PERFORMANCE1(test_block_template, 100);
+  TEST_PERFORMANCE1(test_block_template, 1000);
+
+  TEST_PERFORMANCE2(test_pool_admission, 100, false);
+  TEST_PERFORMANCE2(test_pool_admission, 100, true);
+  TEST_PERFORMANCE1(test_random_outputs, 10);
+  TEST_PERFORMANCE1(test_random_outputs, 50);
+  TEST_PERFORMANCE1(test_transaction_map_lookup, false);
+  TEST_PERFORMANCE1(test_transaction_map_lookup, true);
+
+  TEST_PERFORMANCE2(test_logger_message, Logging::INFO, false);
+  TEST_PERFORMANCE2(test_logger_message, Logging::INFO, true);
+  TEST_PERFORMANCE2(test_logger_message, Logging::TRACE, false);
+
   std::cout << "Tests finished. Elapsed time: " << timer.elapsed_ms() / 1000 << " sec" << std::endl;
 
   return 0;
@@ -25,11 +25,11 @@ using namespace CryptoNote;
 using namespace CryptoNote;
 
 class TransactionValidator : public CryptoNote::ITransactionValidator {
-  virtual bool checkTransactionInputs(const CryptoNote::Transaction& tx, BlockInfo& maxUsedBlock) override {
+  virtual bool checkTransactionInputs(const CryptoNote::CachedTransaction& tx, BlockInfo& maxUsedBlock) override {
     return true;
   }
 
-  virtual bool checkTransactionInputs(const CryptoNote::Transaction& tx, BlockInfo& maxUsedBlock, BlockInfo& lastFailed) override {
+  virtual bool checkTransactionInputs(const CryptoNote::CachedTransaction& tx, BlockInfo& maxUsedBlock, BlockInfo& lastFailed) override {
     return true;
   }
 
@@ -0,0 +1,108 @@
+// Copyright (c) 2018-2022 The Cash2 developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "Logging/AsyncLogWriter.h"
+#include "Logging/LoggerRef.h"
+#include "Logging/StreamLogger.h"
+
+using namespace Logging;
+
+TEST(AsyncLogWriter, writesMessagesInPushOrder) {
+  std::vector<std::string> written;
+  {
+    AsyncLogWriter writer([&](const std::string& message) { written.push_back(message); }, 4);
+    for (size_t i = 0; i < 1000; ++i) {
+      writer.push(std::to_string(i));
+    }
+  }
+
+  ASSERT_EQ(1000, written.size());
+  for (size_t i = 0; i < written.size(); ++i) {
+    EXPECT_EQ(std::to_string(i), written[i]);
+  }
+}
+
+TEST(AsyncLogWriter, flushWaitsForPushedMessages) {
+  std::atomic<size_t> writtenCount(0);
+  AsyncLogWriter writer([&](const std::string&) { std::this_thread::sleep_for(std::chrono::microseconds(100)); ++writtenCount; }, 16);
+  for (size_t i = 0; i < 100; ++i) {
+    writer.push("message");
+  }
+
+  writer.flush();
+  EXPECT_EQ(100, writtenCount);
+}
+
+TEST(AsyncLogWriter, keepsTheOrderOfEveryPushingThread) {
+  const size_t threadCount = 4;
+  const size_t messageCount = 10000;
+  std::vector<std::vector<size_t>> written(threadCount);
+  {
+    AsyncLogWriter writer([&](const std::string& message) {
+      size_t separator = message.find(' ');
+      written[std::stoul(message.substr(0, separator))].push_back(std::stoul(message.substr(separator + 1)));
+    }, 64);
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < threadCount; ++t) {
+      threads.emplace_back([&writer, t, messageCount] {
+        for (size_t i = 0; i < messageCount; ++i) {
+          writer.push(std::to_string(t) + " " + std::to_string(i));
+        }
+      });
+    }
+
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+  for (const std::vector<size_t>& messages : written) {
+    ASSERT_EQ(messageCount, messages.size());
+    for (size_t i = 0; i < messages.size(); ++i) {
+      ASSERT_EQ(i, messages[i]);
+    }
+  }
+}
+
+TEST(AsyncLogWriter, asyncStreamLoggerWritesEverything) {
+  std::ostringstream stream;
+  {
+    StreamLogger logger(stream, TRACE);
+    logger.setPattern("");
+    logger.enableAsyncWriting();
+    LoggerRef log(logger, "test");
+    for (size_t i = 0; i < 100; ++i) {
+      log(INFO) << "message " << i;
+    }
+  }
+
+  std::string expected;
+  for (size_t i = 0; i < 100; ++i) {
+    expected += "message " + std::to_string(i) + "\n";
+  }
+
+  EXPECT_EQ(expected, stream.str());
+}
+
+TEST(LoggerRef, disabledLevelIsNotFormatted) {
+  std::ostringstream stream;
+  StreamLogger logger(stream, INFO);
+  logger.setPattern("");
+  LoggerRef log(logger, "test");
+
+  EXPECT_TRUE(log(TRACE).fail());
+  EXPECT_FALSE(log(INFO).fail());
+
+  log(TRACE) << "trace " << 1;
+  log(INFO) << "info " << 2;
+  EXPECT_EQ("info 2\n", stream.str());
+}
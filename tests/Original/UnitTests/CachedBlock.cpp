@@ -0,0 +1,82 @@
+// Copyright (c) 2018-2022 The Cash2 developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "gtest/gtest.h"
+
+#include "crypto/crypto.h"
+#include "CryptoNoteCore/CachedBlock.h"
+#include "CryptoNoteCore/CryptoNoteFormatUtils.h"
+#include "CryptoNoteCore/CryptoNoteTools.h"
+#include "CryptoNoteCore/Currency.h"
+#include "Logging/ConsoleLogger.h"
+
+#include "TestBlockchainGenerator.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+class CachedBlockTest : public ::testing::Test {
+public:
+  CachedBlockTest() :
+    m_currency(CurrencyBuilder(m_logger).currency()),
+    m_generator(m_currency) {
+  }
+
+protected:
+  Logging::ConsoleLogger m_logger;
+  Currency m_currency;
+  TestBlockchainGenerator m_generator;
+};
+
+}
+
+TEST_F(CachedBlockTest, transactionHashesMatchTheOnesOfTheTransaction) {
+  ASSERT_TRUE(m_generator.generateTransactionsInOneBlock(m_generator.getMinerAccount().getAccountKeys().address, 3));
+
+  const Block& block = m_generator.getBlockchain().back();
+  ASSERT_EQ(3, block.transactionHashes.size());
+
+  for (const Crypto::Hash& transactionHash : block.transactionHashes) {
+    Transaction transaction;
+    ASSERT_TRUE(m_generator.getTransactionByHash(transactionHash, transaction));
+
+    CachedTransaction cachedTransaction(transaction);
+    EXPECT_EQ(transactionHash, cachedTransaction.getTransactionHash());
+    EXPECT_EQ(getObjectHash(*static_cast<TransactionPrefix*>(&transaction)), cachedTransaction.getTransactionPrefixHash());
+    EXPECT_EQ(toBinaryArray(transaction), cachedTransaction.getTransactionBinaryArray());
+    EXPECT_EQ(getObjectBinarySize(transaction), cachedTransaction.getTransactionBinarySize());
+  }
+}
+
+TEST_F(CachedBlockTest, blockHashesMatchTheOnesOfTheBlock) {
+  ASSERT_TRUE(m_generator.generateTransactionsInOneBlock(m_generator.getMinerAccount().getAccountKeys().address, 3));
+
+  for (const Block& block : m_generator.getBlockchain()) {
+    CachedBlock cachedBlock(block);
+
+    BinaryArray hashingBlob;
+    ASSERT_TRUE(get_block_hashing_blob(block, hashingBlob));
+    EXPECT_EQ(hashingBlob, cachedBlock.getBlockHashingBinaryArray());
+    EXPECT_EQ(get_block_hash(block), cachedBlock.getBlockHash());
+    EXPECT_EQ(get_tx_tree_hash(block), cachedBlock.getTransactionTreeHash());
+    EXPECT_EQ(getObjectHash(block.baseTransaction), cachedBlock.getBaseTransaction().getTransactionHash());
+
+    Crypto::cn_context context;
+    Crypto::Hash longHash;
+    ASSERT_TRUE(get_block_longhash(context, block, longHash));
+    EXPECT_EQ(longHash, cachedBlock.getBlockLongHash());
+  }
+}
+
+TEST_F(CachedBlockTest, givenHashesAreNotRecomputed) {
+  const Block& block = m_generator.getBlockchain().front();
+  Crypto::Hash transactionHash = Crypto::rand<Crypto::Hash>();
+  Crypto::Hash transactionPrefixHash = Crypto::rand<Crypto::Hash>();
+
+  CachedTransaction cachedTransaction(block.baseTransaction, transactionHash, transactionPrefixHash, 12345);
+  EXPECT_EQ(transactionHash, cachedTransaction.getTransactionHash());
+  EXPECT_EQ(transactionPrefixHash, cachedTransaction.getTransactionPrefixHash());
+  EXPECT_EQ(12345, cachedTransaction.getTransactionBinarySize());
+}
@@ -0,0 +1,128 @@
+// Copyright (c) 2018-2022 The Cash2 developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "crypto/crypto.h"
+#include "crypto/hash.h"
+#include "CryptoNoteCore/FlatHashMap.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+std::vector<Crypto::Hash> randomHashes(size_t count) {
+  std::vector<Crypto::Hash> hashes(count);
+  for (Crypto::Hash& hash : hashes) {
+    hash = Crypto::rand<Crypto::Hash>();
+  }
+
+  return hashes;
+}
+
+// The first 8 bytes are the same, so all of them start probing at the same slot
+std::vector<Crypto::Hash> collidingHashes(size_t count) {
+  std::vector<Crypto::Hash> hashes = randomHashes(count);
+  for (Crypto::Hash& hash : hashes) {
+    std::fill(hash.data, hash.data + 8, 0x5a);
+  }
+
+  return hashes;
+}
+
+void checkContents(const FlatHashMap<Crypto::Hash, size_t>& map, const std::vector<Crypto::Hash>& hashes, size_t erasedEvery) {
+  size_t expectedSize = 0;
+  for (size_t i = 0; i < hashes.size(); ++i) {
+    const size_t* value = map.find(hashes[i]);
+    if (erasedEvery != 0 && i % erasedEvery == 0) {
+      EXPECT_EQ(nullptr, value);
+    } else {
+      ASSERT_NE(nullptr, value);
+      EXPECT_EQ(i, *value);
+      ++expectedSize;
+    }
+  }
+
+  EXPECT_EQ(expectedSize, map.size());
+}
+
+}
+
+TEST(FlatHashMap, findsInsertedKeys) {
+  FlatHashMap<Crypto::Hash, size_t> map(Crypto::rand<uint64_t>());
+  std::vector<Crypto::Hash> hashes = randomHashes(10000);
+  for (size_t i = 0; i < hashes.size(); ++i) {
+    ASSERT_TRUE(map.insert(hashes[i], i));
+  }
+
+  checkContents(map, hashes, 0);
+  for (const Crypto::Hash& hash : randomHashes(1000)) {
+    EXPECT_FALSE(map.contains(hash));
+  }
+}
+
+TEST(FlatHashMap, insertKeepsValueOfExistingKey) {
+  FlatHashMap<Crypto::Hash, size_t> map(Crypto::rand<uint64_t>());
+  Crypto::Hash hash = Crypto::rand<Crypto::Hash>();
+  ASSERT_TRUE(map.insert(hash, 1));
+  ASSERT_FALSE(map.insert(hash, 2));
+  ASSERT_EQ(1, map.size());
+  EXPECT_EQ(1, *map.find(hash));
+}
+
+TEST(FlatHashMap, eraseKeepsOtherKeys) {
+  FlatHashMap<Crypto::Hash, size_t> map(Crypto::rand<uint64_t>());
+  std::vector<Crypto::Hash> hashes = randomHashes(10000);
+  for (size_t i = 0; i < hashes.size(); ++i) {
+    map.insert(hashes[i], i);
+  }
+
+  for (size_t i = 0; i < hashes.size(); i += 3) {
+    ASSERT_EQ(1, map.erase(hashes[i]));
+    ASSERT_EQ(0, map.erase(hashes[i]));
+  }
+
+  checkContents(map, hashes, 3);
+}
+
+TEST(FlatHashMap, handlesKeysWithSamePrefix) {
+  FlatHashMap<Crypto::Hash, size_t> map(Crypto::rand<uint64_t>());
+  std::vector<Crypto::Hash> hashes = collidingHashes(100);
+  for (size_t i = 0; i < hashes.size(); ++i) {
+    ASSERT_TRUE(map.insert(hashes[i], i));
+  }
+
+  for (size_t i = 0; i < hashes.size(); i += 2) {
+    ASSERT_EQ(1, map.erase(hashes[i]));
+  }
+
+  checkContents(map, hashes, 2);
+}
+
+TEST(FlatHashMap, assignRestoresSavedMap) {
+  FlatHashMap<Crypto::Hash, size_t> map(Crypto::rand<uint64_t>());
+  std::vector<Crypto::Hash> hashes = randomHashes(1000);
+  for (size_t i = 0; i < hashes.size(); ++i) {
+    map.insert(hashes[i], i);
+  }
+
+  FlatHashMap<Crypto::Hash, size_t> loaded(Crypto::rand<uint64_t>());
+  std::vector<Crypto::Hash> keys = map.keys();
+  std::vector<size_t> values = map.values();
+  loaded.assign(std::move(keys), std::move(values));
+  checkContents(loaded, hashes, 0);
+}
+
+TEST(FlatHashMap, assignThrowsOnDuplicateKeys) {
+  FlatHashMap<Crypto::Hash, size_t> map(Crypto::rand<uint64_t>());
+  std::vector<Crypto::Hash> keys = randomHashes(100);
+  keys.push_back(keys[42]);
+  std::vector<size_t> values(keys.size());
+  ASSERT_THROW(map.assign(std::move(keys), std::move(values)), std::runtime_error);
+  EXPECT_TRUE(map.empty());
+}
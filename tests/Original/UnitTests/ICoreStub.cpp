@@ -8,6 +8,7 @@
 
 #include "ICoreStub.h"
 
+#include "CryptoNoteCore/CachedTransaction.h"
 #include "CryptoNoteCore/CryptoNoteFormatUtils.h"
 #include "CryptoNoteCore/CryptoNoteTools.h"
 #include "CryptoNoteCore/IBlock.h"
@@ -333,14 +334,26 @@ std::unique_ptr<CryptoNote::IBlock> ICoreStub::getBlock(const Crypto::Hash& bloc
   return std::unique_ptr<CryptoNote::IBlock>(nullptr);
 }
 
-bool ICoreStub::handleIncomingTransaction(const CryptoNote::Transaction& tx, const Crypto::Hash& txHash, size_t blobSize, CryptoNote::tx_verification_context& tvc, bool keptByBlock, uint32_t blockHeight) {
-  auto result = transactionPool.emplace(std::make_pair(txHash, tx));
+bool ICoreStub::handleIncomingTransaction(const CryptoNote::CachedTransaction& transaction, CryptoNote::tx_verification_context& tvc, bool keptByBlock, uint32_t blockHeight) {
+  auto result = transactionPool.emplace(std::make_pair(transaction.getTransactionHash(), transaction.getTransaction()));
   tvc.m_verification_failed = !poolTxVerificationResult;
   tvc.m_added_to_pool = true;
   tvc.m_should_be_relayed = result.second;
   return poolTxVerificationResult;
 }
 
+bool ICoreStub::prevalidateTransaction(const CryptoNote::CachedTransaction& transaction, CryptoNote::tx_verification_context& tvc, bool keptByBlock, uint32_t blockHeight) {
+  return true;
+}
+
+bool ICoreStub::handlePrevalidatedTransaction(const CryptoNote::CachedTransaction& transaction, CryptoNote::tx_verification_context& tvc, bool keptByBlock) {
+  return handleIncomingTransaction(transaction, tvc, keptByBlock, 0);
+}
+
+void ICoreStub::handleIncomingTransactions(const std::vector<CryptoNote::BinaryArray>& txBlobs, std::vector<CryptoNote::tx_verification_context>& tvcs, bool keptByBlock) {
+  tvcs.assign(txBlobs.size(), CryptoNote::tx_verification_context());
+}
+
 bool ICoreStub::have_block(const Crypto::Hash& id) {
   return blocks.count(id) > 0;
 }
@@ -76,7 +76,10 @@ public:
   virtual bool getPoolTransactionsByTimestamp(uint64_t timestampBegin, uint64_t timestampEnd, uint32_t transactionsNumberLimit, std::vector<CryptoNote::Transaction>& transactions, uint64_t& transactionsNumberWithinTimestamps) override;
   virtual bool getTransactionsByPaymentId(const Crypto::Hash& paymentId, std::vector<CryptoNote::Transaction>& transactions) override;
   virtual std::unique_ptr<CryptoNote::IBlock> getBlock(const Crypto::Hash& blockId) override;
-  virtual bool handleIncomingTransaction(const CryptoNote::Transaction& tx, const Crypto::Hash& txHash, size_t blobSize, CryptoNote::tx_verification_context& tvc, bool keptByBlock, uint32_t blockHeight) override;
+  virtual bool handleIncomingTransaction(const CryptoNote::CachedTransaction& transaction, CryptoNote::tx_verification_context& tvc, bool keptByBlock, uint32_t blockHeight) override;
+  virtual bool prevalidateTransaction(const CryptoNote::CachedTransaction& transaction, CryptoNote::tx_verification_context& tvc, bool keptByBlock, uint32_t blockHeight) override;
+  virtual bool handlePrevalidatedTransaction(const CryptoNote::CachedTransaction& transaction, CryptoNote::tx_verification_context& tvc, bool keptByBlock) override;
+  virtual void handleIncomingTransactions(const std::vector<CryptoNote::BinaryArray>& txBlobs, std::vector<CryptoNote::tx_verification_context>& tvcs, bool keptByBlock) override;
   virtual std::error_code executeLocked(const std::function<std::error_code()>& func) override;
 
   virtual bool addMessageQueue(CryptoNote::MessageQueue<CryptoNote::BlockchainMessage>& messageQueuePtr) override;
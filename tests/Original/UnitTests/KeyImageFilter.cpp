@@ -0,0 +1,69 @@
+// Copyright (c) 2018-2022 The Cash2 developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "crypto/crypto.h"
+#include "CryptoNoteCore/KeyImageFilter.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+const size_t CAPACITY = 100000;
+const size_t ABSENT_LOOKUPS = 200000;
+
+std::vector<Crypto::KeyImage> randomKeyImages(size_t count) {
+  std::vector<Crypto::KeyImage> keyImages(count);
+  for (Crypto::KeyImage& keyImage : keyImages) {
+    keyImage = Crypto::rand<Crypto::KeyImage>();
+  }
+
+  return keyImages;
+}
+
+}
+
+TEST(KeyImageFilter, emptyFilterContainsNothing) {
+  KeyImageFilter filter(CAPACITY, Crypto::rand<uint64_t>());
+  for (const Crypto::KeyImage& keyImage : randomKeyImages(1000)) {
+    EXPECT_FALSE(filter.mayContain(keyImage));
+  }
+
+  EXPECT_EQ(0, filter.falsePositiveRate());
+}
+
+TEST(KeyImageFilter, containsAddedKeyImages) {
+  KeyImageFilter filter(CAPACITY, Crypto::rand<uint64_t>());
+  std::vector<Crypto::KeyImage> keyImages = randomKeyImages(CAPACITY);
+  for (const Crypto::KeyImage& keyImage : keyImages) {
+    filter.add(keyImage);
+  }
+
+  for (const Crypto::KeyImage& keyImage : keyImages) {
+    ASSERT_TRUE(filter.mayContain(keyImage));
+  }
+}
+
+TEST(KeyImageFilter, falsePositiveRateAtCapacityIsSmallAndEstimated) {
+  KeyImageFilter filter(CAPACITY, Crypto::rand<uint64_t>());
+  for (const Crypto::KeyImage& keyImage : randomKeyImages(CAPACITY)) {
+    filter.add(keyImage);
+  }
+
+  size_t falsePositives = 0;
+  for (const Crypto::KeyImage& keyImage : randomKeyImages(ABSENT_LOOKUPS)) {
+    if (filter.mayContain(keyImage)) {
+      ++falsePositives;
+    }
+  }
+
+  double measuredRate = static_cast<double>(falsePositives) / ABSENT_LOOKUPS;
+  EXPECT_LT(measuredRate, 0.002);
+  EXPECT_LT(filter.falsePositiveRate(), 0.002);
+  EXPECT_NEAR(filter.falsePositiveRate(), measuredRate, 0.0005);
+  EXPECT_LE(filter.memoryUsage(), CAPACITY * 2 + 64);
+}
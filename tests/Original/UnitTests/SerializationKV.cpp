@@ -7,6 +7,7 @@
 
 #include <boost/lexical_cast.hpp>
 
+#include "Common/MemoryInputStream.h"
 #include "Serialization/KVBinaryInputStreamSerializer.h"
 #include "Serialization/KVBinaryOutputStreamSerializer.h"
 #include "Serialization/SerializationOverloads.h"
@@ -69,6 +70,23 @@ struct TestStruct {
 
 };
 
+// The fields TestStruct reads, in another order, and fields it doesn't have
+struct ReorderedStruct {
+  uint64_t u64;
+  TestElement root;
+  std::vector<TestElement> vec1;
+  uint8_t u8;
+  std::string missing;
+
+  void serialize(ISerializer& s) {
+    s(u64, "u64");
+    s(missing, "missing");
+    s(vec1, "vec1");
+    s(root, "root");
+    s(u8, "u8");
+  }
+};
+
 }
 
 
@@ -122,3 +140,70 @@ TEST(KVSerialize, BigCollection) {
   ASSERT_TRUE(CryptoNote::loadFromBinaryKeyValue(ts2, buf));
   EXPECT_EQ(ts1, ts2);
 }
+
+TEST(KVSerialize, BufferReaderReadsWhatStreamReaderReads) {
+  TestStruct ts1;
+  ts1.u8 = 7;
+  ts1.u32 = 0xabcdef;
+  ts1.u64 = 1ULL << 50;
+  ts1.root.name = "root";
+  ts1.root.u32array.assign(3, 9);
+
+  TestElement sample;
+  sample.name = "sample";
+  sample.nonce = 11;
+  sample.blob.fill(0x42);
+  ts1.vec1.resize(100, sample);
+  ts1.vec2.resize(3);
+
+  std::string buf = CryptoNote::storeToBinaryKeyValue(ts1);
+
+  TestStruct fromStream;
+  Common::MemoryInputStream stream(buf.data(), buf.size());
+  KVBinaryInputStreamSerializer streamSerializer(stream);
+  serialize(fromStream, streamSerializer);
+
+  TestStruct fromBuffer;
+  KVBinaryInputBufferSerializer bufferSerializer(buf.data(), buf.size());
+  serialize(fromBuffer, bufferSerializer);
+
+  EXPECT_EQ(ts1, fromStream);
+  EXPECT_EQ(ts1, fromBuffer);
+}
+
+TEST(KVSerialize, BufferReaderFindsFieldsInAnyOrder) {
+  TestStruct ts;
+  ts.u8 = 1;
+  ts.u32 = 2;
+  ts.u64 = 3;
+  ts.root.name = "root";
+  ts.root.nonce = 4;
+  ts.vec1.resize(10);
+  ts.vec1[5].name = "fifth";
+  ts.vec2.resize(20);
+
+  ReorderedStruct reordered;
+  reordered.missing = "kept";
+  ASSERT_TRUE(CryptoNote::loadFromBinaryKeyValue(reordered, CryptoNote::storeToBinaryKeyValue(ts)));
+  EXPECT_EQ(ts.u64, reordered.u64);
+  EXPECT_EQ(ts.root, reordered.root);
+  EXPECT_EQ(ts.vec1, reordered.vec1);
+  EXPECT_EQ(ts.u8, reordered.u8);
+  EXPECT_EQ("kept", reordered.missing);
+}
+
+TEST(KVSerialize, BufferReaderRejectsTruncatedStorage) {
+  TestStruct ts;
+  ts.u8 = 1;
+  ts.u32 = 2;
+  ts.u64 = 3;
+  ts.root.name = "root";
+  ts.vec1.resize(3);
+  ts.vec1[1].u32array.assign(5, 1);
+
+  std::string buf = CryptoNote::storeToBinaryKeyValue(ts);
+  for (size_t size = 0; size < buf.size(); ++size) {
+    TestStruct loaded;
+    EXPECT_FALSE(CryptoNote::loadFromBinaryKeyValue(loaded, buf.substr(0, size))) << size;
+  }
+}
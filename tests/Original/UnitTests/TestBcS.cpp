@@ -719,8 +719,8 @@ TEST_F(BcSTest, poolSynchronizationCheckError) {
   EventWaiter e;
   std::error_code errc;
   o1.syncFunc = [&](std::error_code ec) {
-    e.notify();
     errc = ec;
+    e.notify();
   };
 
   m_sync.addObserver(&o1);
@@ -945,8 +945,8 @@ TEST_F(BcSTest, poolSynchronizationCheckConsumerReturnError) {
   EventWaiter e;
   std::error_code errc;
   o1.syncFunc = [&](std::error_code ec) {
-    e.notify();
     errc = ec;
+    e.notify();
   };
 
   m_sync.addObserver(&o1);
@@ -985,8 +985,8 @@ TEST_F(BcSTest, checkINodeError) {
   EventWaiter e;
   std::error_code errc;
   o1.syncFunc = [&](std::error_code ec) {
-    e.notify();
     errc = ec;
+    e.notify();
   };
 
   m_node.queryBlocksFunctor = [](const std::vector<Hash>& knownBlockIds, uint64_t timestamp, std::vector<BlockShortEntry>& newBlocks, uint32_t& startHeight, const INode::Callback& callback) -> bool {
@@ -1010,8 +1010,8 @@ TEST_F(BcSTest, checkConsumerError) {
   EventWaiter e;
   std::error_code errc;
   o1.syncFunc = [&](std::error_code ec) {
-    e.notify();
     errc = ec;
+    e.notify();
   };
 
   generator.generateEmptyBlocks(10);
@@ -1037,8 +1037,8 @@ TEST_F(BcSTest, checkBlocksRequesting) {
   EventWaiter e;
   std::error_code errc;
   o1.syncFunc = [&](std::error_code ec) {
-    e.notify();
     errc = ec;
+    e.notify();
   };
 
 
@@ -1071,8 +1071,8 @@ TEST_F(BcSTest, checkConsumerHeightReceived) {
   EventWaiter e;
   std::error_code errc;
   o1.syncFunc = [&](std::error_code ec) {
-    e.notify();
     errc = ec;
+    e.notify();
   };
 
 
@@ -1116,8 +1116,8 @@ TEST_F(BcSTest, checkConsumerOldBlocksNotIvoked) {
   EventWaiter e;
   std::error_code errc;
   o1.syncFunc = [&](std::error_code ec) {
-    e.notify();
     errc = ec;
+    e.notify();
   };
 
   generator.generateEmptyBlocks(20);
@@ -1158,8 +1158,8 @@ TEST_F(BcSTest, checkConsumerHeightReceivedOnDetach) {
   EventWaiter e;
   std::error_code errc;
   o1.syncFunc = [&](std::error_code ec) {
-    e.notify();
     errc = ec;
+    e.notify();
   };
 
   generator.generateEmptyBlocks(20);
@@ -1207,8 +1207,8 @@ TEST_F(BcSTest, checkStatePreservingBetweenSynchronizations) {
   EventWaiter e;
   std::error_code errc;
   o1.syncFunc = [&](std::error_code ec) {
-    e.notify();
     errc = ec;
+    e.notify();
   };
 
   generator.generateEmptyBlocks(20);
@@ -1244,8 +1244,8 @@ TEST_F(BcSTest, checkBlocksRerequestingOnError) {
   EventWaiter e;
   std::error_code errc;
   o1.syncFunc = [&](std::error_code ec) {
-    e.notify();
     errc = ec;
+    e.notify();
   };
 
   generator.generateEmptyBlocks(20);
@@ -1314,8 +1314,8 @@ TEST_F(BcSTest, checkTxOrder) {
   EventWaiter e;
   std::error_code errc;
   o1.syncFunc = [&](std::error_code ec) {
-    e.notify();
     errc = ec;
+    e.notify();
   };
 
   auto tx1ptr = createTransaction();
@@ -1380,3 +1380,51 @@ TEST_F(BcSTest, checkTxOrder) {
 
   EXPECT_EQ(expectedTxHashes, receivedTxHashes);
 }
+
+TEST_F(BcSTest, checkPrefetchedBlocksRequesting) {
+  addConsumers(1);
+  generator.generateEmptyBlocks(50);
+  m_node.setGetNewBlocksLimit(3);
+  m_sync.setPrefetchDepth(3);
+
+  startSync();
+  m_sync.stop();
+
+  checkSyncedBlockchains();
+
+  BlockchainSynchronizerStatistics statistics = m_sync.getStatistics();
+  EXPECT_LT(0u, statistics.prefetchedQueries);
+  EXPECT_EQ(0u, statistics.discardedQueries);
+  EXPECT_LT(0u, statistics.bytes);
+}
+
+TEST_F(BcSTest, checkPrefetchedBlocksOnDetach) {
+  addConsumers(1);
+  generator.generateEmptyBlocks(30);
+  m_node.setGetNewBlocksLimit(5);
+  m_sync.setPrefetchDepth(1);
+
+  // the node switches to another chain before it answers the first prefetching query
+  size_t queryCount = 0;
+  m_node.queryBlocksFunctor = [&](const std::vector<Hash>&, uint64_t, std::vector<BlockShortEntry>&, uint32_t&, const INode::Callback&) -> bool {
+    if (++queryCount == 2) {
+      m_node.startAlternativeChain(3);
+      generator.generateEmptyBlocks(40);
+    }
+
+    return true;
+  };
+
+  startSync();
+  m_sync.stop();
+
+  checkSyncedBlockchains();
+  EXPECT_LT(0u, m_sync.getStatistics().prefetchedQueries);
+}
+
+TEST_F(BcSTest, setPrefetchDepthStartThrow) {
+  addConsumers(1);
+  m_sync.start();
+  ASSERT_ANY_THROW(m_sync.setPrefetchDepth(2));
+  m_sync.stop();
+}
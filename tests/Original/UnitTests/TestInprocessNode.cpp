@@ -16,6 +16,7 @@
 #include "InProcessNode/InProcessNode.h"
 #include "TestBlockchainGenerator.h"
 #include "Logging/FileLogger.h"
+#include "CryptoNoteCore/CachedTransaction.h"
 #include "CryptoNoteCore/TransactionApi.h"
 #include "CryptoNoteCore/CryptoNoteTools.h"
 #include "CryptoNoteCore/VerificationContext.h"
@@ -687,7 +688,7 @@ TEST_F(InProcessNodeTests, getPoolDiffereceActualBC) {
     transactionHashes.insert(CryptoNote::getObjectHash(tx));
     CryptoNote::tx_verification_context tvc = boost::value_initialized<tx_verification_context>();
     bool keptByBlock = false;
-    coreStub.handleIncomingTransaction(tx, CryptoNote::getObjectHash(tx), CryptoNote::getObjectBinarySize(tx), tvc, keptByBlock, node.getLastLocalBlockHeight());
+    coreStub.handleIncomingTransaction(CryptoNote::CachedTransaction(tx), tvc, keptByBlock, node.getLastLocalBlockHeight());
     ASSERT_TRUE(tvc.m_added_to_pool);
     ASSERT_FALSE(tvc.m_verification_failed);
   }
@@ -726,7 +727,7 @@ TEST_F(InProcessNodeTests, getPoolDiffereceNotActualBC) {
     transactionHashes.insert(CryptoNote::getObjectHash(tx));
     CryptoNote::tx_verification_context tvc = boost::value_initialized<tx_verification_context>();
     bool keptByBlock = false;
-    coreStub.handleIncomingTransaction(tx, CryptoNote::getObjectHash(tx), CryptoNote::getObjectBinarySize(tx), tvc, keptByBlock, node.getLastLocalBlockHeight());
+    coreStub.handleIncomingTransaction(CryptoNote::CachedTransaction(tx), tvc, keptByBlock, node.getLastLocalBlockHeight());
     ASSERT_TRUE(tvc.m_added_to_pool);
     ASSERT_FALSE(tvc.m_verification_failed);
   }
@@ -14,6 +14,7 @@
 #include "CryptoNoteCore/Currency.h"
 #include "CryptoNoteCore/TransactionApi.h"
 #include "CryptoNoteCore/TransactionApiExtra.h"
+#include "CryptoNoteCore/TransactionExtra.h"
 #include "INodeStubs.h"
 #include "TestBlockchainGenerator.h"
 #include "TransactionApiHelpers.h"
@@ -1048,6 +1049,72 @@ TEST_F(WalletApi, loadWithWrongPassword) {
   ASSERT_ANY_THROW(bob.load(data, "pass2"));
 }
 
+TEST_F(WalletApi, saveChangesAppendsChangedPages) {
+  fillWalletWithDetailsCache();
+  node.waitForAsyncContexts();
+  waitForWalletEvent(alice, CryptoNote::SYNC_COMPLETED, std::chrono::seconds(5));
+
+  std::stringstream data;
+  alice.save(data, true, true);
+  size_t savedSize = data.str().size();
+
+  ASSERT_TRUE(alice.saveChanges(data));
+  ASSERT_EQ(savedSize, data.str().size());
+
+  alice.createAddress();
+  ASSERT_TRUE(alice.saveChanges(data));
+  ASSERT_LT(data.str().size() - savedSize, savedSize);
+
+  WalletGreen bob(dispatcher, currency, node, TRANSACTION_SOFTLOCK_TIME);
+  data.seekg(0);
+  bob.load(data, "pass");
+
+  compareWalletsAddresses(alice, bob);
+  compareWalletsActualBalance(alice, bob);
+  compareWalletsPendingBalance(alice, bob);
+  compareWalletsTransactionTransfers(alice, bob);
+
+  bob.createAddress();
+  ASSERT_TRUE(bob.saveChanges(data));
+
+  bob.shutdown();
+  wait(100);
+}
+
+TEST_F(WalletApi, saveChangesFailsForOtherFile) {
+  std::stringstream first;
+  alice.save(first, true, true);
+
+  std::stringstream second;
+  alice.save(second, true, true);
+
+  ASSERT_FALSE(alice.saveChanges(first));
+  ASSERT_TRUE(alice.saveChanges(second));
+
+  alice.changePassword("pass", "pass2");
+  ASSERT_FALSE(alice.saveChanges(second));
+}
+
+TEST_F(WalletApi, loadIgnoresUnfinishedSaveChanges) {
+  std::stringstream data;
+  alice.save(data, true, true);
+  size_t addressCount = alice.getAddressCount();
+
+  alice.createAddress();
+  ASSERT_TRUE(alice.saveChanges(data));
+
+  std::string file = data.str();
+  std::stringstream unfinished(file.substr(0, file.size() - 1));
+
+  WalletGreen bob(dispatcher, currency, node, TRANSACTION_SOFTLOCK_TIME);
+  bob.load(unfinished, "pass");
+
+  ASSERT_EQ(addressCount, bob.getAddressCount());
+
+  bob.shutdown();
+  wait(100);
+}
+
 void WalletApi::testIWalletDataCompatibility(bool details, const std::string& cache, const std::vector<WalletLegacyTransaction>& txs,
     const std::vector<WalletLegacyTransfer>& trs, const std::vector<std::pair<TransactionInformation, int64_t>>& externalTxs) {
   CryptoNote::AccountBase account;
@@ -3039,6 +3106,114 @@ TEST_F(WalletApi, getTransactionsReturnsCorrectTransactionByBlockHash) {
   ASSERT_TRUE(transactionWithTransfersFound(alice, transactions, transactionId));
 }
 
+std::string makePaymentIdExtra(const std::string& paymentId) {
+  std::vector<uint8_t> extra;
+  if (!CryptoNote::createTxExtraWithPaymentId(paymentId, extra)) {
+    throw std::runtime_error("Couldn't create extra with payment id");
+  }
+
+  return Common::asString(extra);
+}
+
+Crypto::Hash parsePaymentIdHash(const std::string& paymentId) {
+  Crypto::Hash hash;
+  if (!Common::podFromHex(paymentId, hash)) {
+    throw std::runtime_error("Couldn't parse payment id");
+  }
+
+  return hash;
+}
+
+TEST_F(WalletApi, getTransactionsFilteredByPaymentId) {
+  const std::string PAYMENT_ID1 = "dededededededededededededededededededededededededededededededede";
+  const std::string PAYMENT_ID2 = "dfdfdfdfdfdfdfdfdfdfdfdfdfdfdfdfdfdfdfdfdfdfdfdfdfdfdfdfdfdfdfdf";
+
+  generateAndUnlockMoney();
+  waitForWalletEvent(alice, CryptoNote::WalletEventType::SYNC_COMPLETED, std::chrono::seconds(3));
+
+  size_t transactionId1 = sendMoney(RANDOM_ADDRESS, SENT, FEE, 0, makePaymentIdExtra(PAYMENT_ID1));
+  size_t transactionId2 = sendMoney(RANDOM_ADDRESS, SENT, FEE, 0, makePaymentIdExtra(PAYMENT_ID2));
+
+  node.updateObservers();
+  waitForWalletEvent(alice, CryptoNote::WalletEventType::SYNC_COMPLETED, std::chrono::seconds(3));
+
+  CryptoNote::TransactionsFilter filter;
+  filter.paymentId = parsePaymentIdHash(PAYMENT_ID1);
+  auto transactions = alice.getTransactions(0, generator.getBlockchain().size(), filter);
+
+  ASSERT_EQ(1, transactions.size());
+  ASSERT_EQ(1, getTransactionsCount(transactions));
+  ASSERT_TRUE(transactionWithTransfersFound(alice, transactions, transactionId1));
+
+  filter.paymentId = parsePaymentIdHash(PAYMENT_ID2);
+  transactions = alice.getTransactions(get_block_hash(generator.getBlockchain().back()), 1, filter);
+
+  ASSERT_EQ(1, getTransactionsCount(transactions));
+  ASSERT_TRUE(transactionWithTransfersFound(alice, transactions, transactionId2));
+
+  filter.paymentId = parsePaymentIdHash(PAYMENT_ID2);
+  transactions = alice.getTransactions(0, generator.getBlockchain().size() - 1, filter);
+
+  ASSERT_TRUE(transactions.empty());
+}
+
+TEST_F(WalletApi, getTransactionsFilteredByAddress) {
+  std::string secondAddress = alice.createAddress();
+
+  generateAndUnlockMoney();
+  waitForWalletEvent(alice, CryptoNote::WalletEventType::SYNC_COMPLETED, std::chrono::seconds(3));
+
+  size_t transactionId1 = sendMoney(RANDOM_ADDRESS, SENT, FEE);
+  size_t transactionId2 = sendMoney(secondAddress, SENT, FEE);
+
+  node.updateObservers();
+  waitForWalletEvent(alice, CryptoNote::WalletEventType::SYNC_COMPLETED, std::chrono::seconds(3));
+
+  CryptoNote::TransactionsFilter filter;
+  filter.addresses.push_back(RANDOM_ADDRESS);
+  auto transactions = alice.getTransactions(0, generator.getBlockchain().size(), filter);
+
+  ASSERT_EQ(1, getTransactionsCount(transactions));
+  ASSERT_TRUE(transactionWithTransfersFound(alice, transactions, transactionId1));
+
+  filter.addresses.push_back(secondAddress);
+  transactions = alice.getTransactions(0, generator.getBlockchain().size(), filter);
+
+  ASSERT_EQ(2, getTransactionsCount(transactions));
+  ASSERT_TRUE(transactionWithTransfersFound(alice, transactions, transactionId1));
+  ASSERT_TRUE(transactionWithTransfersFound(alice, transactions, transactionId2));
+}
+
+TEST_F(WalletApi, getTransactionsFilteredByPaymentIdAfterLoad) {
+  const std::string PAYMENT_ID = "dededededededededededededededededededededededededededededededede";
+
+  generateAndUnlockMoney();
+  waitForWalletEvent(alice, CryptoNote::WalletEventType::SYNC_COMPLETED, std::chrono::seconds(3));
+
+  sendMoney(RANDOM_ADDRESS, SENT, FEE, 0, makePaymentIdExtra(PAYMENT_ID));
+
+  node.updateObservers();
+  waitForWalletEvent(alice, CryptoNote::WalletEventType::SYNC_COMPLETED, std::chrono::seconds(3));
+
+  std::stringstream data;
+  alice.save(data, true, true);
+
+  WalletGreen bob(dispatcher, currency, node, TRANSACTION_SOFTLOCK_TIME);
+  bob.load(data, "pass");
+
+  CryptoNote::TransactionsFilter filter;
+  filter.paymentId = parsePaymentIdHash(PAYMENT_ID);
+  auto aliceTransactions = alice.getTransactions(0, generator.getBlockchain().size(), filter);
+  auto bobTransactions = bob.getTransactions(0, generator.getBlockchain().size(), filter);
+
+  ASSERT_EQ(1, getTransactionsCount(aliceTransactions));
+  ASSERT_EQ(1, getTransactionsCount(bobTransactions));
+  ASSERT_EQ(aliceTransactions[0].transactions[0].transaction, bobTransactions[0].transactions[0].transaction);
+
+  bob.shutdown();
+  wait(100);
+}
+
 TEST_F(WalletApi, getTransactionsDoesntReturnUnconfirmedIncomingTransactions) {
   CryptoNote::WalletGreen bob(dispatcher, currency, node, TRANSACTION_SOFTLOCK_TIME);
   bob.initialize("pass2");
@@ -26,11 +26,11 @@ using namespace CryptoNote;
 using namespace CryptoNote;
 
 class TransactionValidator : public CryptoNote::ITransactionValidator {
-  virtual bool checkTransactionInputs(const CryptoNote::Transaction& tx, BlockInfo& maxUsedBlock) override {
+  virtual bool checkTransactionInputs(const CryptoNote::CachedTransaction& tx, BlockInfo& maxUsedBlock) override {
     return true;
   }
 
-  virtual bool checkTransactionInputs(const CryptoNote::Transaction& tx, BlockInfo& maxUsedBlock, BlockInfo& lastFailed) override {
+  virtual bool checkTransactionInputs(const CryptoNote::CachedTransaction& tx, BlockInfo& maxUsedBlock, BlockInfo& lastFailed) override {
     return true;
   }
 
@@ -687,6 +687,83 @@ TEST_F(tx_pool, TxPoolAcceptsValidFusionTransaction) {
   ASSERT_FALSE(tvc.m_verification_impossible);
 }
 
+namespace {
+
+class CountingTransactionValidator : public TransactionValidator {
+public:
+  CountingTransactionValidator() : inputsChecks(0), keyImagesSpent(false) {}
+
+  size_t inputsChecks;
+  bool keyImagesSpent;
+
+  virtual bool checkTransactionInputs(const CryptoNote::CachedTransaction& tx, BlockInfo& maxUsedBlock, BlockInfo& lastFailed) override {
+    ++inputsChecks;
+    return true;
+  }
+
+  virtual bool haveSpentKeyImages(const CryptoNote::Transaction& tx) override {
+    return keyImagesSpent;
+  }
+};
+
+}
+
+TEST_F(tx_pool, fillBlockTemplateChecksTransactionInputsOnlyAfterChanges) {
+  TestPool<CountingTransactionValidator, RealTimeProvider> pool(currency, logger);
+  Transaction tx1;
+  Transaction tx2;
+  GenerateTransaction(currency, tx1, currency.minimumFee(), 1);
+  GenerateTransaction(currency, tx2, currency.minimumFee(), 2);
+
+  tx_verification_context tvc = boost::value_initialized<tx_verification_context>();
+  uint32_t blockchainHeight = 0;
+  ASSERT_TRUE(pool.add_tx(tx1, tvc, false, blockchainHeight));
+
+  Block bl;
+  size_t totalSize;
+  uint64_t fee;
+  InitBlock(bl);
+  ASSERT_TRUE(pool.fill_block_template2(bl, textMaxCumulativeSize, 0, totalSize, fee));
+  ASSERT_EQ(1, bl.transactionHashes.size());
+  ASSERT_EQ(1, pool.validator.inputsChecks);
+
+  // nothing changed, the template is served from the cache
+  std::vector<Crypto::Hash> hashes = bl.transactionHashes;
+  InitBlock(bl);
+  ASSERT_TRUE(pool.fill_block_template2(bl, textMaxCumulativeSize, 0, totalSize, fee));
+  ASSERT_EQ(hashes, bl.transactionHashes);
+  ASSERT_EQ(1, pool.validator.inputsChecks);
+
+  // only the new transaction is checked
+  ASSERT_TRUE(pool.add_tx(tx2, tvc, false, blockchainHeight));
+  InitBlock(bl);
+  ASSERT_TRUE(pool.fill_block_template2(bl, textMaxCumulativeSize, 0, totalSize, fee));
+  ASSERT_EQ(2, bl.transactionHashes.size());
+  ASSERT_EQ(2, pool.validator.inputsChecks);
+
+  // a new block only needs the key images checked again
+  pool.on_blockchain_inc(1, NULL_HASH);
+  InitBlock(bl);
+  ASSERT_TRUE(pool.fill_block_template2(bl, textMaxCumulativeSize, 0, totalSize, fee));
+  ASSERT_EQ(2, bl.transactionHashes.size());
+  ASSERT_EQ(2, pool.validator.inputsChecks);
+
+  pool.validator.keyImagesSpent = true;
+  pool.on_blockchain_inc(2, NULL_HASH);
+  InitBlock(bl);
+  ASSERT_TRUE(pool.fill_block_template2(bl, textMaxCumulativeSize, 0, totalSize, fee));
+  ASSERT_TRUE(bl.transactionHashes.empty());
+  ASSERT_EQ(2, pool.validator.inputsChecks);
+
+  // after a block is popped every transaction is checked in full
+  pool.validator.keyImagesSpent = false;
+  pool.on_blockchain_dec(1, NULL_HASH);
+  InitBlock(bl);
+  ASSERT_TRUE(pool.fill_block_template2(bl, textMaxCumulativeSize, 0, totalSize, fee));
+  ASSERT_EQ(2, bl.transactionHashes.size());
+  ASSERT_EQ(4, pool.validator.inputsChecks);
+}
+
 // Disable for MINIMUM_FEE = 0
 TEST_F(tx_pool, DISABLED_TxPoolDoesNotAcceptInvalidFusionTransaction) {
   TransactionValidator validator;